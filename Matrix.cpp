@@ -1,10 +1,69 @@
 #include<iostream>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cfloat>
 #include "Matrix.h"
 #include "squareMatrix.h"
+#include "updatableQR.h"
+#include "structuredMatrix.h"
+#include "elementaryOps.h"
+#include "tsqr.h"
+#include "strassen.h"
+#include "matrixCache.h"
+#include "task.h"
+#include "parallel.h"
+#include "numa.h"
+#include "tuning.h"
 using namespace std;
 
+// columns of the input read together by transpose, so the cache lines of a row stay in cache across output columns
+// (the default; see tuning.h)
+#define TRANSPOSE_TILE 64
+// elements below which transpose runs on one thread
+#define TRANSPOSE_PARALLEL_MIN (1 << 18)
+// elements of the trailing matrix below which a step of pivotedQR updates it on one thread, and the columns per chunk
+#define PIVOTED_QR_PARALLEL_MIN (1 << 16)
+#define PIVOTED_QR_GRAIN 16
+// reflectors applied together by explicitQ, and columns per panel of the echelon form behind the RREF subspace bases
+#define SUBSPACE_NB 64
+// elements below which the column loops of the subspace routines run on one thread
+#define SUBSPACE_PARALLEL_MIN (1 << 16)
+// elements per chunk below which the generator constructor does not split the columns further (as VECTOR_GENERATE_GRAIN)
+#define MATRIX_GENERATE_GRAIN (1 << 14)
+
+namespace{
+
+int transposeTile(){
+    int tuned = tuning().transposeTile;
+    return tuned > 0 ? tuned : TRANSPOSE_TILE;
+}
+
+}
+
 //implement arithmetic operations
 
+Matrix::Matrix(int m, int n){
+    if (numaPolicy() == NumaPolicy::Default || (long long)m * n * sizeof(double) < NUMA_MIN_BYTES){
+        mat.assign(n, Vector(m));
+        return;
+    }
+    // every column is placed before it is touched; under FirstTouch it is also zeroed by the thread owning it
+    mat.resize(n);
+    auto build = [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++){
+            Vector &col = mat[j];
+            col.vec.reserve(m);
+            numaPlace(col.vec.data(), (size_t)m * sizeof(double), numaRangeNode(j, n));
+            col.vec.resize(m);
+        }
+    };
+    if (numaPolicy() == NumaPolicy::FirstTouch)
+        parallelFor(0, n, build);
+    else
+        build(0, 0, n);
+}
+
 Matrix::Matrix(std::initializer_list<std::initializer_list<double> > init, bool byColumns){
     if (init.size() == 0) 
         return;
@@ -15,39 +74,119 @@ Matrix::Matrix(std::initializer_list<std::initializer_list<double> > init, bool
             throw std::invalid_argument("Invalid matrix - All sublists must have same size\n");
         }
 
-    if (byColumns)
-        for (auto &column: init){
+    if (byColumns){
+        mat.reserve(init.size());
+        for (auto &column: init)
             mat.push_back(Vector(column));
+    }
+    else{
+        // the columns are sized once and the rows scattered into them
+        int m = init.size(), n = init.begin()->size();
+        mat.assign(n, Vector(m));
+        int i = 0;
+        for (auto &row: init){
+            int j = 0;
+            for (double x: row)
+                mat[j++].vec[i] = x;
+            i++;
         }
-    else
-        for (int column_no = 0; column_no < init.begin()->size(); column_no++){
-            Vector current_column;
-            for (auto &row: init)
-                current_column.push_back(*(row.begin() + column_no));
-            mat.push_back(current_column);
-        }          
+    }
+}
+
+Matrix::Matrix(int m, int n, const std::function<double(int, int)> &f): Matrix(m, n){
+    // by columns, the split Matrix(m, n) used to place them under FirstTouch
+    parallelFor(0, n, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++){
+            double *col = mat[j].vec.data();
+            for (int i = 0; i < m; i++)
+                col[i] = f(i, j);
+        }
+    }, std::max(1, MATRIX_GENERATE_GRAIN / std::max(m, 1)));
+}
+
+Matrix::Matrix(const ConstMatrixView &v): Matrix(v.order().first, v.order().second){
+    for (int j = 0; j < v.order().second; j++)
+        v.col(j).copyTo(mat[j].vec.data());
+}
+
+Matrix Matrix::transpose(bool modify){
+    LINALG_PROFILE("Matrix::transpose", 0, 16.0 * order().first * order().second);
+    int rows = order().first, cols = order().second, tile = transposeTile();
+    Matrix m(cols, rows);
+    // each thread writes a range of columns of the transpose (rows of this matrix), which FirstTouch placed on its node
+    parallelFor(0, rows, [&](int, long long lo, long long hi){
+        for (int jj = 0; jj < cols; jj += tile){
+            int jend = std::min(cols, jj + tile);
+            for (long long i = lo; i < hi; i++){
+                double *out = m.mat[i].vec.data();
+                for (int j = jj; j < jend; j++)
+                    out[j] = mat[j].vec[i];
+            }
+        }
+    }, 1, (long long)rows * cols >= TRANSPOSE_PARALLEL_MIN ? 0 : 1);
+    if(modify)
+        *this = m;
+    return m;
 }
 
-Matrix Matrix::operator *(const Matrix &m){
+Matrix Matrix::operator *(const Matrix &m) const{
+    LINALG_PROFILE("Matrix::operator*", 2.0 * order().first * order().second * m.order().second,
+        8.0 * (order().first * order().second + m.order().first * m.order().second + order().first * m.order().second));
+    return multiply(m, multiplyAlgorithm());
+}
+
+Matrix Matrix::multiply(const Matrix &m, MultiplyAlgorithm algorithm) const{
     if(order().second!=m.order().first)
     {
         std::cerr<<"Matrices incompatible for multiplication"<<std::endl;
         throw std::invalid_argument("Matrices incompatible for multiplication");
     }
     Matrix product(order().first,m.order().second);
-    for(int i{0};i<order().first;i++)
-    {
-        for(int j{0};j<m.order().second;j++)
-        {
-            for(int k{0};k<order().second;k++)
-            {
-                product.at(i,j)+=at(i,k)*m.at(k,j);
-            }
-        }
-    }
+    if (algorithm == MultiplyAlgorithm::Auto)
+        algorithm = std::min({order().first, order().second, m.order().second}) >= 2 * strassenCutoff() ? MultiplyAlgorithm::Strassen : MultiplyAlgorithm::Blocked;
+    if (algorithm == MultiplyAlgorithm::Strassen)
+        strassen(*this, m, product);
+    else
+        gemm(1, *this, m, 0, product);
     return product;
 }
 
+void Matrix::gemm(double alpha, const Matrix &A, const Matrix &B, double beta, Matrix &C){
+    ::gemm(alpha, A, B, beta, C);
+}
+
+Vector Matrix::operator *(const Vector &x) const{
+    if (order().second != x.size()){
+        std::cerr<<"Matrix and vector incompatible for multiplication"<<std::endl;
+        throw std::invalid_argument("Matrix and vector incompatible for multiplication");
+    }
+    Vector y(order().first);
+    ::gemv(1, *this, x, 0, y);
+    return y;
+}
+
+Vector operator*(const Vector &x, const Matrix &A){
+    if (A.order().first != x.size()){
+        std::cerr<<"Matrix and vector incompatible for multiplication"<<std::endl;
+        throw std::invalid_argument("Matrix and vector incompatible for multiplication");
+    }
+    Vector y(A.order().second);
+    ::gemvT(1, A, x, 0, y);
+    return y;
+}
+
+void Matrix::gemv(double alpha, const Matrix &A, const Vector &x, double beta, Vector &y){
+    ::gemv(alpha, A, x, beta, y);
+}
+
+void Matrix::gemvT(double alpha, const Matrix &A, const Vector &x, double beta, Vector &y){
+    ::gemvT(alpha, A, x, beta, y);
+}
+
+void Matrix::ger(double alpha, const Vector &x, const Vector &y, Matrix &A){
+    ::ger(alpha, x, y, A);
+}
+
 Matrix &Matrix::cef(int start_row, int start_col){
     if (start_row == at(0).size() || start_col == mat.size()) return *this; // do nothing more
     bool allzero = true;
@@ -62,37 +201,151 @@ Matrix &Matrix::cef(int start_row, int start_col){
     at(start_col).set_component_to_1(start_row, true);
     for (int column = start_col + 1; column < mat.size(); column++)
         at(column) -= (at(start_row, column) * at(start_col));
-    return cef(start_col + 1, start_row + 1);
+    return cef(start_row + 1, start_col + 1);
 }
 
-Matrix &Matrix::rcef(int start_row, int start_col){
+Matrix &Matrix::rcef(int start_row, int start_col, ElementaryProgram *ops){
     if (start_row == at(0).size() || start_col == mat.size()) return *this; // do nothing more
+    taskCheckpoint((double)start_row / at(0).size());
     bool allzero = true;
     for (int column = start_col; column < mat.size(); column++)
         if (std::abs(at(start_row, column)) > EPSILON){
             allzero = false;
             std::swap(at(start_col), at(column));
+            if (ops)
+                ops->swap(start_col, column);
             break;
         }
-    if (allzero) return rcef(start_row + 1, start_col);
+    if (allzero) return rcef(start_row + 1, start_col, ops);
 
+    if (ops)
+        ops->scale(start_col, 1 / at(start_row, start_col));
     at(start_col).set_component_to_1(start_row, true);
     for (int column = 0; column < mat.size(); column++){ // only change from cef -> rcef
         if (column == start_col) 
             continue;
+        if (ops)
+            ops->add(column, start_col, -at(start_row, column));
         at(column) -= (at(start_row, column) * at(start_col));
     }
-    return rcef(start_col + 1, start_row + 1);
+    return rcef(start_row + 1, start_col + 1, ops);
+}
+
+Matrix Matrix::rcef(ElementaryProgram &ops, bool modify){
+    ops = ElementaryProgram(order().second);
+    Matrix res(*this);
+    res.rcef(0, 0, &ops);
+    if (modify)
+        *this = res;
+    return res;
+}
+
+Matrix Matrix::rref(ElementaryProgram &ops, bool modify){
+    // column operations on the transpose are row operations on the matrix
+    ops = ElementaryProgram(order().first);
+    Matrix res(this->transpose());
+    res.rcef(0, 0, &ops).transpose(true);
+    if (modify)
+        *this = res;
+    return res;
 }
 
 Matrix Matrix::extend_to_basis(bool modify){
-    Matrix res = this->augment(SquareMatrix(order().first, true));
-    return res.GramSchmidt();
+    int m = order().first;
+    UpdatableQR basis(m);
+    for (auto &col: mat)
+        basis.appendColumn(col);
+    // only as many unit vectors as are missing get orthogonalized, instead of the whole identity.
+    for (int i = 0; i < m && basis.order().second < m; i++){
+        Vector e(m);
+        e[i] = 1;
+        basis.appendColumn(e);
+    }
+    Matrix res = basis.Q();
+    if (modify)
+        *this = res;
+    return res;
+}
+
+namespace{
+
+// the parallel factorizations behind QRMethod; false on dependent columns
+bool parallelQR(const Matrix &A, QRMethod method, Matrix &Q, TriangularMatrix &R){
+    if (method == QRMethod::TSQR)
+        return tsqr(A, Q, R);
+    if (method == QRMethod::BlockCGS2)
+        return blockGramSchmidt(A, Q, R);
+    return false;
+}
+
+}
+
+MatrixCache *Matrix::cache() const{
+    if (!slot.enabled)
+        return nullptr;
+    if (!slot.entries || slot.entries->version != slot.version)
+        slot.entries = std::make_shared<MatrixCache>(slot.version);
+    return slot.entries.get();
+}
+
+double Matrix::norm1() const{
+    MatrixCache *c = cache();
+    if (c && c->norm1 >= 0)
+        return c->norm1;
+    double res = 0;
+    for (auto &col: mat){
+        double s = 0;
+        for (double x: col.vec)
+            s += std::abs(x);
+        res = std::max(res, s);
+    }
+    if (c)
+        c->norm1 = res;
+    return res;
+}
+
+double Matrix::normInf() const{
+    MatrixCache *c = cache();
+    if (c && c->normInf >= 0)
+        return c->normInf;
+    std::vector<double> rowsums(order().first);
+    for (auto &col: mat)
+        for (int i = 0; i < (int)rowsums.size(); i++)
+            rowsums[i] += std::abs(col.vec[i]);
+    double res = rowsums.empty() ? 0 : *std::max_element(rowsums.begin(), rowsums.end());
+    if (c)
+        c->normInf = res;
+    return res;
 }
 
-Matrix Matrix::GramSchmidt(bool modify){
+double Matrix::normFrobenius() const{
+    MatrixCache *c = cache();
+    if (c && c->normFrobenius >= 0)
+        return c->normFrobenius;
+    double s = 0;
+    for (auto &col: mat)
+        for (double x: col.vec)
+            s += x * x;
+    double res = std::sqrt(s);
+    if (c)
+        c->normFrobenius = res;
+    return res;
+}
+
+Matrix Matrix::GramSchmidt(bool modify, QRMethod method){
+    LINALG_PROFILE("Matrix::GramSchmidt", 2.0 * order().first * order().second * order().second, 8.0 * order().first * order().second * order().second);
+    if (method != QRMethod::GramSchmidt){
+        Matrix Q;
+        TriangularMatrix R;
+        if (parallelQR(*this, method, Q, R)){
+            if (modify)
+                *this = Q;
+            return Q;
+        }
+    }
     Matrix res;
     for (int i = 0; i < order().second; i++){ //recheck
+        taskCheckpoint((double)i * i / ((double)order().second * order().second));
         Vector vn{at(i)};
         for(auto &k:res.mat)
         {
@@ -108,7 +361,7 @@ Matrix Matrix::GramSchmidt(bool modify){
     return res;
 }
 
-inline void Matrix::Mj(int j, double c, bool columnOperation){
+void Matrix::Mj(int j, double c, bool columnOperation){
     if (std::abs(c) < EPSILON){
         std::cerr << "error in Mj: M_j(0) is not allowed.\n";
         throw std::invalid_argument("error in Mj: M_j(0) is not allowed.\n");
@@ -116,61 +369,572 @@ inline void Matrix::Mj(int j, double c, bool columnOperation){
     if (columnOperation)
         at(j) *= c;
     // must modify that row's elem in every column - visualize, the columns are strewn somewhere on the heap and are reined in by a vector of pointers(the data of a Vector), also on the heap.
-    else for (int i = 0; i < mat.size(); i++) 
-        at(j, i) *= c;
+    else{
+        checkRow(j);
+        touch();
+        for (auto &col: mat)
+            col.vec[j] *= c;
+    }
+}
+
+void Matrix::Pjk(int j, int k, bool columnOperation){
+    if (columnOperation)
+        std::swap(at(j), at(k));
+    else{
+        checkRow(j);
+        checkRow(k);
+        touch();
+        for (auto &col: mat)
+            std::swap(col.vec[j], col.vec[k]);
+    }
 }
 
-inline void Matrix::Ejk(int j, int k, double lambda, bool columnOperation){
+void Matrix::Ejk(int j, int k, double lambda, bool columnOperation){
     if (std::abs(lambda) < EPSILON)
         return; // do nothing in this case.
     if (columnOperation) 
         at(j) += lambda * at(k);
-    else
-    for (int i = 0; i < mat.size(); i++)
-        at(j, i) += lambda * at(k, i);
+    else{
+        checkRow(j);
+        checkRow(k);
+        touch();
+        for (auto &col: mat)
+            col.vec[j] += lambda * col.vec[k];
+    }
 }
 
-inline void Matrix::elementaryColumnOperation(const std::string &type, int j, int k, double lambda){
-    if (j < 0 || j >= mat.size() || k < 0 || k >= mat.size()){
+void Matrix::elementaryColumnOperation(ElementaryOp type, int j, int k, double lambda){
+    if (j < 0 || j >= order().second || (type != ElementaryOp::Scale && (k < 0 || k >= order().second))){
         std::cerr << "error in column operation: invalid input indices.\n";
-        throw 3;
-    }
-    if (type == "M")
-        Mj(j, k, true);
-    else if (type == "P")
-        Pjk(j, k, true);
-    else if (type == "E")
-        Ejk(j, k, lambda, true);
-    else{
-        std::cerr << "Invalid argument to column operation: first argument must be P/E/M.\n";
-        throw 3;
+        throw std::out_of_range("error in column operation: invalid input indices.");
+    }
+    switch (type){
+        case ElementaryOp::Scale: Mj(j, lambda, true); break;
+        case ElementaryOp::Swap: Pjk(j, k, true); break;
+        case ElementaryOp::Add: Ejk(j, k, lambda, true); break;
     }
 }
 
-inline void Matrix::elementaryRowOperation(const std::string &type, int j, int k, double lambda){
-    if (j < 0 || j >= order().first || k < 0 || k >= order().first){
+void Matrix::elementaryRowOperation(ElementaryOp type, int j, int k, double lambda){
+    if (j < 0 || j >= order().first || (type != ElementaryOp::Scale && (k < 0 || k >= order().first))){
         std::cerr << "error in row operation: invalid input indices.\n";
-        throw 3;
-    }
-    if (type == "M")
-        Mj(j, k);
-    else if (type == "P")
-        Pjk(j, k);
-    else if (type == "E")
-        Ejk(j, k, lambda);
-    else{
-        std::cerr << "Invalid argument to row operation: first argument must be P/E/M.\n";
-        throw 3;
+        throw std::out_of_range("error in row operation: invalid input indices.");
     }
+    switch (type){
+        case ElementaryOp::Scale: Mj(j, lambda); break;
+        case ElementaryOp::Swap: Pjk(j, k); break;
+        case ElementaryOp::Add: Ejk(j, k, lambda); break;
+    }
+}
+
+namespace{
+
+ElementaryOp parseOperation(const std::string &type, const char *what){
+    if (type == "M") return ElementaryOp::Scale;
+    if (type == "P") return ElementaryOp::Swap;
+    if (type == "E") return ElementaryOp::Add;
+    std::cerr << "Invalid argument to " << what << " operation: first argument must be P/E/M.\n";
+    throw std::invalid_argument(std::string("Invalid argument to ") + what + " operation: first argument must be P/E/M.");
+}
+
 }
 
-std::pair<Matrix, Matrix> Matrix::QR(){
+void Matrix::elementaryColumnOperation(const std::string &type, int j, int k, double lambda){
+    ElementaryOp op = parseOperation(type, "column");
+    // "M" scales by k
+    elementaryColumnOperation(op, j, op == ElementaryOp::Scale ? j : k, op == ElementaryOp::Scale ? k : lambda);
+}
+
+void Matrix::elementaryRowOperation(const std::string &type, int j, int k, double lambda){
+    ElementaryOp op = parseOperation(type, "row");
+    elementaryRowOperation(op, j, op == ElementaryOp::Scale ? j : k, op == ElementaryOp::Scale ? k : lambda);
+}
+
+std::pair<Matrix, TriangularMatrix> Matrix::QR(QRMethod method){
+    MatrixCache *c = cache();
+    if (c && c->qr[(int)method])
+        return *c->qr[(int)method];
+    auto qr = computeQR(method);
+    if (c)
+        c->qr[(int)method] = std::make_shared<const std::pair<Matrix, TriangularMatrix>>(qr);
+    return qr;
+}
+
+std::pair<Matrix, TriangularMatrix> Matrix::computeQR(QRMethod method){
+    LINALG_PROFILE("Matrix::QR", 3.0 * order().first * order().second * order().second, 16.0 * order().first * order().second * order().second);
+    if (method != QRMethod::GramSchmidt){
+        Matrix Q;
+        TriangularMatrix R;
+        if (parallelQR(*this, method, Q, R))
+            return {Q, R};
+    }
     Matrix Q = GramSchmidt();
-    Matrix R{order().second, order().second};
+    TriangularMatrix R(order().second);
     for(int i{0}; i<order().second; i++){
         for(int j{i}; j<order().second; j++){
             R.at(i,j) = at(j).dot(Q.at(i));
         }
     }
     return {Q, R};
-}
\ No newline at end of file
+}
+
+Task<std::pair<Matrix, TriangularMatrix>> Matrix::QRAsync(QRMethod method) const{
+    auto A = std::make_shared<Matrix>(*this);
+    return runAsync([A, method]{ return A->QR(method); });
+}
+
+Task<Matrix> Matrix::GramSchmidtAsync(QRMethod method) const{
+    auto A = std::make_shared<Matrix>(*this);
+    return runAsync([A, method]{ return A->GramSchmidt(false, method); });
+}
+
+// ===================== rank revealing QR ============================= //
+
+namespace{
+
+// Householder QR with column pivoting of the res.rows*res.cols matrix already copied into res.factors, see Matrix::pivotedQR
+void pivotedQRInPlace(RRQR &res, double rtol, int max_steps){
+    int m = res.rows, n = res.cols;
+    res.perm.resize(n);
+    std::iota(res.perm.begin(), res.perm.end(), 0);
+    if (m == 0 || n == 0)
+        return;
+
+    double *a = res.factors.data();
+    // current (downdated) norms of the trailing part of each column, and the norms they were last recomputed at
+    std::vector<double> norms(n), ref(n);
+    double maxnorm = 0;
+    for (int j = 0; j < n; j++){
+        double s = 0;
+        for (int i = 0; i < m; i++)
+            s += a[(size_t)j*m + i] * a[(size_t)j*m + i];
+        norms[j] = ref[j] = std::sqrt(s);
+        maxnorm = std::max(maxnorm, norms[j]);
+    }
+    if (rtol < 0)
+        rtol = std::max(m, n) * DBL_EPSILON;
+    double threshold = rtol * maxnorm;
+    int steps = std::min(m, n);
+    if (max_steps >= 0)
+        steps = std::min(steps, max_steps);
+    const double downdate_limit = std::sqrt(DBL_EPSILON);
+
+    for (int k = 0; k < steps; k++){
+        int p = k;
+        for (int j = k + 1; j < n; j++)
+            if (norms[j] > norms[p]) p = j;
+        if (norms[p] <= threshold || maxnorm == 0)
+            break; // everything left is negligible: early exit
+        if (p != k){
+            std::swap_ranges(a + (size_t)k*m, a + (size_t)(k+1)*m, a + (size_t)p*m);
+            std::swap(norms[k], norms[p]);
+            std::swap(ref[k], ref[p]);
+            std::swap(res.perm[k], res.perm[p]);
+        }
+
+        // Householder reflector H = I - tau*v*v^T annihilating a[k+1:m, k]
+        double *ak = a + (size_t)k*m;
+        double alpha = ak[k], xnorm = 0;
+        for (int i = k + 1; i < m; i++)
+            xnorm += ak[i] * ak[i];
+        xnorm = std::sqrt(xnorm);
+        double tau = 0;
+        if (xnorm != 0){
+            double beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+            tau = (beta - alpha) / beta;
+            double scale = 1 / (alpha - beta);
+            for (int i = k + 1; i < m; i++)
+                ak[i] *= scale;
+            ak[k] = beta;
+        }
+        res.tau.push_back(tau);
+        res.rank++;
+
+        // the columns right of the pivot are updated independently
+        auto update = [&, k, tau](int, long long lo, long long hi){
+            for (long long j = lo; j < hi; j++){
+                double *aj = a + (size_t)j*m;
+                if (tau != 0){
+                    double w = aj[k];
+                    for (int i = k + 1; i < m; i++)
+                        w += ak[i] * aj[i];
+                    w *= tau;
+                    aj[k] -= w;
+                    for (int i = k + 1; i < m; i++)
+                        aj[i] -= w * ak[i];
+                }
+                // downdate the trailing norm, recomputing it when cancellation makes the update unreliable
+                if (norms[j] != 0){
+                    double t = std::abs(aj[k]) / norms[j];
+                    t = std::max(0.0, (1 + t) * (1 - t));
+                    double r = norms[j] / ref[j];
+                    if (t * r * r <= downdate_limit){
+                        double s = 0;
+                        for (int i = k + 1; i < m; i++)
+                            s += aj[i] * aj[i];
+                        norms[j] = ref[j] = std::sqrt(s);
+                    }
+                    else
+                        norms[j] *= std::sqrt(t);
+                }
+            }
+        };
+        parallelFor(k + 1, n, update, PIVOTED_QR_GRAIN, (long long)(m - k) * (n - k - 1) >= PIVOTED_QR_PARALLEL_MIN ? 0 : 1);
+    }
+}
+
+}
+
+RRQR Matrix::pivotedQR(double rtol, int max_steps) const{
+    int m = order().first, n = order().second;
+    LINALG_PROFILE("Matrix::pivotedQR", 4.0 * m * n * std::min(m, n), 8.0 * m * n * std::min(m, n));
+    RRQR res;
+    res.rows = m; res.cols = n;
+    res.factors.resize((size_t)m * n);
+    for (int j = 0; j < n; j++)
+        std::copy(mat[j].vec.begin(), mat[j].vec.end(), res.factors.begin() + (size_t)j * m);
+    pivotedQRInPlace(res, rtol, max_steps);
+    return res;
+}
+
+int Matrix::numericalRank(double rtol) const{
+    MatrixCache *c = rtol < 0 ? cache() : nullptr;
+    if (c && c->rank >= 0)
+        return c->rank;
+    int r = pivotedQR(rtol).rank;
+    if (c)
+        c->rank = r;
+    return r;
+}
+
+bool Matrix::hasRankAtLeast(int r, double rtol) const{
+    if (r <= 0)
+        return true;
+    if (r > std::min(order().first, order().second))
+        return false;
+    return pivotedQR(rtol, r).rank >= r;
+}
+
+int Matrix::randomizedRank(int max_rank, double rtol, unsigned seed) const{
+    int m = order().first, n = order().second;
+    if (max_rank <= 0 || m == 0 || n == 0)
+        return 0;
+    int k = std::min(max_rank + 10, std::min(m, n));
+    // Y = A*G, accumulated one column of A at a time. Row j of G is drawn when column j is visited.
+    Matrix Y(m, k);
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> gauss;
+    std::vector<double> g(k);
+    for (int j = 0; j < n; j++){
+        for (auto &x: g)
+            x = gauss(gen);
+        const double *aj = mat[j].vec.data();
+        for (int l = 0; l < k; l++){
+            double *yl = Y.mat[l].vec.data();
+            for (int i = 0; i < m; i++)
+                yl[i] += g[l] * aj[i];
+        }
+    }
+    return std::min(Y.numericalRank(rtol), max_rank);
+}
+
+Matrix RRQR::R() const{
+    Matrix res(rank, cols);
+    for (int j = 0; j < cols; j++)
+        for (int i = 0; i <= std::min(j, rank - 1); i++)
+            res.at(i, j) = factors[(size_t)j*rows + i];
+    return res;
+}
+
+namespace{
+
+// Returns the columns offset .. offset+k-1 of Q = H_0 H_1 ... H_{t-1}, the reflectors of f, i.e. Q applied to those
+// columns of the identity. The reflectors are applied in blocks of SUBSPACE_NB, last block first, each as the compact
+// WY form I - V T V^T through gemm. A block starting at reflector s leaves e_j alone for j < s, so those columns are skipped.
+Matrix explicitQ(const RRQR &f, int offset, int k){
+    int m = f.rows, t = f.tau.size();
+    Matrix res(m, k);
+    for (int j = 0; j < k; j++)
+        res.at(j)[offset + j] = 1;
+    if (k == 0)
+        return res;
+    MatrixView C(res);
+    std::vector<double> V, T(SUBSPACE_NB * SUBSPACE_NB), W;
+    for (int s = (t - 1) / SUBSPACE_NB * SUBSPACE_NB; s >= 0; s -= SUBSPACE_NB){
+        int b = std::min(SUBSPACE_NB, t - s), rows = m - s;
+        int c0 = std::max(0, s - offset), cols = k - c0;
+        if (cols <= 0)
+            continue;
+        // V: the vectors of the block, unit diagonal and zeros above it, rows s .. m-1
+        V.assign((size_t)rows * b, 0);
+        for (int i = 0; i < b; i++){
+            double *vi = V.data() + (size_t)i * rows;
+            const double *h = f.factors.data() + (size_t)(s + i) * m + s;
+            vi[i] = 1;
+            std::copy(h + i + 1, h + rows, vi + i + 1);
+        }
+        // T upper triangular with H_s ... H_{s+b-1} = I - V T V^T (forward accumulation, as LAPACK's dlarft)
+        for (int i = 0; i < b; i++){
+            double tau = f.tau[s + i];
+            T[i * b + i] = tau;
+            for (int l = 0; l < i; l++){
+                double w = 0;
+                for (int r = i; r < rows; r++)
+                    w += V[(size_t)l * rows + r] * V[(size_t)i * rows + r];
+                T[i * b + l] = -tau * w;
+            }
+            // T(0:i, i) = T(0:i, 0:i) * T(0:i, i), top down since row l only reads rows l and below
+            for (int l = 0; l < i; l++){
+                double w = 0;
+                for (int q = l; q < i; q++)
+                    w += T[q * b + l] * T[i * b + q];
+                T[i * b + l] = w;
+            }
+        }
+        // C -= V (T (V^T C)) on rows s .. m-1
+        MatrixView Cs = C.block(s, c0, rows, cols);
+        ConstMatrixView Vv(V.data(), rows, b, rows);
+        W.assign((size_t)b * cols, 0);
+        MatrixView Wv(W.data(), b, cols, b);
+        gemm(1, Vv.transposed(), Cs, 0, Wv);
+        for (int j = 0; j < cols; j++){
+            double *w = W.data() + (size_t)j * b;
+            for (int l = 0; l < b; l++){
+                double x = 0;
+                for (int q = l; q < b; q++)
+                    x += T[q * b + l] * w[q];
+                w[l] = x;
+            }
+        }
+        gemm(-1, Vv, Wv, 1, Cs);
+    }
+    return res;
+}
+
+}
+
+Matrix RRQR::Q(int k) const{
+    if (k < 0)
+        k = rank;
+    if (k > rows){
+        std::cerr << "error in RRQR::Q: Q has only " << rows << " columns.\n";
+        throw std::invalid_argument("error in RRQR::Q: too many columns requested.");
+    }
+    return explicitQ(*this, 0, k);
+}
+
+// ===================== subspaces ============================= //
+
+namespace{
+
+// copies the transpose of A into the column-major buffer out (n*m, leading dimension n)
+void transposeInto(const Matrix &A, double *out){
+    int m = A.order().first, n = A.order().second, tile = transposeTile();
+    parallelFor(0, m, [&](int, long long lo, long long hi){
+        for (int jj = 0; jj < n; jj += tile){
+            int jend = std::min(n, jj + tile);
+            for (long long i = lo; i < hi; i++)
+                for (int j = jj; j < jend; j++)
+                    out[(size_t)i * n + j] = A.at(j).data()[i];
+        }
+    }, 1, (long long)m * n >= TRANSPOSE_PARALLEL_MIN ? 0 : 1);
+}
+
+// pivoted QR of the transpose of A: Q spans the row space of A in its first rank columns and the null space in the others
+RRQR transposedQR(const Matrix &A, double rtol){
+    RRQR f;
+    f.rows = A.order().second; f.cols = A.order().first;
+    f.factors.resize((size_t)f.rows * f.cols);
+    transposeInto(A, f.factors.data());
+    pivotedQRInPlace(f, rtol, -1);
+    return f;
+}
+
+// Row echelon form of the m*n column-major a (leading dimension m) by Gaussian elimination with partial pivoting, in panels
+// of SUBSPACE_NB columns: a panel is eliminated on its own, then its row swaps and eliminations are applied to the columns
+// right of it at once, the bulk through gemm. A column with no candidate pivot above tol is free and skipped, so the pivot
+// columns are those of the reduced row echelon form. Returns them; rows 0 .. rank-1 of a then hold the echelon form,
+// with the multipliers left below the pivots and rounding residue below the echelon in the free columns.
+std::vector<int> echelon(double *a, int m, int n, double tol){
+    std::vector<int> pivots, swaps;
+    std::vector<double> L;
+    auto col = [&](int j){ return a + (size_t)j * m; };
+    for (int j0 = 0; j0 < n && (int)pivots.size() < m; j0 += SUBSPACE_NB){
+        taskCheckpoint((double)j0 / n);
+        int j1 = std::min(n, j0 + SUBSPACE_NB), r0 = pivots.size(), first = r0;
+        swaps.clear();
+        for (int j = j0; j < j1 && (int)pivots.size() < m; j++){
+            int r = pivots.size();
+            double *aj = col(j);
+            int p = r;
+            for (int i = r + 1; i < m; i++)
+                if (std::abs(aj[i]) > std::abs(aj[p])) p = i;
+            if (std::abs(aj[p]) <= tol)
+                continue;
+            swaps.push_back(p);
+            if (p != r)
+                for (int c = j0; c < j1; c++)
+                    std::swap(col(c)[r], col(c)[p]);
+            double scale = 1 / aj[r];
+            for (int i = r + 1; i < m; i++)
+                aj[i] *= scale;
+            for (int c = j + 1; c < j1; c++){
+                double *ac = col(c), x = ac[r];
+                if (x != 0)
+                    for (int i = r + 1; i < m; i++)
+                        ac[i] -= x * aj[i];
+            }
+            pivots.push_back(j);
+        }
+        int b = pivots.size() - first;
+        if (b == 0 || j1 == n)
+            continue;
+        // the unit lower trapezoidal multipliers of the panel, rows r0 .. m-1
+        int rows = m - r0;
+        L.assign((size_t)rows * b, 0);
+        for (int l = 0; l < b; l++){
+            const double *src = col(pivots[first + l]);
+            std::copy(src + r0 + l + 1, src + m, L.data() + (size_t)l * rows + l + 1);
+        }
+        // swaps and the unit lower triangular solve on the rows of the panel pivots, column by column
+        parallelFor(j1, n, [&](int, long long lo, long long hi){
+            for (long long c = lo; c < hi; c++){
+                double *ac = col(c);
+                for (int l = 0; l < b; l++)
+                    std::swap(ac[r0 + l], ac[swaps[l]]);
+                for (int l = 0; l < b; l++){
+                    double x = ac[r0 + l];
+                    if (x != 0)
+                        for (int i = l + 1; i < b; i++)
+                            ac[r0 + i] -= x * L[(size_t)l * rows + i];
+                }
+            }
+        }, SUBSPACE_NB, (long long)rows * (n - j1) >= SUBSPACE_PARALLEL_MIN ? 0 : 1);
+        if (rows > b)
+            gemm(-1, ConstMatrixView(L.data() + b, rows - b, b, rows), ConstMatrixView(a + (size_t)j1 * m + r0, b, n - j1, m),
+                1, MatrixView(a + (size_t)j1 * m + r0 + b, rows - b, n - j1, m));
+    }
+    return pivots;
+}
+
+// X = U^{-1} X for the r*r upper triangular U and the r*cols X (column-major, leading dimensions r), in blocks of
+// SUBSPACE_NB rows from the bottom: the diagonal block by back substitution, the rows above it by gemm
+void upperSolve(const double *U, int r, double *X, int cols){
+    for (int i1 = r; i1 > 0; i1 -= SUBSPACE_NB){
+        int i0 = std::max(0, i1 - SUBSPACE_NB);
+        parallelFor(0, cols, [&](int, long long lo, long long hi){
+            for (long long c = lo; c < hi; c++){
+                double *x = X + (size_t)c * r;
+                for (int i = i1 - 1; i >= i0; i--){
+                    const double *ui = U + (size_t)i * r;
+                    x[i] /= ui[i];
+                    for (int l = i0; l < i; l++)
+                        x[l] -= ui[l] * x[i];
+                }
+            }
+        }, SUBSPACE_NB, (long long)(i1 - i0) * (i1 - i0) * cols >= SUBSPACE_PARALLEL_MIN ? 0 : 1);
+        if (i0 > 0)
+            gemm(-1, ConstMatrixView(U + (size_t)i0 * r, i0, i1 - i0, r), ConstMatrixView(X + i0, i1 - i0, cols, r),
+                1, MatrixView(X, i0, cols, r));
+    }
+}
+
+// The single elimination pass behind the RREF bases: the pivot columns of A, its free columns, and the r*(n-r) block
+// X = U_P^{-1} U_F of the reduced row echelon form [I X] (columns reordered pivots first)
+struct Echelon{
+    std::vector<int> pivots, free;
+    std::vector<double> X;
+};
+
+Echelon reduce(const Matrix &A, double rtol, bool solve){
+    int m = A.order().first, n = A.order().second;
+    std::vector<double> a((size_t)m * n);
+    for (int j = 0; j < n; j++)
+        std::copy(A.at(j).data(), A.at(j).data() + m, a.begin() + (size_t)j * m);
+    // the rounding residue left by elimination scales with the row sums rather than the largest element
+    double anorm = A.normInf();
+    if (rtol < 0)
+        rtol = std::max(m, n) * DBL_EPSILON;
+    Echelon res;
+    res.pivots = anorm == 0 ? std::vector<int>() : echelon(a.data(), m, n, rtol * anorm);
+    int r = res.pivots.size();
+    std::vector<char> isPivot(n);
+    for (int p: res.pivots)
+        isPivot[p] = 1;
+    for (int j = 0; j < n; j++)
+        if (!isPivot[j])
+            res.free.push_back(j);
+    if (!solve || r == 0)
+        return res;
+    // U_P from the pivot columns and U_F from the free ones, dropping what lies below the echelon
+    std::vector<double> U((size_t)r * r);
+    for (int l = 0; l < r; l++)
+        std::copy(a.begin() + (size_t)res.pivots[l] * m, a.begin() + (size_t)res.pivots[l] * m + l + 1, U.begin() + (size_t)l * r);
+    res.X.assign((size_t)r * res.free.size(), 0);
+    for (int l = 0, k = 0; l < (int)res.free.size(); l++){
+        while (k < r && res.pivots[k] < res.free[l])
+            k++;
+        std::copy(a.begin() + (size_t)res.free[l] * m, a.begin() + (size_t)res.free[l] * m + k, res.X.begin() + (size_t)l * r);
+    }
+    upperSolve(U.data(), r, res.X.data(), res.free.size());
+    return res;
+}
+
+}
+
+Matrix Matrix::nullspace(SubspaceMethod method, double rtol) const{
+    int n = order().second;
+    LINALG_PROFILE("Matrix::nullspace", 4.0 * order().first * n * std::min(order().first, n), 8.0 * order().first * n);
+    if (method == SubspaceMethod::QR){
+        RRQR f = transposedQR(*this, rtol);
+        return explicitQ(f, f.rank, n - f.rank);
+    }
+    Echelon e = reduce(*this, rtol, true);
+    int r = e.pivots.size(), k = e.free.size();
+    // free variable l set to 1 and the others to 0: the pivot variables are -X(:, l)
+    Matrix res(n, k);
+    for (int l = 0; l < k; l++){
+        double *out = res.mat[l].vec.data();
+        const double *x = e.X.data() + (size_t)l * r;
+        out[e.free[l]] = 1;
+        for (int i = 0; i < r; i++)
+            out[e.pivots[i]] = -x[i];
+    }
+    return res;
+}
+
+Matrix Matrix::colspace(SubspaceMethod method, double rtol) const{
+    int m = order().first;
+    LINALG_PROFILE("Matrix::colspace", 4.0 * m * order().second * std::min(m, order().second), 8.0 * m * order().second);
+    if (method == SubspaceMethod::QR){
+        RRQR f = pivotedQR(rtol);
+        return explicitQ(f, 0, f.rank);
+    }
+    Echelon e = reduce(*this, rtol, false);
+    Matrix res(m, 0);
+    res.mat.reserve(e.pivots.size());
+    for (int p: e.pivots)
+        res.mat.push_back(mat[p]);
+    return res;
+}
+
+Matrix Matrix::rowspace(SubspaceMethod method, double rtol) const{
+    int n = order().second;
+    LINALG_PROFILE("Matrix::rowspace", 4.0 * order().first * n * std::min(order().first, n), 8.0 * order().first * n);
+    if (method == SubspaceMethod::QR){
+        RRQR f = transposedQR(*this, rtol);
+        return explicitQ(f, 0, f.rank);
+    }
+    Echelon e = reduce(*this, rtol, true);
+    int r = e.pivots.size(), k = e.free.size();
+    // column i is row i of the reduced row echelon form: 1 at pivot i, X(i, :) at the free columns
+    Matrix res(n, r);
+    for (int i = 0; i < r; i++)
+        res.mat[i].vec[e.pivots[i]] = 1;
+    for (int l = 0; l < k; l++){
+        const double *x = e.X.data() + (size_t)l * r;
+        for (int i = 0; i < r; i++)
+            res.mat[i].vec[e.free[l]] = x[i];
+    }
+    return res;
+}
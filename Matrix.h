@@ -1,10 +1,16 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <functional>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <exception>
+#include <memory>
 #include "Vector.h"
+#include "view.h"
+#include "instrument.h"
+#include "task.h"
 
 #pragma once
 
@@ -20,7 +26,61 @@
 // 
 
 class Matrix;
+struct RRQR;
+class TriangularMatrix;
+class ElementaryProgram;
+
+/**
+ * @brief The three elementary operations on rows/columns j and k: M (scale j by lambda), P (swap j and k), E (add lambda times k to j).
+ *
+ */
+enum class ElementaryOp{ Scale, Swap, Add };
+
+/**
+ * @brief Algorithms for Matrix::GramSchmidt and Matrix::QR: serial Gram-Schmidt, block Gram-Schmidt with reorthogonalization
+ * (BCGS2) or the communication-avoiding tall-skinny QR (TSQR), the last two parallel over rows (see tsqr.h).
+ * TSQR reads the matrix once and suits tall-skinny matrices (m >> n) best.
+ *
+ */
+enum class QRMethod{ GramSchmidt, BlockCGS2, TSQR };
+
+/**
+ * @brief Algorithms for Matrix::multiply: the cache blocked gemm, Strassen-Winograd recursion (see strassen.h, whose
+ * error bound is normwise only), or Auto, which takes Strassen when every dimension is at least twice the recursion cutoff.
+ *
+ */
+enum class MultiplyAlgorithm{ Auto, Blocked, Strassen };
+
+/**
+ * @brief How Matrix::nullspace, colspace and rowspace compute their bases: QR gives orthonormal bases from a column-pivoted
+ * Householder QR (see Matrix::pivotedQR); RREF gives the bases read off the reduced row echelon form (free variables set to
+ * 0 and 1, the pivot columns of A, the nonzero rows of the RREF), whose entries stay exact when those of A are small integers.
+ *
+ */
+enum class SubspaceMethod{ QR, RREF };
 inline std::ostream& operator << (std::ostream& c, const Matrix&);
+
+struct MatrixCache;
+
+/**
+ * @brief Per-object state of the opt-in cache of a Matrix (see Matrix::enableCache): the modification counter and the memoized results.
+ * It is deliberately not copied: a copy of a matrix starts with an empty cache, and assigning to a matrix invalidates its cache.
+ *
+ */
+class MatrixCacheSlot{
+    unsigned long long version = 0;
+    bool enabled = false;
+    mutable std::shared_ptr<MatrixCache> entries;
+    friend class Matrix;
+public:
+    MatrixCacheSlot(){}
+    MatrixCacheSlot(const MatrixCacheSlot &other): enabled{other.enabled}{}
+    MatrixCacheSlot &operator=(const MatrixCacheSlot &){
+        version++;
+        return *this;
+    }
+};
+
 /**
  * @brief Class implementing a 2D matrix.
  * 
@@ -31,6 +91,13 @@ inline std::ostream& operator << (std::ostream& c, const Matrix&);
 class Matrix{
 protected:
     std::vector<Vector> mat;
+    MatrixCacheSlot slot;
+    friend class ConstMatrixView;
+    friend class LS_Solver;
+    /**
+     * @brief Returns the memoized results valid for the current contents, or nullptr if the cache is disabled.
+     */
+    MatrixCache *cache() const;
 public:
     /**
      * @brief Construct a new empty Matrix object
@@ -40,10 +107,13 @@ public:
     /**
      * @brief Construct a new Matrix object with dimensions m*n
      * 
+     * Large matrices are placed on the NUMA nodes according to numaPolicy() (see numa.h): under NumaPolicy::FirstTouch,
+     * the columns a parallel kernel gives to one thread are put on that thread's node and zeroed by it.
+     * 
      * @param m Number of rows in the matrix
      * @param n Number of columns in the matrix
      */
-    Matrix(int m, int n): mat(n,Vector(m)){}
+    Matrix(int m, int n);
     /**
      * @brief Construct a new Matrix object from the given initializer list.   
      * Example- Matrix({{1,2},{3,4},{5,6}}) creates a 3*2 matrix when byColumns is false and a 2*3 matrix when byColumns is true.
@@ -64,6 +134,54 @@ public:
      * @param v The vector of Vectors to be turned into a Matrix object.
      */
     Matrix(const std::vector<Vector> &v): mat{v}{}
+    /**
+     * @brief Construct a new Matrix object taking over a vector of Vector objects as its columns, without copying the elements.
+     *
+     * @param v The columns, left empty.
+     */
+    Matrix(std::vector<Vector> &&v) noexcept: mat{std::move(v)}{}
+    /**
+     * @brief Construct a new m*n Matrix object with elements f(i, j), filled in parallel by columns (see parallel.h),
+     * so f must be safe to call concurrently. Placed on the NUMA nodes as Matrix(m, n), each column filled by the thread
+     * that first touched it under NumaPolicy::FirstTouch.
+     *
+     * @param f the generator, called once per element
+     */
+    Matrix(int m, int n, const std::function<double(int, int)> &f);
+    /**
+     * @brief Construct a new Matrix object holding a copy of the elements of a view (see view.h).
+     * Explicit, so that passing a block, row, transpose or MatrixBuffer to a routine taking a const Matrix& shows the copy
+     * at the call site: LU(SquareMatrix(B)), Matrix(B).rank(). The kernels taking views (gemm, gemv, ...) copy nothing.
+     *
+     * @param v the view to copy
+     */
+    explicit Matrix(const ConstMatrixView &v);
+    /**
+     * @brief Opts in to (or out of) memoizing the expensive queries on this matrix: rank, norms, QR, and for a SquareMatrix
+     * the determinant, inverse and LU and Cholesky factors, and the reduced row echelon form used by LS_Solver::solve.
+     * Repeated queries on an unchanged matrix are then lookups.
+     *
+     * Every non-const accessor (at, view, block, row, col, diagonal), elementary operation and assignment bumps the
+     * modification counter, which invalidates the memoized results, even when it is only used to read. Read through
+     * cat, or through a const reference (std::as_const), to keep them.
+     *
+     * @note A reference, pointer or view obtained earlier can still write to the matrix without the counter noticing.
+     * After writing through one, call touch() before the next query. The cache is not synchronized: concurrent queries
+     * on one cached matrix need external locking.
+     */
+    void enableCache(bool enable = true){
+        slot.enabled = enable;
+        slot.entries.reset();
+    }
+    bool cacheEnabled() const{ return slot.enabled; }
+    /**
+     * @brief Returns the modification counter, bumped by every mutating access.
+     */
+    unsigned long long version() const{ return slot.version; }
+    /**
+     * @brief Records a modification, invalidating the memoized results (see enableCache).
+     */
+    void touch(){ slot.version++; }
     /**
      * @brief Gives the dimensions of the matrix as the std::pair {num_rows, num_columns}.
      * 
@@ -99,6 +217,7 @@ public:
      * @return const double& 
      */
     double& at(int i, int j){
+        touch();
         if(i<0||i>=mat.at(0).size()||j<0||j>=mat.size())
         {
             std::cerr<<"index out of bounds"<<std::endl;
@@ -117,30 +236,123 @@ public:
     }
 
     Vector& at(int i){
+        touch();
         return mat.at(i);
     }
+    /**
+     * @brief Reads the (i,j)th element like the const at, also on a non-const matrix, so the memoized results survive (see enableCache).
+     */
+    const double& cat(int i, int j) const{ return at(i, j); }
+    /**
+     * @brief Reads the ith column like the const at, also on a non-const matrix, so the memoized results survive (see enableCache).
+     */
+    const Vector& cat(int i) const{ return at(i); }
+    /**
+     * @brief Returns a view of the whole matrix, see view.h. The view aliases the matrix: writes through it change the matrix.
+     *
+     * @return MatrixView
+     */
+    MatrixView view(){ return MatrixView(*this); }
+    ConstMatrixView view() const{ return ConstMatrixView(*this); }
+    /**
+     * @brief Returns a view of the rows*cols block whose top left element is (i,j), without copying.
+     *
+     * @param i row of the top left element
+     * @param j column of the top left element
+     * @param rows number of rows of the block
+     * @param cols number of columns of the block
+     * @return MatrixView
+     */
+    MatrixView block(int i, int j, int rows, int cols){ return view().block(i, j, rows, cols); }
+    ConstMatrixView block(int i, int j, int rows, int cols) const{ return view().block(i, j, rows, cols); }
+    /**
+     * @brief Returns a view of the ith row, without copying.
+     *
+     * @param i index of the row
+     * @return VectorView
+     */
+    VectorView row(int i){ return view().row(i); }
+    ConstVectorView row(int i) const{ return view().row(i); }
+    /**
+     * @brief Returns a view of the jth column, without copying.
+     *
+     * @param j index of the column
+     * @return VectorView
+     */
+    VectorView col(int j){ return view().col(j); }
+    ConstVectorView col(int j) const{ return view().col(j); }
+    /**
+     * @brief Returns a view of the kth diagonal (k > 0 above the main diagonal, k < 0 below it), without copying.
+     *
+     * @param k index of the diagonal
+     * @return VectorView
+     */
+    VectorView diagonal(int k = 0){ return view().diagonal(k); }
+    ConstVectorView diagonal(int k = 0) const{ return view().diagonal(k); }
     /**
      * @brief Returns the product of two matrices
      * 
      * @return Matrix Product of the two matrices 
      */
-    Matrix operator *(const Matrix &m);
+    Matrix operator *(const Matrix &m) const;
+    /**
+     * @brief Returns the matrix-vector product A*x, without going through an n*1 Matrix (see gemv).
+     *
+     * @param x Vector with as many elements as the matrix has columns
+     * @return Vector with as many elements as the matrix has rows
+     */
+    Vector operator *(const Vector &x) const;
+    /**
+     * @brief Matrix multiplication with a chosen algorithm. operator* uses the one set by setMultiplyAlgorithm (Blocked by default).
+     *
+     * @param m the right factor
+     * @param algorithm see MultiplyAlgorithm
+     * @return Matrix Product of the two matrices
+     */
+    Matrix multiply(const Matrix &m, MultiplyAlgorithm algorithm) const;
+    /**
+     * @brief General matrix multiply C = alpha*A*B + beta*C into a caller-provided C, blocked for the cache.
+     * C must already have order (rows of A, columns of B) and must not share storage with A or B.
+     *
+     * @param alpha scalar multiplying A*B
+     * @param A left factor
+     * @param B right factor
+     * @param beta scalar multiplying the previous contents of C. With beta = 0 the contents of C are ignored.
+     * @param C the output
+     */
+    static void gemm(double alpha, const Matrix &A, const Matrix &B, double beta, Matrix &C);
+    /**
+     * @brief Matrix-vector multiply y = alpha*A*x + beta*y into a caller-provided y, so that repeated products
+     * (power iterations, Krylov methods) allocate nothing. y must already have as many elements as A has rows.
+     *
+     * @param alpha scalar multiplying A*x
+     * @param A the matrix
+     * @param x Vector with as many elements as A has columns
+     * @param beta scalar multiplying the previous contents of y. With beta = 0 the contents of y are ignored.
+     * @param y the output
+     */
+    static void gemv(double alpha, const Matrix &A, const Vector &x, double beta, Vector &y);
+    /**
+     * @brief Transposed matrix-vector multiply y = alpha*A^T*x + beta*y (the row vector x^T*A) into a caller-provided y,
+     * which must already have as many elements as A has columns.
+     */
+    static void gemvT(double alpha, const Matrix &A, const Vector &x, double beta, Vector &y);
+    /**
+     * @brief Rank-1 update A += alpha*x*y^T in place.
+     *
+     * @param alpha scalar multiplying x*y^T
+     * @param x Vector with as many elements as A has rows
+     * @param y Vector with as many elements as A has columns
+     * @param A the matrix updated
+     */
+    static void ger(double alpha, const Vector &x, const Vector &y, Matrix &A);
     /**
      * @brief Returns a new matrix which is the transpose of the original matrix
      * 
      * @param modify if modify is true, then the given matrix is changed to its transpose
      * @return Matrix transpose of the given matrix
      */
-    Matrix transpose(bool modify = false){
-        Matrix m(order().second, order().first);
-        // std::cout << m.order().first << " " << m.order().second << std::endl;
-        for(int i{0};i<order().first;i++)
-            for(int j{0};j<order().second;j++)
-                m.at(j,i) = at(i,j);
-        if(modify)
-            *this = m;
-        return m;
-    }
+    Matrix transpose(bool modify = false);
     /**
      * @brief Returns one possible column echelon form of the given matrix
      * 
@@ -148,6 +360,7 @@ public:
      * @return Matrix one possible column echelon form of the given matrix
      */
     Matrix cef(bool modify = false){ 
+        LINALG_PROFILE("Matrix::cef", 1.0 * order().first * order().second * std::min(order().first, order().second), 8.0 * order().first * order().second);
         Matrix res(*this);
         res.cef(0, 0);
         if (modify) 
@@ -180,19 +393,35 @@ public:
      * @return Matrix one possible reduced column echelon form of the given matrix
      */
     Matrix rcef(bool modify = false){ 
+        LINALG_PROFILE("Matrix::rcef", 2.0 * order().first * order().second * std::min(order().first, order().second), 8.0 * order().first * order().second);
         Matrix res(*this);
         res.rcef(0, 0);
         if (modify) 
             *this = res;
         return res; 
     }
+    /**
+     * @brief Returns the reduced column echelon form and records the column operations performed, so that
+     * ops.applyToColumns(B) repeats the same reduction steps on any other matrix B with as many columns.
+     *
+     * @param ops receives the column operations (it is reset to act on order().second columns)
+     * @param modify if modify is true, then the given matrix is changed to its reduced column echelon form
+     * @return Matrix the reduced column echelon form
+     */
+    Matrix rcef(ElementaryProgram &ops, bool modify = false);
 protected: //change to private if not needed
-    Matrix &rcef(int start_row, int start_col);
+    Matrix &rcef(int start_row, int start_col, ElementaryProgram *ops = nullptr);
 protected:
 //returns the number of columns in the matrix. check if needed later
     int size() const{
         return mat.size();
     }
+    void checkRow(int i) const{
+        if (i < 0 || i >= order().first){
+            std::cerr << "index out of bounds" << std::endl;
+            throw std::out_of_range("index out of bounds");
+        }
+    }
 public:
     /**
      * @brief Returns the reduced row echelon form of the given matrix
@@ -201,6 +430,7 @@ public:
      * @return Matrix one possible reduced row echelon form of the given matrix
      */
     Matrix rref(bool modify=false){
+        LINALG_PROFILE("Matrix::rref", 2.0 * order().first * order().second * std::min(order().first, order().second), 8.0 * order().first * order().second);
         Matrix res(this->transpose());
         res.rcef(0, 0).transpose(true);
         if (modify)
@@ -208,10 +438,21 @@ public:
         return res;
     }
 
+    /**
+     * @brief Returns the reduced row echelon form and records the row operations performed, so that
+     * ops.applyToRows(B) repeats the same reduction steps on any other matrix B with as many rows.
+     *
+     * @param ops receives the row operations (it is reset to act on order().first rows)
+     * @param modify if modify is true, then the given matrix is changed to its reduced row echelon form
+     * @return Matrix the reduced row echelon form
+     */
+    Matrix rref(ElementaryProgram &ops, bool modify=false);
+
     Matrix augment_modify(const Matrix &other){
         if (order().first != other.order().first){
             throw 1; // fix later to cerr and throw invalid argument
         }
+        touch();
         for (auto &col: other)
             mat.push_back(col);
         return *this;
@@ -227,16 +468,24 @@ public:
         return res;
     }
 
-    // TODO documentation
+    /**
+     * @brief Returns an orthonormal basis of R^m whose first vectors span the column space of the matrix.
+     * The columns are orthogonalized incrementally (see UpdatableQR), and only the missing unit vectors are added.
+     *
+     * @param modify if true, then the given matrix is replaced by the basis.
+     * @return Matrix the m*m orthogonal matrix of basis vectors.
+     */
     Matrix extend_to_basis(bool modify=false);
 
     /**
      * @brief Runs the Gram-Schmidt algorithm on the columns of a copy of the given matrix.
      * 
      * @param modify if true, then the given matrix is modified.
+     * @param method the algorithm. BlockCGS2 and TSQR need linearly independent columns; when the columns are dependent
+     * they fall back to the serial algorithm, which drops the dependent columns.
      * @return Matrix 
      */
-    Matrix GramSchmidt(bool modify=false);
+    Matrix GramSchmidt(bool modify=false, QRMethod method=QRMethod::GramSchmidt);
 
     /**
      * @brief Multiplies a given row/column at the jth index of the matrix with a nonzero scalar c.
@@ -244,7 +493,7 @@ public:
      * @param c Scalar which is to be multiplied
      * @param columnOperation Multiplies the jth column by c if true, else multiplies the jth row by c.
      */
-    inline void Mj(int j, double c, bool columnOperation=false);
+    void Mj(int j, double c, bool columnOperation=false);
     /**
      * @brief Swaps the row/column at index j with the row/column at index k
      * 
@@ -252,17 +501,7 @@ public:
      * @param k 
      * @param columnOperation If true, then the jth and kth columns are swapped, otherwise rows are swapped.
      */
-    inline void Pjk(int j, int k, bool columnOperation=false){
-        if (columnOperation)
-            std::swap(at(j), at(k));
-        else 
-        for (int i = 0; i < mat.size(); i++){
-            // for each i(column), do the following.
-            auto tmp = at(j, i);
-            at(j, i) = at(k, i);
-            at(k, i) = tmp;
-        }
-    }
+    void Pjk(int j, int k, bool columnOperation=false);
     /**
      * @brief C_j = C_j+lambda*C_k (if columnOperation is true), R_j = R_j+lambda*R_k otherwise
      * 
@@ -271,37 +510,153 @@ public:
      * @param lambda 
      * @param columnOperation 
      */
-    inline void Ejk(int j, int k, double lambda, bool columnOperation=false);
+    void Ejk(int j, int k, double lambda, bool columnOperation=false);
 
     /**
-     * @brief 
-     * 
-     * @param type 
-     * @param j 
-     * @param k 
-     * @param lambda 
+     * @brief Performs an elementary column operation. To repeat a sequence of operations on many matrices, record it in an ElementaryProgram instead.
+     *
+     * @param type Scale (C_j = lambda*C_j), Swap (C_j <-> C_k) or Add (C_j = C_j + lambda*C_k)
+     * @param j index of the column that changes
+     * @param k index of the other column (ignored for Scale)
+     * @param lambda the scalar of Scale and Add
      */
-    inline void elementaryColumnOperation(const std::string &type, int j, int k, double lambda=0);
+    void elementaryColumnOperation(ElementaryOp type, int j, int k, double lambda=0);
     /**
-     * @brief 
-     * 
-     * @param type 
-     * @param j 
-     * @param k 
-     * @param lambda 
+     * @brief Performs an elementary row operation, see elementaryColumnOperation.
+     */
+    void elementaryRowOperation(ElementaryOp type, int j, int k, double lambda=0);
+    /**
+     * @brief String form of elementaryColumnOperation: "M" multiplies column j by k, "P" swaps columns j and k, "E" adds lambda times column k to column j.
+     */
+    void elementaryColumnOperation(const std::string &type, int j, int k, double lambda=0);
+    /**
+     * @brief String form of elementaryRowOperation: "M" multiplies row j by k, "P" swaps rows j and k, "E" adds lambda times row k to row j.
+     */
+    void elementaryRowOperation(const std::string &type, int j, int k, double lambda=0);
+    /**
+     * @brief Returns the rank of the matrix.
+     * @note Computed by a column-pivoted QR with the default relative tolerance, see numericalRank. Memoized when the cache is enabled.
+     *
+     * @return int
      */
-    inline void elementaryRowOperation(const std::string &type, int j, int k, double lambda=0);
-    /* to check */
     inline int rank() const{
-        int r = 0;
-        Matrix cef_ = cef();
-        for (const auto &col: cef_.mat)
-            if (!(col.isZero())) r++;
-        return r;
+        return numericalRank();
+    }
+
+    /**
+     * @brief Returns the 1-norm, the largest absolute column sum.
+     */
+    double norm1() const;
+
+    /**
+     * @brief Returns the infinity norm, the largest absolute row sum.
+     */
+    double normInf() const;
+
+    /**
+     * @brief Returns the Frobenius norm, the square root of the sum of the squares of the elements.
+     */
+    double normFrobenius() const;
+
+    /**
+     * @brief Householder QR with column pivoting (A*P = Q*R), stopping as soon as the remaining columns are negligible.
+     *
+     * @param rtol relative tolerance: a pivot is negligible once its norm is at most rtol times the largest column norm of the matrix. A negative value selects max(m,n)*machine epsilon.
+     * @param max_steps stop after this many pivots (early exit). A negative value means no limit.
+     * @return RRQR the compact factorization, the column permutation and the detected rank.
+     */
+    RRQR pivotedQR(double rtol = -1, int max_steps = -1) const;
+
+    /**
+     * @brief Returns the numerical rank of the matrix, relative to the scale of the matrix.
+     *
+     * @param rtol relative tolerance, see pivotedQR.
+     * @return int
+     */
+    int numericalRank(double rtol = -1) const;
+
+    /**
+     * @brief Checks whether rank >= r. Stops after r pivots, so the cost is O(mnr) instead of O(mn*min(m,n)).
+     *
+     * @param r the rank to test for
+     * @param rtol relative tolerance, see pivotedQR.
+     */
+    bool hasRankAtLeast(int r, double rtol = -1) const;
+
+    /**
+     * @brief Checks whether the matrix has full rank, i.e. rank = min(m,n).
+     *
+     * @param rtol relative tolerance, see pivotedQR.
+     */
+    bool isFullRank(double rtol = -1) const{
+        return hasRankAtLeast(std::min(order().first, order().second), rtol);
     }
 
-    //finding the QR decomposition of any matrix
-    std::pair<Matrix, Matrix> QR();
+    /**
+     * @brief Estimates the rank through a random Gaussian sketch Y = A*G with G of size n*(max_rank+10).
+     * G is generated on the fly, so the extra memory is only the m*(max_rank+10) sketch.
+     *
+     * @param max_rank the largest rank of interest. The result never exceeds it.
+     * @param rtol relative tolerance, see pivotedQR.
+     * @param seed seed of the random sketch.
+     * @return int the estimated rank, capped at max_rank.
+     */
+    int randomizedRank(int max_rank, double rtol = -1, unsigned seed = 0) const;
+
+    /**
+     * @brief Returns a basis of the null space {x : Ax = 0} as the columns of one n*(n-rank) matrix.
+     * QR: the trailing columns of Q in the pivoted QR of A^T, orthonormal. RREF: one column per free variable, that variable
+     * set to 1 and the other free ones to 0, from a single blocked elimination pass (no per-vector solves).
+     * With full column rank the basis is empty: the result has no columns, and like every Matrix without columns it reports
+     * order() == (0, 0), so it cannot be multiplied by A. Check order().second for the dimension.
+     *
+     * @param method see SubspaceMethod
+     * @param rtol relative tolerance deciding the rank, see pivotedQR. For RREF a pivot is negligible once it is at most
+     * rtol times the infinity norm of A.
+     */
+    Matrix nullspace(SubspaceMethod method = SubspaceMethod::QR, double rtol = -1) const;
+
+    /**
+     * @brief Returns a basis of the column space as the columns of one m*rank matrix: orthonormal (QR), or the pivot columns of A (RREF).
+     * For a zero A the basis is empty, and the result is a 0*0 matrix as in nullspace.
+     *
+     * @param method see SubspaceMethod
+     * @param rtol relative tolerance deciding the rank, see nullspace.
+     */
+    Matrix colspace(SubspaceMethod method = SubspaceMethod::QR, double rtol = -1) const;
+
+    /**
+     * @brief Returns a basis of the row space as the columns of one n*rank matrix: orthonormal (QR), or the nonzero rows of the RREF (RREF).
+     * For a zero A the basis is empty, and the result is a 0*0 matrix as in nullspace.
+     *
+     * @param method see SubspaceMethod
+     * @param rtol relative tolerance deciding the rank, see nullspace.
+     */
+    Matrix rowspace(SubspaceMethod method = SubspaceMethod::QR, double rtol = -1) const;
+
+    /**
+     * @brief QR decomposition of a matrix with linearly independent columns, by Gram-Schmidt.
+     * R is returned in packed triangular storage (see structuredMatrix.h), and converts to a dense matrix where one is needed.
+     *
+     * @param method the algorithm, see QRMethod. BlockCGS2 and TSQR fall back to Gram-Schmidt on dependent columns.
+     * With the cache enabled (see enableCache), the factors are memoized per method.
+     * @return std::pair<Matrix, TriangularMatrix> Q with orthonormal columns and the upper triangular R, with A = QR.
+     */
+    std::pair<Matrix, TriangularMatrix> QR(QRMethod method=QRMethod::GramSchmidt);
+
+    /**
+     * @brief Runs QR(method) on a copy of the matrix on the library's executor (see task.h), so the caller does not block.
+     * The task reports progress and can be cancelled.
+     */
+    Task<std::pair<Matrix, TriangularMatrix>> QRAsync(QRMethod method=QRMethod::GramSchmidt) const;
+
+    /**
+     * @brief Runs GramSchmidt(false, method) on a copy of the matrix on the library's executor, see QRAsync.
+     */
+    Task<Matrix> GramSchmidtAsync(QRMethod method=QRMethod::GramSchmidt) const;
+protected:
+    std::pair<Matrix, TriangularMatrix> computeQR(QRMethod method);
+public:
 
     inline std::vector<Vector>::const_iterator begin() const{
         return mat.begin();
@@ -311,6 +666,37 @@ public:
     }
 };
 
+/**
+ * @brief Result of Matrix::pivotedQR. The factorization is stored compactly (LAPACK style):
+ * R is in the upper triangle of factors, the Householder vectors (with implicit unit leading entry) below it.
+ *
+ */
+struct RRQR{
+    int rows = 0, cols = 0;
+    /// column-major m*n storage of R and the Householder vectors
+    std::vector<double> factors;
+    /// scalar factors of the Householder reflectors, one per step performed
+    std::vector<double> tau;
+    /// perm[j] is the original index of the jth column of A*P
+    std::vector<int> perm;
+    /// number of pivots above the tolerance
+    int rank = 0;
+
+    /**
+     * @brief Returns the leading rank*n block of R.
+     */
+    Matrix R() const;
+    /**
+     * @brief Returns the first k columns of Q (k defaults to rank).
+     */
+    Matrix Q(int k = -1) const;
+};
+
+/**
+ * @brief Returns the row vector x^T*A (as a Vector with as many elements as A has columns), see Matrix::gemvT.
+ */
+Vector operator*(const Vector &x, const Matrix &A);
+
 inline std::ostream& operator << (std::ostream& c, const Matrix& m){
     if (m.order().first == 0) c<<"[]";
     else{
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include "Polynomial.h"
+#include "squareMatrix.h"
+
+// below this length the schoolbook product is used, both directly and as the base case of Karatsuba
+#define KARATSUBA_CUTOFF 32
+// from this length of the shorter operand on, products go through the FFT
+#define FFT_CUTOFF 1024
+// number of points evaluated together by Polynomial::evaluate
+#define EVAL_BLOCK 64
+
+namespace{
+
+// c[0..na+nb-1) += a * b
+void schoolbook(const double *a, int na, const double *b, int nb, double *c){
+    for (int i = 0; i < na; i++){
+        double ai = a[i];
+        for (int j = 0; j < nb; j++)
+            c[i + j] += ai * b[j];
+    }
+}
+
+// c[0..2n-1) = a * b for two operands of length n. ws must hold 8n doubles.
+void karatsuba(const double *a, const double *b, int n, double *c, double *ws){
+    if (n <= KARATSUBA_CUTOFF){
+        std::fill(c, c + 2*n - 1, 0.0);
+        schoolbook(a, n, b, n, c);
+        return;
+    }
+    int h = n / 2, k = n - h; // low halves have h terms, high halves k >= h terms
+    // z0 = a0*b0 in c[0..2h-1), z2 = a1*b1 in c[2h..2h+2k-1)
+    karatsuba(a, b, h, c, ws);
+    c[2*h - 1] = 0;
+    karatsuba(a + h, b + h, k, c + 2*h, ws);
+    // (a0+a1)(b0+b1) in the workspace
+    double *sa = ws, *sb = ws + k, *z1 = ws + 2*k, *next = ws + 4*k;
+    for (int i = 0; i < k; i++){
+        sa[i] = a[h + i] + (i < h ? a[i] : 0);
+        sb[i] = b[h + i] + (i < h ? b[i] : 0);
+    }
+    karatsuba(sa, sb, k, z1, next);
+    for (int i = 0; i < 2*h - 1; i++)
+        z1[i] -= c[i];
+    for (int i = 0; i < 2*k - 1; i++)
+        z1[i] -= c[2*h + i];
+    for (int i = 0; i < 2*k - 1; i++)
+        c[h + i] += z1[i];
+}
+
+// in-place iterative radix-2 FFT; invert selects the inverse transform (without the 1/n scaling)
+void fft(std::vector<std::complex<double>> &a, bool invert){
+    int n = a.size();
+    for (int i = 1, j = 0; i < n; i++){
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+    for (int len = 2; len <= n; len <<= 1){
+        double ang = 2 * M_PI / len * (invert ? -1 : 1);
+        // twiddles computed directly rather than by repeated multiplication, to keep the error at O(eps log n)
+        std::vector<std::complex<double>> w(len / 2);
+        for (int j = 0; j < len / 2; j++)
+            w[j] = std::polar(1.0, ang * j);
+        for (int i = 0; i < n; i += len)
+            for (int j = 0; j < len / 2; j++){
+                std::complex<double> u = a[i + j], v = a[i + j + len/2] * w[j];
+                a[i + j] = u + v;
+                a[i + j + len/2] = u - v;
+            }
+    }
+}
+
+std::vector<double> fftMultiply(const std::vector<double> &a, const std::vector<double> &b){
+    size_t need = a.size() + b.size() - 1, n = 1;
+    while (n < need)
+        n <<= 1;
+    // pack a into the real part and b into the imaginary part: one forward and one inverse transform suffice.
+    std::vector<std::complex<double>> f(n);
+    for (size_t i = 0; i < a.size(); i++)
+        f[i].real(a[i]);
+    for (size_t i = 0; i < b.size(); i++)
+        f[i].imag(b[i]);
+    fft(f, false);
+    // (a+ib)^2 = a^2 - b^2 + 2iab, so the product is Im(f^2)/2
+    for (auto &x: f)
+        x *= x;
+    fft(f, true);
+    std::vector<double> res(need);
+    for (size_t i = 0; i < need; i++)
+        res[i] = f[i].imag() / (2.0 * n);
+    return res;
+}
+
+}
+
+// ===================== arithmetic ============================= //
+
+bool Polynomial::isZero() const{
+    for (double c: vec)
+        if (c != 0) return false;
+    return true;
+}
+
+void Polynomial::trim(){
+    while (!vec.empty() && vec.back() == 0)
+        vec.pop_back();
+}
+
+Polynomial Polynomial::operator + (const Polynomial &p) const{
+    Polynomial temp(*this);
+    temp += p;
+    return temp;
+}
+
+Polynomial Polynomial::operator - (const Polynomial &p) const{
+    Polynomial temp(*this);
+    temp -= p;
+    return temp;
+}
+
+const Polynomial &Polynomial::operator += (const Polynomial &p){
+    if (p.vec.size() > vec.size())
+        vec.resize(p.vec.size(), 0);
+    for (size_t i = 0; i < p.vec.size(); i++)
+        vec[i] += p.vec[i];
+    trim();
+    return *this;
+}
+
+const Polynomial &Polynomial::operator -= (const Polynomial &p){
+    if (p.vec.size() > vec.size())
+        vec.resize(p.vec.size(), 0);
+    for (size_t i = 0; i < p.vec.size(); i++)
+        vec[i] -= p.vec[i];
+    trim();
+    return *this;
+}
+
+Polynomial Polynomial::operator * (double d) const{
+    Polynomial temp(*this);
+    for (auto &c: temp.vec)
+        c *= d;
+    temp.trim();
+    return temp;
+}
+
+Polynomial Polynomial::operator * (const Polynomial &p) const{
+    if (vec.empty() || p.vec.empty())
+        return Polynomial(variable);
+    int na = vec.size(), nb = p.vec.size();
+    std::vector<double> res;
+    if (std::min(na, nb) <= KARATSUBA_CUTOFF){
+        res.assign(na + nb - 1, 0.0);
+        schoolbook(vec.data(), na, p.vec.data(), nb, res.data());
+    }
+    else if (std::min(na, nb) >= FFT_CUTOFF)
+        res = fftMultiply(vec, p.vec);
+    else{
+        // Karatsuba on equal-length chunks of the longer operand
+        const std::vector<double> &lng = na >= nb ? vec : p.vec, &sht = na >= nb ? p.vec : vec;
+        int n = sht.size();
+        res.assign(na + nb - 1, 0.0);
+        std::vector<double> chunk(n), prod(2*n), ws(8*n);
+        for (int start = 0; start < (int)lng.size(); start += n){
+            int len = std::min(n, (int)lng.size() - start);
+            std::fill(chunk.begin(), chunk.end(), 0.0);
+            std::copy(lng.begin() + start, lng.begin() + start + len, chunk.begin());
+            karatsuba(chunk.data(), sht.data(), n, prod.data(), ws.data());
+            for (int i = 0; i < std::min(2*n - 1, (int)res.size() - start); i++)
+                res[start + i] += prod[i];
+        }
+    }
+    Polynomial temp(std::move(res), variable);
+    temp.trim();
+    return temp;
+}
+
+const Polynomial &Polynomial::operator *= (const Polynomial &p){
+    *this = *this * p;
+    return *this;
+}
+
+std::pair<Polynomial, Polynomial> Polynomial::divmod(const Polynomial &p) const{
+    Polynomial d(p);
+    d.trim();
+    if (d.vec.empty()){
+        std::cerr << "Division by zero polynomial" << std::endl;
+        throw std::invalid_argument("Cannot divide by the zero polynomial");
+    }
+    Polynomial r(*this);
+    r.trim();
+    int nd = d.vec.size();
+    if (r.vec.size() < d.vec.size())
+        return {Polynomial(variable), r};
+    int nq = r.vec.size() - nd + 1;
+    std::vector<double> q(nq);
+    double lead = d.vec.back();
+    for (int k = nq - 1; k >= 0; k--){
+        double c = r.vec[k + nd - 1] / lead;
+        q[k] = c;
+        for (int j = 0; j < nd; j++)
+            r.vec[k + j] -= c * d.vec[j];
+        r.vec[k + nd - 1] = 0; // exactly, instead of the rounding residue
+    }
+    r.trim();
+    Polynomial quotient(std::move(q), variable);
+    quotient.trim();
+    return {quotient, r};
+}
+
+Polynomial Polynomial::operator / (const Polynomial &p) const{
+    return divmod(p).first;
+}
+
+Polynomial Polynomial::operator % (const Polynomial &p) const{
+    return divmod(p).second;
+}
+
+Polynomial Polynomial::derivative() const{
+    if (vec.size() <= 1)
+        return Polynomial(variable);
+    std::vector<double> d(vec.size() - 1);
+    for (size_t i = 1; i < vec.size(); i++)
+        d[i - 1] = i * vec[i];
+    Polynomial temp(std::move(d), variable);
+    temp.trim();
+    return temp;
+}
+
+Polynomial operator -(const Polynomial &p){
+    Polynomial temp(p);
+    for (auto &c: temp.vec)
+        c = -c;
+    return temp;
+}
+
+Polynomial gcd(const Polynomial &p, const Polynomial &q, double tol){
+    Polynomial a(p), b(q);
+    a.trim(); b.trim();
+    while (!b.isZero()){
+        Polynomial r = a % b;
+        // drop the remainder if it is rounding noise relative to the divisor
+        double scale = 0, rmax = 0;
+        for (double c: b.coefficients())
+            scale = std::max(scale, std::abs(c));
+        for (double c: r.coefficients())
+            rmax = std::max(rmax, std::abs(c));
+        if (rmax <= tol * scale)
+            r = Polynomial();
+        a = b;
+        b = r;
+    }
+    if (a.isZero())
+        return a;
+    return a * (1 / a.coefficients().back());
+}
+
+// ===================== evaluation ============================= //
+
+double Polynomial::operator()(double x) const{
+    double res = 0;
+    for (int i = (int)vec.size() - 1; i >= 0; i--)
+        res = res * x + vec[i];
+    return res;
+}
+
+std::complex<double> Polynomial::operator()(std::complex<double> z) const{
+    std::complex<double> res = 0;
+    for (int i = (int)vec.size() - 1; i >= 0; i--)
+        res = res * z + vec[i];
+    return res;
+}
+
+void Polynomial::evaluate(const double *xs, double *out, size_t n) const{
+    int deg = (int)vec.size() - 1;
+    const double *c = vec.data();
+    size_t start = 0;
+    for (; start + EVAL_BLOCK <= n; start += EVAL_BLOCK){
+        // EVAL_BLOCK independent Horner recurrences advanced together
+        double acc[EVAL_BLOCK], x[EVAL_BLOCK];
+        for (int j = 0; j < EVAL_BLOCK; j++){
+            x[j] = xs[start + j];
+            acc[j] = 0;
+        }
+        for (int i = deg; i >= 0; i--){
+            double ci = c[i];
+            for (int j = 0; j < EVAL_BLOCK; j++)
+                acc[j] = acc[j] * x[j] + ci;
+        }
+        std::copy(acc, acc + EVAL_BLOCK, out + start);
+    }
+    for (; start < n; start++)
+        out[start] = (*this)(xs[start]);
+}
+
+std::vector<double> Polynomial::operator()(const std::vector<double> &xs) const{
+    std::vector<double> res(xs.size());
+    evaluate(xs.data(), res.data(), xs.size());
+    return res;
+}
+
+SquareMatrix Polynomial::operator()(const SquareMatrix &A) const{
+    return A.evaluate(*this);
+}
+
+// ===================== roots ============================= //
+
+std::vector<std::complex<double>> Polynomial::roots() const{
+    Polynomial p(*this);
+    p.trim();
+    int deg = p.degree();
+    std::vector<std::complex<double>> res;
+    // zero roots, factored out exactly
+    int low = 0;
+    while (low < deg && p.vec[low] == 0)
+        low++;
+    res.assign(low, 0.0);
+    int n = deg - low;
+    if (n == 0)
+        return res;
+
+    // companion matrix of the monic polynomial: ones on the subdiagonal, -c_i/c_n in the last column.
+    SquareMatrix C(n);
+    double lead = p.vec[deg];
+    for (int i = 0; i < n; i++){
+        if (i > 0)
+            C.at(i, i - 1) = 1;
+        C.at(i, n - 1) = -p.vec[low + i] / lead;
+    }
+    std::vector<std::complex<double>> ev = C.eigenvalues();
+
+    // one or two Newton steps on the original polynomial to polish what the eigenvalue solver lost to the companion form.
+    Polynomial dp = p.derivative();
+    for (auto z: ev){
+        for (int it = 0; it < 2; it++){
+            std::complex<double> d = dp(z);
+            if (std::abs(d) == 0)
+                break;
+            std::complex<double> step = p(z) / d;
+            if (!(std::abs(step) < 1e-3 * (1 + std::abs(z))))
+                break; // not in the quadratic convergence region: keep the eigenvalue
+            z -= step;
+        }
+        res.push_back(z);
+    }
+    return res;
+}
+
+// ===================== printing ============================= //
+
+std::ostream &operator<<(std::ostream &ost, const Polynomial &p){
+    bool first = true;
+    for (int i = (int)p.vec.size() - 1; i >= 0; i--){
+        double c = p.vec[i];
+        if (c == 0)
+            continue;
+        if (!first)
+            ost << (c < 0 ? " - " : " + ");
+        else if (c < 0)
+            ost << '-';
+        double a = std::abs(c);
+        if (a != 1 || i == 0)
+            ost << a;
+        if (i > 0)
+            ost << p.variable;
+        if (i > 1)
+            ost << '^' << i;
+        first = false;
+    }
+    if (first)
+        ost << 0;
+    return ost;
+}
@@ -1,123 +1,208 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
 #include <iostream>
 #include <vector>
+#include <complex>
 #include <cmath>
 
-#define EPSILON 0.0000000000000000000000001
+#pragma once
+
+class SquareMatrix;
 
+/**
+ * @brief Class implementing a polynomial with real coefficients.
+ *
+ * @note The coefficients are stored in ascending order of the powers of the variable.
+ * @note The zero polynomial has no coefficients. Results of arithmetic operations have no trailing zero coefficients.
+ *
+ */
 class Polynomial
 {
-    //Contains a polynomial in the form of a std::vector<double>, in the ascending order of powers of the variable
 protected:
     std::vector<double> vec;
     char variable;
 public:
+    /**
+     * @brief Construct a new Polynomial object from its coefficients, lowest power first.
+     * Example- Polynomial({1,2,3}) is 3x^2 + 2x + 1.
+     *
+     * @param i the coefficients
+     * @param x the name of the variable, used when printing
+     */
     Polynomial(std::initializer_list<double> i, char x = 'x'): vec{i}, variable{x}
     {}
+    /**
+     * @brief Construct the zero polynomial.
+     *
+     * @param x the name of the variable, used when printing
+     */
     Polynomial(char x = 'x'): variable{x}
     {}
-    Polynomial(double d): variable{'x'}, vec{d}
+    /**
+     * @brief Construct a constant polynomial.
+     *
+     * @param d the constant
+     */
+    Polynomial(double d): vec{d}, variable{'x'}
+    {}
+    /**
+     * @brief Construct a new Polynomial object taking over a vector of coefficients, lowest power first.
+     *
+     * @param coefficients the coefficients. Pass an rvalue to avoid a copy.
+     * @param x the name of the variable, used when printing
+     */
+    Polynomial(std::vector<double> coefficients, char x = 'x'): vec{std::move(coefficients)}, variable{x}
     {}
-    int degree () const
+
+    /**
+     * @brief Returns the degree of the polynomial. Throws for the zero polynomial, whose degree is undefined.
+     *
+     * @return int
+     */
+    int degree() const
     {
         if(vec.size()==0)
         {
             std::cerr<<"undefined degree of zero polynomial"<<std::endl;
-            throw 0;
+            throw std::domain_error("undefined degree of zero polynomial");
         }
         return vec.size()-1;
     }
-    Polynomial operator + (const Polynomial p) const 
-    {
-        Polynomial temp;
-        if(degree()>=p.degree())
-        {
-            for (int i{0};i<=p.degree();i++)
-            {
-                temp.vec.push_back(vec.at(i)+p.vec.at(i));
-            }
-            for(int i{0};i<degree()-p.degree();i++)
-            {
-                temp.vec.push_back(vec.at(i+p.degree()+1));
-            }
-        }
-        else
-        {
-            for (int i{0};i<=degree();i++)
-            {
-                temp.vec.push_back(vec.at(i)+p.vec.at(i));
-            }
-            for(int i{0};i<p.degree()-degree();i++)
-            {
-                temp.vec.push_back(p.vec.at(i+degree()+1));
-            }
-        }
-        return std::move(temp);
-    }
 
-    Polynomial operator - (const Polynomial p) const 
-    {
-        Polynomial temp;
-        if(degree()>=p.degree())
-        {
-            for (int i{0};i<=p.degree();i++)
-            {
-                temp.vec.push_back(vec.at(i)-p.vec.at(i));
-            }
-            for(int i{0};i<degree()-p.degree();i++)
-            {
-                temp.vec.push_back(vec.at(i+p.degree()+1));
-            }
-        }
-        else
-        {
-            for (int i{0};i<=degree();i++)
-            {
-                temp.vec.push_back(vec.at(i)-p.vec.at(i));
-            }
-            for(int i{0};i<p.degree()-degree();i++)
-            {
-                temp.vec.push_back(-p.vec.at(i+degree()+1));
-            }
+    /**
+     * @brief Checks if this is the zero polynomial.
+     */
+    bool isZero() const;
+
+    /**
+     * @brief Returns the coefficients, lowest power first.
+     */
+    const std::vector<double> &coefficients() const{ return vec; }
+
+    /**
+     * @brief Returns the coefficient of x^i (0 if i exceeds the degree).
+     *
+     * @param i the power
+     * @return double
+     */
+    double operator[](int i) const{
+        if (i < 0){
+            std::cerr << "negative power in Polynomial::operator[]" << std::endl;
+            throw std::out_of_range("negative power in Polynomial::operator[]");
         }
-        return std::move(temp);
+        return i < (int)vec.size() ? vec[i] : 0;
     }
 
-    friend inline Polynomial operator -(const Polynomial p);
-    friend inline void print(const Polynomial, int, bool);
+    // arithmetic
+
+    Polynomial operator + (const Polynomial &p) const;
+    Polynomial operator - (const Polynomial &p) const;
+    /**
+     * @brief Returns the product of two polynomials. Uses schoolbook multiplication for small degrees,
+     * Karatsuba for moderate degrees and an FFT convolution for large degrees.
+     *
+     * @note The FFT path has a rounding error of about machine epsilon * log2(n) * |p| * |q| in each coefficient.
+     */
+    Polynomial operator * (const Polynomial &p) const;
+    Polynomial operator * (double d) const;
+    /**
+     * @brief Returns the quotient of polynomial division. Throws if p is zero.
+     */
+    Polynomial operator / (const Polynomial &p) const;
+    /**
+     * @brief Returns the remainder of polynomial division. Throws if p is zero.
+     */
+    Polynomial operator % (const Polynomial &p) const;
+    const Polynomial &operator += (const Polynomial &p);
+    const Polynomial &operator -= (const Polynomial &p);
+    const Polynomial &operator *= (const Polynomial &p);
+
+    /**
+     * @brief Divides self by p.
+     *
+     * @return std::pair<Polynomial, Polynomial> {quotient, remainder}
+     */
+    std::pair<Polynomial, Polynomial> divmod(const Polynomial &p) const;
+
+    /**
+     * @brief Returns the derivative of the polynomial.
+     */
+    Polynomial derivative() const;
+
+    // evaluation
+
+    /**
+     * @brief Evaluates the polynomial at x by Horner's rule.
+     */
+    double operator()(double x) const;
+
+    /**
+     * @brief Evaluates the polynomial at a complex point by Horner's rule.
+     */
+    std::complex<double> operator()(std::complex<double> z) const;
+
+    /**
+     * @brief Evaluates the polynomial at every point of xs.
+     *
+     * @return std::vector<double> the values, in the order of xs.
+     */
+    std::vector<double> operator()(const std::vector<double> &xs) const;
+
+    /**
+     * @brief Evaluates the polynomial at n points, writing into a caller-provided buffer.
+     * Runs Horner's rule on blocks of points at once, so the independent recurrences can be vectorized.
+     *
+     * @param xs the n points
+     * @param out the n results
+     * @param n the number of points
+     */
+    void evaluate(const double *xs, double *out, size_t n) const;
+
+    /**
+     * @brief Evaluates the polynomial at a square matrix, see SquareMatrix::evaluate.
+     */
+    SquareMatrix operator()(const SquareMatrix &A) const;
+
+    // roots
+
+    /**
+     * @brief Computes all the (complex) roots of the polynomial as the eigenvalues of its companion matrix, see SquareMatrix::eigenvalues.
+     *
+     * @return std::vector<std::complex<double>> the degree() roots, with multiplicity.
+     */
+    std::vector<std::complex<double>> roots() const;
+
+    // removes trailing zero coefficients
+    void trim();
+
+    friend Polynomial operator -(const Polynomial &p);
+    friend std::ostream &operator<<(std::ostream &ost, const Polynomial &p);
 };
 
-inline Polynomial operator -(const Polynomial p)
-{
-    Polynomial temp;
-    for(int i{0};i<p.degree()+1;i++)
-    {
-        temp.vec.push_back(-p.vec.at(i));
-    }
-    return std::move(temp);
-}
+/**
+ * @brief Returns the negation of p.
+ */
+Polynomial operator -(const Polynomial &p);
 
-void inline print (const Polynomial p, int prec = 2, bool fix = false)
-{
-    if(fix)
-        std::cout<<std::fixed;
-    std::cout.precision(prec);
-    for(int i{p.degree()};i>0;i--)
-    {
-        if(p.vec.at(i)<0)
-            std::cout<<'\b';
-        std::cout<<p.vec.at(i)<<p.variable<<'^'<<i<<'+';
-    }
-    if(p.vec.at(0)<0)
-        std::cout<<'\b';
-    std::cout<<p.vec.at(0)<<std::endl;
+/**
+ * @brief multiplies p by d and returns the result
+ */
+inline Polynomial operator *(double d, const Polynomial &p){
+    return p * d;
 }
 
-int main()
-{
-    Polynomial p, q{1,2,3,4};
-    Polynomial z=p+q;
-    print(z);
-    print(q-p);
-    p=-p;
-    print(p);
-}
+/**
+ * @brief Returns the monic greatest common divisor of p and q by the Euclidean algorithm.
+ *
+ * @param tol remainders whose coefficients are all below tol times the size of the divisor are treated as zero.
+ * @return Polynomial
+ */
+Polynomial gcd(const Polynomial &p, const Polynomial &q, double tol = 1e-10);
+
+/**
+ * @brief Prints the polynomial, highest power first. Example: 3x^2 - 2x + 1
+ */
+std::ostream &operator<<(std::ostream &ost, const Polynomial &p);
+
+#endif
@@ -1,9 +1,31 @@
 #include "Vector.h"
 #include "Matrix.h"
+#include "numa.h"
+#include "parallel.h"
 #define EPSILON 1e-10
+// elements per chunk below which the generator constructor does not split the work further
+#define VECTOR_GENERATE_GRAIN (1 << 14)
 
 // check the move constructors. Whether or not to add move
 
+Vector::Vector(int n){
+    if (numaPolicy() == NumaPolicy::Default || (long long)n * sizeof(double) < NUMA_MIN_BYTES){
+        vec.resize(n);
+        return;
+    }
+    // reserve maps the pages without touching them, so they can be placed before the zeros are written
+    vec.reserve(n);
+    numaPlaceArray(vec.data(), n);
+    vec.resize(n);
+}
+
+Vector::Vector(int n, const std::function<double(int)> &f): Vector(n){
+    parallelFor(0, n, [&](int, long long lo, long long hi){
+        for (long long i = lo; i < hi; i++)
+            vec[i] = f(i);
+    }, VECTOR_GENERATE_GRAIN);
+}
+
 Vector::Vector(const Matrix &m){
     vec.reserve(m.order().first * m.order().second);
     for(int i{0}; i<m.order().second; i++){
@@ -11,6 +33,10 @@ Vector::Vector(const Matrix &m){
     }
 }
 
+Vector::Vector(const ConstVectorView &v): vec(v.size()){
+    v.copyTo(vec.data());
+}
+
 // Arithmetic operations
 Vector Vector::operator + (const Vector &v) const
 {
@@ -101,24 +127,23 @@ const Vector &Vector::operator/=(double factor){
 }
 
 // inner products and norm
-double Vector::dot(const Vector &v) const
+double Vector::dot(const Vector &v, Summation mode) const
 {
     if (this->size()!=v.size())
     {
         std::cerr<<"Invalid dot product"<<std::endl;
         throw std::invalid_argument("Vectors do not have the same dimension. Cannot take dot product.");
     }
-    double pdt{0};
-    for(int i{0};i<v.size();i++)
-        pdt += at(i) * v.at(i);
-    return pdt;
+    return reduceDot(size(), data(), 1, v.data(), 1, mode);
 }
 
-double Vector::norm(int k) const{
-    double res = 0;
+double Vector::norm(int k, Summation mode) const{
+    if (k == 2)
+        return std::sqrt(reduceDot(size(), data(), 1, data(), 1, mode));
+    std::vector<double> powers(size());
     for (int i = 0; i < size(); i++)
-        res += std::pow(at(i), k);
-    return pow(res, 1.0/k);
+        powers[i] = std::pow(std::abs(at(i)), k);
+    return pow(reduceSum(powers.size(), powers.data(), 1, mode), 1.0/k);
 }
 
 Vector Vector::normalized(bool modify, int k){
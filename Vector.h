@@ -1,10 +1,12 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <exception>
+#include "summation.h"
 
 #pragma once
 
@@ -18,6 +20,7 @@
 #define println(x) std::cout << (x) << std::endl;
 
 class Matrix;
+class ConstVectorView;
 
 //template <class T>
 class Vector{
@@ -38,20 +41,45 @@ public:
      */
     Vector(std::initializer_list<double> init): vec(init){}
 
+    /**
+     * @brief Construct a new Vector object taking over the elements of v, without copying them (v is left empty).
+     */
+    Vector(std::vector<double> &&v) noexcept: vec(std::move(v)){}
+
     /**
      * @brief Construct a new Vector object and initialize it to the n-dimensional zero vector.
+     * Large vectors are placed on the NUMA nodes according to numaPolicy() (see numa.h).
      * 
      * @param n the dimension of the vector
      */
-    Vector(int n): vec(n){}
+    Vector(int n);
+
+    /**
+     * @brief Construct a new n-dimensional Vector object with elements f(i), evaluated in parallel (see parallel.h),
+     * so f must be safe to call concurrently. Placed on the NUMA nodes as Vector(n).
+     */
+    Vector(int n, const std::function<double(int)> &f);
 
     Vector(const Matrix &m);
+
+    /**
+     * @brief Construct a new Vector object holding a copy of the elements of a view (see view.h).
+     *
+     * @param v the view to copy
+     */
+    Vector(const ConstVectorView &v);
     
     /**
      * @brief Default destructor
      */
     ~Vector(){}
 
+    // the user-declared destructor would otherwise suppress the moves, turning every std::swap of columns into two copies
+    Vector(const Vector &) = default;
+    Vector(Vector &&) = default;
+    Vector &operator=(const Vector &) = default;
+    Vector &operator=(Vector &&) = default;
+
     // basic accessor and container operations
 
     /**
@@ -117,6 +145,27 @@ public:
         return (*this)[index];
     }
 
+    /**
+     * @brief direct access to the contiguous storage of the vector, for use by the numerical kernels. No bounds checking is done.
+     *
+     * @return double*. Pointer to the first element.
+     */
+    inline double *data(){ return vec.data(); }
+
+    /**
+     * @brief read-only direct access to the contiguous storage of the vector. No bounds checking is done.
+     *
+     * @return const double*. Pointer to the first element.
+     */
+    inline const double *data() const{ return vec.data(); }
+
+    /**
+     * @brief Hands the elements over to the caller without copying them, leaving the vector empty.
+     */
+    std::vector<double> release(){
+        return std::move(vec);
+    }
+
     
     // Arithmetic operations
 
@@ -191,17 +240,19 @@ public:
      * @brief Computes the dot product of Vectors self and v. Raises invalid_argument error if the dimensions do not match.
      * 
      * @param v The vector to compute the dot product with.
+     * @param mode how the products are summed (see summation.h), by default summationMode()
      * @return double. The computed dot product
      */
-    double dot(const Vector &v) const;
+    double dot(const Vector &v, Summation mode = summationMode()) const;
 
     /**
      * @brief Computes the k-norm of the Vector.
      * 
      * @param k. The norm required. Defaults to 2.
+     * @param mode how the powers of the elements are summed (see summation.h), by default summationMode()
      * @return double. The computed norm.
      */
-    double norm(int k=2) const;
+    double norm(int k=2, Summation mode = summationMode()) const;
 
     /**
      * @brief Normalizes the Vector according to its k-norm. throws invalid_argument exception when the k-norm is 0.
@@ -0,0 +1,551 @@
+// Benchmark suite for the public operations of the library.
+//
+// Usage: linalg_bench [--filter=substring] [--quick] [--min-time=seconds]
+//                     [--out=results.json] [--baseline=results.json] [--threshold=0.10]
+//
+// Every benchmark is swept over a list of sizes. For each (benchmark, size) pair the suite reports
+// the time per iteration, GFLOP/s (from the nominal flop count of the algorithm), the bytes moved
+// per second, and the heap bytes and allocations per iteration. With --baseline, each result is
+// compared to the stored one and the program exits with status 1 if any run is slower than
+// baseline * (1 + threshold).
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include "linalg"
+
+// ===================== allocation tracking ============================= //
+
+static std::atomic<unsigned long long> alloc_count{0}, alloc_bytes{0};
+
+// counts for the benchmarks and, in an instrumented build, for the Profiler's per-routine statistics
+void *operator new(std::size_t size){
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    Profiler::countAllocation(size);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept{ std::free(p); }
+void operator delete(void *p, std::size_t) noexcept{ std::free(p); }
+
+// ===================== framework ============================= //
+
+namespace{
+
+volatile double sink;
+
+class State{
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start;
+    double min_time;
+    unsigned long long allocs0 = 0, bytes0 = 0;
+    bool started = false;
+public:
+    const int n;
+    long long iterations = 0;
+    double seconds = 0, flops = 0, bytes_moved = 0;
+    unsigned long long allocs = 0, alloc_bytes_total = 0;
+
+    State(int n, double min_time): min_time{min_time}, n{n}{}
+
+    /**
+     * @brief Call as the condition of the timed loop. Setup done before the first call is neither timed nor counted.
+     */
+    bool keepRunning(){
+        auto now = clock::now();
+        if (!started){
+            started = true;
+            allocs0 = alloc_count.load();
+            bytes0 = alloc_bytes.load();
+            start = clock::now();
+            return true;
+        }
+        iterations++;
+        seconds = std::chrono::duration<double>(now - start).count();
+        if (seconds < min_time)
+            return true;
+        allocs = alloc_count.load() - allocs0;
+        alloc_bytes_total = alloc_bytes.load() - bytes0;
+        return false;
+    }
+    // nominal flops and bytes moved by one iteration
+    void setFlops(double f){ flops = f; }
+    void setBytes(double b){ bytes_moved = b; }
+};
+
+struct Benchmark{
+    std::string name;
+    std::vector<int> sizes;
+    std::function<void(State&)> fn;
+};
+
+std::vector<Benchmark> &registry(){
+    static std::vector<Benchmark> r;
+    return r;
+}
+
+struct Registrar{
+    Registrar(const std::string &name, std::vector<int> sizes, std::function<void(State&)> fn){
+        registry().push_back({name, std::move(sizes), std::move(fn)});
+    }
+};
+
+#define BENCHMARK(id, name, ...) \
+    void bench_##id(State &state); \
+    Registrar registrar_##id(name, __VA_ARGS__, bench_##id); \
+    void bench_##id(State &state)
+
+std::mt19937 gen(42);
+
+Vector randomVector(int n){
+    std::normal_distribution<double> d;
+    Vector v(n);
+    for (int i = 0; i < n; i++)
+        v[i] = d(gen);
+    return v;
+}
+
+Matrix randomMatrix(int m, int n){
+    std::normal_distribution<double> d;
+    Matrix A(m, n);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < m; i++)
+            A.at(j).data()[i] = d(gen);
+    return A;
+}
+
+// the 5-point Laplacian of an n*n grid, the standard sparse symmetric positive definite test matrix
+SparseMatrix gridLaplacian(int n){
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++){
+            int k = i * n + j;
+            rows.push_back(k); cols.push_back(k); values.push_back(4);
+            for (int nb: {i > 0 ? k - n : -1, i < n - 1 ? k + n : -1, j > 0 ? k - 1 : -1, j < n - 1 ? k + 1 : -1})
+                if (nb != -1){
+                    rows.push_back(k); cols.push_back(nb); values.push_back(-1);
+                }
+        }
+    return SparseMatrix::fromTriplets(n * n, n * n, rows, cols, values);
+}
+
+const std::vector<int> vector_sizes = {1 << 10, 1 << 16, 1 << 20};
+const std::vector<int> cubic_sizes = {16, 64, 256};
+// rows of the tall-skinny m*64 matrices
+const std::vector<int> tall_sizes = {1 << 12, 1 << 16, 1 << 18};
+
+// ===================== benchmarks ============================= //
+
+BENCHMARK(dot, "Vector::dot", vector_sizes){
+    Vector a = randomVector(state.n), b = randomVector(state.n);
+    state.setFlops(2.0 * state.n);
+    state.setBytes(16.0 * state.n);
+    while (state.keepRunning())
+        sink = a.dot(b);
+}
+
+BENCHMARK(dot_compensated, "Vector::dot(Compensated)", vector_sizes){
+    Vector a = randomVector(state.n), b = randomVector(state.n);
+    state.setFlops(2.0 * state.n);
+    state.setBytes(16.0 * state.n);
+    while (state.keepRunning())
+        sink = a.dot(b, Summation::Compensated);
+}
+
+BENCHMARK(dot_reproducible, "Vector::dot(Reproducible)", vector_sizes){
+    Vector a = randomVector(state.n), b = randomVector(state.n);
+    state.setFlops(2.0 * state.n);
+    state.setBytes(16.0 * state.n);
+    while (state.keepRunning())
+        sink = a.dot(b, Summation::Reproducible);
+}
+
+BENCHMARK(norm, "Vector::norm", vector_sizes){
+    Vector a = randomVector(state.n);
+    state.setFlops(2.0 * state.n);
+    state.setBytes(8.0 * state.n);
+    while (state.keepRunning())
+        sink = a.norm();
+}
+
+BENCHMARK(gemm, "Matrix::operator*", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n), B = randomMatrix(state.n, state.n);
+    state.setFlops(2.0 * state.n * state.n * state.n);
+    state.setBytes(24.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix C = A * B;
+        sink = C.at(0, 0);
+    }
+}
+
+BENCHMARK(gemv, "Matrix::gemv", {256, 1024, 4096}){
+    Matrix A = randomMatrix(state.n, state.n);
+    Vector x = randomVector(state.n), y(state.n);
+    state.setFlops(2.0 * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix::gemv(1, A, x, 0, y);
+        sink = y[0];
+    }
+}
+
+BENCHMARK(gemvT, "Matrix::gemvT", {256, 1024, 4096}){
+    Matrix A = randomMatrix(state.n, state.n);
+    Vector x = randomVector(state.n), y(state.n);
+    state.setFlops(2.0 * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix::gemvT(1, A, x, 0, y);
+        sink = y[0];
+    }
+}
+
+BENCHMARK(ger, "Matrix::ger", {256, 1024, 4096}){
+    Matrix A = randomMatrix(state.n, state.n);
+    Vector x = randomVector(state.n), y = randomVector(state.n);
+    state.setFlops(2.0 * state.n * state.n);
+    state.setBytes(16.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix::ger(1e-9, x, y, A);
+        sink = A.at(0, 0);
+    }
+}
+
+BENCHMARK(kronecker, "Kronecker::operator* (order n^2)", cubic_sizes){
+    Kronecker K(randomMatrix(state.n, state.n), randomMatrix(state.n, state.n));
+    Vector x = randomVector(state.n * state.n);
+    state.setFlops(4.0 * state.n * state.n * state.n);
+    state.setBytes(32.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Vector y = K * x;
+        sink = y[0];
+    }
+}
+
+BENCHMARK(sparse_cholesky, "SparseCholesky::refactor (n*n grid)", {64, 256, 512}){
+    SparseMatrix A = gridLaplacian(state.n);
+    SparseCholesky chol(A, SparseOrdering::NestedDissection);
+    state.setFlops(chol.symbolic()->factorFlops());
+    state.setBytes(8.0 * chol.symbolic()->factorNonZeros());
+    while (state.keepRunning()){
+        chol.refactor(A);
+        sink = chol.isPositiveDefinite();
+    }
+}
+
+BENCHMARK(sparse_lu, "SparseLU::refactor (n*n grid)", {64, 256, 512}){
+    SparseMatrix A = gridLaplacian(state.n);
+    SparseLU lu(A, SparseOrdering::NestedDissection);
+    state.setFlops(2 * lu.symbolic()->factorFlops());
+    state.setBytes(16.0 * lu.symbolic()->factorNonZeros());
+    while (state.keepRunning()){
+        lu.refactor(A);
+        sink = lu.perturbations();
+    }
+}
+
+BENCHMARK(strassen, "Matrix::multiply(Strassen)", {512, 1024, 2048}){
+    Matrix A = randomMatrix(state.n, state.n), B = randomMatrix(state.n, state.n);
+    state.setFlops(2.0 * state.n * state.n * state.n);
+    state.setBytes(24.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix C = A.multiply(B, MultiplyAlgorithm::Strassen);
+        sink = C.at(0, 0);
+    }
+}
+
+BENCHMARK(summa, "DistributedMatrix::operator* (4 thread ranks)", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n), B = randomMatrix(state.n, state.n);
+    state.setFlops(2.0 * state.n * state.n * state.n);
+    state.setBytes(24.0 * state.n * state.n);
+    while (state.keepRunning())
+        ThreadTransport::run(4, [&](Transport &comm){
+            DistributedMatrix C = DistributedMatrix(comm, A) * DistributedMatrix(comm, B);
+            if (comm.rank() == 0)
+                sink = C.at(0, 0);
+        });
+}
+
+BENCHMARK(generate, "Matrix(m, n, generator)", {256, 1024, 4096}){
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix A(state.n, state.n, [](int i, int j){ return (double)(i ^ j); });
+        sink = A.at(0, 0);
+    }
+}
+
+BENCHMARK(transpose, "Matrix::transpose", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    state.setBytes(16.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix T = A.transpose();
+        sink = T.at(0, 0);
+    }
+}
+
+BENCHMARK(rref, "Matrix::rref", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    state.setFlops(1.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix R = A.rref();
+        sink = R.at(0, 0);
+    }
+}
+
+BENCHMARK(rank, "Matrix::rank", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    state.setFlops(4.0 / 3.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning())
+        sink = A.rank();
+}
+
+BENCHMARK(nullspace, "Matrix::nullspace (n*8n/5)", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n * 8 / 5);
+    state.setFlops(4.0 * state.n * state.n * state.n * 8 / 5);
+    state.setBytes(8.0 * state.n * state.n * 8 / 5);
+    while (state.keepRunning()){
+        Matrix N = A.nullspace();
+        sink = N.at(0, 0);
+    }
+}
+
+BENCHMARK(nullspace_rref, "Matrix::nullspace(RREF) (n*8n/5)", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n * 8 / 5);
+    state.setFlops(1.0 * state.n * state.n * state.n * 8 / 5);
+    state.setBytes(8.0 * state.n * state.n * 8 / 5);
+    while (state.keepRunning()){
+        Matrix N = A.nullspace(SubspaceMethod::RREF);
+        sink = N.at(0, 0);
+    }
+}
+
+BENCHMARK(gram_schmidt, "Matrix::GramSchmidt", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    state.setFlops(2.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        Matrix Q = A.GramSchmidt();
+        sink = Q.at(0, 0);
+    }
+}
+
+BENCHMARK(qr, "Matrix::QR", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    state.setFlops(3.0 * state.n * state.n * state.n);
+    state.setBytes(16.0 * state.n * state.n);
+    while (state.keepRunning()){
+        auto QR = A.QR();
+        sink = QR.second.at(0, 0);
+    }
+}
+
+BENCHMARK(qr_tall, "Matrix::QR(GramSchmidt) m*64", tall_sizes){
+    Matrix A = randomMatrix(state.n, 64);
+    state.setFlops(3.0 * state.n * 64 * 64);
+    state.setBytes(16.0 * state.n * 64 * 64);
+    while (state.keepRunning()){
+        auto QR = A.QR();
+        sink = QR.second.at(0, 0);
+    }
+}
+
+BENCHMARK(bcgs2_tall, "Matrix::QR(BlockCGS2) m*64", tall_sizes){
+    Matrix A = randomMatrix(state.n, 64);
+    state.setFlops(8.0 * state.n * 64 * 64);
+    state.setBytes(32.0 * state.n * 64 * 2);
+    while (state.keepRunning()){
+        auto QR = A.QR(QRMethod::BlockCGS2);
+        sink = QR.second.at(0, 0);
+    }
+}
+
+BENCHMARK(tsqr_tall, "Matrix::QR(TSQR) m*64", tall_sizes){
+    Matrix A = randomMatrix(state.n, 64);
+    state.setFlops(4.0 * state.n * 64 * 64);
+    state.setBytes(16.0 * state.n * 64);
+    while (state.keepRunning()){
+        auto QR = A.QR(QRMethod::TSQR);
+        sink = QR.second.at(0, 0);
+    }
+}
+
+BENCHMARK(det, "SquareMatrix::det", cubic_sizes){
+    SquareMatrix A(randomMatrix(state.n, state.n));
+    state.setFlops(2.0 / 3.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning())
+        sink = A.det();
+}
+
+BENCHMARK(inverse, "SquareMatrix::inverse", cubic_sizes){
+    SquareMatrix A(randomMatrix(state.n, state.n));
+    state.setFlops(2.0 * state.n * state.n * state.n);
+    state.setBytes(16.0 * state.n * state.n);
+    while (state.keepRunning()){
+        SquareMatrix X = A.inverse();
+        sink = X.at(0, 0);
+    }
+}
+
+BENCHMARK(solve, "LS_Solver::solve", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    Vector b = randomVector(state.n);
+    state.setFlops(1.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        auto sol = LS_Solver::solve(A, b);
+        sink = sol.first.size();
+    }
+}
+
+BENCHMARK(solve_distributed, "LS_Solver::solve(DistributedMatrix) (4 thread ranks)", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    Vector b = randomVector(state.n);
+    state.setFlops(2.0 / 3.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning())
+        ThreadTransport::run(4, [&](Transport &comm){
+            auto sol = LS_Solver::solve(DistributedMatrix(comm, A), b);
+            if (comm.rank() == 0)
+                sink = sol.first.size();
+        });
+}
+
+BENCHMARK(solve_refined, "LS_Solver::solveRefined", cubic_sizes){
+    Matrix A = randomMatrix(state.n, state.n);
+    Vector b = randomVector(state.n);
+    state.setFlops(2.0 / 3.0 * state.n * state.n * state.n);
+    state.setBytes(8.0 * state.n * state.n);
+    while (state.keepRunning()){
+        auto sol = LS_Solver::solveRefined(A, b);
+        sink = sol.first.size();
+    }
+}
+
+// ===================== runner ============================= //
+
+struct Result{
+    std::string name;
+    int n;
+    long long iterations;
+    double ns_per_iter, gflops, gbytes_per_s, bytes_per_iter, allocs_per_iter;
+};
+
+std::string key(const std::string &name, int n){
+    return name + "/" + std::to_string(n);
+}
+
+// reads back the files written by writeJson: one benchmark object per line.
+std::map<std::string, double> readBaseline(const std::string &path){
+    std::map<std::string, double> res;
+    std::ifstream in(path);
+    if (!in){
+        std::cerr << "cannot open baseline " << path << std::endl;
+        std::exit(2);
+    }
+    std::string line;
+    while (std::getline(in, line)){
+        auto pn = line.find("\"name\": \""), pt = line.find("\"ns_per_iter\": ");
+        if (pn == std::string::npos || pt == std::string::npos)
+            continue;
+        pn += 9;
+        std::string name = line.substr(pn, line.find('"', pn) - pn);
+        res[name] = std::atof(line.c_str() + pt + 15);
+    }
+    return res;
+}
+
+void writeJson(const std::string &path, const std::vector<Result> &results){
+    std::ofstream out(path);
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++){
+        const Result &r = results[i];
+        out << "    {\"name\": \"" << key(r.name, r.n) << "\", \"iterations\": " << r.iterations
+            << ", \"ns_per_iter\": " << r.ns_per_iter << ", \"gflops\": " << r.gflops
+            << ", \"gbytes_per_s\": " << r.gbytes_per_s << ", \"bytes_allocated_per_iter\": " << r.bytes_per_iter
+            << ", \"allocs_per_iter\": " << r.allocs_per_iter << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+}
+
+int main(int argc, char **argv){
+    std::string filter, out, baseline;
+    double min_time = 0.2, threshold = 0.10;
+    bool quick = false;
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        auto value = [&](const char *prefix) -> const char*{
+            size_t len = std::string(prefix).size();
+            return arg.compare(0, len, prefix) == 0 ? argv[i] + len : nullptr;
+        };
+        if (const char *v = value("--filter=")) filter = v;
+        else if (const char *v = value("--out=")) out = v;
+        else if (const char *v = value("--baseline=")) baseline = v;
+        else if (const char *v = value("--min-time=")) min_time = std::atof(v);
+        else if (const char *v = value("--threshold=")) threshold = std::atof(v);
+        else if (arg == "--quick") quick = true;
+        else{
+            std::cerr << "usage: " << argv[0] << " [--filter=substring] [--quick] [--min-time=s] [--out=file.json] [--baseline=file.json] [--threshold=0.10]\n";
+            return 2;
+        }
+    }
+    if (quick)
+        min_time = std::min(min_time, 0.02);
+    std::map<std::string, double> base;
+    if (!baseline.empty())
+        base = readBaseline(baseline);
+
+    std::vector<Result> results;
+    int regressions = 0;
+    std::printf("%-28s %14s %10s %10s %12s %10s %10s\n", "benchmark", "time/iter", "GFLOP/s", "GB/s", "alloc B/it", "allocs/it", "vs base");
+    for (auto &b: registry()){
+        if (!filter.empty() && b.name.find(filter) == std::string::npos)
+            continue;
+        for (size_t s = 0; s < b.sizes.size() && (!quick || s == 0); s++){
+            State state(b.sizes[s], min_time);
+            b.fn(state);
+            Result r{b.name, state.n, state.iterations, 0, 0, 0, 0, 0};
+            r.ns_per_iter = 1e9 * state.seconds / state.iterations;
+            r.gflops = state.flops / r.ns_per_iter;
+            r.gbytes_per_s = state.bytes_moved / r.ns_per_iter;
+            r.bytes_per_iter = (double)state.alloc_bytes_total / state.iterations;
+            r.allocs_per_iter = (double)state.allocs / state.iterations;
+            results.push_back(r);
+
+            std::string cmp = "-";
+            auto it = base.find(key(r.name, r.n));
+            if (it != base.end() && it->second > 0){
+                double ratio = r.ns_per_iter / it->second;
+                char buf[32];
+                std::snprintf(buf, sizeof buf, "%+.1f%%%s", 100 * (ratio - 1), ratio > 1 + threshold ? " !" : "");
+                cmp = buf;
+                if (ratio > 1 + threshold)
+                    regressions++;
+            }
+            std::printf("%-28s %12.0fns %10.3f %10.3f %12.0f %10.1f %10s\n", key(r.name, r.n).c_str(),
+                r.ns_per_iter, r.gflops, r.gbytes_per_s, r.bytes_per_iter, r.allocs_per_iter, cmp.c_str());
+        }
+    }
+    if (!out.empty())
+        writeJson(out, results);
+    if (regressions){
+        std::printf("%d regression(s) beyond %.0f%%\n", regressions, 100 * threshold);
+        return 1;
+    }
+    return 0;
+}
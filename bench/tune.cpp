@@ -0,0 +1,189 @@
+// Autotuner for the machine-dependent parameters of the library (see tuning.h).
+//
+// Usage: linalg-tune [--quick] [--min-time=seconds] [--out=path] [--dry-run]
+//
+// The parameters are tuned one after the other, each by timing a representative problem for every candidate value
+// while the parameters already tuned keep their winning values: the thread count and the gemm blocks first, since
+// every other kernel runs on gemm and the threads, then the Strassen cutoff, the transpose tile, the LU and QR panel
+// widths and the order from which inverses go through LU. A candidate's time is the fastest of repeated runs over
+// min-time seconds. The winners are written as the section of this CPU model in the tuning cache (tuningCachePath(),
+// or --out), which the library loads on startup; --dry-run only prints them.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "linalg"
+
+namespace{
+
+volatile double sink;
+double min_time = 0.3;
+TuningParameters best;
+
+std::mt19937 gen(42);
+
+Matrix randomMatrix(int m, int n){
+    std::normal_distribution<double> d;
+    Matrix A(m, n);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < m; i++)
+            A.at(j).data()[i] = d(gen);
+    return A;
+}
+
+// the fastest of repeated runs of f over min_time seconds (at least three), in seconds
+double timeIt(const std::function<void()> &f){
+    typedef std::chrono::steady_clock clock;
+    f(); // warm up caches, pages and threads
+    double fastest = 1e300, total = 0;
+    for (int runs = 0; runs < 3 || total < min_time; runs++){
+        auto start = clock::now();
+        f();
+        double t = std::chrono::duration<double>(clock::now() - start).count();
+        fastest = std::min(fastest, t);
+        total += t;
+    }
+    return fastest;
+}
+
+// times f under best with field set to each candidate, keeps the fastest in best and returns it
+int tune(const char *name, int TuningParameters::*field, const std::vector<int> &candidates, const std::function<void()> &f){
+    std::printf("%s\n", name);
+    int winner = candidates.front();
+    double fastest = 1e300;
+    for (int c: candidates){
+        TuningParameters p = best;
+        p.*field = c;
+        setTuning(p);
+        double t = timeIt(f);
+        std::printf("  %6d %12.3f ms\n", c, 1e3 * t);
+        if (t < fastest){
+            fastest = t;
+            winner = c;
+        }
+    }
+    best.*field = winner;
+    setTuning(best);
+    std::printf("  -> %d\n", winner);
+    return winner;
+}
+
+}
+
+int main(int argc, char **argv){
+    std::string out;
+    bool quick = false, dry_run = false;
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        auto value = [&](const char *prefix) -> const char*{
+            size_t len = std::string(prefix).size();
+            return arg.compare(0, len, prefix) == 0 ? argv[i] + len : nullptr;
+        };
+        if (const char *v = value("--out=")) out = v;
+        else if (const char *v = value("--min-time=")) min_time = std::atof(v);
+        else if (arg == "--quick") quick = true;
+        else if (arg == "--dry-run") dry_run = true;
+        else{
+            std::cerr << "usage: " << argv[0] << " [--quick] [--min-time=s] [--out=path] [--dry-run]\n";
+            return 2;
+        }
+    }
+    if (quick)
+        min_time = std::min(min_time, 0.05);
+    if (std::getenv("LINALG_NUM_THREADS") || std::getenv("LINALG_STRASSEN_CUTOFF"))
+        std::cerr << "warning: LINALG_NUM_THREADS and LINALG_STRASSEN_CUTOFF override the tuned values; unset them to tune those\n";
+    std::printf("tuning for %s\n", cpuModel().c_str());
+    // start from the built-in defaults, not from a cache loaded earlier
+    setTuning(best);
+
+    int n = quick ? 256 : 512;
+    Matrix A = randomMatrix(n, n), B = randomMatrix(n, n), C(n, n);
+    auto product = [&]{ Matrix::gemm(1, A, B, 0, C); sink = C.at(0, 0); };
+
+    int hardware = std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<int> threads;
+    for (int t = 1; t < hardware; t *= 2)
+        threads.push_back(t);
+    threads.push_back(hardware);
+    tune("threads (gemm)", &TuningParameters::threads, threads, product);
+
+    tune("gemm_row_block", &TuningParameters::gemmRowBlock, {64, 128, 256, 512, 1024}, product);
+    tune("gemm_depth_block", &TuningParameters::gemmDepthBlock, {32, 64, 128, 256, 512}, product);
+
+    // Strassen: the cutoff is half the smallest order at which one level of recursion beats the blocked product
+    std::printf("strassen_cutoff\n");
+    best.strassenCutoff = 0;
+    for (int size: quick ? std::vector<int>{256, 512} : std::vector<int>{256, 512, 1024, 2048}){
+        Matrix X = randomMatrix(size, size), Y = randomMatrix(size, size), Z(size, size);
+        double blocked = timeIt([&]{ Matrix::gemm(1, X, Y, 0, Z); sink = Z.at(0, 0); });
+        double recursive = timeIt([&]{ strassen(X, Y, Z, size / 2); sink = Z.at(0, 0); });
+        std::printf("  %6d %12.3f ms blocked %12.3f ms one level\n", size, 1e3 * blocked, 1e3 * recursive);
+        best.strassenCutoff = size / 2;
+        if (recursive < blocked)
+            break;
+        // never faster up to the largest order: Auto, when opted in to, keeps to the blocked product up to twice that
+        best.strassenCutoff = size;
+    }
+    setTuning(best);
+    std::printf("  -> %d\n", best.strassenCutoff);
+
+    int t = quick ? 1024 : 2048;
+    Matrix T = randomMatrix(t, t);
+    tune("transpose_tile", &TuningParameters::transposeTile, {8, 16, 32, 64, 128, 256}, [&]{
+        Matrix X = T.transpose();
+        sink = X.at(0, 0);
+    });
+
+    SquareMatrix S(randomMatrix(n, n));
+    tune("lu_block", &TuningParameters::luBlock, {1, 16, 32, 64, 128, 256}, [&]{
+        LU f(S);
+        sink = f.det();
+    });
+
+    Matrix tall = randomMatrix(quick ? 4096 : 16384, quick ? 128 : 256);
+    tune("qr_block", &TuningParameters::qrBlock, {8, 16, 32, 64, 128}, [&]{
+        Matrix Q;
+        TriangularMatrix R;
+        blockGramSchmidt(tall, Q, R);
+        sink = Q.at(0, 0);
+    });
+
+    // inverse: LU from the smallest order from which it wins at every larger order tried, otherwise never
+    std::printf("inverse_lu_min\n");
+    best.inverseLUMin = 0;
+    for (int size: {8, 16, 32, 64, 128, 256}){
+        SquareMatrix M(randomMatrix(size, size));
+        auto inverse = [&]{ SquareMatrix X = M.inverse(); sink = X.at(0, 0); };
+        TuningParameters p = best;
+        p.inverseLUMin = 0;
+        setTuning(p);
+        double rref = timeIt(inverse);
+        p.inverseLUMin = 1;
+        setTuning(p);
+        double lu = timeIt(inverse);
+        std::printf("  %6d %12.3f ms rref %12.3f ms LU\n", size, 1e3 * rref, 1e3 * lu);
+        if (lu >= rref)
+            best.inverseLUMin = 0;
+        else if (best.inverseLUMin == 0)
+            best.inverseLUMin = size;
+    }
+    setTuning(best);
+    std::printf("  -> %d\n", best.inverseLUMin);
+
+    if (dry_run)
+        return 0;
+    std::string path = out.empty() ? tuningCachePath() : out;
+    try{
+        saveTuning(best, path);
+    }
+    catch (const std::exception &){
+        return 1;
+    }
+    std::printf("written to %s\n", path.c_str());
+    return 0;
+}
@@ -0,0 +1,468 @@
+#include <cmath>
+#include "distributed.h"
+#include "view.h"
+
+// message tags of the distributed kernels
+#define TAG_GATHER 1
+#define TAG_SUMMA_A 2
+#define TAG_SUMMA_B 3
+#define TAG_PIVOT_SEARCH 4
+#define TAG_PIVOT_ROW 5
+#define TAG_PIVOTS 6
+#define TAG_SWAP 7
+#define TAG_L11 8
+#define TAG_L21 9
+#define TAG_U12 10
+#define TAG_SOLVE 11
+#define TAG_DET 12
+
+namespace{
+
+// process owning global index g, with blocks of nb cycled over np processes
+int owner(int g, int nb, int np){
+    return (g / nb) % np;
+}
+
+// local index of global index g on its owner
+int localIndex(int g, int nb, int np){
+    return (g / nb / np) * nb + g % nb;
+}
+
+int globalIndex(int l, int nb, int p, int np){
+    return ((l / nb) * np + p) * nb + l % nb;
+}
+
+// number of global indices below g stored on process p (ScaLAPACK's numroc for g = n)
+int localCount(int g, int nb, int p, int np){
+    int blocks = g / nb;
+    int count = (blocks / np) * nb;
+    if (blocks % np > p)
+        count += nb;
+    else if (blocks % np == p)
+        count += g % nb;
+    return count;
+}
+
+// largest divisor of p not above sqrt(p): the grid rows
+int gridRows(int p){
+    int r = std::max(1, (int)std::sqrt((double)p));
+    while (p % r)
+        r--;
+    return r;
+}
+
+}
+
+// ===================== layout ============================= //
+
+DistributedMatrix::DistributedMatrix(Transport &comm, int m, int n, int nb): comm{&comm}, m{m}, n{n}, nb{nb}
+{
+    if (m < 0 || n < 0 || nb <= 0){
+        std::cerr << "DistributedMatrix: invalid dimensions" << std::endl;
+        throw std::invalid_argument("DistributedMatrix: invalid dimensions");
+    }
+    pr = gridRows(comm.size());
+    pc = comm.size() / pr;
+    myrow = comm.rank() / pc;
+    mycol = comm.rank() % pc;
+    lm = localCount(m, nb, myrow, pr);
+    ln = localCount(n, nb, mycol, pc);
+    a.assign((size_t)ld() * ln, 0);
+}
+
+DistributedMatrix::DistributedMatrix(Transport &comm, const Matrix &A, int nb): DistributedMatrix(comm, A.order().first, A.order().second, nb)
+{
+    for (int lj = 0; lj < ln; lj++){
+        const Vector &col = A.at(globalIndex(lj, nb, mycol, pc));
+        for (int li = 0; li < lm; li++)
+            a[(size_t)lj*ld() + li] = col[globalIndex(li, nb, myrow, pr)];
+    }
+}
+
+DistributedMatrix::DistributedMatrix(Transport &comm, int m, int n, const std::function<double(int, int)> &f, int nb): DistributedMatrix(comm, m, n, nb)
+{
+    for (int lj = 0; lj < ln; lj++){
+        int j = globalIndex(lj, nb, mycol, pc);
+        for (int li = 0; li < lm; li++)
+            a[(size_t)lj*ld() + li] = f(globalIndex(li, nb, myrow, pr), j);
+    }
+}
+
+std::vector<int> DistributedMatrix::processRow(int r) const{
+    std::vector<int> group(pc);
+    for (int c = 0; c < pc; c++)
+        group[c] = rankOf(r, c);
+    return group;
+}
+
+std::vector<int> DistributedMatrix::processColumn(int c) const{
+    std::vector<int> group(pr);
+    for (int r = 0; r < pr; r++)
+        group[r] = rankOf(r, c);
+    return group;
+}
+
+std::vector<int> DistributedMatrix::everyone() const{
+    std::vector<int> group(pr * pc);
+    for (int r = 0; r < pr * pc; r++)
+        group[r] = r;
+    return group;
+}
+
+void DistributedMatrix::checkConformant(const DistributedMatrix &B, const char *where) const{
+    if (comm != B.comm || nb != B.nb){
+        std::cerr << where << ": operands are not distributed alike" << std::endl;
+        throw std::invalid_argument(std::string(where) + ": operands are not distributed alike");
+    }
+}
+
+bool DistributedMatrix::isLocal(int i, int j) const{
+    return i >= 0 && i < m && j >= 0 && j < n && owner(i, nb, pr) == myrow && owner(j, nb, pc) == mycol;
+}
+
+double &DistributedMatrix::at(int i, int j){
+    if (!isLocal(i, j)){
+        std::cerr << "DistributedMatrix::at: element not stored on this rank" << std::endl;
+        throw std::out_of_range("DistributedMatrix::at: element not stored on this rank");
+    }
+    return a[(size_t)localIndex(j, nb, pc)*ld() + localIndex(i, nb, pr)];
+}
+
+double DistributedMatrix::at(int i, int j) const{
+    return const_cast<DistributedMatrix *>(this)->at(i, j);
+}
+
+Matrix DistributedMatrix::gather() const{
+    std::vector<double> full((size_t)m * n);
+    for (int lj = 0; lj < ln; lj++){
+        int j = globalIndex(lj, nb, mycol, pc);
+        for (int li = 0; li < lm; li++)
+            full[(size_t)j*m + globalIndex(li, nb, myrow, pr)] = a[(size_t)lj*ld() + li];
+    }
+    // every element has exactly one owner, so summing assembles the matrix
+    comm->allSum(full, everyone(), TAG_GATHER);
+    Matrix A(m, n);
+    for (int j = 0; j < n; j++)
+        std::copy(full.begin() + (size_t)j*m, full.begin() + (size_t)(j+1)*m, A.at(j).data());
+    return A;
+}
+
+// ===================== arithmetic ============================= //
+
+DistributedMatrix DistributedMatrix::operator+(const DistributedMatrix &B) const{
+    checkConformant(B, "DistributedMatrix::operator+");
+    if (order() != B.order()){
+        std::cerr << "DistributedMatrix::operator+: dimension mismatch" << std::endl;
+        throw std::invalid_argument("DistributedMatrix::operator+: dimension mismatch");
+    }
+    DistributedMatrix C(*this);
+    for (size_t k = 0; k < a.size(); k++)
+        C.a[k] += B.a[k];
+    return C;
+}
+
+DistributedMatrix DistributedMatrix::operator-(const DistributedMatrix &B) const{
+    checkConformant(B, "DistributedMatrix::operator-");
+    if (order() != B.order()){
+        std::cerr << "DistributedMatrix::operator-: dimension mismatch" << std::endl;
+        throw std::invalid_argument("DistributedMatrix::operator-: dimension mismatch");
+    }
+    DistributedMatrix C(*this);
+    for (size_t k = 0; k < a.size(); k++)
+        C.a[k] -= B.a[k];
+    return C;
+}
+
+DistributedMatrix DistributedMatrix::operator*(const DistributedMatrix &B) const{
+    checkConformant(B, "DistributedMatrix::operator*");
+    if (n != B.m){
+        std::cerr << "DistributedMatrix::operator*: dimension mismatch" << std::endl;
+        throw std::invalid_argument("DistributedMatrix::operator*: dimension mismatch");
+    }
+    LINALG_PROFILE("DistributedMatrix::operator*", 2.0 * m * n * B.n / (pr * pc), 8.0 * (lm + B.ln) * n);
+    DistributedMatrix C(*comm, m, B.n, nb);
+    MatrixView c(C.a.data(), C.lm, C.ln, C.ld());
+    std::vector<double> apanel, bpanel;
+    for (int k0 = 0; k0 < n; k0 += nb){
+        int w = std::min(nb, n - k0);
+        // my rows of the block column k of A, from the owning process column
+        int ca = owner(k0, nb, pc);
+        if (mycol == ca){
+            const double *src = a.data() + (size_t)localIndex(k0, nb, pc)*ld();
+            apanel.resize((size_t)lm * w);
+            for (int j = 0; j < w; j++)
+                std::copy(src + (size_t)j*ld(), src + (size_t)j*ld() + lm, apanel.begin() + (size_t)j*lm);
+        }
+        comm->broadcast(apanel, rankOf(myrow, ca), processRow(myrow), TAG_SUMMA_A);
+        // my columns of the block row k of B, from the owning process row
+        int rb = owner(k0, nb, pr);
+        if (myrow == rb){
+            int r0 = localIndex(k0, nb, pr);
+            bpanel.resize((size_t)w * B.ln);
+            for (int j = 0; j < B.ln; j++)
+                std::copy(B.a.begin() + (size_t)j*B.ld() + r0, B.a.begin() + (size_t)j*B.ld() + r0 + w, bpanel.begin() + (size_t)j*w);
+        }
+        comm->broadcast(bpanel, rankOf(rb, mycol), processColumn(mycol), TAG_SUMMA_B);
+        if (lm > 0 && B.ln > 0)
+            ::gemm(1, ConstMatrixView(apanel.data(), lm, w, lm), ConstMatrixView(bpanel.data(), w, B.ln, w), 1, c);
+    }
+    return C;
+}
+
+DistributedLU DistributedMatrix::lu() const{
+    return DistributedLU(*this);
+}
+
+Vector DistributedMatrix::solve(const Vector &b) const{
+    return lu().solve(b);
+}
+
+// ===================== LU ============================= //
+
+DistributedLU::DistributedLU(const DistributedMatrix &A): f{A}, piv(A.m), sign{1}, singular{false}
+{
+    if (A.m != A.n){
+        std::cerr << "DistributedLU: matrix is not square" << std::endl;
+        throw std::invalid_argument("DistributedLU: matrix is not square");
+    }
+    int n = f.n, nb = f.nb, pr = f.pr, pc = f.pc;
+    LINALG_PROFILE("DistributedLU::DistributedLU", 2.0 / 3.0 * n * n * n / (pr * pc), 8.0 * n * n * n / 3 / (pr * pc));
+    Transport &comm = *f.comm;
+    std::vector<double> pivots, l11, l21, u12;
+    for (int k0 = 0; k0 < n; k0 += nb){
+        int jb = std::min(nb, n - k0);
+        int kr = owner(k0, nb, pr), kc = owner(k0, nb, pc);
+        // the pivot rows and a singularity flag, found by the panel's process column
+        pivots.assign(jb + 1, 0);
+        if (f.mycol == kc)
+            factorPanel(k0, jb, pivots);
+        comm.broadcast(pivots, f.rankOf(0, kc), f.everyone(), TAG_PIVOTS);
+        if (pivots[jb] != 0)
+            singular = true;
+        for (int t = 0; t < jb; t++){
+            int j = k0 + t, p = (int)pivots[t];
+            piv[j] = p;
+            if (p != j){
+                sign = -sign;
+                swapRows(j, p, k0, jb);
+            }
+        }
+        if (k0 + jb >= n)
+            break;
+        long ld = f.ld();
+        // U12 = L11^-1 A12 on the process row of the diagonal block
+        if (f.myrow == kr){
+            int li = localIndex(k0, nb, pr);
+            if (f.mycol == kc){
+                l11.resize((size_t)jb * jb);
+                const double *src = f.a.data() + (size_t)localIndex(k0, nb, pc)*ld + li;
+                for (int j = 0; j < jb; j++)
+                    std::copy(src + (size_t)j*ld, src + (size_t)j*ld + jb, l11.begin() + (size_t)j*jb);
+            }
+            comm.broadcast(l11, f.rankOf(kr, kc), f.processRow(kr), TAG_L11);
+            for (int lj = localCount(k0 + jb, nb, f.mycol, pc); lj < f.ln; lj++){
+                double *x = f.a.data() + (size_t)lj*ld + li;
+                for (int k = 0; k < jb; k++){
+                    double xk = x[k];
+                    if (xk != 0)
+                        for (int i = k + 1; i < jb; i++)
+                            x[i] -= xk * l11[(size_t)k*jb + i];
+                }
+            }
+        }
+        // L21 along the process rows, U12 down the process columns, then the local trailing update
+        int r0 = localCount(k0 + jb, nb, f.myrow, pr), rows = f.lm - r0;
+        int c0 = localCount(k0 + jb, nb, f.mycol, pc), cols = f.ln - c0;
+        if (f.mycol == kc){
+            l21.resize((size_t)rows * jb);
+            const double *src = f.a.data() + (size_t)localIndex(k0, nb, pc)*ld + r0;
+            for (int j = 0; j < jb; j++)
+                std::copy(src + (size_t)j*ld, src + (size_t)j*ld + rows, l21.begin() + (size_t)j*rows);
+        }
+        comm.broadcast(l21, f.rankOf(f.myrow, kc), f.processRow(f.myrow), TAG_L21);
+        if (f.myrow == kr){
+            u12.resize((size_t)jb * cols);
+            const double *src = f.a.data() + (size_t)c0*ld + localIndex(k0, nb, pr);
+            for (int j = 0; j < cols; j++)
+                std::copy(src + (size_t)j*ld, src + (size_t)j*ld + jb, u12.begin() + (size_t)j*jb);
+        }
+        comm.broadcast(u12, f.rankOf(kr, f.mycol), f.processColumn(f.mycol), TAG_U12);
+        if (rows > 0 && cols > 0)
+            ::gemm(-1, ConstMatrixView(l21.data(), rows, jb, rows), ConstMatrixView(u12.data(), jb, cols, jb), 1,
+                MatrixView(f.a.data() + (size_t)c0*ld + r0, rows, cols, ld));
+    }
+}
+
+// Unblocked LU of columns k0 .. k0+jb-1 (rows k0 .. n-1), run by the process column owning them.
+// pivots receives the global pivot rows, and a nonzero last entry if an exactly zero pivot was met.
+void DistributedLU::factorPanel(int k0, int jb, std::vector<double> &pivots){
+    Transport &comm = *f.comm;
+    int nb = f.nb, pr = f.pr;
+    long ld = f.ld();
+    std::vector<int> column = f.processColumn(f.mycol);
+    int lc = localIndex(k0, nb, f.pc);
+    double *panel = f.a.data() + (size_t)lc*ld;
+    std::vector<double> best(2), rowp, rowj;
+    for (int t = 0; t < jb; t++){
+        int j = k0 + t;
+        // pivot search: the largest magnitude below the diagonal, ties going to the smallest row
+        best = {-1, -1};
+        for (int li = localCount(j, nb, f.myrow, pr); li < f.lm; li++)
+            if (std::abs(panel[(size_t)t*ld + li]) > best[0])
+                best = {std::abs(panel[(size_t)t*ld + li]), (double)globalIndex(li, nb, f.myrow, pr)};
+        if (f.myrow == 0){
+            for (int r = 1; r < pr; r++){
+                std::vector<double> other = comm.receive(f.rankOf(r, f.mycol), TAG_PIVOT_SEARCH);
+                if (other[0] > best[0] || (other[0] == best[0] && other[1] >= 0 && (best[1] < 0 || other[1] < best[1])))
+                    best = other;
+            }
+        }
+        else
+            comm.send(f.rankOf(0, f.mycol), TAG_PIVOT_SEARCH, best);
+        comm.broadcast(best, f.rankOf(0, f.mycol), column, TAG_PIVOT_SEARCH);
+        int p = (int)best[1];
+        pivots[t] = p;
+        // exchange the panel parts of rows j and p, and keep the pivot row for the update
+        int rj = owner(j, nb, pr), rp = owner(p, nb, pr);
+        auto pack = [&](int g, std::vector<double> &row){
+            row.resize(jb);
+            int li = localIndex(g, nb, pr);
+            for (int s = 0; s < jb; s++)
+                row[s] = panel[(size_t)s*ld + li];
+        };
+        auto unpack = [&](int g, const std::vector<double> &row){
+            int li = localIndex(g, nb, pr);
+            for (int s = 0; s < jb; s++)
+                panel[(size_t)s*ld + li] = row[s];
+        };
+        if (f.myrow == rp)
+            pack(p, rowp);
+        comm.broadcast(rowp, f.rankOf(rp, f.mycol), column, TAG_PIVOT_ROW);
+        if (p != j){
+            if (f.myrow == rj)
+                pack(j, rowj);
+            comm.broadcast(rowj, f.rankOf(rj, f.mycol), column, TAG_PIVOT_ROW);
+            if (f.myrow == rp)
+                unpack(p, rowj);
+            if (f.myrow == rj)
+                unpack(j, rowp);
+        }
+        if (rowp[t] == 0){
+            pivots[jb] = 1;
+            continue;
+        }
+        // scale the column below the pivot and update the rest of the panel
+        double inv = 1 / rowp[t];
+        for (int li = localCount(j + 1, nb, f.myrow, pr); li < f.lm; li++){
+            double l = panel[(size_t)t*ld + li] *= inv;
+            if (l != 0)
+                for (int s = t + 1; s < jb; s++)
+                    panel[(size_t)s*ld + li] -= l * rowp[s];
+        }
+    }
+}
+
+// Interchanges rows j and p outside the panel columns k0 .. k0+jb-1.
+void DistributedLU::swapRows(int j, int p, int k0, int jb){
+    int nb = f.nb, pr = f.pr, pc = f.pc;
+    int rj = owner(j, nb, pr), rp = owner(p, nb, pr);
+    if (f.myrow != rj && f.myrow != rp)
+        return;
+    long ld = f.ld();
+    // my columns outside the panel
+    int skip0 = localCount(k0, nb, f.mycol, pc), skip1 = localCount(k0 + jb, nb, f.mycol, pc);
+    if (rj == rp){
+        int lj = localIndex(j, nb, pr), lp = localIndex(p, nb, pr);
+        for (int c = 0; c < f.ln; c++)
+            if (c < skip0 || c >= skip1)
+                std::swap(f.a[(size_t)c*ld + lj], f.a[(size_t)c*ld + lp]);
+        return;
+    }
+    int mine = localIndex(f.myrow == rj ? j : p, nb, pr), partner = f.rankOf(f.myrow == rj ? rp : rj, f.mycol);
+    std::vector<double> row;
+    row.reserve(f.ln);
+    for (int c = 0; c < f.ln; c++)
+        if (c < skip0 || c >= skip1)
+            row.push_back(f.a[(size_t)c*ld + mine]);
+    f.comm->send(partner, TAG_SWAP, row);
+    row = f.comm->receive(partner, TAG_SWAP);
+    size_t k = 0;
+    for (int c = 0; c < f.ln; c++)
+        if (c < skip0 || c >= skip1)
+            f.a[(size_t)c*ld + mine] = row[k++];
+}
+
+double DistributedLU::det() const{
+    int n = f.n;
+    std::vector<double> diag(n);
+    for (int i = 0; i < n; i++)
+        if (f.isLocal(i, i))
+            diag[i] = f.at(i, i);
+    f.comm->allSum(diag, f.everyone(), TAG_DET);
+    double d = sign;
+    for (double u: diag)
+        d *= u;
+    return d;
+}
+
+Vector DistributedLU::solve(const Vector &b) const{
+    int n = f.n, nb = f.nb, pr = f.pr, pc = f.pc;
+    if (b.size() != n){
+        std::cerr << "DistributedLU::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("DistributedLU::solve: dimension mismatch");
+    }
+    if (singular){
+        std::cerr << "DistributedLU::solve: matrix is singular" << std::endl;
+        throw std::domain_error("DistributedLU::solve: matrix is singular");
+    }
+    LINALG_PROFILE("DistributedLU::solve", 2.0 * n * n / (pr * pc), 8.0 * n * n / (pr * pc));
+    Transport &comm = *f.comm;
+    long ld = f.ld();
+    Vector x(b);
+    for (int k = 0; k < n; k++)
+        if (piv[k] != k)
+            std::swap(x[k], x[piv[k]]);
+    std::vector<double> block;
+    // Block k of x needs the products of the blocks left (right, for U) of the diagonal block with the blocks of x already
+    // solved: the process row of block k sums them onto the owner of the diagonal block, which solves and broadcasts.
+    auto step = [&](int k0, bool lower){
+        int jb = std::min(nb, n - k0);
+        int kr = owner(k0, nb, pr), kc = owner(k0, nb, pc), root = f.rankOf(kr, kc);
+        if (f.myrow == kr){
+            int li = localIndex(k0, nb, pr);
+            block.assign(jb, 0);
+            int c0 = lower ? 0 : localCount(k0 + jb, nb, f.mycol, pc), c1 = lower ? localCount(k0, nb, f.mycol, pc) : f.ln;
+            for (int c = c0; c < c1; c++){
+                double xc = x[globalIndex(c, nb, f.mycol, pc)];
+                if (xc != 0)
+                    for (int i = 0; i < jb; i++)
+                        block[i] += f.a[(size_t)c*ld + li + i] * xc;
+            }
+            comm.sum(block, root, f.processRow(kr), TAG_SOLVE);
+            if (f.mycol == kc){
+                const double *d = f.a.data() + (size_t)localIndex(k0, nb, pc)*ld + li;
+                for (int i = 0; i < jb; i++)
+                    block[i] = x[k0 + i] - block[i];
+                if (lower){
+                    for (int k = 0; k < jb; k++)
+                        for (int i = k + 1; i < jb; i++)
+                            block[i] -= block[k] * d[(size_t)k*ld + i];
+                }
+                else{
+                    for (int k = jb - 1; k >= 0; k--){
+                        block[k] /= d[(size_t)k*ld + k];
+                        for (int i = 0; i < k; i++)
+                            block[i] -= block[k] * d[(size_t)k*ld + i];
+                    }
+                }
+            }
+        }
+        comm.broadcast(block, root, f.everyone(), TAG_SOLVE);
+        std::copy(block.begin(), block.end(), x.data() + k0);
+    };
+    for (int k0 = 0; k0 < n; k0 += nb)
+        step(k0, true);
+    for (int k0 = ((n - 1) / nb) * nb; n > 0 && k0 >= 0; k0 -= nb)
+        step(k0, false);
+    return x;
+}
@@ -0,0 +1,142 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <functional>
+#include "Matrix.h"
+#include "transport.h"
+
+#pragma once
+
+// Matrices spread over the ranks of a Transport in a 2D block-cyclic layout (as in ScaLAPACK): the ranks form a pr*pc grid
+// (pr the largest divisor of the rank count not above its square root, rank = row*pc + column), the matrix is cut into
+// nb*nb blocks, and block (I, J) lives on grid process (I mod pr, J mod pc). Every rank stores only its own blocks, as one
+// column-major local matrix, so the memory and the flops of a product or a factorization are split evenly over the ranks.
+//
+// The operations are collective: every rank of the transport calls them, in the same order, with the same arguments
+// (vectors and matrices passed in are replicated, that is equal on all ranks).
+
+class DistributedLU;
+
+/**
+ * @brief Matrix distributed block-cyclically over the ranks of a Transport. Mirrors Matrix where the operation
+ * makes sense for distributed data; gather() brings it back into one Matrix.
+ *
+ */
+class DistributedMatrix{
+    friend class DistributedLU;
+    Transport *comm;
+    int m, n, nb;
+    int pr, pc, myrow, mycol;
+    int lm, ln;
+    std::vector<double> a;
+
+    long ld() const{ return std::max(1, lm); }
+    int rankOf(int r, int c) const{ return r*pc + c; }
+    std::vector<int> processRow(int r) const;
+    std::vector<int> processColumn(int c) const;
+    std::vector<int> everyone() const;
+    void checkConformant(const DistributedMatrix &B, const char *where) const;
+public:
+    /**
+     * @brief The zero m*n matrix distributed over the ranks of comm, in blocks of nb*nb.
+     * comm must outlive the matrix.
+     */
+    DistributedMatrix(Transport &comm, int m, int n, int nb = 64);
+
+    /**
+     * @brief Distributes A, which every rank passes (only the local blocks are kept).
+     */
+    DistributedMatrix(Transport &comm, const Matrix &A, int nb = 64);
+
+    /**
+     * @brief Fills the local blocks with f(i, j), so that no rank ever holds the whole matrix.
+     */
+    DistributedMatrix(Transport &comm, int m, int n, const std::function<double(int, int)> &f, int nb = 64);
+
+    /**
+     * @brief returns the (global) order of the matrix as the pair {rows, columns}.
+     */
+    std::pair<int, int> order() const{ return {m, n}; }
+
+    /**
+     * @brief returns the process grid as the pair {rows, columns}.
+     */
+    std::pair<int, int> grid() const{ return {pr, pc}; }
+
+    int blockSize() const{ return nb; }
+    Transport &transport() const{ return *comm; }
+
+    /**
+     * @brief whether element (i, j) is stored on this rank.
+     */
+    bool isLocal(int i, int j) const;
+
+    /**
+     * @brief element (i, j), which must be stored on this rank (see isLocal); throws out_of_range otherwise.
+     */
+    double &at(int i, int j);
+    double at(int i, int j) const;
+
+    /**
+     * @brief Collective: assembles the whole matrix on every rank.
+     */
+    Matrix gather() const;
+
+    DistributedMatrix operator+(const DistributedMatrix &B) const;
+    DistributedMatrix operator-(const DistributedMatrix &B) const;
+
+    /**
+     * @brief Collective SUMMA product: for every block column of this matrix (block row of B), the owners broadcast it
+     * along their process rows (process columns for B) and every rank multiplies the two panels it received into its
+     * blocks of the result. Both operands must share the transport and the block size.
+     */
+    DistributedMatrix operator*(const DistributedMatrix &B) const;
+
+    /**
+     * @brief Collective LU factorization with partial pivoting (see DistributedLU).
+     */
+    DistributedLU lu() const;
+
+    /**
+     * @brief Collective: solves Ax = b for a square nonsingular A through lu(); b and x are replicated.
+     */
+    Vector solve(const Vector &b) const;
+};
+
+/**
+ * @brief Right-looking blocked LU factorization PA = LU of a distributed square matrix, along the lines of ScaLAPACK's pdgetrf:
+ * each panel of nb columns is factorized by its process column (pivot search and row swaps with messages in that column only),
+ * the row interchanges are applied to the other columns, U12 is solved on the process row of the diagonal block, and the
+ * trailing matrix is updated by a local gemm once L21 and U12 have been broadcast along the process rows and columns.
+ *
+ */
+class DistributedLU{
+    DistributedMatrix f;
+    std::vector<int> piv;
+    int sign;
+    bool singular;
+
+    void factorPanel(int k0, int jb, std::vector<double> &pivots);
+    void swapRows(int j, int p, int k0, int jb);
+public:
+    /**
+     * @brief Collective: factorizes A. A singular matrix is factorized too; isSingular() reports it.
+     */
+    DistributedLU(const DistributedMatrix &A);
+
+    int order() const{ return f.m; }
+    bool isSingular() const{ return singular; }
+
+    /**
+     * @brief Collective: the determinant, from the diagonal of U.
+     */
+    double det() const;
+
+    /**
+     * @brief Collective: solves Ax = b by blocked forward and back substitution; b and x are replicated.
+     * Throws a domain_error if A is singular.
+     */
+    Vector solve(const Vector &b) const;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <numeric>
+#include "elementaryOps.h"
+
+// rows per block when replaying on columns: the touched part of every column stays in cache while all operations run
+#define ELEMENTARY_ROW_BLOCK 256
+
+ElementaryProgram::ElementaryProgram(int n): n{n}, perm(n){
+    if (n < 0){
+        std::cerr << "ElementaryProgram: negative order" << std::endl;
+        throw std::invalid_argument("ElementaryProgram: negative order");
+    }
+    std::iota(perm.begin(), perm.end(), 0);
+}
+
+void ElementaryProgram::checkIndex(int i) const{
+    if (i < 0 || i >= n){
+        std::cerr << "ElementaryProgram: index out of range" << std::endl;
+        throw std::out_of_range("ElementaryProgram: index out of range");
+    }
+}
+
+void ElementaryProgram::record(const Step &s){
+    steps.push_back(s);
+    // compile on the fly: swaps relabel the slots, the other operations are rewritten onto the slots
+    switch (s.type){
+        case ElementaryOp::Swap: std::swap(perm[s.j], perm[s.k]); break;
+        case ElementaryOp::Scale: ops.push_back({s.type, perm[s.j], perm[s.j], s.lambda}); break;
+        case ElementaryOp::Add: ops.push_back({s.type, perm[s.j], perm[s.k], s.lambda}); break;
+    }
+}
+
+ElementaryProgram &ElementaryProgram::scale(int j, double c){
+    checkIndex(j);
+    if (std::abs(c) < EPSILON){
+        std::cerr << "error in scale: scaling by 0 is not allowed.\n";
+        throw std::invalid_argument("error in scale: scaling by 0 is not allowed.");
+    }
+    if (c != 1)
+        record({ElementaryOp::Scale, j, j, c});
+    return *this;
+}
+
+ElementaryProgram &ElementaryProgram::swap(int j, int k){
+    checkIndex(j);
+    checkIndex(k);
+    if (j != k)
+        record({ElementaryOp::Swap, j, k, 0});
+    return *this;
+}
+
+ElementaryProgram &ElementaryProgram::add(int j, int k, double lambda){
+    checkIndex(j);
+    checkIndex(k);
+    if (j == k){
+        std::cerr << "error in add: j and k must differ, use scale instead.\n";
+        throw std::invalid_argument("error in add: j and k must differ, use scale instead.");
+    }
+    if (lambda != 0)
+        record({ElementaryOp::Add, j, k, lambda});
+    return *this;
+}
+
+ElementaryProgram &ElementaryProgram::append(ElementaryOp type, int j, int k, double lambda){
+    switch (type){
+        case ElementaryOp::Scale: return scale(j, lambda);
+        case ElementaryOp::Swap: return swap(j, k);
+        case ElementaryOp::Add: return add(j, k, lambda);
+    }
+    return *this;
+}
+
+ElementaryProgram ElementaryProgram::then(const ElementaryProgram &next) const{
+    if (next.n != n){
+        std::cerr << "ElementaryProgram::then: orders do not match" << std::endl;
+        throw std::invalid_argument("ElementaryProgram::then: orders do not match");
+    }
+    ElementaryProgram res(*this);
+    for (const Step &s: next.steps)
+        res.record(s);
+    return res;
+}
+
+ElementaryProgram ElementaryProgram::inverse() const{
+    ElementaryProgram res(n);
+    for (auto it = steps.rbegin(); it != steps.rend(); it++){
+        Step s = *it;
+        if (s.type == ElementaryOp::Scale)
+            s.lambda = 1 / s.lambda;
+        else if (s.type == ElementaryOp::Add)
+            s.lambda = -s.lambda;
+        res.record(s);
+    }
+    return res;
+}
+
+void ElementaryProgram::applyToColumn(double *x, double *buffer) const{
+    for (const Step &s: ops){
+        if (s.type == ElementaryOp::Scale)
+            x[s.j] *= s.lambda;
+        else
+            x[s.j] += s.lambda * x[s.k];
+    }
+    for (int i = 0; i < n; i++)
+        buffer[i] = x[perm[i]];
+    std::copy(buffer, buffer + n, x);
+}
+
+void ElementaryProgram::applyToRows(Matrix &A) const{
+    if (A.order().first != n){
+        std::cerr << "ElementaryProgram::applyToRows: dimension mismatch" << std::endl;
+        throw std::invalid_argument("ElementaryProgram::applyToRows: dimension mismatch");
+    }
+    std::vector<double> buffer(n);
+    // every column gets all the operations while it is in cache, instead of one strided sweep over the matrix per operation
+    for (int j = 0; j < A.order().second; j++)
+        applyToColumn(A.at(j).data(), buffer.data());
+}
+
+void ElementaryProgram::apply(Vector &v) const{
+    if (v.size() != n){
+        std::cerr << "ElementaryProgram::apply: dimension mismatch" << std::endl;
+        throw std::invalid_argument("ElementaryProgram::apply: dimension mismatch");
+    }
+    std::vector<double> buffer(n);
+    applyToColumn(v.data(), buffer.data());
+}
+
+void ElementaryProgram::applyToColumns(Matrix &A) const{
+    if (A.order().second != n){
+        std::cerr << "ElementaryProgram::applyToColumns: dimension mismatch" << std::endl;
+        throw std::invalid_argument("ElementaryProgram::applyToColumns: dimension mismatch");
+    }
+    int m = A.order().first;
+    std::vector<double *> cols(n);
+    for (int j = 0; j < n; j++)
+        cols[j] = A.at(j).data();
+    for (int r0 = 0; r0 < m; r0 += ELEMENTARY_ROW_BLOCK){
+        int r1 = std::min(m, r0 + ELEMENTARY_ROW_BLOCK);
+        for (const Step &s: ops){
+            double *x = cols[s.j] + r0;
+            int len = r1 - r0;
+            if (s.type == ElementaryOp::Scale)
+                for (int i = 0; i < len; i++)
+                    x[i] *= s.lambda;
+            else{
+                const double *y = cols[s.k] + r0;
+                for (int i = 0; i < len; i++)
+                    x[i] += s.lambda * y[i];
+            }
+        }
+    }
+    // column i of the result is slot perm[i]: move whole columns, following the cycles of the permutation
+    std::vector<bool> done(n);
+    for (int i = 0; i < n; i++){
+        if (done[i])
+            continue;
+        Vector tmp;
+        std::swap(tmp, A.at(i));
+        int j = i;
+        while (perm[j] != i){
+            std::swap(A.at(j), A.at(perm[j]));
+            done[j] = true;
+            j = perm[j];
+        }
+        std::swap(A.at(j), tmp);
+        done[j] = true;
+    }
+}
+
+SquareMatrix ElementaryProgram::toMatrix() const{
+    SquareMatrix E(n, true);
+    applyToRows(E);
+    return E;
+}
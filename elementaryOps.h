@@ -0,0 +1,102 @@
+#ifndef ELEMENTARYOPS_H
+#define ELEMENTARYOPS_H
+
+#include <vector>
+#include "squareMatrix.h"
+
+#pragma once
+
+/**
+ * @brief A recorded sequence of elementary operations on n rows (or columns), which can be replayed on any number of
+ * matrices and vectors, inverted and composed without touching a matrix.
+ *
+ * The sequence is compiled once into a list of scale/add steps on fixed slots followed by one permutation: a swap only
+ * relabels slots, so no data moves until the final gather. Replaying then makes one pass over each column.
+ *
+ * @note Applied to rows, the program computes E*A, where E is the product of the elementary matrices (see toMatrix).
+ * Applied to columns, the same operations compute A*E^T.
+ */
+class ElementaryProgram{
+    struct Step{
+        ElementaryOp type;
+        int j, k;
+        double lambda;
+    };
+    int n;
+    // the operations as recorded
+    std::vector<Step> steps;
+    // compiled form: Scale/Add steps on slots, then logical index i is found in slot perm[i]
+    std::vector<Step> ops;
+    std::vector<int> perm;
+
+    void checkIndex(int i) const;
+    void record(const Step &s);
+    void applyToColumn(double *x, double *buffer) const;
+public:
+    /**
+     * @brief Construct the empty program (the identity) on n rows or columns.
+     */
+    ElementaryProgram(int n = 0);
+
+    /**
+     * @brief Returns the number of rows (or columns) the program acts on.
+     */
+    int order() const{ return n; }
+
+    /**
+     * @brief Returns the number of recorded operations.
+     */
+    int size() const{ return steps.size(); }
+
+    /**
+     * @brief Appends R_j = c*R_j. Throws invalid_argument if c is (numerically) zero.
+     */
+    ElementaryProgram &scale(int j, double c);
+
+    /**
+     * @brief Appends R_j <-> R_k.
+     */
+    ElementaryProgram &swap(int j, int k);
+
+    /**
+     * @brief Appends R_j = R_j + lambda*R_k (j != k).
+     */
+    ElementaryProgram &add(int j, int k, double lambda);
+
+    /**
+     * @brief Appends an operation given by its type, see Matrix::elementaryRowOperation.
+     */
+    ElementaryProgram &append(ElementaryOp type, int j, int k, double lambda = 0);
+
+    /**
+     * @brief Returns the program performing this one and then next (E_next * E_this), without replaying either.
+     */
+    ElementaryProgram then(const ElementaryProgram &next) const;
+
+    /**
+     * @brief Returns the program undoing this one: the inverse operations in reverse order.
+     */
+    ElementaryProgram inverse() const;
+
+    /**
+     * @brief Replays the operations on the rows of A, i.e. A = E*A, making one pass over each column.
+     */
+    void applyToRows(Matrix &A) const;
+
+    /**
+     * @brief Replays the operations on the columns of A, i.e. A = A*E^T. Swaps become a single permutation of the columns, which moves no elements.
+     */
+    void applyToColumns(Matrix &A) const;
+
+    /**
+     * @brief Replays the operations on the entries of v, i.e. v = E*v.
+     */
+    void apply(Vector &v) const;
+
+    /**
+     * @brief Returns the n*n matrix E of the program.
+     */
+    SquareMatrix toMatrix() const;
+};
+
+#endif
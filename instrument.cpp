@@ -0,0 +1,164 @@
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "instrument.h"
+
+namespace{
+
+thread_local unsigned long long thread_allocs = 0, thread_alloc_bytes = 0;
+// set while the profiler itself allocates, so its bookkeeping is not charged to the enclosing scopes
+thread_local bool bookkeeping = false;
+
+struct TraceEvent{
+    const char *name;
+    double start_us, duration_us;
+    size_t tid;
+};
+
+const size_t max_trace_events = 1000000;
+// trace timestamps are relative to the loading of the library
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+struct Registry{
+    std::mutex lock;
+    std::map<std::string, ProfileStats> stats;
+    std::vector<TraceEvent> events;
+};
+
+// never destroyed, so instrumented code running in static destructors or atexit handlers can still record
+Registry &registry(){
+    static Registry *r = new Registry;
+    return *r;
+}
+
+void writeReports(){
+    if (const char *path = std::getenv("LINALG_PROFILE_OUT")){
+        std::ofstream out(path);
+        Profiler::writeJson(out);
+    }
+    if (const char *path = std::getenv("LINALG_TRACE_OUT")){
+        std::ofstream out(path);
+        Profiler::writeChromeTrace(out);
+    }
+}
+
+// the reports are written when the program exits, after what main recorded
+const bool reports_registered = (std::atexit(writeReports), true);
+
+void writeEscaped(std::ostream &ost, const std::string &s){
+    ost << '"';
+    for (char c: s){
+        if (c == '"' || c == '\\')
+            ost << '\\';
+        ost << c;
+    }
+    ost << '"';
+}
+
+}
+
+bool Profiler::enabled(){
+#ifdef LINALG_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profiler::countAllocation(std::size_t bytes){
+    if (!bookkeeping){
+        thread_allocs++;
+        thread_alloc_bytes += bytes;
+    }
+}
+
+unsigned long long Profiler::threadAllocations(){
+    return thread_allocs;
+}
+
+unsigned long long Profiler::threadAllocatedBytes(){
+    return thread_alloc_bytes;
+}
+
+void Profiler::record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+    double flops, double bytes, unsigned long long allocations, unsigned long long allocated_bytes){
+    bookkeeping = true;
+    Registry &r = registry();
+    {
+        std::lock_guard<std::mutex> guard(r.lock);
+        ProfileStats &s = r.stats[name];
+        s.calls++;
+        s.seconds += std::chrono::duration<double>(end - start).count();
+        s.flops += flops;
+        s.bytes += bytes;
+        s.allocations += allocations;
+        s.allocated_bytes += allocated_bytes;
+        if (r.events.size() < max_trace_events)
+            r.events.push_back({name, std::chrono::duration<double, std::micro>(start - epoch).count(),
+                std::chrono::duration<double, std::micro>(end - start).count(), std::hash<std::thread::id>()(std::this_thread::get_id())});
+    }
+    bookkeeping = false;
+}
+
+void Profiler::reset(){
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.stats.clear();
+    r.events.clear();
+}
+
+ProfileStats Profiler::stats(const std::string &name){
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    auto it = r.stats.find(name);
+    return it == r.stats.end() ? ProfileStats() : it->second;
+}
+
+void Profiler::report(std::ostream &ost){
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    ost << std::left << std::setw(28) << "routine" << std::right << std::setw(10) << "calls" << std::setw(14) << "time (ms)"
+        << std::setw(12) << "GFLOP/s" << std::setw(12) << "GB/s" << std::setw(12) << "allocs" << std::setw(16) << "alloc bytes" << '\n';
+    for (auto &entry: r.stats){
+        const ProfileStats &s = entry.second;
+        double gflops = s.seconds > 0 ? s.flops / s.seconds * 1e-9 : 0, gbs = s.seconds > 0 ? s.bytes / s.seconds * 1e-9 : 0;
+        ost << std::left << std::setw(28) << entry.first << std::right << std::setw(10) << s.calls << std::setw(14) << s.seconds * 1e3
+            << std::setw(12) << gflops << std::setw(12) << gbs << std::setw(12) << s.allocations << std::setw(16) << s.allocated_bytes << '\n';
+    }
+}
+
+void Profiler::writeJson(std::ostream &ost){
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    ost << "{\n";
+    size_t i = 0;
+    for (auto &entry: r.stats){
+        const ProfileStats &s = entry.second;
+        ost << "  ";
+        writeEscaped(ost, entry.first);
+        ost << ": {\"calls\": " << s.calls << ", \"seconds\": " << s.seconds << ", \"flops\": " << s.flops << ", \"bytes\": " << s.bytes
+            << ", \"allocations\": " << s.allocations << ", \"allocated_bytes\": " << s.allocated_bytes << "}"
+            << (++i < r.stats.size() ? "," : "") << "\n";
+    }
+    ost << "}\n";
+}
+
+void Profiler::writeChromeTrace(std::ostream &ost){
+    Registry &r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    ost << "{\"traceEvents\": [\n";
+    for (size_t i = 0; i < r.events.size(); i++){
+        const TraceEvent &e = r.events[i];
+        ost << "  {\"name\": ";
+        writeEscaped(ost, e.name);
+        ost << ", \"cat\": \"linalg\", \"ph\": \"X\", \"ts\": " << std::fixed << std::setprecision(3) << e.start_us
+            << ", \"dur\": " << e.duration_us << std::defaultfloat << ", \"pid\": 0, \"tid\": " << (e.tid % 1000000) << "}"
+            << (i + 1 < r.events.size() ? "," : "") << "\n";
+    }
+    ost << "]}\n";
+}
@@ -0,0 +1,130 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#pragma once
+
+// Opt-in instrumentation. Configure with -DLINALG_INSTRUMENT=ON (or compile everything with -DLINALG_INSTRUMENT)
+// to record, for every instrumented routine, the call count, wall time, estimated flops, bytes moved and heap allocations.
+// Without it LINALG_PROFILE expands to nothing and the Profiler reports are empty.
+//
+// Setting the environment variable LINALG_PROFILE_OUT (or LINALG_TRACE_OUT) to a file name writes the JSON report
+// (or the Chrome trace, viewable in chrome://tracing or Perfetto) when the program exits.
+//
+// The library does not replace the global operator new. Heap allocations are counted when the program's own replacement
+// calls Profiler::countAllocation, as the benchmark suite does; otherwise they are reported as zero.
+
+#ifdef LINALG_INSTRUMENT
+#define LINALG_PROFILE_CONCAT_(a, b) a##b
+#define LINALG_PROFILE_CONCAT(a, b) LINALG_PROFILE_CONCAT_(a, b)
+/**
+ * @brief Profiles the enclosing scope under the given name.
+ *
+ * @param name string literal naming the routine
+ * @param flops estimated floating point operations of the call
+ * @param bytes estimated bytes read and written by the call
+ */
+#define LINALG_PROFILE(name, flops, bytes) ProfileScope LINALG_PROFILE_CONCAT(linalg_profile_, __LINE__)(name, flops, bytes)
+#else
+#define LINALG_PROFILE(name, flops, bytes) ((void)0)
+#endif
+
+/**
+ * @brief Aggregated statistics of one instrumented routine. Times and counts are inclusive of nested instrumented calls.
+ *
+ */
+struct ProfileStats{
+    unsigned long long calls = 0;
+    double seconds = 0;
+    double flops = 0;
+    double bytes = 0;
+    unsigned long long allocations = 0;
+    unsigned long long allocated_bytes = 0;
+};
+
+/**
+ * @brief Global registry of the instrumentation records.
+ *
+ */
+class Profiler{
+public:
+    /**
+     * @brief Checks if the library was compiled with instrumentation.
+     */
+    static bool enabled();
+
+    /**
+     * @brief Clears all recorded statistics and trace events.
+     */
+    static void reset();
+
+    /**
+     * @brief Returns the statistics recorded for a routine (all zero if it was never called).
+     *
+     * @param name the routine name, e.g. "Matrix::operator*"
+     */
+    static ProfileStats stats(const std::string &name);
+
+    /**
+     * @brief Writes a table of the recorded statistics, one routine per line.
+     */
+    static void report(std::ostream &ost = std::cout);
+
+    /**
+     * @brief Writes the recorded statistics as a JSON object keyed by routine name.
+     */
+    static void writeJson(std::ostream &ost);
+
+    /**
+     * @brief Writes the recorded calls in the Chrome trace event format (one complete event per call).
+     * At most the first million calls are kept for the trace; the statistics are always complete.
+     */
+    static void writeChromeTrace(std::ostream &ost);
+
+    /**
+     * @brief Counts a heap allocation of the given size on the current thread. Meant to be called from a replacement of
+     * the global operator new in the program, which the allocation statistics rely on.
+     */
+    static void countAllocation(std::size_t bytes);
+
+    /**
+     * @brief Heap allocations made by the current thread so far, as counted by countAllocation.
+     */
+    static unsigned long long threadAllocations();
+
+    /**
+     * @brief Heap bytes allocated by the current thread so far, as counted by countAllocation.
+     */
+    static unsigned long long threadAllocatedBytes();
+
+    // used by ProfileScope
+    static void record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+        double flops, double bytes, unsigned long long allocations, unsigned long long allocated_bytes);
+};
+
+/**
+ * @brief RAII helper behind LINALG_PROFILE: measures the lifetime of the scope and records it with the Profiler.
+ *
+ */
+class ProfileScope{
+    const char *name;
+    double flops, bytes;
+    unsigned long long allocs0, alloc_bytes0;
+    std::chrono::steady_clock::time_point start;
+public:
+    ProfileScope(const char *name, double flops, double bytes): name{name}, flops{flops}, bytes{bytes},
+        allocs0{Profiler::threadAllocations()}, alloc_bytes0{Profiler::threadAllocatedBytes()}, start{std::chrono::steady_clock::now()}{}
+    ~ProfileScope(){
+        auto end = std::chrono::steady_clock::now();
+        Profiler::record(name, start, end, flops, bytes,
+            Profiler::threadAllocations() - allocs0, Profiler::threadAllocatedBytes() - alloc_bytes0);
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope &operator=(const ProfileScope&) = delete;
+};
+
+#endif
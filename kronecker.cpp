@@ -0,0 +1,215 @@
+#include <algorithm>
+#include "kronecker.h"
+#include "view.h"
+#include "lu.h"
+#include "parallel.h"
+
+// solves with one factor below this many flops run on one thread
+#define KRONECKER_PARALLEL_MIN (1 << 18)
+
+namespace{
+
+// Y += s * B X A^T for X q*n at x and Y p*m at y (column-major, leading dimensions q and p), with the cheaper association
+void applyTerm(double s, const ConstMatrixView &A, const ConstMatrixView &B, const double *x, double *y){
+    int m = A.order().first, n = A.order().second, p = B.order().first, q = B.order().second;
+    if (s == 0 || m == 0 || n == 0 || p == 0 || q == 0)
+        return;
+    ConstMatrixView X(x, q, n, q);
+    MatrixView Y(y, p, m, p);
+    if ((double)p * n * (q + m) <= (double)q * m * (n + p)){
+        // (B X) A^T: the intermediate is p*n
+        Matrix T(p, n);
+        gemm(1, B, X, 0, T);
+        gemm(s, T, A.transposed(), 1, Y);
+    }
+    else{
+        // B (X A^T): the intermediate is q*m
+        Matrix T(q, m);
+        gemm(1, X, A.transposed(), 0, T);
+        gemm(s, B, T, 1, Y);
+    }
+}
+
+void checkSize(bool ok, const char *where){
+    if (!ok){
+        std::cerr << where << ": dimension mismatch" << std::endl;
+        throw std::invalid_argument(std::string(where) + ": dimension mismatch");
+    }
+}
+
+// x[0 .. p*m-1] = B^{-1} X for the p*m matrix X at x, one column at a time
+void solveColumns(const LU &B, double *x, int m){
+    int p = B.order();
+    parallelFor(0, m, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++)
+            B.solveInPlace(x + j * p);
+    }, 1, (double)p * p * m >= KRONECKER_PARALLEL_MIN ? 0 : 1);
+}
+
+}
+
+Kronecker::Kronecker(const Matrix &A, const Matrix &B): t{Term{1, A, B}}, m{A.order().first}, n{A.order().second},
+    p{B.order().first}, q{B.order().second}{}
+
+void Kronecker::checkConformant(const Kronecker &K, const char *where) const{
+    if (t.empty() || K.t.empty())
+        return;
+    if (m != K.m || n != K.n || p != K.p || q != K.q){
+        std::cerr << where << ": Kronecker factors of different orders" << std::endl;
+        throw std::invalid_argument(std::string(where) + ": Kronecker factors of different orders");
+    }
+}
+
+double Kronecker::at(long i, long j) const{
+    if (i < 0 || j < 0 || i >= order().first || j >= order().second){
+        std::cerr << "Index out of range" << std::endl;
+        throw std::out_of_range("Index out of range");
+    }
+    double s = 0;
+    for (auto &term: t)
+        s += term.c * term.A.at(i / p, j / q) * term.B.at(i % p, j % q);
+    return s;
+}
+
+const Kronecker &Kronecker::operator+=(const Kronecker &K){
+    checkConformant(K, "Kronecker::operator+");
+    if (t.empty()){
+        m = K.m; n = K.n; p = K.p; q = K.q;
+    }
+    t.insert(t.end(), K.t.begin(), K.t.end());
+    return *this;
+}
+
+const Kronecker &Kronecker::operator-=(const Kronecker &K){
+    return *this += K * -1;
+}
+
+Kronecker Kronecker::operator+(const Kronecker &K) const{
+    Kronecker res(*this);
+    return res += K;
+}
+
+Kronecker Kronecker::operator-(const Kronecker &K) const{
+    Kronecker res(*this);
+    return res -= K;
+}
+
+Kronecker Kronecker::operator*(double factor) const{
+    Kronecker res(*this);
+    for (auto &term: res.t)
+        term.c *= factor;
+    return res;
+}
+
+Kronecker operator*(double factor, const Kronecker &K){
+    return K * factor;
+}
+
+Kronecker Kronecker::transposed() const{
+    Kronecker res;
+    res.m = n; res.n = m; res.p = q; res.q = p;
+    for (auto &term: t)
+        res.t.push_back(Term{term.c, Matrix(ConstMatrixView(term.A).transposed()), Matrix(ConstMatrixView(term.B).transposed())});
+    return res;
+}
+
+Vector Kronecker::operator*(const Vector &x) const{
+    Vector y((int)order().first);
+    gemv(1, *this, x, 0, y);
+    return y;
+}
+
+void Kronecker::gemv(double alpha, const Kronecker &K, const Vector &x, double beta, Vector &y){
+    LINALG_PROFILE("Kronecker::gemv", 2.0 * K.terms() * std::min((double)K.p * K.n * (K.q + K.m), (double)K.q * K.m * (K.n + K.p)),
+        8.0 * (K.terms() * ((double)K.m * K.n + (double)K.p * K.q) + x.size() + 2.0 * y.size()));
+    checkSize(x.size() == K.order().second && y.size() == K.order().first, "Kronecker::gemv");
+    // y is overwritten (scaled) before x is read
+    Vector copy;
+    const double *px = x.data();
+    if (&x == &y){
+        copy = x;
+        px = copy.data();
+    }
+    if (beta == 0)
+        std::fill(y.data(), y.data() + y.size(), 0.0);
+    else if (beta != 1)
+        y *= beta;
+    for (auto &term: K.t)
+        applyTerm(alpha * term.c, term.A, term.B, px, y.data());
+}
+
+void Kronecker::gemvT(double alpha, const Kronecker &K, const Vector &x, double beta, Vector &y){
+    LINALG_PROFILE("Kronecker::gemvT", 2.0 * K.terms() * std::min((double)K.q * K.m * (K.p + K.n), (double)K.p * K.n * (K.m + K.q)),
+        8.0 * (K.terms() * ((double)K.m * K.n + (double)K.p * K.q) + x.size() + 2.0 * y.size()));
+    checkSize(x.size() == K.order().first && y.size() == K.order().second, "Kronecker::gemvT");
+    Vector copy;
+    const double *px = x.data();
+    if (&x == &y){
+        copy = x;
+        px = copy.data();
+    }
+    if (beta == 0)
+        std::fill(y.data(), y.data() + y.size(), 0.0);
+    else if (beta != 1)
+        y *= beta;
+    // (A (x) B)^T = A^T (x) B^T, applied through transposed views rather than transposed copies
+    for (auto &term: K.t)
+        applyTerm(alpha * term.c, ConstMatrixView(term.A).transposed(), ConstMatrixView(term.B).transposed(), px, y.data());
+}
+
+Vector Kronecker::solve(const Vector &b) const{
+    LINALG_PROFILE("Kronecker::solve", 2.0 / 3 * ((double)m * m * m + (double)p * p * p) + 2.0 * m * p * (m + p), 8.0 * (m * m + p * p + 3.0 * m * p));
+    checkSize(b.size() == order().first, "Kronecker::solve");
+    if (order().first != order().second){
+        std::cerr << "Kronecker::solve: the operator is not square" << std::endl;
+        throw std::domain_error("Kronecker::solve: the operator is not square");
+    }
+    if (t.size() != 1 || m != n){
+        // no factored form for a sum of terms (nor for square products of rectangular factors)
+        if (order().first > KRONECKER_DENSE_MAX){
+            std::cerr << "Kronecker::solve: too large to solve densely" << std::endl;
+            throw std::domain_error("Kronecker::solve: too large to solve densely");
+        }
+        LU lu{SquareMatrix(dense())};
+        if (lu.isSingular()){
+            std::cerr << "Kronecker::solve: singular operator" << std::endl;
+            throw std::domain_error("Kronecker::solve: singular operator");
+        }
+        return lu.solve(b);
+    }
+    const Term &term = t[0];
+    LU luA{SquareMatrix(term.A)}, luB{SquareMatrix(term.B)};
+    if (term.c == 0 || luA.isSingular() || luB.isSingular()){
+        std::cerr << "Kronecker::solve: singular operator" << std::endl;
+        throw std::domain_error("Kronecker::solve: singular operator");
+    }
+    // B X A^T = Y / c: first W = B^{-1} Y (columns of length p), then X^T = A^{-1} W^T (columns of length m)
+    Vector x(b);
+    x *= 1 / term.c;
+    solveColumns(luB, x.data(), m);
+    std::vector<double> wt((size_t)m * p);
+    MatrixView(wt.data(), m, p, m) = ConstMatrixView(x.data(), p, m, p).transposed();
+    solveColumns(luA, wt.data(), p);
+    MatrixView(x.data(), p, m, p) = ConstMatrixView(wt.data(), m, p, m).transposed();
+    return x;
+}
+
+Matrix Kronecker::dense() const{
+    LINALG_PROFILE("Kronecker::dense", (double)terms() * order().first * order().second, 8.0 * order().first * order().second);
+    Matrix K((int)order().first, (int)order().second);
+    for (auto &term: t)
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < m; i++){
+                double a = term.c * term.A.at(i, j);
+                if (a == 0)
+                    continue;
+                // block (i, j) is a*B
+                for (int jj = 0; jj < q; jj++){
+                    double *k = K.at(j * q + jj).data() + (long)i * p;
+                    const double *b = term.B.at(jj).data();
+                    for (int ii = 0; ii < p; ii++)
+                        k[ii] += a * b[ii];
+                }
+            }
+    return K;
+}
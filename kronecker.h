@@ -0,0 +1,121 @@
+#ifndef KRONECKER_H
+#define KRONECKER_H
+
+#include <vector>
+#include "Matrix.h"
+
+#pragma once
+
+// Lazy Kronecker products. A (x) B, for A m*n and B p*q, is the (m*p)*(n*q) block matrix whose block (i, j) is A(i, j)*B.
+// It is never formed: with x = vec(X) for the q*n matrix X (columns stacked, the order of Vector(const Matrix&)),
+//     (A (x) B) x = vec(B X A^T),
+// two matrix products through gemm in O(pqn + pnm) (or O(qnm + pqm)) flops and O(mp + nq) memory, instead of the
+// O(mnpq) of the explicit matrix. A Kronecker holds a sum of such terms c_1 A_1 (x) B_1 + c_2 A_2 (x) B_2 + ...,
+// as in discretized separable operators (A (x) I + I (x) B) or Sylvester and Lyapunov equations.
+
+// the largest order (rows or columns) of a sum of terms that Kronecker::solve and LS_Solver::solve form densely
+#define KRONECKER_DENSE_MAX 4096
+
+/**
+ * @brief Sum of Kronecker products c_t A_t (x) B_t whose terms all have the same order (every A_t m*n, every B_t p*q).
+ * Applied to vectors by the vec trick, without forming the (m*p)*(n*q) matrix.
+ *
+ */
+class Kronecker{
+    struct Term{
+        double c;
+        Matrix A, B;
+    };
+    std::vector<Term> t;
+    int m = 0, n = 0, p = 0, q = 0;
+
+    void checkConformant(const Kronecker &K, const char *where) const;
+public:
+    /**
+     * @brief Construct the empty (0*0) operator.
+     */
+    Kronecker(){}
+
+    /**
+     * @brief Construct the single term A (x) B. The factors are copied.
+     */
+    Kronecker(const Matrix &A, const Matrix &B);
+
+    /**
+     * @brief returns the order of the operator as the pair {m*p, n*q}.
+     */
+    std::pair<long, long> order() const{ return {(long)m * p, (long)n * q}; }
+
+    /**
+     * @brief returns the number of Kronecker terms in the sum.
+     */
+    int terms() const{ return t.size(); }
+
+    /**
+     * @brief Returns the (i,j)th element, summed over the terms: c_t A_t(i/p, j/q) B_t(i%p, j%q).
+     * Throws out_of_range error if the indices are invalid.
+     */
+    double at(long i, long j) const;
+
+    /**
+     * @brief Returns the sum of the terms of both operators, which must have factors of the same orders. Raises invalid_argument error otherwise.
+     */
+    Kronecker operator+(const Kronecker &K) const;
+    Kronecker operator-(const Kronecker &K) const;
+    const Kronecker &operator+=(const Kronecker &K);
+    const Kronecker &operator-=(const Kronecker &K);
+
+    /**
+     * @brief Scales the coefficient of every term by factor.
+     */
+    Kronecker operator*(double factor) const;
+
+    /**
+     * @brief Returns the transpose, the sum of the c_t A_t^T (x) B_t^T.
+     */
+    Kronecker transposed() const;
+
+    /**
+     * @brief Returns (K x) for x of size n*q, computed term by term as vec(B_t X A_t^T). See gemv.
+     */
+    Vector operator*(const Vector &x) const;
+
+    /**
+     * @brief y = alpha*K*x + beta*y into a caller-provided y of size m*p, as Matrix::gemv. x may be y itself.
+     *
+     * @param alpha scalar multiplying K*x
+     * @param K the operator
+     * @param x Vector of size n*q, read as vec of a q*n matrix
+     * @param beta scalar multiplying the previous contents of y. With beta = 0 the contents of y are ignored.
+     * @param y the output, vec of a p*m matrix
+     */
+    static void gemv(double alpha, const Kronecker &K, const Vector &x, double beta, Vector &y);
+
+    /**
+     * @brief y = alpha*K^T*x + beta*y into a caller-provided y of size n*q, as Matrix::gemvT. x may be y itself.
+     */
+    static void gemvT(double alpha, const Kronecker &K, const Vector &x, double beta, Vector &y);
+
+    /**
+     * @brief Solves Kx = b. For a single term with square factors this is x = vec(B^{-1} Y A^{-T}) / c with b = vec(Y),
+     * through LU factorizations of the factors, in O(m^3 + p^3 + mp(m + p)) flops.
+     * A sum of terms (or non-square factors) is solved through the dense matrix, if it has at most
+     * KRONECKER_DENSE_MAX rows and columns. Throws a domain_error if K is singular or too large to form.
+     *
+     * @param b Vector of size m*p
+     * @return Vector the solution x
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Returns the explicit (m*p)*(n*q) matrix. Only sensible for small factors.
+     */
+    Matrix dense() const;
+};
+
+/**
+ * @brief Scales every term of K by factor.
+ */
+Kronecker operator*(double factor, const Kronecker &K);
+
+#endif
@@ -1,8 +1,30 @@
+#include <cfloat>
 #include "ls.h"
+#include "matrixCache.h"
+#include "distributed.h"
+#include "kronecker.h"
+#include "sparseSolver.h"
 
 std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const Matrix &A, const Vector &b){
-    Matrix Ab = A.augment(b);
-    Ab.rref(true);
+    LINALG_PROFILE("LS_Solver::solve", 2.0 * A.order().first * (A.order().second + 1) * std::min(A.order().first, A.order().second + 1),
+        8.0 * A.order().first * (A.order().second + 1) * std::min(A.order().first, A.order().second + 1));
+    Matrix Ab;
+    MatrixCache *c = A.cache();
+    if (c){
+        // the row operations reducing A do not depend on b: reduce A once, then replay the operations on each b
+        if (!c->rref){
+            auto ops = std::make_shared<ElementaryProgram>();
+            c->rref = std::make_shared<const Matrix>(Matrix(A).rref(*ops));
+            c->rrefOps = ops;
+        }
+        Vector eb(b);
+        c->rrefOps->apply(eb);
+        Ab = c->rref->augment(eb);
+    }
+    else{
+        Ab = A.augment(b);
+        Ab.rref(true);
+    }
     std::vector<bool> isPivotal(Ab.order().second); 
     // to find the pivotal columns, essentially we must find the 1s in the pivotal rows, the corresponding columns are what we need. 
     // so we iterate in a one-dimensional fashion always moving to the right starting on the first row, 
@@ -17,9 +39,11 @@ std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const Matrix &A, const V
         }
     }
 
-    for (int i = 0; i < Ab.order().second; i++) std::cout << isPivotal.at(i) << " ";
-    std::cout << std::endl;
-
+    // a replayed b is not reduced itself: a nonzero below the pivot rows means no solution
+    if (c)
+        for (int k = i; k < Ab.order().first; k++)
+            if (std::abs(Ab.at(k, Ab.order().second - 1)) > EPSILON)
+                return {Vector(), std::vector<Vector>()};
     // no solution if the last column is pivotal
     if (isPivotal.at(Ab.order().second - 1))
         return {Vector(), std::vector<Vector>()};
@@ -28,7 +52,6 @@ std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const Matrix &A, const V
     const Vector& rref_b = Ab.at(Ab.order().second - 1);
     for(int i{0}; i<Ab.order().second - 1; i++){
         if (isPivotal.at(i)) continue;
-        std::cout << i << std::endl;
         ans.push_back(retrieve(rref_b, i, Ab.at(i), isPivotal));
     }
 
@@ -45,6 +68,107 @@ std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const Matrix &A, const V
 }
 
 
+std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const Matrix &A, const Vector &b, double *rcond){
+    if (!rcond)
+        return solve(A, b);
+    if (A.order().first != b.size()){
+        std::cerr << "LS_Solver::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("LS_Solver::solve: dimension mismatch");
+    }
+    *rcond = 0;
+    if (A.order().first != A.order().second || A.order().first == 0)
+        return solve(A, b);
+    // one LU factorization serves both the estimate and the solution
+    MatrixCache *c = A.cache();
+    std::shared_ptr<const LU> lu = c && c->lu ? c->lu : std::make_shared<const LU>(SquareMatrix(A));
+    if (c)
+        c->lu = lu;
+    *rcond = c && c->rcond >= 0 ? c->rcond : lu->rcond();
+    if (c)
+        c->rcond = *rcond;
+    if (lu->isSingular())
+        return solve(A, b);
+    return {lu->solve(b), std::vector<Vector>()};
+}
+
+std::pair<Vector, std::vector<Vector>> LS_Solver::solveRefined(const Matrix &A, const Vector &b, RefinementInfo *info, double *rcond){
+    if (A.order().first != b.size()){
+        std::cerr << "LS_Solver::solveRefined: dimension mismatch" << std::endl;
+        throw std::invalid_argument("LS_Solver::solveRefined: dimension mismatch");
+    }
+    if (rcond)
+        *rcond = 0;
+    if (A.order().first != A.order().second || A.order().first == 0)
+        return solve(A, b);
+    MixedPrecisionLU lu{SquareMatrix(A)};
+    if (lu.isSingular())
+        return solve(A, b);
+    double rc = lu.rcond();
+    if (rcond)
+        *rcond = rc;
+    // A numerically singular for float, or a solve whose refinement stalled, is left to solve(), which gives the basis of
+    // solutions (or none) instead of a refined vector that does not solve the system
+    RefinementInfo stats;
+    stats.fellBack = true;
+    if (rc >= FLT_EPSILON){
+        Vector x = lu.solve(b, &stats);
+        if (!stats.fellBack){
+            if (info)
+                *info = stats;
+            return {x, std::vector<Vector>()};
+        }
+    }
+    if (info)
+        *info = stats;
+    return solve(A, b);
+}
+
+Task<std::pair<Vector, std::vector<Vector>>> LS_Solver::solveAsync(const Matrix &A, const Vector &b){
+    auto Ab = std::make_shared<const std::pair<Matrix, Vector>>(A, b);
+    return runAsync([Ab]{ return solve(Ab->first, Ab->second); });
+}
+
+Task<Vector> LS_Solver::solveAsync(const Task<std::shared_ptr<const LU>> &lu, const Task<Vector> &b){
+    return whenAll(lu, b).then([](const std::tuple<std::shared_ptr<const LU>, Vector> &inputs){
+        return std::get<0>(inputs)->solve(std::get<1>(inputs));
+    });
+}
+
+std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const DistributedMatrix &A, const Vector &b){
+    return {A.solve(b), std::vector<Vector>()};
+}
+
+std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const Kronecker &A, const Vector &b){
+    if (A.order().first != b.size()){
+        std::cerr << "LS_Solver::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("LS_Solver::solve: dimension mismatch");
+    }
+    if (A.terms() == 1 && A.order().first == A.order().second){
+        // the factored solve needs square nonsingular factors; anything else is left to the dense path
+        try{
+            return {A.solve(b), std::vector<Vector>()};
+        }
+        catch (const std::domain_error &){}
+    }
+    if (std::max(A.order().first, A.order().second) > KRONECKER_DENSE_MAX){
+        std::cerr << "LS_Solver::solve: Kronecker operator too large to solve densely" << std::endl;
+        throw std::domain_error("LS_Solver::solve: Kronecker operator too large to solve densely");
+    }
+    return solve(A.dense(), b);
+}
+
+std::pair<Vector, std::vector<Vector>> LS_Solver::solve(const SparseMatrix &A, const Vector &b){
+    if (A.order().first != b.size()){
+        std::cerr << "LS_Solver::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("LS_Solver::solve: dimension mismatch");
+    }
+    if (A.order().first != A.order().second){
+        std::cerr << "LS_Solver::solve: sparse systems must be square" << std::endl;
+        throw std::invalid_argument("LS_Solver::solve: sparse systems must be square");
+    }
+    return {SparseLU(A).solve(b), std::vector<Vector>()};
+}
+
 Vector LS_Solver::retrieve(const Vector &b, int non_pivotal_col_index, const Vector &non_pivotal_col, const std::vector<bool> &isPivotal){
     int n = isPivotal.size() - 1; // isPivotal.size() = number of columns of Ab = n + 1
     Vector res(n);
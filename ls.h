@@ -1,6 +1,11 @@
 #include "Matrix.h"
+#include "lu.h"
 #pragma once
 
+class DistributedMatrix;
+class Kronecker;
+class SparseMatrix;
+
 class LS_Solver{
     /**
      * @brief class to solve systems of linear equations of the form Ax = b.
@@ -15,9 +20,66 @@ class LS_Solver{
     static Vector retrieve(const Vector &b, int non_pivotal_col_index, const Vector &non_pivotal_col, const std::vector<bool> &isPivotal);
 public:
     /**
-     * @brief Function to solve the system Ax = b. 
+     * @brief Function to solve the system Ax = b. With the cache of A enabled (see Matrix::enableCache), A is reduced once
+     * and later calls only replay the recorded row operations on b, in O(m*min(m,n)) instead of O(m*n*min(m,n)). 
+     * Each basis vector is itself a solution, one free variable set to 1 (see retrieve), not a vector of the null space of A,
+     * which Matrix::nullspace returns as one matrix.
      * 
      * @return std::pair<Vector, std::vector<Vector>> the first element of the pair is a solution of Ax = b, the Vectors in the std::vector<Vector> form a basis of the solution set. If the function returns std::pair{b, A}, then the solutions of the system are of the form b+Ax, where x is a Vector with the appropriate dimensions. 
      */
     static std::pair<Vector, std::vector<Vector>> solve(const Matrix &A, const Vector &b);
+
+    /**
+     * @brief Same as solve, and also estimates the reciprocal condition number of A (see SquareMatrix::rcond), for instance
+     * to decide whether the solution needs refinement. A square A is then solved from its LU factors, which the estimate
+     * reuses in O(n^2); with the cache of A enabled the factors and the estimate are memoized. A singular A goes through solve.
+     *
+     * @param rcond receives 1 / (||A||_1 ||A^{-1}||_1) estimated, 0 if A is singular or not square
+     */
+    static std::pair<Vector, std::vector<Vector>> solve(const Matrix &A, const Vector &b, double *rcond);
+
+    /**
+     * @brief Same as solve, but a square nonsingular A (the common case) is solved by a float LU factorization refined to double
+     * accuracy (see MixedPrecisionLU) instead of a double RREF of the augmented matrix. Other systems go through solve, as do
+     * those whose float factors estimate rcond below FLT_EPSILON or whose refinement does not converge.
+     *
+     * @param info if not null and the mixed precision path was taken, receives the iteration count, the backward error and
+     * whether the system was passed on to solve (fellBack)
+     * @param rcond if not null, receives the reciprocal condition number estimated from the float factors (see MixedPrecisionLU::rcond), 0 if A is singular or not square
+     * @return std::pair<Vector, std::vector<Vector>> as for solve; the basis is empty for a nonsingular A.
+     */
+    static std::pair<Vector, std::vector<Vector>> solveRefined(const Matrix &A, const Vector &b, RefinementInfo *info = nullptr, double *rcond = nullptr);
+
+    /**
+     * @brief Runs solve(A, b) on copies of A and b on the library's executor (see task.h), so the caller does not block.
+     */
+    static Task<std::pair<Vector, std::vector<Vector>>> solveAsync(const Matrix &A, const Vector &b);
+
+    /**
+     * @brief Solves Ax = b once both the factorization of A and the right hand side are available, for instance
+     * solveAsync(A.luAsync(), runAsync(loadRhs)): the factorization and the loading of b run concurrently.
+     * The task fails with the exception of either input, or a domain_error if A is singular.
+     */
+    static Task<Vector> solveAsync(const Task<std::shared_ptr<const LU>> &lu, const Task<Vector> &b);
+
+    /**
+     * @brief Collective: solves Ax = b for a square nonsingular A distributed over the ranks of its transport (see distributed.h).
+     * b is passed on every rank and the solution is returned on every rank; the basis is empty. Throws a domain_error if A is singular.
+     */
+    static std::pair<Vector, std::vector<Vector>> solve(const DistributedMatrix &A, const Vector &b);
+
+    /**
+     * @brief Solves Ax = b for a lazy Kronecker sum (see kronecker.h) without forming it when A is a single term
+     * with square nonsingular factors. Otherwise A is formed densely and solved as a Matrix, if it has at most
+     * KRONECKER_DENSE_MAX rows and columns; larger ones throw a domain_error.
+     */
+    static std::pair<Vector, std::vector<Vector>> solve(const Kronecker &A, const Vector &b);
+
+    /**
+     * @brief Solves Ax = b for a square sparse A (see sparse.h) by a supernodal LU factorization with a minimum degree
+     * ordering, refined where static pivoting perturbed it (see SparseLU). To factorize once and solve many times, or
+     * to refactor matrices of the same pattern, use SparseLU or SparseCholesky directly.
+     * Raises invalid_argument error if A is not square, and throws a domain_error if A is singular.
+     */
+    static std::pair<Vector, std::vector<Vector>> solve(const SparseMatrix &A, const Vector &b);
 };
\ No newline at end of file
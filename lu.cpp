@@ -0,0 +1,458 @@
+#include <cfloat>
+#include <cmath>
+#include "lu.h"
+#include "task.h"
+#include "parallel.h"
+#include "tuning.h"
+
+// default panel width of the LU factorization, unless tuned (see tuning.h)
+#define LU_BLOCK 64
+// flops of a trailing update below which it runs on one thread
+#define LU_PARALLEL_MIN (1 << 20)
+
+namespace{
+
+// U12 = L11^{-1} A12 and A22 -= L21 U12 for the columns right of the panel k0 .. k1-1: through gemm in double
+void updateTrailing(double *a, int n, int k0, int k1){
+    parallelFor(k1, n, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++){
+            double *aj = a + (size_t)j*n;
+            for (int l = k0; l < k1; l++){
+                const double *al = a + (size_t)l*n;
+                for (int i = l + 1; i < k1; i++)
+                    aj[i] -= aj[l] * al[i];
+            }
+        }
+    }, 1, (long long)(k1 - k0) * (k1 - k0) * (n - k1) >= LU_PARALLEL_MIN ? 0 : 1);
+    gemm(-1, ConstMatrixView(a + (size_t)k0*n + k1, n - k1, k1 - k0, n), ConstMatrixView(a + (size_t)k1*n + k0, k1 - k0, n - k1, n),
+        1, MatrixView(a + (size_t)k1*n + k1, n - k1, n - k1, n));
+}
+
+// and column by column in float, which gemm does not cover
+void updateTrailing(float *a, int n, int k0, int k1){
+    parallelFor(k1, n, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++){
+            float *aj = a + (size_t)j*n;
+            for (int l = k0; l < k1; l++){
+                const float *al = a + (size_t)l*n;
+                float f = aj[l];
+                if (f == 0)
+                    continue;
+                for (int i = l + 1; i < n; i++)
+                    aj[i] -= f * al[i];
+            }
+        }
+    }, 1, (long long)(k1 - k0) * (n - k1) * (n - k0) >= LU_PARALLEL_MIN ? 0 : 1);
+}
+
+// In-place LU with partial pivoting of the column-major n*n array a, shared by the double and the float factorizations.
+// Right-looking in panels of nb columns: a panel is factorized on its own, then its row swaps are applied to the other
+// columns and its eliminations to the columns right of it at once (see updateTrailing). nb = 1 is the unblocked algorithm.
+// Returns false if an exactly zero pivot was met.
+template <class T>
+bool factorize(T *a, int n, int *piv, int &sign, int nb){
+    bool nonsingular = true;
+    sign = 1;
+    nb = std::max(1, nb);
+    for (int k0 = 0; k0 < n; k0 += nb){
+        int k1 = std::min(n, k0 + nb);
+        for (int k = k0; k < k1; k++){
+            // fraction of the 2n^3/3 flops done so far
+            taskCheckpoint(1 - std::pow((double)(n - k) / n, 3));
+            T *ak = a + (size_t)k*n;
+            int p = k;
+            for (int i = k + 1; i < n; i++)
+                if (std::abs(ak[i]) > std::abs(ak[p])) p = i;
+            piv[k] = p;
+            if (p != k){
+                sign = -sign;
+                for (int j = k0; j < k1; j++)
+                    std::swap(a[(size_t)j*n + k], a[(size_t)j*n + p]);
+            }
+            if (ak[k] == 0){
+                nonsingular = false;
+                continue;
+            }
+            T inv = 1 / ak[k];
+            for (int i = k + 1; i < n; i++)
+                ak[i] *= inv;
+            // rank-1 update of the rest of the panel, one contiguous axpy per column
+            for (int j = k + 1; j < k1; j++){
+                T *aj = a + (size_t)j*n;
+                T f = aj[k];
+                if (f == 0)
+                    continue;
+                for (int i = k + 1; i < n; i++)
+                    aj[i] -= f * ak[i];
+            }
+        }
+        for (int k = k0; k < k1; k++)
+            if (piv[k] != k){
+                for (int j = 0; j < k0; j++)
+                    std::swap(a[(size_t)j*n + k], a[(size_t)j*n + piv[k]]);
+                for (int j = k1; j < n; j++)
+                    std::swap(a[(size_t)j*n + k], a[(size_t)j*n + piv[k]]);
+            }
+        if (k1 < n)
+            updateTrailing(a, n, k0, k1);
+    }
+    return nonsingular;
+}
+
+// the tuned panel width of factorize (see tuning.h), LU_BLOCK by default
+int luBlock(){
+    int tuned = tuning().luBlock;
+    return tuned > 0 ? tuned : LU_BLOCK;
+}
+
+template <class T>
+void substitute(const T *a, int n, const int *piv, T *x){
+    for (int k = 0; k < n; k++)
+        if (piv[k] != k)
+            std::swap(x[k], x[piv[k]]);
+    // forward substitution with the unit lower triangle, column oriented
+    for (int k = 0; k < n; k++){
+        const T *ak = a + (size_t)k*n;
+        T xk = x[k];
+        if (xk != 0)
+            for (int i = k + 1; i < n; i++)
+                x[i] -= xk * ak[i];
+    }
+    // back substitution with U
+    for (int k = n - 1; k >= 0; k--){
+        const T *ak = a + (size_t)k*n;
+        x[k] /= ak[k];
+        T xk = x[k];
+        for (int i = 0; i < k; i++)
+            x[i] -= xk * ak[i];
+    }
+}
+
+// solves A^T x = b for PA = LU: U^T z = b, then L^T w = z, then x = P^T w (the swaps undone in reverse order)
+template <class T>
+void substituteTransposed(const T *a, int n, const int *piv, T *x){
+    for (int k = 0; k < n; k++){
+        const T *ak = a + (size_t)k*n;
+        T s = x[k];
+        for (int i = 0; i < k; i++)
+            s -= ak[i] * x[i];
+        x[k] = s / ak[k];
+    }
+    for (int k = n - 1; k >= 0; k--){
+        const T *ak = a + (size_t)k*n;
+        T s = x[k];
+        for (int i = k + 1; i < n; i++)
+            s -= ak[i] * x[i];
+        x[k] = s;
+    }
+    for (int k = n - 1; k >= 0; k--)
+        if (piv[k] != k)
+            std::swap(x[k], x[piv[k]]);
+}
+
+// largest absolute column sum of the column-major n*n array a
+double columnSumMax(const double *a, int n){
+    double m = 0;
+    for (int j = 0; j < n; j++){
+        double s = 0;
+        for (int i = 0; i < n; i++)
+            s += std::abs(a[(size_t)j*n + i]);
+        m = std::max(m, s);
+    }
+    return m;
+}
+
+// r = b - A x in double, for the column-major n*n array a
+void residual(const double *a, int n, const double *x, const double *b, double *r){
+    std::copy(b, b + n, r);
+    for (int j = 0; j < n; j++){
+        const double *aj = a + (size_t)j*n;
+        double xj = x[j];
+        for (int i = 0; i < n; i++)
+            r[i] -= aj[i] * xj;
+    }
+}
+
+double maxAbs(const double *x, int n){
+    double m = 0;
+    for (int i = 0; i < n; i++)
+        m = std::max(m, std::abs(x[i]));
+    return m;
+}
+
+}
+
+LU::LU(const SquareMatrix &A): n{A.order()}, lu((size_t)n * n), piv(n), sign{1}, singular{false}
+{
+    LINALG_PROFILE("LU::LU", 2.0 / 3.0 * n * n * n, 8.0 * n * n * n / 3);
+    for (int j = 0; j < n; j++)
+        std::copy(A.at(j).begin(), A.at(j).end(), lu.begin() + (size_t)j*n);
+    anorm1 = columnSumMax(lu.data(), n);
+    singular = !factorize(lu.data(), n, piv.data(), sign, luBlock());
+}
+
+double LU::det() const{
+    double d = sign;
+    for (int k = 0; k < n; k++)
+        d *= lu[(size_t)k*n + k];
+    return d;
+}
+
+void LU::solveInPlace(double *x) const{
+    if (singular){
+        std::cerr << "LU::solve: matrix is singular" << std::endl;
+        throw std::domain_error("LU::solve: matrix is singular");
+    }
+    substitute(lu.data(), n, piv.data(), x);
+}
+
+void LU::solveTransposedInPlace(double *x) const{
+    if (singular){
+        std::cerr << "LU::solve: matrix is singular" << std::endl;
+        throw std::domain_error("LU::solve: matrix is singular");
+    }
+    substituteTransposed(lu.data(), n, piv.data(), x);
+}
+
+double LU::rcond() const{
+    if (singular)
+        return 0;
+    if (n == 0)
+        return 1;
+    LINALG_PROFILE("LU::rcond", 22.0 * n * n, 88.0 * n * n);
+    double inorm = estimateNorm1(n, [this](double *x){ solveInPlace(x); }, [this](double *x){ solveTransposedInPlace(x); });
+    return inorm > 0 && anorm1 > 0 ? 1 / (anorm1 * inorm) : 0;
+}
+
+Vector LU::solve(const Vector &b) const{
+    if (b.size() != n){
+        std::cerr << "LU::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("LU::solve: dimension mismatch");
+    }
+    Vector x(b);
+    solveInPlace(x.data());
+    return x;
+}
+
+Matrix LU::solve(const Matrix &B) const{
+    if (B.order().first != n){
+        std::cerr << "LU::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("LU::solve: dimension mismatch");
+    }
+    Matrix X(B);
+    for (int j = 0; j < X.order().second; j++)
+        solveInPlace(X.at(j).data());
+    return X;
+}
+
+SquareMatrix LU::inverse() const{
+    SquareMatrix X(n, true);
+    for (int j = 0; j < n; j++)
+        solveInPlace(X.at(j).data());
+    return X;
+}
+
+// ===================== mixed precision ============================= //
+
+// refinement steps before giving up on the float factorization (as in LAPACK's dsgesv)
+#define REFINEMENT_MAX_ITERATIONS 30
+
+MixedPrecisionLU::MixedPrecisionLU(const SquareMatrix &A): n{A.order()}, a((size_t)n * n), lu((size_t)n * n), piv(n), usable{true}
+{
+    LINALG_PROFILE("MixedPrecisionLU::MixedPrecisionLU", 2.0 / 3.0 * n * n * n, 4.0 * n * n * n / 3);
+    anorm = 0;
+    for (int j = 0; j < n; j++){
+        const double *col = A.at(j).data();
+        std::copy(col, col + n, a.begin() + (size_t)j*n);
+        for (int i = 0; i < n; i++){
+            // entries beyond the float range cannot be factorized in float
+            if (std::abs(col[i]) > FLT_MAX)
+                usable = false;
+            lu[(size_t)j*n + i] = (float)col[i];
+        }
+    }
+    // infinity norm, for the stopping test
+    std::vector<double> rowsum(n);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            rowsum[i] += std::abs(a[(size_t)j*n + i]);
+    for (double r: rowsum)
+        anorm = std::max(anorm, r);
+    anorm1 = columnSumMax(a.data(), n);
+    int sign;
+    if (usable)
+        usable = factorize(lu.data(), n, piv.data(), sign, luBlock());
+}
+
+bool MixedPrecisionLU::refine(double *x, const double *b, RefinementInfo &info) const{
+    if (!usable)
+        return false;
+    std::vector<double> r(b, b + n);
+    std::vector<float> d(n);
+    // x0 from the float factors
+    for (int i = 0; i < n; i++)
+        d[i] = (float)r[i];
+    substitute(lu.data(), n, piv.data(), d.data());
+    for (int i = 0; i < n; i++)
+        x[i] = d[i];
+    double tolerance = anorm * DBL_EPSILON * std::sqrt((double)n), previous = HUGE_VAL;
+    for (int iter = 0; iter <= REFINEMENT_MAX_ITERATIONS; iter++){
+        residual(a.data(), n, x, b, r.data());
+        double rnorm = maxAbs(r.data(), n), xnorm = maxAbs(x, n);
+        info.iterations = iter;
+        info.backwardError = xnorm * anorm > 0 ? rnorm / (xnorm * anorm) : rnorm;
+        if (!std::isfinite(rnorm) || !std::isfinite(xnorm))
+            return false;
+        if (rnorm <= xnorm * tolerance)
+            return true;
+        // a residual that stopped shrinking means cond(A) is too large for float: stop early instead of running all the steps
+        if (iter == REFINEMENT_MAX_ITERATIONS || rnorm >= previous)
+            break;
+        previous = rnorm;
+        // correction from the float factors
+        for (int i = 0; i < n; i++){
+            if (std::abs(r[i]) > FLT_MAX)
+                return false;
+            d[i] = (float)r[i];
+        }
+        substitute(lu.data(), n, piv.data(), d.data());
+        for (int i = 0; i < n; i++)
+            x[i] += d[i];
+    }
+    return false;
+}
+
+const LU &MixedPrecisionLU::doubleLU() const{
+    if (!fallback){
+        SquareMatrix A(n);
+        for (int j = 0; j < n; j++)
+            std::copy(a.begin() + (size_t)j*n, a.begin() + (size_t)(j+1)*n, A.at(j).data());
+        fallback = std::make_shared<LU>(A);
+    }
+    return *fallback;
+}
+
+Vector MixedPrecisionLU::solve(const Vector &b, RefinementInfo *info) const{
+    if (b.size() != n){
+        std::cerr << "MixedPrecisionLU::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("MixedPrecisionLU::solve: dimension mismatch");
+    }
+    LINALG_PROFILE("MixedPrecisionLU::solve", 4.0 * n * n, 12.0 * n * n);
+    RefinementInfo stats;
+    Vector x(n);
+    if (!refine(x.data(), b.data(), stats)){
+        // the float factorization failed or refinement stalled (ill-conditioned A): factorize in double instead
+        stats.fellBack = true;
+        x = doubleLU().solve(b);
+        std::vector<double> r(n);
+        residual(a.data(), n, x.data(), b.data(), r.data());
+        double xnorm = maxAbs(x.data(), n);
+        stats.backwardError = xnorm * anorm > 0 ? maxAbs(r.data(), n) / (xnorm * anorm) : maxAbs(r.data(), n);
+    }
+    if (info)
+        *info = stats;
+    return x;
+}
+
+Matrix MixedPrecisionLU::solve(const Matrix &B, RefinementInfo *info) const{
+    if (B.order().first != n){
+        std::cerr << "MixedPrecisionLU::solve: dimension mismatch" << std::endl;
+        throw std::invalid_argument("MixedPrecisionLU::solve: dimension mismatch");
+    }
+    Matrix X(n, B.order().second);
+    RefinementInfo total;
+    for (int j = 0; j < B.order().second; j++){
+        RefinementInfo stats;
+        X.at(j) = solve(B.at(j), &stats);
+        total.iterations = std::max(total.iterations, stats.iterations);
+        total.backwardError = std::max(total.backwardError, stats.backwardError);
+        total.fellBack = total.fellBack || stats.fellBack;
+    }
+    if (info)
+        *info = total;
+    return X;
+}
+
+double MixedPrecisionLU::rcond() const{
+    if (!usable)
+        return doubleLU().rcond();
+    if (n == 0)
+        return 1;
+    LINALG_PROFILE("MixedPrecisionLU::rcond", 22.0 * n * n, 44.0 * n * n);
+    // an estimate only needs a few correct digits: the float factors do
+    std::vector<float> d(n);
+    auto through = [&](void (*solver)(const float *, int, const int *, float *)){
+        return [&, solver](double *x){
+            for (int i = 0; i < n; i++)
+                d[i] = (float)x[i];
+            solver(lu.data(), n, piv.data(), d.data());
+            for (int i = 0; i < n; i++)
+                x[i] = d[i];
+        };
+    };
+    double inorm = estimateNorm1(n, through(substitute<float>), through(substituteTransposed<float>));
+    return std::isfinite(inorm) && inorm > 0 && anorm1 > 0 ? 1 / (anorm1 * inorm) : 0;
+}
+
+// ===================== norm estimation ============================= //
+
+// products with B^T before the estimate is taken as converged (LAPACK's ITMAX)
+#define NORM1_ESTIMATE_ITERATIONS 5
+
+double estimateNorm1(int n, const std::function<void(double *)> &apply, const std::function<void(double *)> &applyTransposed){
+    if (n <= 0)
+        return 0;
+    auto sum = [](const std::vector<double> &x){
+        double s = 0;
+        for (double v: x)
+            s += std::abs(v);
+        return s;
+    };
+    auto largest = [](const std::vector<double> &x){
+        size_t j = 0;
+        for (size_t i = 1; i < x.size(); i++)
+            if (std::abs(x[i]) > std::abs(x[j]))
+                j = i;
+        return (int)j;
+    };
+    std::vector<double> x(n, 1.0 / n), sign(n, 0);
+    // replaces x by its sign vector; returns true if that is the previous sign vector
+    auto toSigns = [&](){
+        bool same = true;
+        for (int i = 0; i < n; i++){
+            double s = x[i] >= 0 ? 1 : -1;
+            same = same && s == sign[i];
+            x[i] = sign[i] = s;
+        }
+        return same;
+    };
+    apply(x.data());
+    if (n == 1)
+        return std::abs(x[0]);
+    double est = sum(x);
+    toSigns();
+    applyTransposed(x.data());
+    int j = largest(x);
+    // ||B||_1 is the largest ||B e_j||_1: each step moves to the column where the subgradient B^T sign(B e_j) points
+    for (int iter = 2; iter <= NORM1_ESTIMATE_ITERATIONS; iter++){
+        std::fill(x.begin(), x.end(), 0.0);
+        x[j] = 1;
+        apply(x.data());
+        double previous = est;
+        est = sum(x);
+        if (toSigns() || est <= previous){
+            est = std::max(est, previous);
+            break;
+        }
+        applyTransposed(x.data());
+        int last = j;
+        j = largest(x);
+        if (std::abs(x[last]) == std::abs(x[j]))
+            break;
+    }
+    // Higham's alternating vector guards against the matrices that defeat the iteration
+    for (int i = 0; i < n; i++)
+        x[i] = (i % 2 ? -1 : 1) * (1 + (double)i / (n - 1));
+    apply(x.data());
+    return std::max(est, 2 * sum(x) / (3.0 * n));
+}
@@ -0,0 +1,37 @@
+#ifndef MATRIXCACHE_H
+#define MATRIXCACHE_H
+
+#include <memory>
+#include "lu.h"
+#include "structuredMatrix.h"
+#include "elementaryOps.h"
+
+#pragma once
+
+/**
+ * @brief The results memoized for one version of a matrix with the cache enabled (see Matrix::enableCache).
+ * Entries are filled lazily by the queries; a negative scalar or a null pointer means not computed yet.
+ *
+ */
+struct MatrixCache{
+    unsigned long long version;
+    int rank = -1;
+    double norm1 = -1, normInf = -1, normFrobenius = -1;
+    bool hasDet = false;
+    double det = 0;
+    double rcond = -1;
+    // indexed by QRMethod: the methods round differently
+    std::shared_ptr<const std::pair<Matrix, TriangularMatrix>> qr[3];
+    std::shared_ptr<const LU> lu;
+    std::shared_ptr<const SquareMatrix> inverse;
+    // the Cholesky factor, or choleskyFailed if the matrix is not positive definite
+    std::shared_ptr<const TriangularMatrix> cholesky;
+    bool choleskyFailed = false;
+    // the reduced row echelon form and the row operations producing it, replayed on each right hand side by LS_Solver::solve
+    std::shared_ptr<const Matrix> rref;
+    std::shared_ptr<const ElementaryProgram> rrefOps;
+
+    MatrixCache(unsigned long long version): version{version}{}
+};
+
+#endif
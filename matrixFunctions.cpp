@@ -0,0 +1,337 @@
+#include <algorithm>
+#include "matrixFunctions.h"
+#include "lu.h"
+
+namespace{
+
+typedef std::complex<double> cd;
+
+// dense complex n*n matrix, row-major
+struct CMatrix{
+    int n;
+    std::vector<cd> a;
+    CMatrix(int n): n{n}, a((size_t)n * n){}
+    cd &operator()(int i, int j){ return a[(size_t)i*n + j]; }
+    cd operator()(int i, int j) const{ return a[(size_t)i*n + j]; }
+};
+
+double norm1(const Matrix &A){
+    double res = 0;
+    for (auto &col: A){
+        double s = 0;
+        for (double x: col)
+            s += std::abs(x);
+        res = std::max(res, s);
+    }
+    return res;
+}
+
+double norm1(const CMatrix &A){
+    double res = 0;
+    for (int j = 0; j < A.n; j++){
+        double s = 0;
+        for (int i = 0; i < A.n; i++)
+            s += std::abs(A(i, j));
+        res = std::max(res, s);
+    }
+    return res;
+}
+
+// Y += alpha * X
+void axpy(double alpha, const Matrix &X, Matrix &Y){
+    for (int j = 0; j < X.order().second; j++){
+        const double *x = X.at(j).data();
+        double *y = Y.at(j).data();
+        for (int i = 0; i < X.order().first; i++)
+            y[i] += alpha * x[i];
+    }
+}
+
+// Complex Schur decomposition A = Z T Z^*, T upper triangular: Hessenberg reduction followed by the
+// single-shift QR iteration with Wilkinson shifts, applied to the whole of T so that it ends up triangular.
+void schur(const SquareMatrix &A, CMatrix &T, CMatrix &Z){
+    int n = A.order();
+    SquareMatrix Q;
+    SquareMatrix H = A.hessenberg(&Q);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++){
+            T(i, j) = H.at(j).data()[i];
+            Z(i, j) = Q.at(j).data()[i];
+        }
+    const double eps = 2.220446049250313e-16;
+    int hi = n - 1, its = 0;
+    while (hi > 0){
+        int l = hi;
+        for (; l > 0; l--){
+            double s = std::abs(T(l-1, l-1)) + std::abs(T(l, l));
+            if (std::abs(T(l, l-1)) <= eps * s || std::abs(T(l, l-1)) < 1e-300){
+                T(l, l-1) = 0;
+                break;
+            }
+        }
+        if (l == hi){
+            hi--;
+            its = 0;
+            continue;
+        }
+        if (++its > 100){
+            std::cerr << "schur: QR iteration did not converge" << std::endl;
+            throw std::runtime_error("schur: QR iteration did not converge");
+        }
+        cd shift;
+        if (its % 10 == 0) // exceptional shift
+            shift = T(hi, hi) + std::abs(T(hi, hi-1));
+        else{
+            cd a = T(hi-1, hi-1), b = T(hi-1, hi), c = T(hi, hi-1), d = T(hi, hi);
+            cd disc = std::sqrt(0.25 * (a - d) * (a - d) + b * c);
+            cd m1 = 0.5 * (a + d) + disc, m2 = 0.5 * (a + d) - disc;
+            shift = std::abs(m1 - d) < std::abs(m2 - d) ? m1 : m2;
+        }
+        cd x = T(l, l) - shift, y = T(l+1, l);
+        for (int k = l; k < hi; k++){
+            if (k > l){
+                x = T(k, k-1);
+                y = T(k+1, k-1);
+            }
+            double r = std::hypot(std::abs(x), std::abs(y));
+            if (r == 0)
+                continue;
+            // G = [c s; -conj(s) c] with real c maps (x, y) to (r*x/|x|, 0)
+            double c;
+            cd s;
+            if (std::abs(x) == 0){
+                c = 0;
+                s = std::conj(y) / r;
+            }
+            else{
+                c = std::abs(x) / r;
+                s = (x / std::abs(x)) * std::conj(y) / r;
+            }
+            for (int j = std::max(k - 1, 0); j < n; j++){
+                cd u = T(k, j), v = T(k+1, j);
+                T(k, j) = c * u + s * v;
+                T(k+1, j) = -std::conj(s) * u + c * v;
+            }
+            if (k > l)
+                T(k+1, k-1) = 0;
+            for (int i = 0; i <= std::min(k + 2, hi); i++){
+                cd u = T(i, k), v = T(i, k+1);
+                T(i, k) = u * c + v * std::conj(s);
+                T(i, k+1) = -u * s + v * c;
+            }
+            for (int i = 0; i < n; i++){
+                cd u = Z(i, k), v = Z(i, k+1);
+                Z(i, k) = u * c + v * std::conj(s);
+                Z(i, k+1) = -u * s + v * c;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < i; j++)
+            T(i, j) = 0;
+}
+
+// principal square root of an upper triangular matrix (Bjorck-Hammarling recurrence)
+CMatrix sqrtTriangular(const CMatrix &T){
+    int n = T.n;
+    CMatrix U(n);
+    for (int i = 0; i < n; i++)
+        U(i, i) = std::sqrt(T(i, i));
+    for (int j = 1; j < n; j++)
+        for (int i = j - 1; i >= 0; i--){
+            cd s = T(i, j);
+            for (int k = i + 1; k < j; k++)
+                s -= U(i, k) * U(k, j);
+            cd d = U(i, i) + U(j, j);
+            if (std::abs(d) == 0){
+                std::cerr << "sqrtm: matrix has no square root" << std::endl;
+                throw std::domain_error("sqrtm: matrix has no square root");
+            }
+            U(i, j) = s / d;
+        }
+    return U;
+}
+
+// the real part of Z T Z^*, checking that the imaginary part is rounding noise
+SquareMatrix backTransform(const CMatrix &T, const CMatrix &Z, const char *name){
+    int n = T.n;
+    CMatrix ZT(n);
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++){
+            cd z = Z(i, k);
+            if (z == 0.0)
+                continue;
+            for (int j = k; j < n; j++)
+                ZT(i, j) += z * T(k, j);
+        }
+    SquareMatrix res(n);
+    double re = 0, im = 0;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++){
+            cd s = 0;
+            for (int k = 0; k < n; k++)
+                s += ZT(i, k) * std::conj(Z(j, k));
+            res.at(i, j) = s.real();
+            re = std::max(re, std::abs(s.real()));
+            im = std::max(im, std::abs(s.imag()));
+        }
+    if (im > 1e-8 * std::max(re, 1.0)){
+        std::cerr << name << ": result is not real" << std::endl;
+        throw std::domain_error(std::string(name) + ": result is not real");
+    }
+    return res;
+}
+
+// the eigenvalues of a real matrix come in conjugate pairs, so the principal root/logarithm is real unless one lies on the closed negative real axis.
+void checkSpectrum(const CMatrix &T, const char *name, bool allow_zero){
+    double scale = norm1(T);
+    for (int i = 0; i < T.n; i++){
+        cd l = T(i, i);
+        bool on_axis = std::abs(l.imag()) <= 1e-12 * std::max(scale, 1e-300);
+        if (on_axis && (l.real() < 0 || (!allow_zero && l.real() <= 1e-14 * scale))){
+            std::cerr << name << ": eigenvalue on the closed negative real axis" << std::endl;
+            throw std::domain_error(std::string(name) + ": eigenvalue on the closed negative real axis");
+        }
+    }
+}
+
+}
+
+// ===================== exponential ============================= //
+
+SquareMatrix expm(const SquareMatrix &A){
+    int n = A.order();
+    static const double theta[] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1, 2.097847961257068, 5.371920351148152};
+    static const double b3[] = {120, 60, 12, 1};
+    static const double b5[] = {30240, 15120, 3360, 420, 30, 1};
+    static const double b7[] = {17297280, 8648640, 1995840, 277200, 25200, 1512, 56, 1};
+    static const double b9[] = {17643225600., 8821612800., 2075673600, 302702400, 30270240, 2162160, 110880, 3960, 90, 1};
+    static const double b13[] = {64764752532480000., 32382376266240000., 7771770303897600., 1187353796428800.,
+        129060195264000., 10559470521600., 670442572800., 33522128640., 1323241920., 40840800., 960960., 16380., 182., 1.};
+    static const double *const coeff[] = {b3, b5, b7, b9};
+
+    if (n == 0)
+        return SquareMatrix();
+    double norm = norm1(A);
+    SquareMatrix I(n, true);
+    Matrix U(n, n), V(n, n), A2(n, n);
+    Matrix::gemm(1, A, A, 0, A2);
+    int s = 0;
+
+    int m = -1;
+    for (int i = 0; i < 4; i++)
+        if (norm <= theta[i]){ m = i; break; }
+    if (m >= 0){
+        // degree 3, 5, 7 or 9: U = A * sum b_{2k+1} A^{2k}, V = sum b_{2k} A^{2k}
+        const double *b = coeff[m];
+        int deg = 2 * m + 3;
+        Matrix P(I), tmp(n, n), Uh(n, n);
+        for (int k = 0; 2*k <= deg; k++){
+            if (k > 0){
+                Matrix::gemm(1, P, A2, 0, tmp);
+                std::swap(P, tmp);
+            }
+            axpy(b[2*k], P, V);
+            if (2*k + 1 <= deg)
+                axpy(b[2*k + 1], P, Uh);
+        }
+        Matrix::gemm(1, A, Uh, 0, U);
+    }
+    else{
+        // degree 13 after scaling A by 2^-s
+        s = std::max(0, (int)std::ceil(std::log2(norm / theta[4])));
+        double f = std::ldexp(1.0, -s);
+        Matrix As(A);
+        for (int j = 0; j < n; j++)
+            As.at(j) *= f;
+        const double *b = b13;
+        Matrix A4(n, n), A6(n, n), tmp(n, n);
+        for (int j = 0; j < n; j++)
+            A2.at(j) *= f * f;
+        Matrix::gemm(1, A2, A2, 0, A4);
+        Matrix::gemm(1, A4, A2, 0, A6);
+        // U = A [A6 (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I]
+        Matrix W(n, n);
+        axpy(b[13], A6, W); axpy(b[11], A4, W); axpy(b[9], A2, W);
+        Matrix::gemm(1, A6, W, 0, tmp);
+        axpy(b[7], A6, tmp); axpy(b[5], A4, tmp); axpy(b[3], A2, tmp); axpy(b[1], I, tmp);
+        Matrix::gemm(1, As, tmp, 0, U);
+        // V = A6 (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I
+        Matrix W2(n, n);
+        axpy(b[12], A6, W2); axpy(b[10], A4, W2); axpy(b[8], A2, W2);
+        Matrix::gemm(1, A6, W2, 0, V);
+        axpy(b[6], A6, V); axpy(b[4], A4, V); axpy(b[2], A2, V); axpy(b[0], I, V);
+    }
+
+    // r = (V - U)^{-1} (V + U)
+    Matrix P(V), Q(V);
+    axpy(1, U, P);
+    axpy(-1, U, Q);
+    Matrix R = LU(SquareMatrix(Q)).solve(P);
+    Matrix tmp(n, n);
+    for (int i = 0; i < s; i++){
+        Matrix::gemm(1, R, R, 0, tmp);
+        std::swap(R, tmp);
+    }
+    return SquareMatrix(R);
+}
+
+// ===================== square root and logarithm ============================= //
+
+SquareMatrix sqrtm(const SquareMatrix &A){
+    int n = A.order();
+    if (n == 0)
+        return SquareMatrix();
+    CMatrix T(n), Z(n);
+    schur(A, T, Z);
+    checkSpectrum(T, "sqrtm", true);
+    return backTransform(sqrtTriangular(T), Z, "sqrtm");
+}
+
+SquareMatrix logm(const SquareMatrix &A){
+    int n = A.order();
+    if (n == 0)
+        return SquareMatrix();
+    CMatrix T(n), Z(n);
+    schur(A, T, Z);
+    checkSpectrum(T, "logm", false);
+
+    // take square roots until T^(1/2^s) is within 0.25 of I
+    int s = 0;
+    while (true){
+        CMatrix X(T);
+        for (int i = 0; i < n; i++)
+            X(i, i) -= 1.0;
+        if (norm1(X) <= 0.25 || s == 64)
+            break;
+        T = sqrtTriangular(T);
+        s++;
+    }
+    CMatrix X(T);
+    for (int i = 0; i < n; i++)
+        X(i, i) -= 1.0;
+
+    // log(I + X) = int_0^1 X (I + tX)^{-1} dt, by 8-point Gauss-Legendre quadrature (the [8/8] Pade approximant)
+    static const double nodes[] = {0.1834346424956498, 0.5255324099163290, 0.7966664774136267, 0.9602898564975363};
+    static const double weights[] = {0.3626837833783620, 0.3137066458778873, 0.2223810344533745, 0.1012285362903763};
+    CMatrix L(n);
+    for (int q = 0; q < 8; q++){
+        double t = 0.5 * (1 + (q < 4 ? -nodes[q] : nodes[q - 4]));
+        double w = 0.5 * weights[q % 4];
+        // Y = (I + tX)^{-1} X: upper triangular back substitution, one column of X at a time
+        CMatrix Y(n);
+        for (int j = 0; j < n; j++)
+            for (int i = j; i >= 0; i--){
+                cd sum = X(i, j);
+                for (int k = i + 1; k <= j; k++)
+                    sum -= t * X(i, k) * Y(k, j);
+                Y(i, j) = sum / (1.0 + t * X(i, i));
+            }
+        for (size_t k = 0; k < L.a.size(); k++)
+            L.a[k] += w * Y.a[k];
+    }
+    double scale = std::ldexp(1.0, s);
+    for (auto &x: L.a)
+        x *= scale;
+    return backTransform(L, Z, "logm");
+}
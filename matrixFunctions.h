@@ -0,0 +1,36 @@
+#ifndef MATRIXFUNCTIONS_H
+#define MATRIXFUNCTIONS_H
+
+#include "squareMatrix.h"
+
+#pragma once
+
+/**
+ * @brief Computes the matrix exponential e^A by Pade scaling and squaring (Higham 2005).
+ * The degree of the Pade approximant (3, 5, 7, 9 or 13) and the number of squarings are chosen from the 1-norm of A.
+ *
+ * @param A the matrix
+ * @return SquareMatrix e^A
+ */
+SquareMatrix expm(const SquareMatrix &A);
+
+/**
+ * @brief Computes the principal square root of A through a complex Schur decomposition A = ZTZ^* and the recurrence for the root of the triangular T.
+ * Throws std::domain_error if A has no real principal square root (an eigenvalue on the closed negative real axis, or a singular A with a defective zero eigenvalue).
+ *
+ * @param A the matrix
+ * @return SquareMatrix X with X*X = A
+ */
+SquareMatrix sqrtm(const SquareMatrix &A);
+
+/**
+ * @brief Computes the principal logarithm of A by inverse scaling and squaring on the Schur form:
+ * repeated triangular square roots bring T close to I, an [8/8] Pade approximant (Gauss-Legendre form) gives log(T^(1/2^s)), and the result is scaled back by 2^s.
+ * Throws std::domain_error if A has no real principal logarithm (an eigenvalue on the closed negative real axis).
+ *
+ * @param A the matrix
+ * @return SquareMatrix X with e^X = A
+ */
+SquareMatrix logm(const SquareMatrix &A);
+
+#endif
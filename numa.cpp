@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "numa.h"
+#include "parallel.h"
+
+// memory policies of mbind(2), from <numaif.h> (libnuma is not required)
+#define LINALG_MPOL_BIND 2
+#define LINALG_MPOL_INTERLEAVE 3
+
+namespace{
+
+// CPUs of every node with CPUs, read once from sysfs
+struct Topology{
+    std::vector<int> nodes;
+    std::vector<std::vector<int>> cpus;
+};
+
+// parses a sysfs list such as "0-3,8,10-11"
+std::vector<int> parseList(const std::string &text){
+    std::vector<int> items;
+    size_t pos = 0;
+    while (pos < text.size()){
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string part = text.substr(pos, end - pos);
+        size_t dash = part.find('-');
+        if (!part.empty() && std::isdigit((unsigned char)part[0])){
+            int lo = std::atoi(part.c_str()), hi = dash == std::string::npos ? lo : std::atoi(part.c_str() + dash + 1);
+            for (int i = lo; i <= hi; i++)
+                items.push_back(i);
+        }
+        pos = end + 1;
+    }
+    return items;
+}
+
+std::string readLine(const std::string &path){
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+const Topology &topology(){
+    static const Topology t = []{
+        Topology t;
+        for (int node: parseList(readLine("/sys/devices/system/node/online"))){
+            std::vector<int> cpus = parseList(readLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+            // memory-only nodes get no threads
+            if (!cpus.empty()){
+                t.nodes.push_back(node);
+                t.cpus.push_back(cpus);
+            }
+        }
+        return t;
+    }();
+    return t;
+}
+
+struct Settings{
+    NumaPolicy policy = NumaPolicy::Default;
+    int node = 0;
+    bool pin = false;
+};
+
+const Settings &environment(){
+    static const Settings s = []{
+        Settings s;
+        if (const char *env = std::getenv("LINALG_NUMA")){
+            std::string v = env;
+            if (v == "first-touch")
+                s.policy = NumaPolicy::FirstTouch;
+            else if (v == "interleave")
+                s.policy = NumaPolicy::Interleave;
+            else if (v.compare(0, 4, "bind") == 0){
+                s.policy = NumaPolicy::Bind;
+                if (v.size() > 5 && v[4] == ':')
+                    s.node = std::atoi(v.c_str() + 5);
+            }
+        }
+        if (const char *env = std::getenv("LINALG_PIN_THREADS"))
+            s.pin = std::atoi(env) != 0;
+        return s;
+    }();
+    return s;
+}
+
+// -1 until set by setNumaPolicy / setThreadPinning
+std::atomic<int> configuredPolicy{-1}, configuredNode{0}, configuredPin{-1};
+
+// index of a node number in the topology, for the CPU lists
+int nodeIndex(int node){
+    const Topology &t = topology();
+    auto it = std::find(t.nodes.begin(), t.nodes.end(), node);
+    return it == t.nodes.end() ? -1 : it - t.nodes.begin();
+}
+
+// chunks of a top-level parallelFor over [0, count) with grain 1 (placement does not depend on where it is decided)
+int splitChunks(long long count){
+    return (int)std::max(1LL, std::min((long long)threadCount(), count));
+}
+
+}
+
+int numaNodeCount(){
+    return std::max<int>(1, topology().nodes.size());
+}
+
+NumaPolicy numaPolicy(){
+    int p = configuredPolicy.load(std::memory_order_relaxed);
+    return p >= 0 ? (NumaPolicy)p : environment().policy;
+}
+
+int numaBindNode(){
+    return configuredPolicy.load(std::memory_order_relaxed) >= 0 ? configuredNode.load(std::memory_order_relaxed) : environment().node;
+}
+
+void setNumaPolicy(NumaPolicy policy, int node){
+    if (policy == NumaPolicy::Bind && nodeIndex(node) < 0 && !(node == 0 && topology().nodes.empty())){
+        std::cerr << "setNumaPolicy: no such node" << std::endl;
+        throw std::invalid_argument("setNumaPolicy: no such node");
+    }
+    configuredNode.store(node, std::memory_order_relaxed);
+    configuredPolicy.store((int)policy, std::memory_order_relaxed);
+}
+
+bool threadPinning(){
+    int p = configuredPin.load(std::memory_order_relaxed);
+    return p >= 0 ? p != 0 : environment().pin;
+}
+
+void setThreadPinning(bool pin){
+    configuredPin.store(pin, std::memory_order_relaxed);
+}
+
+int numaChunkNode(int chunk, int chunks){
+    const Topology &t = topology();
+    if (t.nodes.empty() || chunks <= 0)
+        return 0;
+    return t.nodes[(long long)chunk * t.nodes.size() / chunks];
+}
+
+int numaRangeNode(long long index, long long count){
+    switch (numaPolicy()){
+    case NumaPolicy::FirstTouch:{
+        if (count <= 0)
+            return numaChunkNode(0, 1);
+        int chunks = splitChunks(count);
+        // the chunk c with c*count/chunks <= index < (c+1)*count/chunks, as parallelFor cuts the range
+        return numaChunkNode((int)((index * chunks + chunks - 1) / count), chunks);
+    }
+    case NumaPolicy::Bind:
+        return numaBindNode();
+    default:
+        return -1;
+    }
+}
+
+bool numaPlace(const void *data, size_t bytes, int node){
+#ifdef SYS_mbind
+    // only the pages lying entirely inside the buffer: the others are shared with neighbouring allocations
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t lo = ((uintptr_t)data + page - 1) / page * page, hi = ((uintptr_t)data + bytes) / page * page;
+    if (hi <= lo)
+        return false;
+    const Topology &t = topology();
+    int maxNode = t.nodes.empty() ? 0 : *std::max_element(t.nodes.begin(), t.nodes.end());
+    if (node > maxNode)
+        return false;
+    const int bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(maxNode / bits + 1);
+    if (node >= 0)
+        mask[node / bits] |= 1UL << (node % bits);
+    else if (t.nodes.empty())
+        mask[0] = 1;
+    else
+        for (int n: t.nodes)
+            mask[n / bits] |= 1UL << (n % bits);
+    int mode = node >= 0 ? LINALG_MPOL_BIND : LINALG_MPOL_INTERLEAVE;
+    return syscall(SYS_mbind, (void *)lo, hi - lo, mode, mask.data(), (unsigned long)mask.size() * bits + 1, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+void numaPlaceArray(const double *data, long long count){
+    NumaPolicy policy = numaPolicy();
+    if (policy == NumaPolicy::Default || count * (long long)sizeof(double) < NUMA_MIN_BYTES)
+        return;
+    if (policy != NumaPolicy::FirstTouch){
+        numaPlace(data, count * sizeof(double), numaRangeNode(0, count));
+        return;
+    }
+    int chunks = splitChunks(count);
+    for (int c = 0; c < chunks; c++){
+        long long lo = count * c / chunks, hi = count * (c + 1) / chunks;
+        numaPlace(data + lo, (hi - lo) * sizeof(double), numaChunkNode(c, chunks));
+    }
+}
+
+NumaPin::NumaPin(int node){
+    int index = node < 0 ? -1 : nodeIndex(node);
+    if (index < 0)
+        return;
+    cpu_set_t old, set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof old, &old) != 0)
+        return;
+    CPU_ZERO(&set);
+    for (int cpu: topology().cpus[index])
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof set, &set) != 0)
+        return;
+    saved.assign((unsigned long *)&old, (unsigned long *)&old + sizeof old / sizeof(unsigned long));
+}
+
+NumaPin::~NumaPin(){
+    if (saved.empty())
+        return;
+    cpu_set_t old;
+    std::memcpy(&old, saved.data(), sizeof old);
+    pthread_setaffinity_np(pthread_self(), sizeof old, &old);
+}
@@ -0,0 +1,100 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+#pragma once
+
+// NUMA placement of large buffers and pinning of worker threads, for multi-socket machines where a page lives on the
+// node of the thread that first touched it. Placement is decided before the first touch with mbind(2), so it does not
+// depend on which thread constructs a Matrix; pinning keeps the threads of parallelFor and of the Executor on the node
+// holding the data they work on. On a single node machine, or without these system calls, everything here is a no-op.
+
+// buffers smaller than this (in bytes) are never placed: they fit in cache or are not worth a system call
+#define NUMA_MIN_BYTES (1 << 22)
+
+/**
+ * @brief Where Matrix(m, n) and Vector(n) put their elements. FirstTouch splits the columns (the elements of a Vector)
+ * the way parallelFor splits them and puts each chunk on the node of the thread that processes it, as if that thread had
+ * initialized it; Interleave spreads pages round-robin over all nodes (for data read by every thread); Bind puts
+ * everything on one node. Default leaves placement to the kernel (the constructing thread's node).
+ *
+ */
+enum class NumaPolicy{Default, FirstTouch, Interleave, Bind};
+
+/**
+ * @brief Returns the number of NUMA nodes with CPUs, 1 if the topology cannot be read.
+ */
+int numaNodeCount();
+
+/**
+ * @brief Returns the allocation policy: the one set by setNumaPolicy if any, otherwise the LINALG_NUMA environment
+ * variable (first-touch, interleave, bind or bind:<node>), otherwise Default.
+ */
+NumaPolicy numaPolicy();
+
+/**
+ * @brief Returns the node used by NumaPolicy::Bind.
+ */
+int numaBindNode();
+
+/**
+ * @brief Sets the allocation policy of the matrices and vectors constructed from now on.
+ *
+ * @param node the node for NumaPolicy::Bind, ignored otherwise
+ */
+void setNumaPolicy(NumaPolicy policy, int node = 0);
+
+/**
+ * @brief Returns whether the threads of parallelFor and of the Executor are pinned to nodes: set by setThreadPinning,
+ * otherwise by the LINALG_PIN_THREADS environment variable, off by default.
+ */
+bool threadPinning();
+
+/**
+ * @brief Pins (or stops pinning) the parallel loops started from now on, and the Executor workers started from now on.
+ * Chunk c of k in parallelFor runs on a worker pinned to node numaChunkNode(c, k), which is where NumaPolicy::FirstTouch
+ * put the data of that chunk; such workers are pinned once, when they start, and serve only their node.
+ */
+void setThreadPinning(bool pin);
+
+/**
+ * @brief The node serving chunk of chunks: the chunks are dealt to the nodes in contiguous groups.
+ */
+int numaChunkNode(int chunk, int chunks);
+
+/**
+ * @brief The node the current policy assigns to element index of a range [0, count) split by parallelFor,
+ * -1 for Interleave (every node). Not meaningful under Default, which places nothing.
+ */
+int numaRangeNode(long long index, long long count);
+
+/**
+ * @brief Applies a placement to the whole pages of [data, data + bytes), which must not have been touched yet
+ * (pages already present keep their node). node is a node number, or -1 to interleave over all nodes.
+ *
+ * @return bool whether the placement was applied
+ */
+bool numaPlace(const void *data, size_t bytes, int node);
+
+/**
+ * @brief Applies the current policy to a buffer of count doubles, as Vector(n) does.
+ */
+void numaPlaceArray(const double *data, long long count);
+
+/**
+ * @brief Pins the calling thread to the CPUs of a node for its lifetime, and restores the previous affinity on destruction.
+ * A negative node leaves the thread alone.
+ *
+ */
+class NumaPin{
+    std::vector<unsigned long> saved;
+public:
+    explicit NumaPin(int node);
+    ~NumaPin();
+    NumaPin(const NumaPin &) = delete;
+    NumaPin &operator=(const NumaPin &) = delete;
+};
+
+#endif
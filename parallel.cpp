@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include "parallel.h"
+#include "numa.h"
+#include "tuning.h"
+
+namespace{
+
+std::atomic<int> configured{0};
+
+// set on the pool workers, and on the caller while it runs a chunk, so that nested loops run inline
+thread_local bool insideChunk = false;
+
+// the LINALG_NUM_THREADS environment variable, 0 if unset
+int environmentThreads(){
+    static const int n = []{
+        if (const char *env = std::getenv("LINALG_NUM_THREADS")){
+            int t = std::atoi(env);
+            if (t > 0)
+                return t;
+        }
+        return 0;
+    }();
+    return n;
+}
+
+
+// one call of parallelFor: its chunks are claimed once each, by the pool workers or by the caller
+struct Loop{
+    const std::function<void(int, long long, long long)> *body;
+    long long begin, len;
+    int chunks;
+    bool pin;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::mutex lock;
+    std::condition_variable finished;
+    int pending;
+    std::exception_ptr error;
+
+    Loop(const std::function<void(int, long long, long long)> &body, long long begin, long long len, int chunks, bool pin):
+        body(&body), begin(begin), len(len), chunks(chunks), pin(pin), claimed(new std::atomic<bool>[chunks]()), pending(chunks){}
+
+    bool claim(int c){
+        return !claimed[c].exchange(true);
+    }
+
+    // chunk c covers [begin + c*len/chunks, begin + (c+1)*len/chunks): lengths differ by at most one
+    void run(int c){
+        try{
+            (*body)(c, begin + len * c / chunks, begin + len * (c + 1) / chunks);
+        }
+        catch (...){
+            std::lock_guard<std::mutex> guard(lock);
+            if (!error)
+                error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if (--pending == 0)
+            finished.notify_all();
+    }
+};
+
+// The workers behind parallelFor, started on first use and kept for the life of the process: a loop costs a queue push
+// and a wake-up per chunk instead of a thread creation. Unpinned loops share one queue; pinned loops have one queue per
+// node, served by workers pinned to that node once, when they start. Each set grows to the largest loop asked for.
+// The pool is never destroyed, since its detached workers may still be waiting on it at exit.
+class Pool{
+    typedef std::pair<std::shared_ptr<Loop>, int> Job;
+    struct Queue{
+        std::deque<Job> jobs;
+        std::condition_variable available;
+        int workers = 0;
+    };
+    std::mutex lock;
+    // queues[g] serves node numaChunkNode(g, nodes), queues[nodes] the unpinned loops
+    int nodes = numaNodeCount();
+    std::vector<Queue> queues = std::vector<Queue>(nodes + 1);
+
+    void work(int q){
+        NumaPin pinned(q < nodes ? numaChunkNode(q, nodes) : -1);
+        insideChunk = true;
+        Queue &queue = queues[q];
+        for (;;){
+            Job job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                queue.available.wait(guard, [&]{ return !queue.jobs.empty(); });
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+            // the caller may have run the chunk itself while it waited in the queue
+            if (job.first->claim(job.second))
+                job.first->run(job.second);
+        }
+    }
+
+    // the queue of the node of a pinned chunk
+    int queueOf(int chunk, int chunks){
+        int node = numaChunkNode(chunk, chunks);
+        for (int g = 0; g < nodes; g++)
+            if (numaChunkNode(g, nodes) == node)
+                return g;
+        return 0;
+    }
+
+public:
+    // queues chunks 1 .. chunks-1 of the loop, chunk 0 being the caller's
+    void submit(const std::shared_ptr<Loop> &loop){
+        std::vector<int> count(queues.size());
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (int c = 1; c < loop->chunks; c++){
+                int q = loop->pin ? queueOf(c, loop->chunks) : nodes;
+                queues[q].jobs.emplace_back(loop, c);
+                count[q]++;
+            }
+            for (int q = 0; q <= nodes; q++)
+                for (; queues[q].workers < count[q]; queues[q].workers++)
+                    std::thread([this, q]{ work(q); }).detach();
+        }
+        for (int q = 0; q <= nodes; q++)
+            if (count[q])
+                queues[q].available.notify_all();
+    }
+};
+
+std::atomic<Pool *> current{nullptr};
+
+// A forked child inherits only the forking thread, not the workers: it starts a pool of its own (the parent's, whose
+// lock may have been held at the fork, is left alone).
+Pool &pool(){
+    Pool *p = current.load(std::memory_order_acquire);
+    if (p)
+        return *p;
+    static const int registered = pthread_atfork(nullptr, nullptr, []{ current.store(nullptr); });
+    (void)registered;
+    Pool *fresh = new Pool;
+    if (current.compare_exchange_strong(p, fresh, std::memory_order_acq_rel))
+        return *fresh;
+    delete fresh;
+    return *p;
+}
+
+}
+
+int threadCount(){
+    int t = configured.load(std::memory_order_relaxed);
+    if (t > 0)
+        return t;
+    if ((t = environmentThreads()) > 0)
+        return t;
+    if ((t = tuning().threads) > 0)
+        return t;
+    static const int hardware = std::max(1, (int)std::thread::hardware_concurrency());
+    return hardware;
+}
+
+void setThreadCount(int threads){
+    configured.store(std::max(0, threads), std::memory_order_relaxed);
+}
+
+int parallelChunks(long long begin, long long end, long long grain, int threads){
+    if (end <= begin)
+        return 0;
+    if (insideChunk)
+        return 1;
+    if (threads <= 0)
+        threads = threadCount();
+    long long len = end - begin;
+    return (int)std::max(1LL, std::min((long long)threads, len / std::max(1LL, grain)));
+}
+
+int parallelFor(long long begin, long long end, const std::function<void(int, long long, long long)> &body, long long grain, int threads){
+    int chunks = parallelChunks(begin, end, grain, threads);
+    if (chunks == 0)
+        return 0;
+    if (chunks == 1){
+        body(0, begin, end);
+        return 1;
+    }
+    auto loop = std::make_shared<Loop>(body, begin, end - begin, chunks, threadPinning());
+    pool().submit(loop);
+    auto run = [&](int c){
+        NumaPin pinned(loop->pin ? numaChunkNode(c, chunks) : -1);
+        insideChunk = true;
+        loop->run(c);
+        insideChunk = false;
+    };
+    // chunk 0, then whatever the workers have not started yet, e.g. while they are busy with the loops of other threads
+    loop->claim(0);
+    run(0);
+    for (int c = 1; c < chunks; c++)
+        if (loop->claim(c))
+            run(c);
+    {
+        std::unique_lock<std::mutex> guard(loop->lock);
+        loop->finished.wait(guard, [&]{ return loop->pending == 0; });
+    }
+    if (loop->error)
+        std::rethrow_exception(loop->error);
+    return chunks;
+}
@@ -0,0 +1,45 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+#pragma once
+
+// Minimal fork-join parallelism for the blocked kernels: a range is cut into contiguous chunks, one per thread.
+// The calling thread takes the first chunk itself, so a single-chunk loop runs inline; the others go to a pool of worker
+// threads started on first use and kept until exit, and the caller also takes those no worker has started by then.
+// A parallelFor inside the body of another runs inline as one chunk, so nested kernels do not oversubscribe the machine.
+// With threadPinning() on (see numa.h), chunk c of k runs on the CPUs of node numaChunkNode(c, k): the workers serving a
+// node are pinned to it once, when they start, and the caller only while it runs a chunk.
+
+/**
+ * @brief Returns the number of threads the parallel kernels use: the value set by setThreadCount if any,
+ * otherwise the LINALG_NUM_THREADS environment variable, otherwise the tuned count (see tuning.h), otherwise the number of hardware threads.
+ */
+int threadCount();
+
+/**
+ * @brief Sets the number of threads the parallel kernels use. 0 restores the default.
+ */
+void setThreadCount(int threads);
+
+/**
+ * @brief Calls body(chunk, lo, hi) on disjoint contiguous chunks [lo, hi) covering [begin, end), concurrently, and waits for all of them.
+ * Chunks are numbered 0 .. chunks-1 in order, so the body can write per-chunk partial results without locking.
+ * An exception thrown by a chunk is rethrown in the caller once all chunks are done.
+ *
+ * @param begin first index
+ * @param end one past the last index
+ * @param body the work on one chunk
+ * @param grain the minimal chunk length, so that small ranges are not split into chunks too small to pay for a thread
+ * @param threads the number of chunks to aim for, 0 for threadCount()
+ * @return int the number of chunks used
+ */
+int parallelFor(long long begin, long long end, const std::function<void(int, long long, long long)> &body, long long grain = 1, int threads = 0);
+
+/**
+ * @brief Returns the number of chunks parallelFor would use for the same arguments, e.g. to size per-chunk buffers beforehand.
+ */
+int parallelChunks(long long begin, long long end, long long grain = 1, int threads = 0);
+
+#endif
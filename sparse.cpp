@@ -0,0 +1,581 @@
+#include <algorithm>
+#include <numeric>
+#include "sparse.h"
+#include "parallel.h"
+
+// entries below which the sparse products run on one thread
+#define SPARSE_PARALLEL_MIN (1 << 18)
+// nested dissection stops splitting pieces of at most this many vertices, and orders them by minimum degree
+#define ND_LEAF 256
+
+namespace{
+
+void checkSize(bool ok, const char *where){
+    if (!ok){
+        std::cerr << where << ": dimension mismatch" << std::endl;
+        throw std::invalid_argument(std::string(where) + ": dimension mismatch");
+    }
+}
+
+// ------------------------------- approximate minimum degree ------------------------------- //
+
+enum NodeState: char{ Variable, Element, Absorbed, Merged };
+
+// Approximate minimum degree ordering of the graph with adjacency lists adj[xadj[i] .. xadj[i+1]-1] (no self loops),
+// on the quotient graph: an eliminated pivot p becomes an element whose list Le[p] holds the variables it connects,
+// instead of a clique of fill edges. Each variable keeps the elements E_i and the variables A_i it is adjacent to.
+// Degrees are the AMD upper bound |A_i| + |Lp \ i| + sum over the other elements e of |Le \ Lp|, elements whose
+// variables all belong to the new element are absorbed into it, and variables with the same adjacency are merged
+// into supervariables, which are eliminated together.
+std::vector<int> minimumDegree(int n, const int *xadj, const int *adj){
+    std::vector<std::vector<int>> var(n), elem(n), le(n);
+    std::vector<int> nv(n, 1), deg(n), esize(n, 0);
+    std::vector<char> state(n, Variable);
+    // degree lists
+    std::vector<int> head(n + 1, -1), next(n, -1), prev(n, -1);
+    auto insert = [&](int i){
+        next[i] = head[deg[i]];
+        prev[i] = -1;
+        if (head[deg[i]] != -1)
+            prev[head[deg[i]]] = i;
+        head[deg[i]] = i;
+    };
+    auto remove = [&](int i){
+        if (prev[i] != -1)
+            next[prev[i]] = next[i];
+        else
+            head[deg[i]] = next[i];
+        if (next[i] != -1)
+            prev[next[i]] = prev[i];
+    };
+    // the variables merged into a supervariable follow it in a chain
+    std::vector<int> memberNext(n, -1), memberLast(n);
+    for (int i = 0; i < n; i++){
+        var[i].assign(adj + xadj[i], adj + xadj[i + 1]);
+        deg[i] = var[i].size();
+        memberLast[i] = i;
+        insert(i);
+    }
+    std::vector<int> flag(n, 0), w(n, 0), wflag(n, 0);
+    int mark = 0, wmark = 0;
+    std::vector<int> order, lp;
+    order.reserve(n);
+    int k = 0, mindeg = 0;
+    while (k < n){
+        while (head[mindeg] == -1)
+            mindeg++;
+        int p = head[mindeg];
+        remove(p);
+
+        // Lp: the variables adjacent to p directly or through its elements, which p absorbs
+        flag[p] = ++mark;
+        lp.clear();
+        for (int e: elem[p]){
+            if (state[e] != Element)
+                continue;
+            for (int i: le[e])
+                if (state[i] == Variable && flag[i] != mark){
+                    flag[i] = mark;
+                    lp.push_back(i);
+                }
+            state[e] = Absorbed;
+            std::vector<int>().swap(le[e]);
+        }
+        for (int i: var[p])
+            if (state[i] == Variable && flag[i] != mark){
+                flag[i] = mark;
+                lp.push_back(i);
+            }
+        std::vector<int>().swap(elem[p]);
+        std::vector<int>().swap(var[p]);
+        state[p] = Element;
+        le[p] = lp;
+        for (int i = p; i != -1; i = memberNext[i])
+            order.push_back(i);
+        k += nv[p];
+        int degme = 0;
+        for (int i: lp){
+            degme += nv[i];
+            remove(i);
+        }
+        esize[p] = degme;
+
+        // w[e] = |Le \ Lp| for the elements adjacent to Lp: the weight of an element only changes when it is created
+        wmark++;
+        for (int i: lp)
+            for (int e: elem[i]){
+                if (state[e] != Element)
+                    continue;
+                if (wflag[e] != wmark){
+                    wflag[e] = wmark;
+                    w[e] = esize[e];
+                }
+                w[e] -= nv[i];
+            }
+
+        // prune the adjacency of Lp, absorb the elements inside Lp, and bound the degrees
+        for (int i: lp){
+            auto &E = elem[i];
+            size_t o = 0;
+            int de = 0;
+            for (int e: E){
+                if (state[e] != Element)
+                    continue;
+                if (w[e] == 0){
+                    state[e] = Absorbed;
+                    std::vector<int>().swap(le[e]);
+                    continue;
+                }
+                E[o++] = e;
+                de += w[e];
+            }
+            E.resize(o);
+            E.push_back(p);
+            auto &V = var[i];
+            o = 0;
+            int dv = 0;
+            for (int j: V)
+                if (state[j] == Variable && flag[j] != mark){
+                    V[o++] = j;
+                    dv += nv[j];
+                }
+            V.resize(o);
+            int ext = degme - nv[i];
+            deg[i] = std::max(0, std::min({n - k - nv[i], deg[i] + ext, dv + de + ext}));
+        }
+
+        // supervariables: variables of Lp with the same elements and variables are indistinguishable from now on
+        std::vector<std::pair<unsigned long, int>> hashes;
+        hashes.reserve(lp.size());
+        for (int i: lp){
+            std::sort(elem[i].begin(), elem[i].end());
+            std::sort(var[i].begin(), var[i].end());
+            unsigned long h = 0;
+            for (int e: elem[i])
+                h += e;
+            for (int j: var[i])
+                h += j;
+            hashes.push_back({h, i});
+        }
+        std::sort(hashes.begin(), hashes.end());
+        for (size_t a = 0; a < hashes.size(); ){
+            size_t b = a;
+            while (b < hashes.size() && hashes[b].first == hashes[a].first)
+                b++;
+            for (size_t x = a; x < b; x++){
+                int i = hashes[x].second;
+                if (state[i] != Variable)
+                    continue;
+                for (size_t y = x + 1; y < b; y++){
+                    int j = hashes[y].second;
+                    if (state[j] != Variable || elem[j] != elem[i] || var[j] != var[i])
+                        continue;
+                    nv[i] += nv[j];
+                    deg[i] = std::max(0, deg[i] - nv[j]);
+                    nv[j] = 0;
+                    state[j] = Merged;
+                    memberNext[memberLast[i]] = j;
+                    memberLast[i] = memberLast[j];
+                    std::vector<int>().swap(elem[j]);
+                    std::vector<int>().swap(var[j]);
+                }
+            }
+            a = b;
+        }
+        for (int i: lp)
+            if (state[i] == Variable){
+                insert(i);
+                mindeg = std::min(mindeg, deg[i]);
+            }
+    }
+    return order;
+}
+
+// ------------------------------- nested dissection ------------------------------- //
+
+// Orders the vertices of the graph G (a symmetric pattern) by recursive bisection: each connected piece is split by
+// the middle level of a breadth-first level structure rooted at a pseudo-peripheral vertex, its two sides are ordered
+// first and the separator last, so that the fill stays inside the sides.
+class Dissection{
+    const int *xadj, *adj;
+    // part[v] is the piece v currently belongs to; seen and level serve the breadth-first searches
+    std::vector<int> part, seen, level, local;
+    int pieces = 0, visits = 0;
+    std::vector<int> &order;
+
+    // visits the vertices of piece id reachable from root, in breadth-first order, setting their level
+    std::vector<int> bfs(int root, int id){
+        int mark = ++visits;
+        std::vector<int> visit{root};
+        seen[root] = mark;
+        level[root] = 0;
+        for (size_t h = 0; h < visit.size(); h++){
+            int v = visit[h];
+            for (int q = xadj[v]; q < xadj[v + 1]; q++){
+                int u = adj[q];
+                if (part[u] == id && seen[u] != mark){
+                    seen[u] = mark;
+                    level[u] = level[v] + 1;
+                    visit.push_back(u);
+                }
+            }
+        }
+        return visit;
+    }
+
+    void leaf(const std::vector<int> &nodes);
+    void split(const std::vector<int> &nodes, int id);
+public:
+    Dissection(const SparseMatrix &G, std::vector<int> &order): xadj{G.columnPointers().data()}, adj{G.rowIndices().data()},
+        part(G.order().first, 0), seen(G.order().first, 0), level(G.order().first, 0), local(G.order().first, -1), order{order}{}
+
+    /**
+     * @brief Appends the ordered nodes to the order.
+     */
+    void dissect(const std::vector<int> &nodes);
+};
+
+}
+
+// ------------------------------- SparseMatrix ------------------------------- //
+
+SparseMatrix::SparseMatrix(int m, int n): m{m}, n{n}, colptr(n + 1, 0){
+    if (m < 0 || n < 0){
+        std::cerr << "SparseMatrix: negative dimension" << std::endl;
+        throw std::invalid_argument("SparseMatrix: negative dimension");
+    }
+}
+
+SparseMatrix::SparseMatrix(int m, int n, std::vector<int> colptr, std::vector<int> rowind, std::vector<double> values):
+    m{m}, n{n}, colptr(std::move(colptr)), rowind(std::move(rowind)), val(std::move(values)){
+    bool ok = m >= 0 && n >= 0 && (int)this->colptr.size() == n + 1 && this->colptr[0] == 0
+        && this->colptr[n] == (long)this->rowind.size() && this->rowind.size() == val.size();
+    for (int j = 0; ok && j < n; j++)
+        ok = this->colptr[j] <= this->colptr[j + 1];
+    for (size_t q = 0; ok && q < this->rowind.size(); q++)
+        ok = this->rowind[q] >= 0 && this->rowind[q] < m;
+    if (!ok){
+        std::cerr << "SparseMatrix: invalid compressed column arrays" << std::endl;
+        throw std::invalid_argument("SparseMatrix: invalid compressed column arrays");
+    }
+    sortColumns();
+}
+
+void SparseMatrix::sortColumns(){
+    // sort each column by row and sum the duplicates, compacting in place
+    std::vector<std::pair<int, double>> col;
+    int out = 0;
+    for (int j = 0; j < n; j++){
+        int lo = colptr[j], hi = colptr[j + 1];
+        colptr[j] = out;
+        bool sorted = true;
+        for (int q = lo + 1; q < hi && sorted; q++)
+            sorted = rowind[q - 1] < rowind[q];
+        if (sorted){
+            for (int q = lo; q < hi; q++){
+                rowind[out] = rowind[q];
+                val[out++] = val[q];
+            }
+            continue;
+        }
+        col.clear();
+        for (int q = lo; q < hi; q++)
+            col.push_back({rowind[q], val[q]});
+        std::sort(col.begin(), col.end(), [](const std::pair<int, double> &a, const std::pair<int, double> &b){ return a.first < b.first; });
+        for (size_t q = 0; q < col.size(); q++){
+            if (out > colptr[j] && rowind[out - 1] == col[q].first)
+                val[out - 1] += col[q].second;
+            else{
+                rowind[out] = col[q].first;
+                val[out++] = col[q].second;
+            }
+        }
+    }
+    colptr[n] = out;
+    rowind.resize(out);
+    val.resize(out);
+}
+
+SparseMatrix SparseMatrix::fromTriplets(int m, int n, const std::vector<int> &rows, const std::vector<int> &cols, const std::vector<double> &values){
+    if (rows.size() != cols.size() || rows.size() != values.size()){
+        std::cerr << "SparseMatrix::fromTriplets: arrays of different lengths" << std::endl;
+        throw std::invalid_argument("SparseMatrix::fromTriplets: arrays of different lengths");
+    }
+    std::vector<int> colptr(n + 1, 0);
+    for (size_t q = 0; q < cols.size(); q++){
+        if (cols[q] < 0 || cols[q] >= n || rows[q] < 0 || rows[q] >= m){
+            std::cerr << "SparseMatrix::fromTriplets: index out of range" << std::endl;
+            throw std::invalid_argument("SparseMatrix::fromTriplets: index out of range");
+        }
+        colptr[cols[q] + 1]++;
+    }
+    std::partial_sum(colptr.begin(), colptr.end(), colptr.begin());
+    std::vector<int> rowind(rows.size()), pos(colptr.begin(), colptr.end() - 1);
+    std::vector<double> val(rows.size());
+    for (size_t q = 0; q < cols.size(); q++){
+        int at = pos[cols[q]]++;
+        rowind[at] = rows[q];
+        val[at] = values[q];
+    }
+    return SparseMatrix(m, n, std::move(colptr), std::move(rowind), std::move(val));
+}
+
+SparseMatrix::SparseMatrix(const Matrix &A, double dropTolerance): m{A.order().first}, n{A.order().second}, colptr(n + 1, 0){
+    for (int j = 0; j < n; j++){
+        const double *a = A.at(j).data();
+        for (int i = 0; i < m; i++)
+            if (std::abs(a[i]) > dropTolerance){
+                rowind.push_back(i);
+                val.push_back(a[i]);
+            }
+        colptr[j + 1] = rowind.size();
+    }
+}
+
+double SparseMatrix::at(int i, int j) const{
+    if (i < 0 || j < 0 || i >= m || j >= n){
+        std::cerr << "Index out of range" << std::endl;
+        throw std::out_of_range("Index out of range");
+    }
+    auto lo = rowind.begin() + colptr[j], hi = rowind.begin() + colptr[j + 1];
+    auto it = std::lower_bound(lo, hi, i);
+    return it != hi && *it == i ? val[it - rowind.begin()] : 0;
+}
+
+bool SparseMatrix::samePattern(const SparseMatrix &B) const{
+    return m == B.m && n == B.n && colptr == B.colptr && rowind == B.rowind;
+}
+
+Vector SparseMatrix::operator*(const Vector &x) const{
+    Vector y(m);
+    gemv(1, *this, x, 0, y);
+    return y;
+}
+
+void SparseMatrix::gemv(double alpha, const SparseMatrix &A, const Vector &x, double beta, Vector &y){
+    LINALG_PROFILE("SparseMatrix::gemv", 2.0 * A.nonZeros(), 12.0 * A.nonZeros() + 8.0 * (A.n + 2.0 * A.m));
+    checkSize(x.size() == A.n && y.size() == A.m, "SparseMatrix::gemv");
+    double *py = y.data();
+    if (beta == 0)
+        std::fill(py, py + A.m, 0.0);
+    else if (beta != 1)
+        y *= beta;
+    if (alpha == 0)
+        return;
+    // the columns scatter into y: each chunk of columns accumulates into its own copy of y, which are summed afterwards
+    int threads = A.nonZeros() >= SPARSE_PARALLEL_MIN ? 0 : 1;
+    int chunks = parallelChunks(0, A.n, 1, threads);
+    std::vector<std::vector<double>> part(chunks > 1 ? chunks : 0);
+    const double *px = x.data();
+    parallelFor(0, A.n, [&](int c, long long lo, long long hi){
+        double *out = py;
+        if (chunks > 1){
+            part[c].assign(A.m, 0.0);
+            out = part[c].data();
+        }
+        for (long long j = lo; j < hi; j++){
+            double xj = alpha * px[j];
+            if (xj == 0)
+                continue;
+            for (int q = A.colptr[j]; q < A.colptr[j + 1]; q++)
+                out[A.rowind[q]] += A.val[q] * xj;
+        }
+    }, 1, threads);
+    if (chunks > 1)
+        parallelFor(0, A.m, [&](int, long long lo, long long hi){
+            for (auto &pc: part)
+                for (long long i = lo; i < hi; i++)
+                    py[i] += pc[i];
+        }, 1, threads);
+}
+
+void SparseMatrix::gemvT(double alpha, const SparseMatrix &A, const Vector &x, double beta, Vector &y){
+    LINALG_PROFILE("SparseMatrix::gemvT", 2.0 * A.nonZeros(), 12.0 * A.nonZeros() + 8.0 * (A.m + 2.0 * A.n));
+    checkSize(x.size() == A.m && y.size() == A.n, "SparseMatrix::gemvT");
+    double *py = y.data();
+    const double *px = x.data();
+    // each entry of y is the dot product of a column with x: the columns are independent
+    parallelFor(0, A.n, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++){
+            double s = 0;
+            for (int q = A.colptr[j]; q < A.colptr[j + 1]; q++)
+                s += A.val[q] * px[A.rowind[q]];
+            py[j] = (beta == 0 ? 0 : beta * py[j]) + alpha * s;
+        }
+    }, 1, A.nonZeros() >= SPARSE_PARALLEL_MIN ? 0 : 1);
+}
+
+SparseMatrix SparseMatrix::transposed() const{
+    SparseMatrix T(n, m);
+    T.rowind.resize(rowind.size());
+    T.val.resize(val.size());
+    for (int r: rowind)
+        T.colptr[r + 1]++;
+    std::partial_sum(T.colptr.begin(), T.colptr.end(), T.colptr.begin());
+    std::vector<int> pos(T.colptr.begin(), T.colptr.end() - 1);
+    // going through the columns in order leaves the rows of T sorted
+    for (int j = 0; j < n; j++)
+        for (int q = colptr[j]; q < colptr[j + 1]; q++){
+            int at = pos[rowind[q]]++;
+            T.rowind[at] = j;
+            T.val[at] = val[q];
+        }
+    return T;
+}
+
+SparseMatrix SparseMatrix::symmetricPattern() const{
+    if (m != n){
+        std::cerr << "SparseMatrix::symmetricPattern: the matrix is not square" << std::endl;
+        throw std::invalid_argument("SparseMatrix::symmetricPattern: the matrix is not square");
+    }
+    // count the entries of A + A^T column by column, skipping the diagonal and an entry already met in the other triangle
+    SparseMatrix T = transposed();
+    SparseMatrix S(n, n);
+    const SparseMatrix *both[] = {this, &T};
+    std::vector<int> flag(n, -1);
+    for (int pass = 0; pass < 2; pass++){
+        std::fill(flag.begin(), flag.end(), -1);
+        long nz = 0;
+        for (int j = 0; j < n; j++){
+            flag[j] = j;
+            for (const SparseMatrix *M: both)
+                for (int q = M->colptr[j]; q < M->colptr[j + 1]; q++){
+                    int i = M->rowind[q];
+                    if (flag[i] == j)
+                        continue;
+                    flag[i] = j;
+                    if (pass == 1)
+                        S.rowind[nz] = i;
+                    nz++;
+                }
+            if (pass == 0)
+                S.colptr[j + 1] = nz;
+            else
+                std::sort(S.rowind.begin() + S.colptr[j], S.rowind.begin() + S.colptr[j + 1]);
+        }
+        if (pass == 0){
+            S.rowind.resize(nz);
+            S.val.assign(nz, 1.0);
+        }
+    }
+    return S;
+}
+
+Matrix SparseMatrix::dense() const{
+    Matrix A(m, n);
+    for (int j = 0; j < n; j++){
+        double *a = A.at(j).data();
+        for (int q = colptr[j]; q < colptr[j + 1]; q++)
+            a[rowind[q]] = val[q];
+    }
+    return A;
+}
+
+// ------------------------------- orderings ------------------------------- //
+
+void Dissection::leaf(const std::vector<int> &nodes){
+    int k = nodes.size();
+    for (int a = 0; a < k; a++)
+        local[nodes[a]] = a;
+    std::vector<int> lx(k + 1, 0), la;
+    for (int a = 0; a < k; a++){
+        int v = nodes[a];
+        for (int q = xadj[v]; q < xadj[v + 1]; q++)
+            if (local[adj[q]] >= 0)
+                la.push_back(local[adj[q]]);
+        lx[a + 1] = la.size();
+    }
+    for (int a: minimumDegree(k, lx.data(), la.data()))
+        order.push_back(nodes[a]);
+    for (int v: nodes)
+        local[v] = -1;
+}
+
+void Dissection::dissect(const std::vector<int> &nodes){
+    int id = ++pieces;
+    for (int v: nodes)
+        part[v] = id;
+    // the connected components are ordered one after the other
+    for (int v: nodes)
+        if (part[v] == id){
+            std::vector<int> component = bfs(v, id);
+            int cid = ++pieces;
+            for (int u: component)
+                part[u] = cid;
+            split(component, cid);
+        }
+}
+
+void Dissection::split(const std::vector<int> &nodes, int id){
+    if ((int)nodes.size() <= ND_LEAF){
+        leaf(nodes);
+        return;
+    }
+    // pseudo-peripheral root: restart from a vertex of least degree in the last level while the depth grows
+    std::vector<int> visit = bfs(nodes[0], id);
+    int depth = level[visit.back()];
+    for (int sweep = 0; sweep < 8; sweep++){
+        int candidate = visit.back();
+        for (auto it = visit.rbegin(); it != visit.rend() && level[*it] == depth; ++it)
+            if (xadj[*it + 1] - xadj[*it] < xadj[candidate + 1] - xadj[candidate])
+                candidate = *it;
+        int root = visit[0];
+        std::vector<int> again = bfs(candidate, id);
+        if (level[again.back()] > depth){
+            visit = std::move(again);
+            depth = level[visit.back()];
+            continue;
+        }
+        // no deeper: keep the previous root's levels
+        visit = bfs(root, id);
+        break;
+    }
+    if (depth < 2){
+        // too compact for a level separator
+        leaf(nodes);
+        return;
+    }
+    // the separator is the middle level (by vertex count), less its vertices with no neighbor beyond it
+    std::vector<int> count(depth + 1, 0);
+    for (int v: visit)
+        count[level[v]]++;
+    int mid = 0;
+    for (int below = 0; mid < depth && (below += count[mid]) < (int)nodes.size() / 2; mid++)
+        ;
+    mid = std::min(std::max(mid, 1), depth - 1);
+    std::vector<int> first, second, separator;
+    for (int v: visit){
+        if (level[v] < mid)
+            first.push_back(v);
+        else if (level[v] > mid)
+            second.push_back(v);
+        else{
+            bool cut = false;
+            for (int q = xadj[v]; q < xadj[v + 1] && !cut; q++)
+                cut = part[adj[q]] == id && level[adj[q]] == mid + 1;
+            (cut ? separator : first).push_back(v);
+        }
+    }
+    dissect(first);
+    dissect(second);
+    order.insert(order.end(), separator.begin(), separator.end());
+}
+
+std::vector<int> fillReducingOrder(const SparseMatrix &A, SparseOrdering ordering){
+    int n = A.order().first;
+    LINALG_PROFILE("fillReducingOrder", 0, 8.0 * A.nonZeros());
+    SparseMatrix G = A.symmetricPattern();
+    if (ordering == SparseOrdering::Natural){
+        std::vector<int> perm(n);
+        std::iota(perm.begin(), perm.end(), 0);
+        return perm;
+    }
+    if (ordering == SparseOrdering::MinimumDegree)
+        return minimumDegree(n, G.columnPointers().data(), G.rowIndices().data());
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<int> all(n);
+    std::iota(all.begin(), all.end(), 0);
+    Dissection(G, order).dissect(std::move(all));
+    return order;
+}
@@ -0,0 +1,133 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <vector>
+#include "Matrix.h"
+
+#pragma once
+
+// Sparse matrices in compressed sparse column (CSC) storage, and the fill-reducing orderings used by the sparse direct
+// solvers (see sparseSolver.h). Column j holds the row indices rowIndices()[columnPointers()[j] .. columnPointers()[j+1]-1],
+// sorted and without duplicates, and the matching entries of values().
+
+/**
+ * @brief Symmetric permutations the sparse factorizations can eliminate in, to limit the fill of the factors.
+ * Natural keeps the given order. MinimumDegree is approximate minimum degree (AMD: quotient graph, element absorption,
+ * supervariables). NestedDissection splits the graph recursively by level-structure separators, numbering the separators
+ * last, and orders the small pieces by minimum degree; it gives less fill on large 2D and 3D meshes.
+ */
+enum class SparseOrdering{Natural, MinimumDegree, NestedDissection};
+
+/**
+ * @brief m*n sparse matrix in compressed sparse column storage.
+ *
+ */
+class SparseMatrix{
+    int m = 0, n = 0;
+    std::vector<int> colptr{0};
+    std::vector<int> rowind;
+    std::vector<double> val;
+
+    void sortColumns();
+public:
+    /**
+     * @brief Construct the empty (0*0) matrix.
+     */
+    SparseMatrix(){}
+
+    /**
+     * @brief Construct the m*n zero matrix (no stored entries).
+     */
+    SparseMatrix(int m, int n);
+
+    /**
+     * @brief Construct from CSC arrays, taking them over. Rows are sorted within each column and duplicate entries summed.
+     * Raises invalid_argument error if the arrays are inconsistent or an index is out of range.
+     *
+     * @param colptr n+1 nondecreasing offsets, starting at 0
+     * @param rowind the row index of every entry
+     * @param values the value of every entry
+     */
+    SparseMatrix(int m, int n, std::vector<int> colptr, std::vector<int> rowind, std::vector<double> values);
+
+    /**
+     * @brief Construct from (row, column, value) triplets in any order; duplicates are summed.
+     * Raises invalid_argument error if the arrays differ in length or an index is out of range.
+     */
+    static SparseMatrix fromTriplets(int m, int n, const std::vector<int> &rows, const std::vector<int> &cols, const std::vector<double> &values);
+
+    /**
+     * @brief Construct from a dense matrix, keeping the entries with |a(i,j)| > dropTolerance.
+     */
+    explicit SparseMatrix(const Matrix &A, double dropTolerance = 0);
+
+    /**
+     * @brief returns the order of the matrix as the pair {rows, columns}.
+     */
+    std::pair<int, int> order() const{ return {m, n}; }
+
+    /**
+     * @brief returns the number of stored entries.
+     */
+    long nonZeros() const{ return rowind.size(); }
+
+    const std::vector<int> &columnPointers() const{ return colptr; }
+    const std::vector<int> &rowIndices() const{ return rowind; }
+
+    /**
+     * @brief direct access to the stored values, e.g. to change the numbers and refactor with the same pattern.
+     */
+    double *values(){ return val.data(); }
+    const double *values() const{ return val.data(); }
+
+    /**
+     * @brief Returns the (i,j)th element, 0 if it is not stored, in O(log(entries of column j)).
+     * Throws out_of_range error if the indices are invalid.
+     */
+    double at(int i, int j) const;
+
+    /**
+     * @brief Checks if B stores exactly the same positions.
+     */
+    bool samePattern(const SparseMatrix &B) const;
+
+    /**
+     * @brief Returns A*x in 2*nonZeros() flops.
+     */
+    Vector operator*(const Vector &x) const;
+
+    /**
+     * @brief y = alpha*A*x + beta*y into a caller-provided y, as Matrix::gemv.
+     */
+    static void gemv(double alpha, const SparseMatrix &A, const Vector &x, double beta, Vector &y);
+
+    /**
+     * @brief y = alpha*A^T*x + beta*y into a caller-provided y, as Matrix::gemvT.
+     */
+    static void gemvT(double alpha, const SparseMatrix &A, const Vector &x, double beta, Vector &y);
+
+    /**
+     * @brief Returns the transpose, in O(nonZeros() + m + n).
+     */
+    SparseMatrix transposed() const;
+
+    /**
+     * @brief Returns the pattern of A + A^T without the diagonal (all values 1), the adjacency graph the orderings work on.
+     * Raises invalid_argument error if the matrix is not square.
+     */
+    SparseMatrix symmetricPattern() const;
+
+    /**
+     * @brief Returns the dense matrix.
+     */
+    Matrix dense() const;
+};
+
+/**
+ * @brief Computes a fill-reducing symmetric ordering of the square matrix A, from the pattern of A + A^T.
+ *
+ * @return std::vector<int> perm, with perm[k] the index of the row and column eliminated kth
+ */
+std::vector<int> fillReducingOrder(const SparseMatrix &A, SparseOrdering ordering = SparseOrdering::MinimumDegree);
+
+#endif
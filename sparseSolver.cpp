@@ -0,0 +1,810 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include "sparseSolver.h"
+#include "view.h"
+#include "parallel.h"
+#include "task.h"
+
+// width of the column panels of the dense partial factorizations of the fronts
+#define FRONT_NB 64
+// factorizations below this many flops stay on one thread
+#define SPARSE_FACTOR_PARALLEL_MIN (1 << 22)
+// refinement steps of SparseLU::solve before giving up
+#define SPARSE_REFINEMENT_MAX_ITERATIONS 10
+
+namespace{
+
+void checkSize(bool ok, const char *where){
+    if (!ok){
+        std::cerr << where << ": dimension mismatch" << std::endl;
+        throw std::invalid_argument(std::string(where) + ": dimension mismatch");
+    }
+}
+
+// Cholesky factorization of the first w columns of the lower triangle of the nr*nr front F (column-major), in column
+// panels: the columns of a panel are factorized left-looking, then the trailing columns (the rest of the own columns
+// and the update matrix F[w.., w..]) are updated by gemm, one panel-width block column at a time.
+// Returns false at a pivot that is not positive.
+bool partialCholesky(double *F, int nr, int w){
+    MatrixView V(F, nr, nr, nr);
+    for (int k0 = 0; k0 < w; k0 += FRONT_NB){
+        int k1 = std::min(k0 + FRONT_NB, w);
+        for (int j = k0; j < k1; j++){
+            double *fj = F + (size_t)j * nr;
+            for (int k = k0; k < j; k++){
+                const double *fk = F + (size_t)k * nr;
+                double c = fk[j];
+                if (c != 0)
+                    for (int i = j; i < nr; i++)
+                        fj[i] -= c * fk[i];
+            }
+            if (!(fj[j] > 0))
+                return false;
+            double d = std::sqrt(fj[j]), inv = 1 / d;
+            fj[j] = d;
+            for (int i = j + 1; i < nr; i++)
+                fj[i] *= inv;
+        }
+        // only the lower part of each diagonal block is meaningful; gemm also updates the part above it
+        for (int j0 = k1; j0 < nr; j0 += FRONT_NB){
+            int jb = std::min(FRONT_NB, nr - j0);
+            gemm(-1, V.block(j0, k0, nr - j0, k1 - k0), V.block(j0, k0, jb, k1 - k0).transposed(), 1, V.block(j0, j0, nr - j0, jb));
+        }
+    }
+    return true;
+}
+
+// LU factorization of the first w columns of the nr*nr front F, with partial pivoting among its first w rows (the
+// rows the front owns), swapping whole rows. Pivots smaller than tau in magnitude are replaced by +-tau.
+// Each panel is factorized right-looking, then its block row of U is solved and the trailing matrix updated by gemm.
+// Returns the number of replaced pivots.
+int partialLU(double *F, int nr, int w, int *piv, double tau){
+    MatrixView V(F, nr, nr, nr);
+    int replaced = 0;
+    for (int k0 = 0; k0 < w; k0 += FRONT_NB){
+        int k1 = std::min(k0 + FRONT_NB, w);
+        for (int j = k0; j < k1; j++){
+            double *fj = F + (size_t)j * nr;
+            int p = j;
+            for (int i = j + 1; i < w; i++)
+                if (std::abs(fj[i]) > std::abs(fj[p]))
+                    p = i;
+            piv[j] = p;
+            if (p != j)
+                for (int c = 0; c < nr; c++)
+                    std::swap(F[(size_t)c * nr + j], F[(size_t)c * nr + p]);
+            if (!(std::abs(fj[j]) >= tau)){
+                fj[j] = fj[j] < 0 ? -tau : tau;
+                replaced++;
+            }
+            double inv = 1 / fj[j];
+            for (int i = j + 1; i < nr; i++)
+                fj[i] *= inv;
+            for (int c = j + 1; c < k1; c++){
+                double *fc = F + (size_t)c * nr;
+                double u = fc[j];
+                if (u != 0)
+                    for (int i = j + 1; i < nr; i++)
+                        fc[i] -= u * fj[i];
+            }
+        }
+        if (k1 == nr)
+            continue;
+        // U12 = L11^{-1} F[k0..k1-1, k1..]
+        for (int c = k1; c < nr; c++){
+            double *fc = F + (size_t)c * nr;
+            for (int j = k0; j < k1; j++){
+                double u = fc[j];
+                if (u == 0)
+                    continue;
+                const double *fj = F + (size_t)j * nr;
+                for (int i = j + 1; i < k1; i++)
+                    fc[i] -= u * fj[i];
+            }
+        }
+        gemm(-1, V.block(k1, k0, nr - k1, k1 - k0), V.block(k0, k1, k1 - k0, nr - k1), 1, V.block(k1, k1, nr - k1, nr - k1));
+    }
+    return replaced;
+}
+
+// A row for every column of the square matrix A, rowOf[j] having a nonzero in column j, as many as the pattern allows:
+// a maximum transversal by depth-first augmenting paths (Duff's MC21), after a greedy pass that gives each column its
+// largest unmatched entry. Columns left over (structurally singular matrices) get the rows left over.
+std::vector<int> transversal(const SparseMatrix &A){
+    int n = A.order().first;
+    const int *cp = A.columnPointers().data(), *ri = A.rowIndices().data();
+    const double *v = A.values();
+    std::vector<int> rowOf(n, -1), colOf(n, -1);
+    for (int j = 0; j < n; j++){
+        int best = -1;
+        for (int q = cp[j]; q < cp[j + 1]; q++)
+            if (v[q] != 0 && colOf[ri[q]] == -1 && (best == -1 || std::abs(v[q]) > std::abs(v[best])))
+                best = q;
+        if (best != -1){
+            rowOf[j] = ri[best];
+            colOf[ri[best]] = j;
+        }
+    }
+    // look[j] is how far the search for an unmatched row in column j got; it never needs to look again before that
+    std::vector<int> look(cp, cp + n), visited(n, -1), cols, next;
+    for (int j0 = 0; j0 < n; j0++){
+        if (rowOf[j0] != -1)
+            continue;
+        cols.assign(1, j0);
+        next.assign(1, cp[j0]);
+        int found = -1;
+        while (!cols.empty()){
+            int j = cols.back();
+            for (; look[j] < cp[j + 1] && found == -1; look[j]++)
+                if (v[look[j]] != 0 && colOf[ri[look[j]]] == -1)
+                    found = ri[look[j]];
+            if (found != -1)
+                break;
+            // otherwise take a matched row not seen yet, and look for a new row for its column
+            int &q = next.back();
+            while (q < cp[j + 1] && (v[q] == 0 || visited[ri[q]] == j0))
+                q++;
+            if (q == cp[j + 1]){
+                cols.pop_back();
+                next.pop_back();
+                continue;
+            }
+            int i = ri[q++];
+            visited[i] = j0;
+            cols.push_back(colOf[i]);
+            next.push_back(cp[colOf[i]]);
+        }
+        // augment: every column on the path takes the row the next one gives up
+        for (int k = (int)cols.size() - 1, i = found; found != -1 && k >= 0; k--){
+            int previous = rowOf[cols[k]];
+            rowOf[cols[k]] = i;
+            colOf[i] = cols[k];
+            i = previous;
+        }
+    }
+    for (int j = 0, i = 0; j < n; j++)
+        if (rowOf[j] == -1){
+            while (colOf[i] != -1)
+                i++;
+            rowOf[j] = i;
+            colOf[i] = j;
+        }
+    return rowOf;
+}
+
+double maxAbs(const double *x, int n){
+    double m = 0;
+    for (int i = 0; i < n; i++)
+        m = std::max(m, std::abs(x[i]));
+    return m;
+}
+
+}
+
+// ------------------------------- symbolic analysis ------------------------------- //
+
+SparseSymbolic::SparseSymbolic(const SparseMatrix &A, SparseOrdering ordering, bool permuteRows): n{A.order().first},
+    colptr(A.columnPointers()), rowind(A.rowIndices()){
+    LINALG_PROFILE("SparseSymbolic::SparseSymbolic", 0, 8.0 * A.nonZeros());
+    if (n != A.order().second){
+        std::cerr << "SparseSymbolic: the matrix is not square" << std::endl;
+        throw std::invalid_argument("SparseSymbolic: the matrix is not square");
+    }
+    // the analyzed matrix B has the rows of A in the order rowOf: row i of A is row rowPos[i] of B
+    rowOf.resize(n);
+    std::iota(rowOf.begin(), rowOf.end(), 0);
+    if (permuteRows)
+        rowOf = transversal(A);
+    std::vector<int> rowPos(n);
+    for (int k = 0; k < n; k++)
+        rowPos[rowOf[k]] = k;
+    std::vector<int> browind(rowind.size());
+    for (size_t q = 0; q < rowind.size(); q++)
+        browind[q] = rowPos[rowind[q]];
+    SparseMatrix B(n, n, colptr, std::move(browind), std::vector<double>(rowind.size(), 1.0));
+    SparseMatrix G = B.symmetricPattern();
+    const int *xadj = G.columnPointers().data(), *adj = G.rowIndices().data();
+    std::vector<int> order = fillReducingOrder(B, ordering);
+
+    // elimination tree of the reordered pattern (Liu's algorithm, with path compression through ancestor)
+    pinv.assign(n, 0);
+    for (int k = 0; k < n; k++)
+        pinv[order[k]] = k;
+    std::vector<int> parent(n, -1), ancestor(n, -1);
+    for (int k = 0; k < n; k++)
+        for (int q = xadj[order[k]]; q < xadj[order[k] + 1]; q++)
+            for (int i = pinv[adj[q]]; i != -1 && i < k; ){
+                int next = ancestor[i];
+                ancestor[i] = k;
+                if (next == -1)
+                    parent[i] = k;
+                i = next;
+            }
+
+    // postorder the tree, so that every subtree is a contiguous range of columns ending at its root
+    std::vector<int> head(n, -1), next(n, -1), post, stack;
+    post.reserve(n);
+    for (int j = n - 1; j >= 0; j--)
+        if (parent[j] != -1){
+            next[j] = head[parent[j]];
+            head[parent[j]] = j;
+        }
+    for (int r = 0; r < n; r++){
+        if (parent[r] != -1)
+            continue;
+        stack.push_back(r);
+        while (!stack.empty()){
+            int top = stack.back(), child = head[top];
+            if (child == -1){
+                stack.pop_back();
+                post.push_back(top);
+            }
+            else{
+                head[top] = next[child];
+                stack.push_back(child);
+            }
+        }
+    }
+    std::vector<int> renumber(n), etree(n);
+    perm.resize(n);
+    for (int k = 0; k < n; k++){
+        renumber[post[k]] = k;
+        perm[k] = order[post[k]];
+    }
+    for (int k = 0; k < n; k++){
+        pinv[perm[k]] = k;
+        etree[k] = parent[post[k]] == -1 ? -1 : renumber[parent[post[k]]];
+    }
+
+    // strictly lower pattern of the reordered matrix, by columns
+    std::vector<int> lp(n + 1, 0), li(G.nonZeros() / 2);
+    for (int j = 0; j < n; j++)
+        for (int q = xadj[perm[j]]; q < xadj[perm[j] + 1]; q++)
+            if (pinv[adj[q]] > j)
+                lp[j + 1]++;
+    std::partial_sum(lp.begin(), lp.end(), lp.begin());
+    for (int j = 0; j < n; j++){
+        int at = lp[j];
+        for (int q = xadj[perm[j]]; q < xadj[perm[j] + 1]; q++)
+            if (pinv[adj[q]] > j)
+                li[at++] = pinv[adj[q]];
+    }
+
+    // column counts of L (with the diagonal), from the row subtrees: the algorithm of Gilbert, Ng and Peyton as in CSparse's cs_counts
+    std::vector<int> count(n), first(n, -1), maxfirst(n, -1), prevleaf(n, -1), nchild(n, 0);
+    for (int k = 0; k < n; k++){
+        count[k] = first[k] == -1;
+        for (int j = k; j != -1 && first[j] == -1; j = etree[j])
+            first[j] = k;
+    }
+    std::iota(ancestor.begin(), ancestor.end(), 0);
+    for (int j = 0; j < n; j++){
+        if (etree[j] != -1){
+            count[etree[j]]--;
+            nchild[etree[j]]++;
+        }
+        for (int q = lp[j]; q < lp[j + 1]; q++){
+            int i = li[q];
+            if (first[j] <= maxfirst[i])
+                continue;
+            // j is a leaf of the row subtree of i
+            maxfirst[i] = first[j];
+            int jprev = prevleaf[i];
+            prevleaf[i] = j;
+            count[j]++;
+            if (jprev == -1)
+                continue;
+            // subtract at the least common ancestor of j and the previous leaf
+            int lca = jprev;
+            while (lca != ancestor[lca])
+                lca = ancestor[lca];
+            for (int s = jprev; s != lca; ){
+                int up = ancestor[s];
+                ancestor[s] = lca;
+                s = up;
+            }
+            count[lca]--;
+        }
+        if (etree[j] != -1)
+            ancestor[j] = etree[j];
+    }
+    for (int j = 0; j < n; j++)
+        if (etree[j] != -1)
+            count[etree[j]] += count[j];
+
+    // fundamental supernodes (a chain of columns whose structures nest exactly), then relaxed amalgamation: a supernode
+    // is merged into its parent when they are adjacent and the explicit zeros this adds to L stay few (the rules of CHOLMOD)
+    struct Group{
+        int first, width, rows;
+        double zeros;
+    };
+    std::vector<Group> groups;
+    for (int j = 0; j < n; ){
+        Group t{j, 1, count[j], 0};
+        while (j + t.width < n && etree[j + t.width - 1] == j + t.width && nchild[j + t.width] == 1 && count[j + t.width] == count[j + t.width - 1] - 1)
+            t.width++;
+        j += t.width;
+        while (!groups.empty()){
+            const Group &s = groups.back();
+            int p = etree[s.first + s.width - 1];
+            if (p < t.first || p >= t.first + t.width)
+                break;
+            int width = s.width + t.width, rows = s.width + t.rows;
+            double zeros = s.zeros + t.zeros + (double)s.width * (t.rows - (s.rows - s.width));
+            double z = zeros / ((double)width * rows - (double)width * (width - 1) / 2);
+            if (!(width <= 4 || (width <= 16 && z < 0.8) || (width <= 48 && z < 0.1) || z < 0.05))
+                break;
+            t = Group{s.first, width, rows, zeros};
+            groups.pop_back();
+        }
+        groups.push_back(t);
+    }
+    int ns = groups.size();
+    std::vector<int> superOf(n);
+    super.resize(ns + 1);
+    for (int s = 0; s < ns; s++){
+        super[s] = groups[s].first;
+        std::fill(superOf.begin() + groups[s].first, superOf.begin() + groups[s].first + groups[s].width, s);
+    }
+    super[ns] = n;
+    superParent.assign(ns, -1);
+    childStart.assign(ns + 1, 0);
+    for (int s = 0; s < ns; s++){
+        int p = etree[super[s + 1] - 1];
+        if (p != -1){
+            superParent[s] = superOf[p];
+            childStart[superOf[p] + 1]++;
+        }
+    }
+    std::partial_sum(childStart.begin(), childStart.end(), childStart.begin());
+    children.resize(childStart[ns]);
+    {
+        std::vector<int> at(childStart.begin(), childStart.end() - 1);
+        for (int s = 0; s < ns; s++)
+            if (superParent[s] != -1)
+                children[at[superParent[s]]++] = s;
+    }
+
+    // rows of each supernode: its own columns, then the rows of its lower entries and of its children below it
+    std::vector<int> mark(n, -1), pos(n, -1), below;
+    rowStart.assign(ns + 1, 0);
+    relStart.assign(ns, 0);
+    for (int s = 0; s < ns; s++){
+        int f = super[s], l = super[s + 1] - 1;
+        for (int j = f; j <= l; j++){
+            rows.push_back(j);
+            mark[j] = s;
+        }
+        below.clear();
+        for (int j = f; j <= l; j++)
+            for (int q = lp[j]; q < lp[j + 1]; q++)
+                if (mark[li[q]] != s){
+                    mark[li[q]] = s;
+                    below.push_back(li[q]);
+                }
+        for (int c = childStart[s]; c < childStart[s + 1]; c++){
+            int child = children[c], cw = super[child + 1] - super[child];
+            for (int q = rowStart[child] + cw; q < rowStart[child + 1]; q++)
+                if (mark[rows[q]] != s){
+                    mark[rows[q]] = s;
+                    below.push_back(rows[q]);
+                }
+        }
+        std::sort(below.begin(), below.end());
+        rows.insert(rows.end(), below.begin(), below.end());
+        rowStart[s + 1] = rows.size();
+        for (int q = rowStart[s]; q < rowStart[s + 1]; q++)
+            pos[rows[q]] = q - rowStart[s];
+        for (int c = childStart[s]; c < childStart[s + 1]; c++){
+            int child = children[c], cw = super[child + 1] - super[child];
+            relStart[child] = rel.size();
+            for (int q = rowStart[child] + cw; q < rowStart[child + 1]; q++)
+                rel.push_back(pos[rows[q]]);
+        }
+    }
+
+    // assembly of A: entry (i, j) goes to the front of the supernode of its leftmost reordered index
+    assemblyStart.assign(ns + 1, 0);
+    for (int j = 0; j < n; j++)
+        for (int q = colptr[j]; q < colptr[j + 1]; q++)
+            assemblyStart[superOf[std::min(pinv[rowPos[rowind[q]]], pinv[j])] + 1]++;
+    std::partial_sum(assemblyStart.begin(), assemblyStart.end(), assemblyStart.begin());
+    assembly.resize(assemblyStart[ns]);
+    {
+        std::vector<int> at(assemblyStart.begin(), assemblyStart.end() - 1);
+        auto local = [&](int s, int x){
+            if (x < super[s + 1])
+                return x - super[s];
+            auto lo = rows.begin() + rowStart[s] + (super[s + 1] - super[s]), hi = rows.begin() + rowStart[s + 1];
+            return (int)(std::lower_bound(lo, hi, x) - (rows.begin() + rowStart[s]));
+        };
+        for (int j = 0; j < n; j++)
+            for (int q = colptr[j]; q < colptr[j + 1]; q++){
+                int r = pinv[rowPos[rowind[q]]], c = pinv[j], s = superOf[std::min(r, c)];
+                assembly[at[s]++] = Entry{q, local(s, r), local(s, c), rowind[q] >= j};
+            }
+    }
+
+    // storage of the factors, and the work of each front and subtree
+    lStart.assign(ns + 1, 0);
+    uStart.assign(ns + 1, 0);
+    work.assign(ns, 0);
+    subtreeWork.assign(ns, 0);
+    firstDescendant.resize(ns);
+    std::iota(firstDescendant.begin(), firstDescendant.end(), 0);
+    for (int s = 0; s < ns; s++){
+        long w = super[s + 1] - super[s], nr = rowStart[s + 1] - rowStart[s];
+        lStart[s + 1] = lStart[s] + nr * w;
+        uStart[s + 1] = uStart[s] + w * (nr - w);
+        for (long k = 0; k < w; k++)
+            work[s] += (double)(nr - k) * (nr - k);
+        flops += work[s];
+        subtreeWork[s] += work[s];
+        if (superParent[s] != -1){
+            subtreeWork[superParent[s]] += subtreeWork[s];
+            firstDescendant[superParent[s]] = std::min(firstDescendant[superParent[s]], firstDescendant[s]);
+        }
+    }
+}
+
+long SparseSymbolic::factorNonZeros() const{
+    long nz = 0;
+    for (int s = 0; s < supernodes(); s++){
+        long w = super[s + 1] - super[s], nr = rowStart[s + 1] - rowStart[s];
+        nz += w * nr - w * (w - 1) / 2;
+    }
+    return nz;
+}
+
+bool SparseSymbolic::matches(const SparseMatrix &A) const{
+    return A.order().first == n && A.order().second == n && A.columnPointers() == colptr && A.rowIndices() == rowind;
+}
+
+void SparseSymbolic::traverse(const std::function<void(int)> &factor) const{
+    int ns = supernodes(), threads = threadCount();
+    std::vector<char> done(ns, 0);
+    double finished = 0;
+    if (threads > 1 && flops >= SPARSE_FACTOR_PARALLEL_MIN){
+        // split the heaviest subtree into its children until every subtree is at most a fraction of the work,
+        // then hand the subtrees to the threads, heaviest first to the least loaded (LPT scheduling)
+        double limit = flops / (2.0 * threads);
+        std::priority_queue<std::pair<double, int>> heap;
+        for (int s = 0; s < ns; s++)
+            if (superParent[s] == -1)
+                heap.push({subtreeWork[s], s});
+        while (!heap.empty() && heap.top().first > limit){
+            int s = heap.top().second;
+            heap.pop();
+            for (int c = childStart[s]; c < childStart[s + 1]; c++)
+                heap.push({subtreeWork[children[c]], children[c]});
+        }
+        std::vector<std::vector<int>> bins(threads);
+        std::vector<double> load(threads, 0);
+        for (; !heap.empty(); heap.pop()){
+            int b = std::min_element(load.begin(), load.end()) - load.begin();
+            bins[b].push_back(heap.top().second);
+            load[b] += heap.top().first;
+            finished += heap.top().first;
+        }
+        parallelFor(0, threads, [&](int, long long lo, long long hi){
+            for (long long b = lo; b < hi; b++)
+                for (int root: bins[b])
+                    for (int s = firstDescendant[root]; s <= root; s++)
+                        factor(s);
+        }, 1, threads);
+        for (auto &bin: bins)
+            for (int root: bin)
+                std::fill(done.begin() + firstDescendant[root], done.begin() + root + 1, 1);
+    }
+    // the top of the tree, in order
+    for (int s = 0; s < ns; s++){
+        if (done[s])
+            continue;
+        taskCheckpoint(flops > 0 ? finished / flops : 0);
+        factor(s);
+        finished += work[s];
+    }
+}
+
+// ------------------------------- Cholesky ------------------------------- //
+
+SparseCholesky::SparseCholesky(const SparseMatrix &A, SparseOrdering ordering): sym{std::make_shared<const SparseSymbolic>(A, ordering)}{
+    factorize(A);
+}
+
+SparseCholesky::SparseCholesky(std::shared_ptr<const SparseSymbolic> symbolic, const SparseMatrix &A): sym{std::move(symbolic)}{
+    for (int k = 0; k < sym->n; k++)
+        if (sym->rowOf[k] != k){
+            std::cerr << "SparseCholesky: the analysis permutes rows" << std::endl;
+            throw std::invalid_argument("SparseCholesky: the analysis permutes rows");
+        }
+    refactor(A);
+}
+
+void SparseCholesky::refactor(const SparseMatrix &A){
+    if (!sym->matches(A)){
+        std::cerr << "SparseCholesky::refactor: the matrix does not have the analyzed pattern" << std::endl;
+        throw std::invalid_argument("SparseCholesky::refactor: the matrix does not have the analyzed pattern");
+    }
+    factorize(A);
+}
+
+void SparseCholesky::factorize(const SparseMatrix &A){
+    const SparseSymbolic &S = *sym;
+    LINALG_PROFILE("SparseCholesky::factorize", S.flops, 8.0 * (S.lStart.back() + A.nonZeros()));
+    L.resize(S.lStart.back());
+    std::vector<std::vector<double>> update(S.supernodes());
+    std::atomic<bool> ok{true};
+    const double *a = A.values();
+    S.traverse([&](int s){
+        if (!ok)
+            return;
+        int w = S.super[s + 1] - S.super[s], nr = S.rowStart[s + 1] - S.rowStart[s], b = nr - w;
+        // the front: lower entries of A, then the update matrices of the children (lower triangles), added in place
+        std::vector<double> F((size_t)nr * nr, 0.0);
+        for (int e = S.assemblyStart[s]; e < S.assemblyStart[s + 1]; e++){
+            const SparseSymbolic::Entry &en = S.assembly[e];
+            if (en.lower)
+                F[(size_t)std::min(en.row, en.col) * nr + std::max(en.row, en.col)] += a[en.source];
+        }
+        for (int c = S.childStart[s]; c < S.childStart[s + 1]; c++){
+            int child = S.children[c];
+            const std::vector<double> &Uc = update[child];
+            int bc = S.rowStart[child + 1] - S.rowStart[child] - (S.super[child + 1] - S.super[child]);
+            const int *r = S.rel.data() + S.relStart[child];
+            for (int jj = 0; jj < bc; jj++){
+                double *f = F.data() + (size_t)r[jj] * nr;
+                const double *u = Uc.data() + (size_t)jj * bc;
+                for (int ii = jj; ii < bc; ii++)
+                    f[r[ii]] += u[ii];
+            }
+            std::vector<double>().swap(update[child]);
+        }
+        if (!partialCholesky(F.data(), nr, w)){
+            ok = false;
+            return;
+        }
+        std::copy(F.begin(), F.begin() + (size_t)nr * w, L.begin() + S.lStart[s]);
+        update[s].resize((size_t)b * b);
+        for (int j = 0; j < b; j++)
+            std::copy(F.begin() + (size_t)(w + j) * nr + w + j, F.begin() + (size_t)(w + j + 1) * nr, update[s].begin() + (size_t)j * b + j);
+    });
+    positiveDefinite = ok;
+}
+
+void SparseCholesky::solveInPlace(double *x) const{
+    if (!positiveDefinite){
+        std::cerr << "SparseCholesky::solve: matrix is not positive definite" << std::endl;
+        throw std::domain_error("SparseCholesky::solve: matrix is not positive definite");
+    }
+    const SparseSymbolic &S = *sym;
+    int n = S.n;
+    std::vector<double> y(n);
+    for (int k = 0; k < n; k++)
+        y[k] = x[S.perm[k]];
+    // L y = P b, one supernode at a time: the triangle of its own columns, then the rows below it
+    for (int s = 0; s < S.supernodes(); s++){
+        int f = S.super[s], w = S.super[s + 1] - f, nr = S.rowStart[s + 1] - S.rowStart[s];
+        const double *Ls = L.data() + S.lStart[s];
+        const int *R = S.rows.data() + S.rowStart[s];
+        for (int j = 0; j < w; j++){
+            const double *lj = Ls + (size_t)j * nr;
+            double yj = y[f + j] /= lj[j];
+            if (yj == 0)
+                continue;
+            for (int i = j + 1; i < w; i++)
+                y[f + i] -= lj[i] * yj;
+            for (int i = w; i < nr; i++)
+                y[R[i]] -= lj[i] * yj;
+        }
+    }
+    // L^T x = y, backwards
+    for (int s = S.supernodes() - 1; s >= 0; s--){
+        int f = S.super[s], w = S.super[s + 1] - f, nr = S.rowStart[s + 1] - S.rowStart[s];
+        const double *Ls = L.data() + S.lStart[s];
+        const int *R = S.rows.data() + S.rowStart[s];
+        for (int j = w - 1; j >= 0; j--){
+            const double *lj = Ls + (size_t)j * nr;
+            double t = y[f + j];
+            for (int i = j + 1; i < w; i++)
+                t -= lj[i] * y[f + i];
+            for (int i = w; i < nr; i++)
+                t -= lj[i] * y[R[i]];
+            y[f + j] = t / lj[j];
+        }
+    }
+    for (int k = 0; k < n; k++)
+        x[S.perm[k]] = y[k];
+}
+
+Vector SparseCholesky::solve(const Vector &b) const{
+    checkSize(b.size() == order(), "SparseCholesky::solve");
+    Vector x(b);
+    solveInPlace(x.data());
+    return x;
+}
+
+Matrix SparseCholesky::solve(const Matrix &B) const{
+    checkSize(B.order().first == order(), "SparseCholesky::solve");
+    Matrix X(B);
+    parallelFor(0, X.order().second, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++)
+            solveInPlace(X.at(j).data());
+    }, 1, (double)L.size() * X.order().second >= SPARSE_FACTOR_PARALLEL_MIN ? 0 : 1);
+    return X;
+}
+
+// ------------------------------- LU ------------------------------- //
+
+SparseLU::SparseLU(const SparseMatrix &A, SparseOrdering ordering): sym{std::make_shared<const SparseSymbolic>(A, ordering, true)}, A{A}{
+    factorize();
+}
+
+SparseLU::SparseLU(std::shared_ptr<const SparseSymbolic> symbolic, const SparseMatrix &A): sym{std::move(symbolic)}{
+    refactor(A);
+}
+
+void SparseLU::refactor(const SparseMatrix &A){
+    if (!sym->matches(A)){
+        std::cerr << "SparseLU::refactor: the matrix does not have the analyzed pattern" << std::endl;
+        throw std::invalid_argument("SparseLU::refactor: the matrix does not have the analyzed pattern");
+    }
+    this->A = A;
+    factorize();
+}
+
+void SparseLU::factorize(){
+    const SparseSymbolic &S = *sym;
+    LINALG_PROFILE("SparseLU::factorize", 2 * S.flops, 8.0 * (S.lStart.back() + S.uStart.back() + A.nonZeros()));
+    int n = S.n;
+    const double *a = A.values();
+    // infinity norm for the refinement, largest entry for the static pivots
+    std::vector<double> rowsum(n, 0.0);
+    double amax = 0;
+    for (long q = 0; q < A.nonZeros(); q++){
+        rowsum[A.rowIndices()[q]] += std::abs(a[q]);
+        amax = std::max(amax, std::abs(a[q]));
+    }
+    anorm = n > 0 ? *std::max_element(rowsum.begin(), rowsum.end()) : 0;
+    // an all-zero matrix gets unit pivots, and is reported singular by the solves
+    double tau = amax > 0 ? std::sqrt(DBL_EPSILON) * amax : 1;
+    L.resize(S.lStart.back());
+    U.resize(S.uStart.back());
+    piv.resize(n);
+    std::vector<std::vector<double>> update(S.supernodes());
+    std::atomic<int> replaced{0};
+    S.traverse([&](int s){
+        int f = S.super[s], w = S.super[s + 1] - f, nr = S.rowStart[s + 1] - S.rowStart[s], b = nr - w;
+        std::vector<double> F((size_t)nr * nr, 0.0);
+        for (int e = S.assemblyStart[s]; e < S.assemblyStart[s + 1]; e++){
+            const SparseSymbolic::Entry &en = S.assembly[e];
+            F[(size_t)en.col * nr + en.row] += a[en.source];
+        }
+        for (int c = S.childStart[s]; c < S.childStart[s + 1]; c++){
+            int child = S.children[c];
+            const std::vector<double> &Uc = update[child];
+            int bc = S.rowStart[child + 1] - S.rowStart[child] - (S.super[child + 1] - S.super[child]);
+            const int *r = S.rel.data() + S.relStart[child];
+            for (int jj = 0; jj < bc; jj++){
+                double *fc = F.data() + (size_t)r[jj] * nr;
+                const double *u = Uc.data() + (size_t)jj * bc;
+                for (int ii = 0; ii < bc; ii++)
+                    fc[r[ii]] += u[ii];
+            }
+            std::vector<double>().swap(update[child]);
+        }
+        replaced += partialLU(F.data(), nr, w, piv.data() + f, tau);
+        std::copy(F.begin(), F.begin() + (size_t)nr * w, L.begin() + S.lStart[s]);
+        double *Us = U.data() + S.uStart[s];
+        update[s].resize((size_t)b * b);
+        for (int j = 0; j < b; j++){
+            std::copy(F.begin() + (size_t)(w + j) * nr, F.begin() + (size_t)(w + j) * nr + w, Us + (size_t)j * w);
+            std::copy(F.begin() + (size_t)(w + j) * nr + w, F.begin() + (size_t)(w + j + 1) * nr, update[s].begin() + (size_t)j * b);
+        }
+    });
+    perturbed = amax > 0 ? (int)replaced : n;
+}
+
+void SparseLU::solveInPlace(double *x) const{
+    const SparseSymbolic &S = *sym;
+    int n = S.n;
+    std::vector<double> y(n);
+    for (int k = 0; k < n; k++)
+        y[k] = x[S.rowOf[S.perm[k]]];
+    // forward: the row swaps of each supernode, its unit lower triangle, then the rows below it
+    for (int s = 0; s < S.supernodes(); s++){
+        int f = S.super[s], w = S.super[s + 1] - f, nr = S.rowStart[s + 1] - S.rowStart[s];
+        const double *Ls = L.data() + S.lStart[s];
+        const int *R = S.rows.data() + S.rowStart[s];
+        for (int j = 0; j < w; j++)
+            std::swap(y[f + j], y[f + piv[f + j]]);
+        for (int j = 0; j < w; j++){
+            const double *lj = Ls + (size_t)j * nr;
+            double yj = y[f + j];
+            if (yj == 0)
+                continue;
+            for (int i = j + 1; i < w; i++)
+                y[f + i] -= lj[i] * yj;
+            for (int i = w; i < nr; i++)
+                y[R[i]] -= lj[i] * yj;
+        }
+    }
+    // backward: the block row of U right of the own columns, then the upper triangle
+    for (int s = S.supernodes() - 1; s >= 0; s--){
+        int f = S.super[s], w = S.super[s + 1] - f, nr = S.rowStart[s + 1] - S.rowStart[s];
+        const double *Ls = L.data() + S.lStart[s], *Us = U.data() + S.uStart[s];
+        const int *R = S.rows.data() + S.rowStart[s];
+        for (int c = 0; c < nr - w; c++){
+            double yc = y[R[w + c]];
+            if (yc == 0)
+                continue;
+            const double *uc = Us + (size_t)c * w;
+            for (int j = 0; j < w; j++)
+                y[f + j] -= uc[j] * yc;
+        }
+        for (int j = w - 1; j >= 0; j--){
+            const double *lj = Ls + (size_t)j * nr;
+            double yj = y[f + j] /= lj[j];
+            if (yj == 0)
+                continue;
+            for (int i = 0; i < j; i++)
+                y[f + i] -= lj[i] * yj;
+        }
+    }
+    for (int k = 0; k < n; k++)
+        x[S.perm[k]] = y[k];
+}
+
+Vector SparseLU::solve(const Vector &b, RefinementInfo *info) const{
+    checkSize(b.size() == order(), "SparseLU::solve");
+    int n = order();
+    Vector x(b);
+    solveInPlace(x.data());
+    // refine while the residual shrinks, as MixedPrecisionLU does: a residual costs one product with A, less than the
+    // solve itself, and also makes up for pivots that the restriction to the own rows of the supernodes left small
+    RefinementInfo res;
+    double tolerance = anorm * DBL_EPSILON * std::sqrt((double)n), previous = HUGE_VAL;
+    bool converged = false;
+    Vector r(n);
+    for (int iter = 0; ; iter++){
+        r = b;
+        SparseMatrix::gemv(-1, A, x, 1, r);
+        double rnorm = maxAbs(r.data(), n), xnorm = maxAbs(x.data(), n);
+        res.iterations = iter;
+        res.backwardError = xnorm * anorm > 0 ? rnorm / (xnorm * anorm) : rnorm;
+        converged = rnorm <= xnorm * tolerance;
+        if (converged || !std::isfinite(rnorm) || rnorm >= previous || iter == SPARSE_REFINEMENT_MAX_ITERATIONS)
+            break;
+        previous = rnorm;
+        solveInPlace(r.data());
+        x += r;
+    }
+    // with perturbed pivots, a solution that refinement cannot make converge means a (numerically) singular matrix
+    if (perturbed > 0 && !converged){
+        std::cerr << "SparseLU::solve: matrix is singular" << std::endl;
+        throw std::domain_error("SparseLU::solve: matrix is singular");
+    }
+    if (info)
+        *info = res;
+    return x;
+}
+
+Matrix SparseLU::solve(const Matrix &B, RefinementInfo *info) const{
+    checkSize(B.order().first == order(), "SparseLU::solve");
+    Matrix X(B.order().first, B.order().second);
+    if (info)
+        *info = RefinementInfo{};
+    for (int j = 0; j < B.order().second; j++){
+        RefinementInfo col;
+        X.at(j) = solve(B.at(j), info ? &col : nullptr);
+        if (info){
+            info->iterations = std::max(info->iterations, col.iterations);
+            info->backwardError = std::max(info->backwardError, col.backwardError);
+        }
+    }
+    return X;
+}
@@ -0,0 +1,223 @@
+#ifndef SPARSESOLVER_H
+#define SPARSESOLVER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "sparse.h"
+#include "lu.h"
+
+#pragma once
+
+// Sparse direct solvers. Solving Ax = b for a square sparse A happens in two phases:
+//  - the symbolic analysis (SparseSymbolic) depends only on the positions of the entries. It orders the unknowns to
+//    limit fill (see SparseOrdering), computes the elimination tree of the reordered pattern of A + A^T, the column
+//    counts of its Cholesky factor and groups columns with (nearly) the same structure into supernodes.
+//  - the numeric factorization (SparseCholesky, SparseLU) is multifrontal: each supernode assembles a dense frontal
+//    matrix from entries of A and the update matrices of its children, factorizes its columns and passes the Schur
+//    complement to its parent. The dense work runs through gemm (see view.h), and independent subtrees of the
+//    elimination tree are factorized on different threads.
+// The symbolic analysis is shared (a shared_ptr) and reused by refactor(), so a sequence of matrices with the same
+// pattern, such as the Jacobians of a Newton iteration, pays for the ordering and the analysis only once.
+
+/**
+ * @brief Symbolic analysis of the pattern of a square sparse matrix, reusable by the numeric factorizations of
+ * every matrix with the same pattern.
+ *
+ */
+class SparseSymbolic{
+    struct Entry{
+        // index of the entry in the values of A, its position in the front of its supernode, and whether it lies in the lower triangle of A
+        int source, row, col;
+        bool lower;
+    };
+    int n = 0;
+    // the analyzed pattern
+    std::vector<int> colptr, rowind;
+    // perm[k] is the index of A eliminated kth, pinv its inverse; rowOf[k] is the row of A placed at row k before the symmetric permutation
+    std::vector<int> perm, pinv, rowOf;
+    // supernode s owns the columns super[s] .. super[s+1]-1 of the permuted matrix
+    std::vector<int> super, superParent, firstDescendant;
+    // the (sorted) rows of supernode s, own columns first, are rows[rowStart[s] .. rowStart[s+1]-1]
+    std::vector<int> rowStart, rows;
+    // the children of s are children[childStart[s] .. childStart[s+1]-1]
+    std::vector<int> childStart, children;
+    // rel[relStart[c] ..] are the positions, in the rows of its parent, of the rows of c below its own columns
+    std::vector<int> relStart, rel;
+    // the entries of A assembled into the front of s are assembly[assemblyStart[s] .. assemblyStart[s+1]-1]
+    std::vector<int> assemblyStart;
+    std::vector<Entry> assembly;
+    // offsets of the L (rows*width) and U (width*below) blocks of each supernode in the factors
+    std::vector<long> lStart, uStart;
+    // Cholesky flops of the front of s, and of its whole subtree
+    std::vector<double> work, subtreeWork;
+    double flops = 0;
+
+    friend class SparseCholesky;
+    friend class SparseLU;
+
+    /**
+     * @brief Calls factor(s) for every supernode, after the supernodes of its subtree: disjoint subtrees in parallel, then the top of the tree.
+     */
+    void traverse(const std::function<void(int)> &factor) const;
+public:
+    /**
+     * @brief Analyzes the pattern of A + A^T. Raises invalid_argument error if A is not square.
+     *
+     * @param A the matrix; only the positions of its entries are used, unless permuteRows
+     * @param ordering the fill-reducing ordering
+     * @param permuteRows first permute the rows of A so that the diagonal holds nonzeros, large ones where possible (a maximum
+     * transversal), and analyze that matrix instead. This is what SparseLU does, for matrices with zeros on the diagonal.
+     */
+    explicit SparseSymbolic(const SparseMatrix &A, SparseOrdering ordering = SparseOrdering::MinimumDegree, bool permuteRows = false);
+
+    int order() const{ return n; }
+
+    /**
+     * @brief Returns the elimination order: perm[k] is the index of the row and column eliminated kth.
+     */
+    const std::vector<int> &permutation() const{ return perm; }
+
+    /**
+     * @brief Returns the number of supernodes.
+     */
+    int supernodes() const{ return (int)super.size() - 1; }
+
+    /**
+     * @brief Returns the number of entries of the Cholesky factor L, including the zeros stored by relaxed supernodes.
+     */
+    long factorNonZeros() const;
+
+    /**
+     * @brief Returns the flops of the numeric Cholesky factorization (about half those of the LU factorization).
+     */
+    double factorFlops() const{ return flops; }
+
+    /**
+     * @brief Checks if A has the analyzed pattern, i.e. can be factorized with this analysis.
+     */
+    bool matches(const SparseMatrix &A) const;
+};
+
+/**
+ * @brief Supernodal multifrontal Cholesky factorization P A P^T = L L^T of a sparse symmetric positive definite matrix.
+ * Only the lower triangle of A (entries a(i,j) with i >= j) is read.
+ *
+ * @note The factorization itself never throws on matrices that are not positive definite: a nonpositive pivot is recorded, and the solves then throw.
+ */
+class SparseCholesky{
+    std::shared_ptr<const SparseSymbolic> sym;
+    std::vector<double> L;
+    bool positiveDefinite = false;
+
+    void factorize(const SparseMatrix &A);
+public:
+    /**
+     * @brief Analyzes and factorizes A. Raises invalid_argument error if A is not square.
+     */
+    explicit SparseCholesky(const SparseMatrix &A, SparseOrdering ordering = SparseOrdering::MinimumDegree);
+
+    /**
+     * @brief Factorizes A with an existing analysis, which must not permute rows. Raises invalid_argument error if A does not have its pattern.
+     */
+    SparseCholesky(std::shared_ptr<const SparseSymbolic> symbolic, const SparseMatrix &A);
+
+    /**
+     * @brief Factorizes A, which must have the pattern of the first matrix (raises invalid_argument error otherwise), reusing the analysis and the storage.
+     */
+    void refactor(const SparseMatrix &A);
+
+    std::shared_ptr<const SparseSymbolic> symbolic() const{ return sym; }
+
+    int order() const{ return sym->order(); }
+
+    /**
+     * @brief Checks if every pivot was positive.
+     */
+    bool isPositiveDefinite() const{ return positiveDefinite; }
+
+    /**
+     * @brief Solves Ax = b in O(entries of L). Throws if A is not positive definite.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves AX = B for every column of B. Throws if A is not positive definite.
+     */
+    Matrix solve(const Matrix &B) const;
+
+    /**
+     * @brief Solves x in place, overwriting the right hand side with the solution.
+     *
+     * @param x pointer to n contiguous doubles
+     */
+    void solveInPlace(double *x) const;
+};
+
+/**
+ * @brief Supernodal multifrontal LU factorization of a sparse square matrix, on the analysis of the pattern of A + A^T.
+ * Pivots are chosen by partial pivoting among the own rows of each supernode, so the analyzed structure holds; a pivot
+ * still smaller than sqrt(eps) max|a(i,j)| is replaced by that value (static pivoting), and the solves then recover
+ * the accuracy by iterative refinement with the original matrix.
+ *
+ * @note The factorization itself never throws: the solves throw on singular matrices.
+ */
+class SparseLU{
+    std::shared_ptr<const SparseSymbolic> sym;
+    // a copy of the matrix, for the residuals of iterative refinement
+    SparseMatrix A;
+    std::vector<double> L, U;
+    // piv[k] is the row (of the same supernode, permuted numbering) swapped with row k
+    std::vector<int> piv;
+    int perturbed = 0;
+    double anorm = 0;
+
+    void factorize();
+public:
+    /**
+     * @brief Analyzes and factorizes A. Raises invalid_argument error if A is not square.
+     */
+    explicit SparseLU(const SparseMatrix &A, SparseOrdering ordering = SparseOrdering::MinimumDegree);
+
+    /**
+     * @brief Factorizes A with an existing analysis. Raises invalid_argument error if A does not have its pattern.
+     */
+    SparseLU(std::shared_ptr<const SparseSymbolic> symbolic, const SparseMatrix &A);
+
+    /**
+     * @brief Factorizes A, which must have the pattern of the first matrix (raises invalid_argument error otherwise), reusing the analysis and the storage.
+     */
+    void refactor(const SparseMatrix &A);
+
+    std::shared_ptr<const SparseSymbolic> symbolic() const{ return sym; }
+
+    int order() const{ return sym->order(); }
+
+    /**
+     * @brief Returns the number of tiny pivots replaced by static pivoting.
+     */
+    int perturbations() const{ return perturbed; }
+
+    /**
+     * @brief Solves Ax = b, refining the solution with residuals of A until the backward error is at the level of the
+     * rounding errors or stops decreasing. Throws a domain_error if there were perturbed pivots and refinement did not
+     * converge: A is singular to working precision.
+     *
+     * @param info if not null, receives the refinement steps taken and the backward error max|b - Ax| / (||A||_inf max|x|)
+     */
+    Vector solve(const Vector &b, RefinementInfo *info = nullptr) const;
+
+    /**
+     * @brief Solves AX = B column by column. The info reports the worst column.
+     */
+    Matrix solve(const Matrix &B, RefinementInfo *info = nullptr) const;
+
+    /**
+     * @brief Solves x in place with the factors alone, without refinement.
+     *
+     * @param x pointer to n contiguous doubles
+     */
+    void solveInPlace(double *x) const;
+};
+
+#endif
@@ -1,4 +1,7 @@
 #include "squareMatrix.h"
+#include "lu.h"
+#include "matrixCache.h"
+#include "tuning.h"
 
 SquareMatrix::SquareMatrix(int m, bool Identity): Matrix{m,m}
 {
@@ -22,30 +25,13 @@ SquareMatrix::SquareMatrix(const Matrix &m): Matrix{m}
         throw 1;
     }
 }
-
-// modifies *this. So always use the .det() method with no arguments. Anyways private.
-double SquareMatrix::det(int start_row, int start_col){
-    if (start_row == at(0).size() || start_col == size())
+SquareMatrix::SquareMatrix(const ConstMatrixView &v): Matrix{v}
+{
+    if(Matrix::order().first != Matrix::order().second)
     {
-        double x{1};
-        for(int i{0};i< Matrix::order().first;i++)
-        {
-            x*=at(i,i);
-        }
-        return x;
+        std::cerr<<"View is not square, cannot convert to SquareMatrix"<<std::endl;
+        throw 1;
     }
-    bool allzero = true;
-    for (int column = start_col; column < size(); column++)
-        if (std::abs(at(start_row, column)) > EPSILON){
-            allzero = false;
-            std::swap(at(start_col), at(column));
-            break;
-        }
-    if (allzero) return 0;
-    double x = at(start_row, start_col);
-    for (int column = start_col + 1; column < size(); column++)
-        at(column) -= (at(start_row, column) * at(start_col))/x;
-    return det(start_col + 1, start_row + 1);
 }
 
 int SquareMatrix::order() const{
@@ -53,11 +39,52 @@ int SquareMatrix::order() const{
     return mat.size();
 }
 double SquareMatrix::det() const{
-    SquareMatrix scpy{*this};
-    return scpy.det(0, 0);
+    MatrixCache *c = cache();
+    if (c && c->hasDet)
+        return c->det;
+    // always from the LU factors (memoized with the cache), so the result does not depend on what was queried before
+    double d = lu()->det();
+    if (c){
+        c->hasDet = true;
+        c->det = d;
+    }
+    return d;
 }
 
-SquareMatrix SquareMatrix::inverse() const{
+SquareMatrix SquareMatrix::inverse(double *rcond) const{
+    MatrixCache *c = cache();
+    if (rcond){
+        // the estimate needs the LU factors, which then give the inverse as well
+        std::shared_ptr<const LU> f = lu();
+        *rcond = c && c->rcond >= 0 ? c->rcond : f->rcond();
+        if (c)
+            c->rcond = *rcond;
+        if (c && c->inverse)
+            return *c->inverse;
+        if (f->isSingular()) throw "non-invertible matrix";
+        SquareMatrix ans = f->inverse();
+        if (c)
+            c->inverse = std::make_shared<const SquareMatrix>(ans);
+        return ans;
+    }
+    if (c && c->inverse)
+        return *c->inverse;
+    if (c && c->lu){
+        if (c->lu->isSingular()) throw "non-invertible matrix";
+        c->inverse = std::make_shared<const SquareMatrix>(c->lu->inverse());
+        return *c->inverse;
+    }
+    // from the tuned order on (see tuning.h), factorizing beats reducing (A|I) on this machine
+    int luMin = tuning().inverseLUMin;
+    if (luMin > 0 && order() >= luMin){
+        std::shared_ptr<const LU> f = lu();
+        if (f->isSingular()) throw "non-invertible matrix";
+        SquareMatrix ans = f->inverse();
+        if (c)
+            c->inverse = std::make_shared<const SquareMatrix>(ans);
+        return ans;
+    }
+    LINALG_PROFILE("SquareMatrix::inverse", 4.0 * order() * order() * order(), 16.0 * order() * order() * order());
     Matrix scpy{*this};
     scpy.augment_modify(SquareMatrix(order(), true)); // augment identity to M.
     scpy.rref(true);
@@ -69,5 +96,435 @@ SquareMatrix SquareMatrix::inverse() const{
     SquareMatrix ans(order());
     for (int i = 0; i < order(); i++)
         ans.at(i) = scpy.at(order() + i);
+    if (c)
+        c->inverse = std::make_shared<const SquareMatrix>(ans);
     return ans;
-}
\ No newline at end of file
+}
+
+double SquareMatrix::rcond() const{
+    MatrixCache *c = cache();
+    if (c && c->rcond >= 0)
+        return c->rcond;
+    double r = lu()->rcond();
+    if (c)
+        c->rcond = r;
+    return r;
+}
+
+std::shared_ptr<const LU> SquareMatrix::lu() const{
+    MatrixCache *c = cache();
+    if (c && c->lu)
+        return c->lu;
+    auto res = std::make_shared<const LU>(*this);
+    if (c)
+        c->lu = res;
+    return res;
+}
+
+std::shared_ptr<const TriangularMatrix> SquareMatrix::cholesky() const{
+    MatrixCache *c = cache();
+    if (c && c->cholesky)
+        return c->cholesky;
+    if (c && c->choleskyFailed){
+        std::cerr << "SymmetricMatrix::cholesky: matrix is not positive definite" << std::endl;
+        throw std::domain_error("SymmetricMatrix::cholesky: matrix is not positive definite");
+    }
+    try{
+        auto res = std::make_shared<const TriangularMatrix>(SymmetricMatrix(*this).cholesky());
+        if (c)
+            c->cholesky = res;
+        return res;
+    }
+    catch (const std::domain_error &){
+        if (c)
+            c->choleskyFailed = true;
+        throw;
+    }
+}
+
+// ===================== eigenvalues ============================= //
+// The kernels below work on a row-major n*n copy, a[i*n + j] = A(i, j).
+
+namespace{
+
+// Parlett-Reinsch balancing: diagonal similarity by powers of 2 that makes row and column norms comparable.
+void balance(std::vector<double> &a, int n){
+    const double radix = 2, sqrdx = radix * radix;
+    bool done = false;
+    while (!done){
+        done = true;
+        for (int i = 0; i < n; i++){
+            double r = 0, c = 0;
+            for (int j = 0; j < n; j++)
+                if (j != i){
+                    c += std::abs(a[j*n + i]);
+                    r += std::abs(a[i*n + j]);
+                }
+            if (c == 0 || r == 0)
+                continue;
+            double g = r / radix, f = 1, s = c + r;
+            while (c < g){
+                f *= radix;
+                c *= sqrdx;
+            }
+            g = r * radix;
+            while (c > g){
+                f /= radix;
+                c /= sqrdx;
+            }
+            if ((c + r) / f < 0.95 * s){
+                done = false;
+                g = 1 / f;
+                for (int j = 0; j < n; j++)
+                    a[i*n + j] *= g;
+                for (int j = 0; j < n; j++)
+                    a[j*n + i] *= f;
+            }
+        }
+    }
+}
+
+// Householder reduction to upper Hessenberg form, in place. If q is not null, the orthogonal Q with A = Q H Q^T is accumulated into it (row-major).
+void reduceToHessenberg(std::vector<double> &a, int n, std::vector<double> *q = nullptr){
+    if (q){
+        q->assign((size_t)n * n, 0.0);
+        for (int i = 0; i < n; i++)
+            (*q)[(size_t)i*n + i] = 1;
+    }
+    std::vector<double> v(n);
+    for (int k = 0; k < n - 2; k++){
+        double alpha = a[(k+1)*n + k], xnorm = 0;
+        for (int i = k + 2; i < n; i++)
+            xnorm += a[i*n + k] * a[i*n + k];
+        if (xnorm == 0)
+            continue;
+        double beta = -std::copysign(std::sqrt(alpha*alpha + xnorm), alpha);
+        // v = x - beta*e1, H = I - 2vv^T/(v^Tv)
+        v[k+1] = alpha - beta;
+        for (int i = k + 2; i < n; i++)
+            v[i] = a[i*n + k];
+        double vtv = v[k+1]*v[k+1] + xnorm;
+        // A = H A
+        for (int j = k; j < n; j++){
+            double s = 0;
+            for (int i = k + 1; i < n; i++)
+                s += v[i] * a[i*n + j];
+            s *= 2 / vtv;
+            for (int i = k + 1; i < n; i++)
+                a[i*n + j] -= s * v[i];
+        }
+        // A = A H
+        for (int i = 0; i < n; i++){
+            double s = 0;
+            for (int j = k + 1; j < n; j++)
+                s += a[i*n + j] * v[j];
+            s *= 2 / vtv;
+            for (int j = k + 1; j < n; j++)
+                a[i*n + j] -= s * v[j];
+        }
+        if (q)
+            for (int i = 0; i < n; i++){
+                double s = 0;
+                for (int j = k + 1; j < n; j++)
+                    s += (*q)[i*n + j] * v[j];
+                s *= 2 / vtv;
+                for (int j = k + 1; j < n; j++)
+                    (*q)[i*n + j] -= s * v[j];
+            }
+        a[(k+1)*n + k] = beta;
+        for (int i = k + 2; i < n; i++)
+            a[i*n + k] = 0;
+    }
+}
+
+// Francis double-shift QR iteration on an upper Hessenberg matrix (destroyed).
+std::vector<std::complex<double>> hessenbergEigenvalues(std::vector<double> &h, int n){
+    auto a = [&](int i, int j) -> double& { return h[i*n + j]; };
+    std::vector<std::complex<double>> w(n);
+    double anorm = 0;
+    for (int i = 0; i < n; i++)
+        for (int j = std::max(i - 1, 0); j < n; j++)
+            anorm += std::abs(a(i, j));
+
+    int nn = n - 1, l = 0;
+    double t = 0, p = 0, q = 0, r = 0, x, y, z, s, u, v, ww;
+    while (nn >= 0){
+        int its = 0;
+        do{
+            // look for a negligible subdiagonal element
+            for (l = nn; l > 0; l--){
+                s = std::abs(a(l-1, l-1)) + std::abs(a(l, l));
+                if (s == 0)
+                    s = anorm;
+                if (std::abs(a(l, l-1)) + s == s){
+                    a(l, l-1) = 0;
+                    break;
+                }
+            }
+            x = a(nn, nn);
+            if (l == nn){ // one root found
+                w[nn--] = x + t;
+            }
+            else{
+                y = a(nn-1, nn-1);
+                ww = a(nn, nn-1) * a(nn-1, nn);
+                if (l == nn - 1){ // two roots found
+                    p = 0.5 * (y - x);
+                    q = p*p + ww;
+                    z = std::sqrt(std::abs(q));
+                    x += t;
+                    if (q >= 0){
+                        z = p + std::copysign(z, p);
+                        w[nn-1] = w[nn] = x + z;
+                        if (z != 0)
+                            w[nn] = x - ww / z;
+                    }
+                    else{
+                        w[nn-1] = std::complex<double>(x + p, z);
+                        w[nn] = std::complex<double>(x + p, -z);
+                    }
+                    nn -= 2;
+                }
+                else{
+                    if (its == 60){
+                        std::cerr << "eigenvalues: QR iteration did not converge" << std::endl;
+                        throw std::runtime_error("eigenvalues: QR iteration did not converge");
+                    }
+                    if (its % 10 == 0 && its > 0){ // exceptional shift
+                        t += x;
+                        for (int i = 0; i <= nn; i++)
+                            a(i, i) -= x;
+                        s = std::abs(a(nn, nn-1)) + std::abs(a(nn-1, nn-2));
+                        y = x = 0.75 * s;
+                        ww = -0.4375 * s * s;
+                    }
+                    ++its;
+                    int m;
+                    // look for two consecutive small subdiagonal elements
+                    for (m = nn - 2; m >= l; m--){
+                        z = a(m, m);
+                        r = x - z;
+                        s = y - z;
+                        p = (r*s - ww) / a(m+1, m) + a(m, m+1);
+                        q = a(m+1, m+1) - z - r - s;
+                        r = a(m+2, m+1);
+                        s = std::abs(p) + std::abs(q) + std::abs(r);
+                        p /= s; q /= s; r /= s;
+                        if (m == l)
+                            break;
+                        u = std::abs(a(m, m-1)) * (std::abs(q) + std::abs(r));
+                        v = std::abs(p) * (std::abs(a(m-1, m-1)) + std::abs(z) + std::abs(a(m+1, m+1)));
+                        if (u + v == v)
+                            break;
+                    }
+                    for (int i = m; i < nn - 1; i++){
+                        a(i+2, i) = 0;
+                        if (i != m)
+                            a(i+2, i-1) = 0;
+                    }
+                    // double QR step on rows l..nn and columns m..nn
+                    for (int k = m; k < nn; k++){
+                        if (k != m){
+                            p = a(k, k-1);
+                            q = a(k+1, k-1);
+                            r = 0;
+                            if (k + 1 != nn)
+                                r = a(k+2, k-1);
+                            if ((x = std::abs(p) + std::abs(q) + std::abs(r)) != 0){
+                                p /= x; q /= x; r /= x;
+                            }
+                        }
+                        if ((s = std::copysign(std::sqrt(p*p + q*q + r*r), p)) != 0){
+                            if (k == m){
+                                if (l != m)
+                                    a(k, k-1) = -a(k, k-1);
+                            }
+                            else
+                                a(k, k-1) = -s * x;
+                            p += s;
+                            x = p / s; y = q / s; z = r / s;
+                            q /= p; r /= p;
+                            for (int j = k; j <= nn; j++){
+                                p = a(k, j) + q * a(k+1, j);
+                                if (k + 1 != nn){
+                                    p += r * a(k+2, j);
+                                    a(k+2, j) -= p * z;
+                                }
+                                a(k+1, j) -= p * y;
+                                a(k, j) -= p * x;
+                            }
+                            int mmin = nn < k + 3 ? nn : k + 3;
+                            for (int i = l; i <= mmin; i++){
+                                p = x * a(i, k) + y * a(i, k+1);
+                                if (k + 1 != nn){
+                                    p += z * a(i, k+2);
+                                    a(i, k+2) -= p * r;
+                                }
+                                a(i, k+1) -= p * q;
+                                a(i, k) -= p;
+                            }
+                        }
+                    }
+                }
+            }
+        } while (l + 1 < nn);
+    }
+    return w;
+}
+
+}
+
+Task<SquareMatrix> SquareMatrix::inverseAsync() const{
+    auto A = std::make_shared<const SquareMatrix>(*this);
+    return runAsync([A]{ return A->inverse(); });
+}
+
+Task<std::shared_ptr<const LU>> SquareMatrix::luAsync() const{
+    auto A = std::make_shared<const SquareMatrix>(*this);
+    return runAsync([A]{ return std::shared_ptr<const LU>(std::make_shared<const LU>(*A)); });
+}
+
+Vector SquareMatrix::solve(const Vector &b) const{
+    return lu()->solve(b);
+}
+
+Vector SquareMatrix::solveRefined(const Vector &b, RefinementInfo *info) const{
+    return MixedPrecisionLU(*this).solve(b, info);
+}
+
+SquareMatrix SquareMatrix::hessenberg(SquareMatrix *Q) const{
+    int n = order();
+    std::vector<double> a((size_t)n * n), q;
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            a[(size_t)i*n + j] = at(j).data()[i];
+    reduceToHessenberg(a, n, Q ? &q : nullptr);
+    SquareMatrix res(n);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            res.at(j).data()[i] = a[(size_t)i*n + j];
+    if (Q){
+        *Q = SquareMatrix(n);
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++)
+                Q->at(j).data()[i] = q[(size_t)i*n + j];
+    }
+    return res;
+}
+
+SquareMatrix SquareMatrix::pow(long long k) const{
+    int n = order();
+    // the magnitude of k, as unsigned: -k overflows for LLONG_MIN
+    unsigned long long e = k < 0 ? 0ULL - (unsigned long long)k : (unsigned long long)k;
+    if (e == 0)
+        return SquareMatrix(n, true);
+    // binary powering: about 2*log2(k) products, all written into the same three buffers.
+    Matrix base = k < 0 ? Matrix(LU(*this).inverse()) : Matrix(*this), result, tmp(n, n);
+    bool started = false;
+    while (true){
+        if (e & 1){
+            if (!started){
+                result = base;
+                started = true;
+            }
+            else{
+                gemm(1, result, base, 0, tmp);
+                std::swap(result, tmp);
+            }
+        }
+        e >>= 1;
+        if (e == 0)
+            break;
+        gemm(1, base, base, 0, tmp);
+        std::swap(base, tmp);
+    }
+    return SquareMatrix(result);
+}
+
+std::vector<std::complex<double>> SquareMatrix::eigenvalues() const{
+    int n = order();
+    std::vector<double> a((size_t)n * n);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            a[(size_t)i*n + j] = at(j).data()[i];
+    balance(a, n);
+    reduceToHessenberg(a, n);
+    return hessenbergEigenvalues(a, n);
+}
+
+// ===================== polynomials ============================= //
+
+Polynomial SquareMatrix::charpoly() const{
+    int n = order();
+    SquareMatrix H = hessenberg();
+    // p[k] = characteristic polynomial of the leading k*k block of H:
+    // p_k(x) = (x - h_kk) p_{k-1}(x) - sum_{i<k} h_ik (h_{i+1,i} ... h_{k,k-1}) p_{i-1}(x)   (1-based)
+    std::vector<Polynomial> p(n + 1);
+    p[0] = Polynomial{1};
+    for (int k = 1; k <= n; k++){
+        const double *hk = H.at(k - 1).data(); // column k-1 of H
+        p[k] = Polynomial{-hk[k - 1], 1} * p[k - 1];
+        double prod = 1;
+        for (int i = k - 1; i >= 1; i--){
+            prod *= H.at(i - 1).data()[i]; // h_{i+1,i}
+            if (prod == 0)
+                break; // the block is reducible, earlier terms vanish
+            p[k] -= p[i - 1] * (hk[i - 1] * prod);
+        }
+    }
+    return p[n];
+}
+
+SquareMatrix SquareMatrix::evaluate(const Polynomial &p) const{
+    int n = order();
+    SquareMatrix res(n);
+    if (p.isZero() || n == 0)
+        return res;
+    int d = p.coefficients().size() - 1;
+    // block size s ~ sqrt(d): powers A^0..A^s are formed once, then Horner's rule runs in A^s over d/s blocks.
+    int s = std::max(1, (int)std::ceil(std::sqrt((double)d + 1)));
+    int r = d / s;
+    // the blocks use A^0..A^min(s-1, d), and Horner's rule A^s only if there is more than one block
+    int top = r > 0 ? s : std::min(s - 1, d);
+    std::vector<Matrix> pw(s + 1);
+    pw[0] = SquareMatrix(n, true);
+    pw[1] = *this;
+    for (int i = 2; i <= top; i++){
+        pw[i] = Matrix(n, n);
+        gemm(1, pw[i - 1], *this, 0, pw[i]);
+    }
+    // acc += c * X
+    auto addScaled = [&](Matrix &acc, double c, const Matrix &X){
+        for (int col = 0; col < n; col++){
+            double *a = acc.at(col).data();
+            const double *x = X.at(col).data();
+            for (int row = 0; row < n; row++)
+                a[row] += c * x[row];
+        }
+    };
+    // B_j = sum_{i<s} c_{js+i} A^i
+    auto block = [&](int j, Matrix &B){
+        for (int col = 0; col < n; col++)
+            std::fill(B.at(col).data(), B.at(col).data() + n, 0.0);
+        for (int i = 0; i < s && j*s + i <= d; i++)
+            if (p[j*s + i] != 0)
+                addScaled(B, p[j*s + i], pw[i]);
+    };
+    Matrix acc(n, n), tmp(n, n);
+    int j = r;
+    if (r > 0 && d % s == 0){
+        // the top block is c_d*I, whose product with A^s is a scaling: start from B_{r-1} + c_d*A^s
+        block(--j, acc);
+        addScaled(acc, p[d], pw[s]);
+    }
+    else
+        block(r, acc);
+    while (--j >= 0){
+        gemm(1, acc, pw[s], 0, tmp);
+        block(j, acc);
+        addScaled(acc, 1, tmp);
+    }
+    for (int col = 0; col < n; col++)
+        res.at(col) = acc.at(col);
+    return res;
+}
@@ -1,9 +1,15 @@
 #ifndef SQUAREMATRIX_H
 #define SQUAREMATRIX_H
 
+#include <complex>
+#include <memory>
 #include "Matrix.h"
+#include "Polynomial.h"
 #pragma once
 
+struct RefinementInfo;
+class LU;
+
 class SquareMatrix: public Matrix{
 public:
     SquareMatrix(){}
@@ -12,15 +18,108 @@ public:
 
     SquareMatrix(std::initializer_list<std::initializer_list<double> > i);
     SquareMatrix(const Matrix &m);
-private:
-    // modifies *this. So always use the .det() method with no arguments. Anyways private.
-    double det(int start_row, int start_col);
-public:
+    // copies the elements of a square view; explicit, like Matrix(const ConstMatrixView &), so the copy shows at the call
+    explicit SquareMatrix(const ConstMatrixView &v);
     int order() const;
 
+    /**
+     * @brief Returns the determinant, the signed product of the pivots of lu(). Memoized when the cache is enabled (see
+     * Matrix::enableCache), together with the LU factors.
+     */
     double det() const;
 
-    SquareMatrix inverse() const;
+    /**
+     * @brief Returns the inverse. Memoized when the cache is enabled, and then computed from the memoized LU factors if they exist.
+     * Otherwise (A|I) is reduced to its rref, or A factorized by LU from the order tuned for this machine (see tuning.h).
+     *
+     * @param rcond if not null, receives rcond(), and the inverse is then computed from the same LU factors
+     */
+    SquareMatrix inverse(double *rcond = nullptr) const;
+
+    /**
+     * @brief Estimates the reciprocal condition number 1 / (||A||_1 ||A^{-1}||_1) in O(n^2) from the LU factors (see
+     * LU::rcond), without forming the inverse: near 1 for a well-conditioned matrix, about 1e-16 or 0 for a singular one.
+     * With the cache enabled, the estimate and the factors are memoized, so checking the conditioning before solve()
+     * costs one factorization in all.
+     */
+    double rcond() const;
+
+    /**
+     * @brief Returns the LU factorization with partial pivoting, computed once per version of the matrix when the cache is enabled.
+     */
+    std::shared_ptr<const LU> lu() const;
+
+    /**
+     * @brief Computes inverse() of a copy of the matrix on the library's executor (see task.h). The task reports progress and can be cancelled.
+     */
+    Task<SquareMatrix> inverseAsync() const;
+
+    /**
+     * @brief Computes the LU factorization of a copy of the matrix on the library's executor, e.g. to overlap it with loading
+     * the right hand sides (see LS_Solver::solveAsync).
+     */
+    Task<std::shared_ptr<const LU>> luAsync() const;
+
+    /**
+     * @brief Returns the lower triangular Cholesky factor L with A = LL^T, reading the lower triangle of the matrix.
+     * Computed once per version of the matrix when the cache is enabled. Throws a domain_error if the matrix is not positive definite.
+     */
+    std::shared_ptr<const TriangularMatrix> cholesky() const;
+
+    /**
+     * @brief Solves Ax = b by LU with partial pivoting in double, reusing the memoized factors when the cache is enabled.
+     * Throws a domain_error if A is singular.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves Ax = b to double accuracy by a float LU factorization and iterative refinement with double residuals
+     * (see MixedPrecisionLU), falling back to the double LU when refinement does not converge. Throws a domain_error if A is singular.
+     *
+     * @param info if not null, receives the iteration count, whether the fallback was taken and the backward error
+     */
+    Vector solveRefined(const Vector &b, RefinementInfo *info = nullptr) const;
+
+    /**
+     * @brief Returns the upper Hessenberg form H = Q^T A Q, computed with Householder reflections in O(n^3).
+     * H is orthogonally similar to the matrix, so it has the same eigenvalues and characteristic polynomial.
+     *
+     * @param Q if not null, receives the orthogonal matrix Q.
+     * @return SquareMatrix the upper Hessenberg matrix H.
+     */
+    SquareMatrix hessenberg(SquareMatrix *Q = nullptr) const;
+
+    /**
+     * @brief Returns A^k by binary powering, i.e. about 2*log2(k) matrix products (A^1000 takes 15 instead of 999).
+     * Negative powers go through the LU inverse.
+     *
+     * @param k the power
+     * @return SquareMatrix A^k
+     */
+    SquareMatrix pow(long long k) const;
+
+    /**
+     * @brief Computes all the (complex) eigenvalues: balancing, reduction to Hessenberg form, then the Francis double-shift QR iteration.
+     * Throws a std::runtime_error if the iteration fails to converge.
+     *
+     * @return std::vector<std::complex<double>> the n eigenvalues, with multiplicity.
+     */
+    std::vector<std::complex<double>> eigenvalues() const;
+
+    /**
+     * @brief Returns the characteristic polynomial det(xI - A), computed in O(n^3) from the Hessenberg form by Hyman's recurrence.
+     *
+     * @return Polynomial the monic characteristic polynomial of degree n.
+     */
+    Polynomial charpoly() const;
+
+    /**
+     * @brief Evaluates p(A) by the Paterson-Stockmeyer scheme, which needs about 2*sqrt(deg p) matrix products instead of deg p for Horner's rule.
+     *
+     * @param p the polynomial to evaluate
+     * @return SquareMatrix p(A)
+     */
+    SquareMatrix evaluate(const Polynomial &p) const;
 };
 
 inline double det(const SquareMatrix &s){
@@ -0,0 +1,145 @@
+#include <atomic>
+#include <cstdlib>
+#include "strassen.h"
+#include "tuning.h"
+
+// default recursion cutoff: below it the blocked gemm is faster than a further level of recursion
+#define STRASSEN_CUTOFF 256
+
+namespace{
+
+std::atomic<int> configuredCutoff{0};
+std::atomic<MultiplyAlgorithm> configuredAlgorithm{MultiplyAlgorithm::Blocked};
+
+// X = A + s*B, elementwise; X may be A or B
+void combine(const ConstMatrixView &A, double s, const ConstMatrixView &B, const MatrixView &X){
+    int m = X.order().first, n = X.order().second;
+    for (int j = 0; j < n; j++){
+        ConstVectorView a = A.col(j), b = B.col(j);
+        VectorView x = X.col(j);
+        const double *ap = a.data(), *bp = b.data();
+        double *xp = x.data();
+        if (ap && bp && xp)
+            for (int i = 0; i < m; i++)
+                xp[i] = ap[i] + s * bp[i];
+        else
+            for (int i = 0; i < m; i++)
+                x[i] = a[i] + s * b[i];
+    }
+}
+
+void winograd(const ConstMatrixView &A, const ConstMatrixView &B, const MatrixView &C, double *work, int cutoff){
+    int m = A.order().first, k = A.order().second, n = B.order().second;
+    if (std::min({m, k, n}) <= cutoff){
+        gemm(1, A, B, 0, C);
+        return;
+    }
+    int mh = m / 2, kh = k / 2, nh = n / 2;
+    if (m % 2 || k % 2 || n % 2){
+        // even part by recursion, then the odd row, column and rank one term of the inner dimension by gemm
+        MatrixView Ce = C.block(0, 0, 2 * mh, 2 * nh);
+        winograd(A.block(0, 0, 2 * mh, 2 * kh), B.block(0, 0, 2 * kh, 2 * nh), Ce, work, cutoff);
+        if (k % 2)
+            gemm(1, A.block(0, k - 1, 2 * mh, 1), B.block(k - 1, 0, 1, 2 * nh), 1, Ce);
+        if (n % 2)
+            gemm(1, A, B.block(0, n - 1, k, 1), 0, C.block(0, n - 1, m, 1));
+        if (m % 2)
+            gemm(1, A.block(m - 1, 0, 1, k), B.block(0, 0, k, 2 * nh), 0, C.block(m - 1, 0, 1, 2 * nh));
+        return;
+    }
+    ConstMatrixView A11 = A.block(0, 0, mh, kh), A12 = A.block(0, kh, mh, kh), A21 = A.block(mh, 0, mh, kh), A22 = A.block(mh, kh, mh, kh);
+    ConstMatrixView B11 = B.block(0, 0, kh, nh), B12 = B.block(0, nh, kh, nh), B21 = B.block(kh, 0, kh, nh), B22 = B.block(kh, nh, kh, nh);
+    MatrixView C11 = C.block(0, 0, mh, nh), C12 = C.block(0, nh, mh, nh), C21 = C.block(mh, 0, mh, nh), C22 = C.block(mh, nh, mh, nh);
+    // two temporaries per level: X holds the S_i (mh*kh) and then P1 (mh*nh), Y the T_i (kh*nh); the products
+    // are accumulated in the quadrants of C. The schedule is the one of Boyer, Dumas, Pernet and Zhou (2009), table 1.
+    size_t xsize = (size_t)mh * std::max(kh, nh);
+    MatrixView X(work, mh, kh, mh), P1(work, mh, nh, mh), Y(work + xsize, kh, nh, kh);
+    double *next = work + xsize + (size_t)kh * nh;
+    combine(A11, -1, A21, X);                    // S3 = A11 - A21
+    combine(B22, -1, B12, Y);                    // T3 = B22 - B12
+    winograd(X, Y, C21, next, cutoff);           // P7 = S3 T3
+    combine(A21, 1, A22, X);                     // S1 = A21 + A22
+    combine(B12, -1, B11, Y);                    // T1 = B12 - B11
+    winograd(X, Y, C22, next, cutoff);           // P5 = S1 T1
+    combine(X, -1, A11, X);                      // S2 = S1 - A11
+    combine(B22, -1, Y, Y);                      // T2 = B22 - T1
+    winograd(X, Y, C12, next, cutoff);           // P6 = S2 T2
+    combine(A12, -1, X, X);                      // S4 = A12 - S2
+    winograd(X, B22, C11, next, cutoff);         // P3 = S4 B22
+    winograd(A11, B11, P1, next, cutoff);        // P1 = A11 B11
+    combine(P1, 1, C12, C12);                    // U2 = P1 + P6
+    combine(C12, 1, C21, C21);                   // U3 = U2 + P7
+    combine(C12, 1, C22, C12);                   // U4 = U2 + P5
+    combine(C21, 1, C22, C22);                   // U7 = U3 + P5 = C22
+    combine(C12, 1, C11, C12);                   // U5 = U4 + P3 = C12
+    combine(Y, -1, B21, Y);                      // T4 = T2 - B21
+    winograd(A22, Y, C11, next, cutoff);         // P4 = A22 T4
+    combine(C21, -1, C11, C21);                  // U6 = U3 - P4 = C21
+    winograd(A12, B21, C11, next, cutoff);       // P2 = A12 B21
+    combine(P1, 1, C11, C11);                    // U1 = P1 + P2 = C11
+}
+
+}
+
+size_t strassenWorkspaceSize(int m, int k, int n, int cutoff){
+    if (cutoff <= 0)
+        cutoff = strassenCutoff();
+    size_t total = 0;
+    while (std::min({m, k, n}) > cutoff){
+        m /= 2; k /= 2; n /= 2;
+        total += (size_t)m * std::max(k, n) + (size_t)k * n;
+    }
+    return total;
+}
+
+void strassen(const ConstMatrixView &A, const ConstMatrixView &B, const MatrixView &C, int cutoff, std::vector<double> *workspace){
+    int m = A.order().first, k = A.order().second, n = B.order().second;
+    LINALG_PROFILE("strassen", 2.0 * m * k * n, 8.0 * (m * k + k * n + 2.0 * m * n));
+    if (k != B.order().first || C.order().first != m || C.order().second != n){
+        std::cerr<<"Matrices incompatible for multiplication"<<std::endl;
+        throw std::invalid_argument("Matrices incompatible for multiplication");
+    }
+    if (C.overlaps(A) || C.overlaps(B)){
+        std::cerr<<"strassen: output aliases an input"<<std::endl;
+        throw std::invalid_argument("strassen: output aliases an input");
+    }
+    if (cutoff <= 0)
+        cutoff = strassenCutoff();
+    cutoff = std::max(cutoff, 16);
+    std::vector<double> local;
+    std::vector<double> &work = workspace ? *workspace : local;
+    size_t size = strassenWorkspaceSize(m, k, n, cutoff);
+    if (work.size() < size)
+        work.resize(size);
+    winograd(A, B, C, work.data(), cutoff);
+}
+
+int strassenCutoff(){
+    int c = configuredCutoff.load(std::memory_order_relaxed);
+    if (c > 0)
+        return c;
+    static const int environment = []{
+        if (const char *env = std::getenv("LINALG_STRASSEN_CUTOFF")){
+            int t = std::atoi(env);
+            if (t > 0)
+                return std::max(t, 16);
+        }
+        return 0;
+    }();
+    if (environment > 0)
+        return environment;
+    int tuned = tuning().strassenCutoff;
+    return tuned > 0 ? std::max(tuned, 16) : STRASSEN_CUTOFF;
+}
+
+void setStrassenCutoff(int cutoff){
+    configuredCutoff.store(cutoff <= 0 ? 0 : std::max(cutoff, 16), std::memory_order_relaxed);
+}
+
+MultiplyAlgorithm multiplyAlgorithm(){
+    return configuredAlgorithm.load(std::memory_order_relaxed);
+}
+
+void setMultiplyAlgorithm(MultiplyAlgorithm algorithm){
+    configuredAlgorithm.store(algorithm, std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include <vector>
+#include "Matrix.h"
+
+#pragma once
+
+// Strassen-Winograd multiplication: 7 half-size products and 15 additions per level instead of 8 products, i.e.
+// O(n^2.807) flops, recursing down to the blocked gemm below a cutoff. On large products one level saves about 12%
+// of the flops, three levels about 33%.
+//
+// Accuracy: the bound is normwise, not componentwise as for gemm. With u the unit roundoff, n0 the cutoff and
+// ||X|| = max |x_ij|, Higham (Accuracy and Stability of Numerical Algorithms, 23.2.3) gives for n*n matrices
+//     ||C - fl(A*B)|| <= [(n/n0)^log2(18) * (n0^2 + 6*n0) - 6n] u ||A|| ||B|| + O(u^2),
+// against n^2 u ||A|| ||B|| for the conventional product. Small entries of C can therefore lose relative accuracy when
+// A or B have entries of widely different magnitudes; scale such matrices, or use MultiplyAlgorithm::Blocked.
+
+/**
+ * @brief Computes C = A*B by Strassen-Winograd recursion, falling back to gemm on blocks with a dimension <= cutoff.
+ * Any shape is accepted: odd dimensions are peeled off and handled by gemm.
+ *
+ * @param A m*k factor
+ * @param B k*n factor
+ * @param C m*n output, which must not overlap A or B. Its previous contents are ignored.
+ * @param cutoff the recursion cutoff, 0 for strassenCutoff()
+ * @param workspace if not null, scratch space reused across calls (grown when too small, see strassenWorkspaceSize);
+ * otherwise the scratch space is allocated for the call. Either way there is one allocation at most.
+ */
+void strassen(const ConstMatrixView &A, const ConstMatrixView &B, const MatrixView &C, int cutoff = 0, std::vector<double> *workspace = nullptr);
+
+/**
+ * @brief Returns the number of doubles of scratch space strassen needs for an m*k by k*n product, about (m*k + k*n)/3 + m*n/3.
+ */
+size_t strassenWorkspaceSize(int m, int k, int n, int cutoff = 0);
+
+/**
+ * @brief Returns the recursion cutoff of strassen: the value set by setStrassenCutoff if any, otherwise the
+ * LINALG_STRASSEN_CUTOFF environment variable, otherwise the tuned cutoff (see tuning.h), otherwise 256.
+ */
+int strassenCutoff();
+
+/**
+ * @brief Sets the recursion cutoff of strassen (at least 16). 0 restores the default.
+ */
+void setStrassenCutoff(int cutoff);
+
+/**
+ * @brief Returns the algorithm Matrix::operator* uses, MultiplyAlgorithm::Blocked unless changed by setMultiplyAlgorithm.
+ */
+MultiplyAlgorithm multiplyAlgorithm();
+
+/**
+ * @brief Sets the algorithm Matrix::operator* uses. Auto or Strassen trade the componentwise error bound of the blocked
+ * product for speed on large products (see above), so they are opt-in.
+ */
+void setMultiplyAlgorithm(MultiplyAlgorithm algorithm);
+
+#endif
@@ -0,0 +1,615 @@
+#include <algorithm>
+#include "structuredMatrix.h"
+#include "lu.h"
+
+namespace{
+
+void checkOrder(int expected, int got, const char *what){
+    if (expected != got){
+        std::cerr << what << ": dimension mismatch" << std::endl;
+        throw std::invalid_argument(std::string(what) + ": dimension mismatch");
+    }
+}
+
+void checkSquare(const Matrix &A, const char *what){
+    if (A.order().first != A.order().second){
+        std::cerr << what << ": matrix is not square" << std::endl;
+        throw std::invalid_argument(std::string(what) + ": matrix is not square");
+    }
+}
+
+void throwSingular(const char *what){
+    std::cerr << what << ": matrix is singular" << std::endl;
+    throw std::domain_error(std::string(what) + ": matrix is singular");
+}
+
+void throwOutOfRange(){
+    std::cerr << "index out of bounds" << std::endl;
+    throw std::out_of_range("index out of bounds");
+}
+
+}
+
+// ===================== diagonal ============================= //
+
+double DiagonalMatrix::at(int i, int j) const{
+    if (i < 0 || i >= order() || j < 0 || j >= order())
+        throwOutOfRange();
+    return i == j ? d[i] : 0;
+}
+
+double &DiagonalMatrix::operator[](int i){
+    if (i < 0 || i >= order())
+        throwOutOfRange();
+    return d[i];
+}
+
+const double &DiagonalMatrix::operator[](int i) const{
+    if (i < 0 || i >= order())
+        throwOutOfRange();
+    return d[i];
+}
+
+Vector DiagonalMatrix::operator*(const Vector &x) const{
+    checkOrder(order(), x.size(), "DiagonalMatrix::operator*");
+    Vector y(x);
+    double *p = y.data();
+    for (int i = 0; i < order(); i++)
+        p[i] *= d[i];
+    return y;
+}
+
+Matrix DiagonalMatrix::operator*(const Matrix &B) const{
+    checkOrder(order(), B.order().first, "DiagonalMatrix::operator*");
+    Matrix C(B);
+    for (int j = 0; j < C.order().second; j++){
+        double *c = C.at(j).data();
+        for (int i = 0; i < order(); i++)
+            c[i] *= d[i];
+    }
+    return C;
+}
+
+DiagonalMatrix DiagonalMatrix::operator*(const DiagonalMatrix &D) const{
+    checkOrder(order(), D.order(), "DiagonalMatrix::operator*");
+    DiagonalMatrix res(*this);
+    for (int i = 0; i < order(); i++)
+        res.d[i] *= D.d[i];
+    return res;
+}
+
+Matrix operator*(const Matrix &B, const DiagonalMatrix &D){
+    checkOrder(D.order(), B.order().second, "operator*(Matrix, DiagonalMatrix)");
+    Matrix C(B);
+    for (int j = 0; j < C.order().second; j++)
+        C.at(j) *= D[j];
+    return C;
+}
+
+Vector DiagonalMatrix::solve(const Vector &b) const{
+    checkOrder(order(), b.size(), "DiagonalMatrix::solve");
+    DiagonalMatrix inv = inverse();
+    return inv * b;
+}
+
+Matrix DiagonalMatrix::solve(const Matrix &B) const{
+    checkOrder(order(), B.order().first, "DiagonalMatrix::solve");
+    return inverse() * B;
+}
+
+double DiagonalMatrix::det() const{
+    double res = 1;
+    for (double x: d)
+        res *= x;
+    return res;
+}
+
+DiagonalMatrix DiagonalMatrix::inverse() const{
+    DiagonalMatrix res(*this);
+    for (double &x: res.d){
+        if (x == 0)
+            throwSingular("DiagonalMatrix");
+        x = 1 / x;
+    }
+    return res;
+}
+
+SquareMatrix DiagonalMatrix::toMatrix() const{
+    SquareMatrix res(order());
+    for (int i = 0; i < order(); i++)
+        res.at(i, i) = d[i];
+    return res;
+}
+
+// ===================== triangular ============================= //
+
+TriangularMatrix::TriangularMatrix(const Matrix &A, bool upper): TriangularMatrix(A.order().first, upper){
+    checkSquare(A, "TriangularMatrix");
+    for (int j = 0; j < n; j++){
+        const double *col = A.at(j).data();
+        if (upper)
+            std::copy(col, col + j + 1, a.begin() + index(0, j));
+        else
+            std::copy(col + j, col + n, a.begin() + index(j, j));
+    }
+}
+
+void TriangularMatrix::checkIndex(int i, int j) const{
+    if (i < 0 || i >= n || j < 0 || j >= n)
+        throwOutOfRange();
+}
+
+double TriangularMatrix::at(int i, int j) const{
+    checkIndex(i, j);
+    return inside(i, j) ? a[index(i, j)] : 0;
+}
+
+double &TriangularMatrix::at(int i, int j){
+    checkIndex(i, j);
+    if (!inside(i, j)){
+        std::cerr << "TriangularMatrix: element outside the triangle" << std::endl;
+        throw std::out_of_range("TriangularMatrix: element outside the triangle");
+    }
+    return a[index(i, j)];
+}
+
+void TriangularMatrix::multiplyInPlace(double *x) const{
+    // column oriented, so every packed column is read contiguously. x[j] is still unmodified when column j is applied.
+    if (upper)
+        for (int j = 0; j < n; j++){
+            const double *col = a.data() + index(0, j);
+            double xj = x[j];
+            for (int i = 0; i < j; i++)
+                x[i] += col[i] * xj;
+            x[j] = col[j] * xj;
+        }
+    else
+        for (int j = n - 1; j >= 0; j--){
+            const double *col = a.data() + index(j, j) - j;
+            double xj = x[j];
+            x[j] = col[j] * xj;
+            for (int i = j + 1; i < n; i++)
+                x[i] += col[i] * xj;
+        }
+}
+
+void TriangularMatrix::solveInPlace(double *x) const{
+    if (upper)
+        for (int j = n - 1; j >= 0; j--){
+            const double *col = a.data() + index(0, j);
+            if (col[j] == 0)
+                throwSingular("TriangularMatrix::solve");
+            double xj = x[j] /= col[j];
+            for (int i = 0; i < j; i++)
+                x[i] -= col[i] * xj;
+        }
+    else
+        for (int j = 0; j < n; j++){
+            // shifted so that col[i] is the (i,j)th element
+            const double *col = a.data() + index(j, j) - j;
+            if (col[j] == 0)
+                throwSingular("TriangularMatrix::solve");
+            double xj = x[j] /= col[j];
+            for (int i = j + 1; i < n; i++)
+                x[i] -= col[i] * xj;
+        }
+}
+
+Vector TriangularMatrix::operator*(const Vector &x) const{
+    checkOrder(n, x.size(), "TriangularMatrix::operator*");
+    Vector y(x);
+    multiplyInPlace(y.data());
+    return y;
+}
+
+Matrix TriangularMatrix::operator*(const Matrix &B) const{
+    checkOrder(n, B.order().first, "TriangularMatrix::operator*");
+    Matrix C(B);
+    for (int j = 0; j < C.order().second; j++)
+        multiplyInPlace(C.at(j).data());
+    return C;
+}
+
+Vector TriangularMatrix::solve(const Vector &b) const{
+    checkOrder(n, b.size(), "TriangularMatrix::solve");
+    Vector x(b);
+    solveInPlace(x.data());
+    return x;
+}
+
+Matrix TriangularMatrix::solve(const Matrix &B) const{
+    checkOrder(n, B.order().first, "TriangularMatrix::solve");
+    Matrix X(B);
+    for (int j = 0; j < X.order().second; j++)
+        solveInPlace(X.at(j).data());
+    return X;
+}
+
+double TriangularMatrix::det() const{
+    double res = 1;
+    for (int i = 0; i < n; i++)
+        res *= a[index(i, i)];
+    return res;
+}
+
+TriangularMatrix TriangularMatrix::inverse() const{
+    TriangularMatrix res(n, upper);
+    // column j of the inverse solves T x = e_j, and x is zero outside the leading (upper) or trailing (lower) part,
+    // so each solve only touches the j+1 (or n-j) rows that can be nonzero.
+    std::vector<double> x(n);
+    for (int j = 0; j < n; j++){
+        std::fill(x.begin(), x.end(), 0.0);
+        x[j] = 1;
+        if (upper)
+            for (int k = j; k >= 0; k--){
+                const double *col = a.data() + index(0, k);
+                if (col[k] == 0)
+                    throwSingular("TriangularMatrix::inverse");
+                double xk = x[k] /= col[k];
+                for (int i = 0; i < k; i++)
+                    x[i] -= col[i] * xk;
+            }
+        else
+            for (int k = j; k < n; k++){
+                const double *col = a.data() + index(k, k) - k;
+                if (col[k] == 0)
+                    throwSingular("TriangularMatrix::inverse");
+                double xk = x[k] /= col[k];
+                for (int i = k + 1; i < n; i++)
+                    x[i] -= col[i] * xk;
+            }
+        if (upper)
+            std::copy(x.begin(), x.begin() + j + 1, res.a.begin() + index(0, j));
+        else
+            std::copy(x.begin() + j, x.end(), res.a.begin() + index(j, j));
+    }
+    return res;
+}
+
+TriangularMatrix TriangularMatrix::transpose() const{
+    TriangularMatrix res(n, !upper);
+    for (int j = 0; j < n; j++)
+        for (int i = upper ? 0 : j; i < (upper ? j + 1 : n); i++)
+            res.a[res.index(j, i)] = a[index(i, j)];
+    return res;
+}
+
+SquareMatrix TriangularMatrix::toMatrix() const{
+    SquareMatrix res(n);
+    for (int j = 0; j < n; j++){
+        double *col = res.at(j).data();
+        if (upper)
+            std::copy(a.begin() + index(0, j), a.begin() + index(0, j) + j + 1, col);
+        else
+            std::copy(a.begin() + index(j, j), a.begin() + index(j, j) + (n - j), col + j);
+    }
+    return res;
+}
+
+// ===================== banded ============================= //
+
+BandedMatrix::BandedMatrix(int n, int kl, int ku): n{n}, kl{kl}, ku{ku}{
+    if (n < 0 || kl < 0 || ku < 0){
+        std::cerr << "BandedMatrix: negative order or bandwidth" << std::endl;
+        throw std::invalid_argument("BandedMatrix: negative order or bandwidth");
+    }
+    ab.resize((size_t)(kl + ku + 1) * n);
+}
+
+BandedMatrix::BandedMatrix(const Matrix &A, int kl, int ku): BandedMatrix(A.order().first, kl, ku){
+    checkSquare(A, "BandedMatrix");
+    for (int j = 0; j < n; j++){
+        const double *col = A.at(j).data();
+        for (int i = std::max(0, j - ku); i <= std::min(n - 1, j + kl); i++)
+            ab[(ku + i - j) + (size_t)j * (kl + ku + 1)] = col[i];
+    }
+}
+
+void BandedMatrix::checkIndex(int i, int j) const{
+    if (i < 0 || i >= n || j < 0 || j >= n)
+        throwOutOfRange();
+}
+
+double BandedMatrix::at(int i, int j) const{
+    checkIndex(i, j);
+    return inside(i, j) ? ab[(ku + i - j) + (size_t)j * (kl + ku + 1)] : 0;
+}
+
+double &BandedMatrix::at(int i, int j){
+    checkIndex(i, j);
+    if (!inside(i, j)){
+        std::cerr << "BandedMatrix: element outside the band" << std::endl;
+        throw std::out_of_range("BandedMatrix: element outside the band");
+    }
+    return ab[(ku + i - j) + (size_t)j * (kl + ku + 1)];
+}
+
+Vector BandedMatrix::operator*(const Vector &x) const{
+    checkOrder(n, x.size(), "BandedMatrix::operator*");
+    Vector y(n);
+    double *py = y.data();
+    const double *px = x.data();
+    size_t ld = kl + ku + 1;
+    for (int j = 0; j < n; j++){
+        // the band part of column j is contiguous in ab
+        const double *col = ab.data() + j * ld + ku - j;
+        double xj = px[j];
+        for (int i = std::max(0, j - ku); i <= std::min(n - 1, j + kl); i++)
+            py[i] += col[i] * xj;
+    }
+    return y;
+}
+
+Matrix BandedMatrix::operator*(const Matrix &B) const{
+    checkOrder(n, B.order().first, "BandedMatrix::operator*");
+    Matrix C(n, B.order().second);
+    for (int j = 0; j < B.order().second; j++)
+        C.at(j) = (*this) * B.at(j);
+    return C;
+}
+
+Vector BandedMatrix::solve(const Vector &b) const{
+    return BandedLU(*this).solve(b);
+}
+
+Matrix BandedMatrix::solve(const Matrix &B) const{
+    return BandedLU(*this).solve(B);
+}
+
+double BandedMatrix::det() const{
+    return BandedLU(*this).det();
+}
+
+SquareMatrix BandedMatrix::inverse() const{
+    return SquareMatrix(BandedLU(*this).solve(SquareMatrix(n, true)));
+}
+
+SquareMatrix BandedMatrix::toMatrix() const{
+    SquareMatrix res(n);
+    for (int j = 0; j < n; j++)
+        for (int i = std::max(0, j - ku); i <= std::min(n - 1, j + kl); i++)
+            res.at(i, j) = ab[(ku + i - j) + (size_t)j * (kl + ku + 1)];
+    return res;
+}
+
+BandedLU::BandedLU(const BandedMatrix &A): n{A.n}, kl{A.kl}, ku{A.ku}, ld{2 * A.kl + A.ku + 1},
+    lu((size_t)(2 * A.kl + A.ku + 1) * A.n), piv(A.n), sign{1}, singular{false}
+{
+    LINALG_PROFILE("BandedLU::BandedLU", 2.0 * n * kl * (kl + ku + 1), 8.0 * ld * n);
+    int kv = kl + ku;
+    // the first kl rows of each column are left zero for the fill-in caused by row interchanges
+    for (int j = 0; j < n; j++)
+        std::copy(A.ab.begin() + (size_t)j * (kl + ku + 1), A.ab.begin() + (size_t)(j + 1) * (kl + ku + 1), lu.begin() + (size_t)j * ld + kl);
+    double *a = lu.data();
+    // (i,j) is at a[kv + i - j + j*ld]
+    auto elem = [&](int i, int j) -> double &{ return a[kv + i - j + (size_t)j * ld]; };
+    int ju = 0; // last column touched by the row interchanges so far
+    for (int j = 0; j < n; j++){
+        int km = std::min(kl, n - 1 - j);
+        double *col = &elem(j, j);
+        int jp = 0;
+        for (int t = 1; t <= km; t++)
+            if (std::abs(col[t]) > std::abs(col[jp])) jp = t;
+        piv[j] = j + jp;
+        if (col[jp] == 0){
+            singular = true;
+            continue;
+        }
+        ju = std::max(ju, std::min(j + ku + jp, n - 1));
+        if (jp != 0){
+            sign = -sign;
+            for (int c = j; c <= ju; c++)
+                std::swap(elem(j, c), elem(j + jp, c));
+        }
+        double inv = 1 / col[0];
+        for (int t = 1; t <= km; t++)
+            col[t] *= inv;
+        // rank-1 update of the trailing band, one contiguous axpy per column
+        for (int c = j + 1; c <= ju; c++){
+            double *cc = &elem(j, c);
+            double f = cc[0];
+            if (f == 0)
+                continue;
+            for (int t = 1; t <= km; t++)
+                cc[t] -= f * col[t];
+        }
+    }
+}
+
+double BandedLU::det() const{
+    double d = sign;
+    for (int j = 0; j < n; j++)
+        d *= lu[(kl + ku) + (size_t)j * ld];
+    return d;
+}
+
+void BandedLU::solveInPlace(double *x) const{
+    if (singular)
+        throwSingular("BandedLU::solve");
+    int kv = kl + ku;
+    const double *a = lu.data();
+    // L solve, applying the interchanges as they come
+    for (int j = 0; j < n - 1; j++){
+        int lm = std::min(kl, n - 1 - j);
+        if (piv[j] != j)
+            std::swap(x[j], x[piv[j]]);
+        double xj = x[j];
+        if (xj != 0){
+            const double *col = a + kv + (size_t)j * ld;
+            for (int t = 1; t <= lm; t++)
+                x[j + t] -= xj * col[t];
+        }
+    }
+    // U solve, U has kl+ku superdiagonals
+    for (int j = n - 1; j >= 0; j--){
+        const double *col = a + kv + (size_t)j * ld - j; // col[i] is (i,j)
+        double xj = x[j] /= col[j];
+        for (int i = std::max(0, j - kv); i < j; i++)
+            x[i] -= xj * col[i];
+    }
+}
+
+Vector BandedLU::solve(const Vector &b) const{
+    checkOrder(n, b.size(), "BandedLU::solve");
+    Vector x(b);
+    solveInPlace(x.data());
+    return x;
+}
+
+Matrix BandedLU::solve(const Matrix &B) const{
+    checkOrder(n, B.order().first, "BandedLU::solve");
+    Matrix X(B);
+    for (int j = 0; j < X.order().second; j++)
+        solveInPlace(X.at(j).data());
+    return X;
+}
+
+// ===================== symmetric ============================= //
+
+SymmetricMatrix::SymmetricMatrix(const Matrix &A): SymmetricMatrix(A.order().first){
+    checkSquare(A, "SymmetricMatrix");
+    for (int j = 0; j < n; j++){
+        const double *col = A.at(j).data();
+        std::copy(col + j, col + n, a.begin() + index(j, j));
+    }
+}
+
+void SymmetricMatrix::checkIndex(int i, int j) const{
+    if (i < 0 || i >= n || j < 0 || j >= n)
+        throwOutOfRange();
+}
+
+double SymmetricMatrix::at(int i, int j) const{
+    checkIndex(i, j);
+    return a[index(i, j)];
+}
+
+double &SymmetricMatrix::at(int i, int j){
+    checkIndex(i, j);
+    return a[index(i, j)];
+}
+
+Vector SymmetricMatrix::operator*(const Vector &x) const{
+    checkOrder(n, x.size(), "SymmetricMatrix::operator*");
+    Vector y(n);
+    double *py = y.data();
+    const double *px = x.data();
+    // each stored column j contributes as column j (to y[j+1..]) and as row j (to y[j])
+    for (int j = 0; j < n; j++){
+        const double *col = a.data() + index(j, j) - j;
+        double xj = px[j], s = col[j] * xj;
+        for (int i = j + 1; i < n; i++){
+            py[i] += col[i] * xj;
+            s += col[i] * px[i];
+        }
+        py[j] += s;
+    }
+    return y;
+}
+
+Matrix SymmetricMatrix::operator*(const Matrix &B) const{
+    checkOrder(n, B.order().first, "SymmetricMatrix::operator*");
+    Matrix C(n, B.order().second);
+    for (int j = 0; j < B.order().second; j++)
+        C.at(j) = (*this) * B.at(j);
+    return C;
+}
+
+bool SymmetricMatrix::cholesky(TriangularMatrix &L) const{
+    // the packed lower triangle has the same layout in both classes
+    L = TriangularMatrix(n, false);
+    L.a = a;
+    // left-looking: column j is updated by the previous columns, each read contiguously from its diagonal down
+    for (int j = 0; j < n; j++){
+        double *cj = &L.at(j, j) - j;
+        for (int k = 0; k < j; k++){
+            const double *ck = &L.at(k, k) - k;
+            double f = ck[j];
+            if (f != 0)
+                for (int i = j; i < n; i++)
+                    cj[i] -= f * ck[i];
+        }
+        if (!(cj[j] > 0))
+            return false;
+        double d = std::sqrt(cj[j]);
+        cj[j] = d;
+        for (int i = j + 1; i < n; i++)
+            cj[i] /= d;
+    }
+    return true;
+}
+
+bool SymmetricMatrix::isPositiveDefinite() const{
+    TriangularMatrix L;
+    return cholesky(L);
+}
+
+TriangularMatrix SymmetricMatrix::cholesky() const{
+    TriangularMatrix L;
+    if (!cholesky(L)){
+        std::cerr << "SymmetricMatrix::cholesky: matrix is not positive definite" << std::endl;
+        throw std::domain_error("SymmetricMatrix::cholesky: matrix is not positive definite");
+    }
+    return L;
+}
+
+Vector SymmetricMatrix::solve(const Vector &b) const{
+    checkOrder(n, b.size(), "SymmetricMatrix::solve");
+    TriangularMatrix L;
+    if (!cholesky(L))
+        return LU(toMatrix()).solve(b);
+    Vector x(b);
+    L.solveInPlace(x.data());
+    L.transpose().solveInPlace(x.data());
+    return x;
+}
+
+Matrix SymmetricMatrix::solve(const Matrix &B) const{
+    checkOrder(n, B.order().first, "SymmetricMatrix::solve");
+    TriangularMatrix L;
+    if (!cholesky(L))
+        return LU(toMatrix()).solve(B);
+    TriangularMatrix Lt = L.transpose();
+    Matrix X(B);
+    for (int j = 0; j < X.order().second; j++){
+        L.solveInPlace(X.at(j).data());
+        Lt.solveInPlace(X.at(j).data());
+    }
+    return X;
+}
+
+double SymmetricMatrix::det() const{
+    TriangularMatrix L;
+    if (!cholesky(L))
+        return LU(toMatrix()).det();
+    double d = L.det();
+    return d * d;
+}
+
+SymmetricMatrix SymmetricMatrix::inverse() const{
+    TriangularMatrix L;
+    if (!cholesky(L))
+        return SymmetricMatrix(LU(toMatrix()).inverse());
+    // A^{-1} = L^{-T} L^{-1}: element (i,j), i >= j, is the dot product of columns i and j of L^{-1} over rows i..n-1
+    TriangularMatrix M = L.inverse();
+    SymmetricMatrix res(n);
+    for (int j = 0; j < n; j++){
+        const double *mj = &M.at(j, j) - j;
+        for (int i = j; i < n; i++){
+            const double *mi = &M.at(i, i) - i;
+            double s = 0;
+            for (int k = i; k < n; k++)
+                s += mi[k] * mj[k];
+            res.a[res.index(i, j)] = s;
+        }
+    }
+    return res;
+}
+
+SquareMatrix SymmetricMatrix::toMatrix() const{
+    SquareMatrix res(n);
+    for (int j = 0; j < n; j++)
+        for (int i = j; i < n; i++)
+            res.at(i, j) = res.at(j, i) = a[index(i, j)];
+    return res;
+}
@@ -0,0 +1,400 @@
+#ifndef STRUCTUREDMATRIX_H
+#define STRUCTUREDMATRIX_H
+
+#include <vector>
+#include "squareMatrix.h"
+
+#pragma once
+
+// Square matrices with known structure, stored packed (only the entries that can be nonzero) and with kernels that
+// exploit the structure: O(n) diagonal solves, O(n^2) triangular solves, O(n*kl*(kl+ku)) banded LU, Cholesky in packed storage.
+// Every type converts implicitly to a dense SquareMatrix, so it can still be passed to any routine taking a Matrix.
+
+/**
+ * @brief n*n diagonal matrix, storing only the n diagonal entries.
+ *
+ */
+class DiagonalMatrix{
+    std::vector<double> d;
+public:
+    /**
+     * @brief Construct the n*n diagonal matrix with every diagonal entry equal to value (value = 1 gives the identity).
+     *
+     * @param n the order of the matrix
+     * @param value the diagonal entry
+     */
+    DiagonalMatrix(int n = 0, double value = 0): d(n, value){}
+
+    /**
+     * @brief Construct the diagonal matrix with the entries of v on its diagonal.
+     */
+    DiagonalMatrix(const Vector &v): d(v.begin(), v.end()){}
+
+    int order() const{ return d.size(); }
+
+    /**
+     * @brief Returns the (i,j)th element (0 off the diagonal). Throws out_of_range if the indices are invalid.
+     */
+    double at(int i, int j) const;
+
+    /**
+     * @brief access the ith diagonal entry. Throws out_of_range error if the index is invalid.
+     */
+    double &operator[](int i);
+    const double &operator[](int i) const;
+
+    /**
+     * @brief Computes D*x in O(n).
+     */
+    Vector operator*(const Vector &x) const;
+
+    /**
+     * @brief Computes D*B, i.e. scales the rows of B, in O(size of B).
+     */
+    Matrix operator*(const Matrix &B) const;
+
+    DiagonalMatrix operator*(const DiagonalMatrix &D) const;
+
+    /**
+     * @brief Solves Dx = b in O(n). Throws a domain_error if a diagonal entry is zero.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves DX = B for every column of B. Throws a domain_error if a diagonal entry is zero.
+     */
+    Matrix solve(const Matrix &B) const;
+
+    /**
+     * @brief Returns the determinant, the product of the diagonal.
+     */
+    double det() const;
+
+    /**
+     * @brief Returns D^{-1}. Throws a domain_error if a diagonal entry is zero.
+     */
+    DiagonalMatrix inverse() const;
+
+    /**
+     * @brief Returns the dense n*n matrix.
+     */
+    SquareMatrix toMatrix() const;
+    operator SquareMatrix() const{ return toMatrix(); }
+};
+
+/**
+ * @brief Computes B*D, i.e. scales the columns of B, in O(size of B).
+ */
+Matrix operator*(const Matrix &B, const DiagonalMatrix &D);
+
+/**
+ * @brief n*n upper or lower triangular matrix in packed column-major storage (n(n+1)/2 doubles).
+ *
+ */
+class TriangularMatrix{
+    int n;
+    bool upper;
+    std::vector<double> a;
+
+    // position of (i,j) in the packed storage; (i,j) must be inside the triangle
+    size_t index(int i, int j) const{
+        return upper ? (size_t)j * (j + 1) / 2 + i : (size_t)j * n - (size_t)j * (j - 1) / 2 + (i - j);
+    }
+    bool inside(int i, int j) const{ return upper ? i <= j : i >= j; }
+    void checkIndex(int i, int j) const;
+    friend class SymmetricMatrix;
+public:
+    /**
+     * @brief Construct the n*n zero triangular matrix.
+     *
+     * @param n the order of the matrix
+     * @param upper true for upper triangular, false for lower triangular
+     */
+    TriangularMatrix(int n = 0, bool upper = true): n{n}, upper{upper}, a((size_t)n * (n + 1) / 2){}
+
+    /**
+     * @brief Construct from the upper (or lower) triangle of the square matrix A. The other entries of A are ignored.
+     */
+    TriangularMatrix(const Matrix &A, bool upper = true);
+
+    int order() const{ return n; }
+
+    bool isUpper() const{ return upper; }
+
+    /**
+     * @brief Returns the (i,j)th element (0 outside the triangle). Throws out_of_range if the indices are invalid.
+     */
+    double at(int i, int j) const;
+
+    /**
+     * @brief Returns a reference to the (i,j)th element. Throws out_of_range if the indices are invalid or outside the triangle.
+     */
+    double &at(int i, int j);
+
+    /**
+     * @brief Computes T*x in n^2 flops.
+     */
+    Vector operator*(const Vector &x) const;
+
+    /**
+     * @brief Computes T*B in n^2 flops per column of B.
+     */
+    Matrix operator*(const Matrix &B) const;
+
+    /**
+     * @brief Computes x := T*x in place.
+     *
+     * @param x pointer to n contiguous doubles
+     */
+    void multiplyInPlace(double *x) const;
+
+    /**
+     * @brief Solves Tx = b by substitution in n^2 flops. Throws a domain_error if a diagonal entry is zero.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves TX = B for every column of B. Throws a domain_error if a diagonal entry is zero.
+     */
+    Matrix solve(const Matrix &B) const;
+
+    /**
+     * @brief Solves x in place, overwriting the right hand side with the solution.
+     *
+     * @param x pointer to n contiguous doubles
+     */
+    void solveInPlace(double *x) const;
+
+    /**
+     * @brief Returns the determinant, the product of the diagonal.
+     */
+    double det() const;
+
+    /**
+     * @brief Returns T^{-1}, which is triangular as well, in n^3/3 flops. Throws a domain_error if a diagonal entry is zero.
+     */
+    TriangularMatrix inverse() const;
+
+    /**
+     * @brief Returns the transpose (upper becomes lower and vice versa).
+     */
+    TriangularMatrix transpose() const;
+
+    /**
+     * @brief Returns the dense n*n matrix.
+     */
+    SquareMatrix toMatrix() const;
+    operator SquareMatrix() const{ return toMatrix(); }
+};
+
+class BandedLU;
+
+/**
+ * @brief n*n matrix with kl subdiagonals and ku superdiagonals, in LAPACK band storage ((kl+ku+1)*n doubles).
+ * A tridiagonal matrix (kl = ku = 1) takes 3n doubles.
+ *
+ */
+class BandedMatrix{
+    int n, kl, ku;
+    // column j holds the elements (j-ku .. j+kl, j); (i,j) is at ab[(ku + i - j) + j*(kl+ku+1)]
+    std::vector<double> ab;
+
+    bool inside(int i, int j) const{ return i - j <= kl && j - i <= ku; }
+    void checkIndex(int i, int j) const;
+    friend class BandedLU;
+public:
+    /**
+     * @brief Construct the n*n zero matrix with the given bandwidths.
+     *
+     * @param n the order of the matrix
+     * @param kl number of subdiagonals
+     * @param ku number of superdiagonals
+     */
+    BandedMatrix(int n = 0, int kl = 0, int ku = 0);
+
+    /**
+     * @brief Construct from the band of the square matrix A. Entries of A outside the band are ignored.
+     */
+    BandedMatrix(const Matrix &A, int kl, int ku);
+
+    int order() const{ return n; }
+    int lowerBandwidth() const{ return kl; }
+    int upperBandwidth() const{ return ku; }
+
+    /**
+     * @brief Returns the (i,j)th element (0 outside the band). Throws out_of_range if the indices are invalid.
+     */
+    double at(int i, int j) const;
+
+    /**
+     * @brief Returns a reference to the (i,j)th element. Throws out_of_range if the indices are invalid or outside the band.
+     */
+    double &at(int i, int j);
+
+    /**
+     * @brief Computes A*x in O(n(kl+ku)).
+     */
+    Vector operator*(const Vector &x) const;
+
+    /**
+     * @brief Computes A*B in O(n(kl+ku)) per column of B.
+     */
+    Matrix operator*(const Matrix &B) const;
+
+    /**
+     * @brief Solves Ax = b through a banded LU factorization (see BandedLU). Throws a domain_error if A is singular.
+     * To solve repeatedly with the same matrix, keep a BandedLU instead.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves AX = B for every column of B. Throws a domain_error if A is singular.
+     */
+    Matrix solve(const Matrix &B) const;
+
+    /**
+     * @brief Returns the determinant, from the banded LU factorization.
+     */
+    double det() const;
+
+    /**
+     * @brief Returns A^{-1}. The inverse of a banded matrix is dense in general. Throws a domain_error if A is singular.
+     */
+    SquareMatrix inverse() const;
+
+    /**
+     * @brief Returns the dense n*n matrix.
+     */
+    SquareMatrix toMatrix() const;
+    operator SquareMatrix() const{ return toMatrix(); }
+};
+
+/**
+ * @brief LU factorization with partial pivoting of a BandedMatrix, PA = LU, in O(n*kl*(kl+ku)) flops.
+ * Pivoting widens U to kl+ku superdiagonals, so the factors take (2kl+ku+1)*n doubles.
+ *
+ * @note As with LU, the factorization itself never throws; an exactly zero pivot marks the matrix as singular and the solves then throw.
+ */
+class BandedLU{
+    int n, kl, ku, ld;
+    // (i,j) of the factors is at lu[(kl + ku + i - j) + j*ld]
+    std::vector<double> lu;
+    std::vector<int> piv;
+    int sign;
+    bool singular;
+public:
+    BandedLU(const BandedMatrix &A);
+
+    int order() const{ return n; }
+    bool isSingular() const{ return singular; }
+
+    /**
+     * @brief Returns the determinant, the signed product of the pivots.
+     */
+    double det() const;
+
+    /**
+     * @brief Solves Ax = b in O(n(2kl+ku)). Throws a domain_error if A is singular.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves AX = B for every column of B. Throws a domain_error if A is singular.
+     */
+    Matrix solve(const Matrix &B) const;
+
+    /**
+     * @brief Solves x in place, overwriting the right hand side with the solution.
+     *
+     * @param x pointer to n contiguous doubles
+     */
+    void solveInPlace(double *x) const;
+};
+
+/**
+ * @brief n*n symmetric matrix storing only its lower triangle, packed column-major (n(n+1)/2 doubles).
+ *
+ */
+class SymmetricMatrix{
+    int n;
+    std::vector<double> a;
+
+    size_t index(int i, int j) const{
+        if (i < j)
+            std::swap(i, j);
+        return (size_t)j * n - (size_t)j * (j - 1) / 2 + (i - j);
+    }
+    void checkIndex(int i, int j) const;
+    bool cholesky(TriangularMatrix &L) const;
+public:
+    /**
+     * @brief Construct the n*n zero matrix.
+     */
+    SymmetricMatrix(int n = 0): n{n}, a((size_t)n * (n + 1) / 2){}
+
+    /**
+     * @brief Construct from the lower triangle of the square matrix A. The strict upper triangle of A is ignored.
+     */
+    SymmetricMatrix(const Matrix &A);
+
+    int order() const{ return n; }
+
+    /**
+     * @brief Returns the (i,j)th element, equal to the (j,i)th. Throws out_of_range if the indices are invalid.
+     */
+    double at(int i, int j) const;
+
+    /**
+     * @brief Returns a reference to the (i,j)th element, which is shared with the (j,i)th. Throws out_of_range if the indices are invalid.
+     */
+    double &at(int i, int j);
+
+    /**
+     * @brief Computes A*x in n^2 flops, reading each stored element once.
+     */
+    Vector operator*(const Vector &x) const;
+
+    /**
+     * @brief Computes A*B in n^2 flops per column of B.
+     */
+    Matrix operator*(const Matrix &B) const;
+
+    /**
+     * @brief Checks if the matrix is (numerically) positive definite, i.e. if its Cholesky factorization exists.
+     */
+    bool isPositiveDefinite() const;
+
+    /**
+     * @brief Returns the lower triangular Cholesky factor L with A = LL^T, in n^3/3 flops.
+     * Throws a domain_error if the matrix is not positive definite.
+     */
+    TriangularMatrix cholesky() const;
+
+    /**
+     * @brief Solves Ax = b by Cholesky when A is positive definite, by dense LU otherwise. Throws a domain_error if A is singular.
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Solves AX = B for every column of B, see solve(const Vector&).
+     */
+    Matrix solve(const Matrix &B) const;
+
+    /**
+     * @brief Returns the determinant, from the Cholesky factor when A is positive definite, from dense LU otherwise.
+     */
+    double det() const;
+
+    /**
+     * @brief Returns A^{-1}, which is symmetric as well. Throws a domain_error if A is singular.
+     */
+    SymmetricMatrix inverse() const;
+
+    /**
+     * @brief Returns the dense n*n matrix.
+     */
+    SquareMatrix toMatrix() const;
+    operator SquareMatrix() const{ return toMatrix(); }
+};
+
+#endif
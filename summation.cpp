@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "summation.h"
+#include "parallel.h"
+
+// The error-free transformations and the pre-rounding of the reproducible mode need every product and sum rounded
+// separately: no fused multiply-adds. GCC ignores the standard pragma, and gets -ffp-contract=off from CMakeLists.txt.
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif !defined(__GNUC__) || defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+// elements below which a reduction runs on one thread, and the least elements per thread above it
+#define SUMMATION_PARALLEL_MIN (1 << 20)
+#define SUMMATION_GRAIN (1 << 18)
+// independent partial sums per loop, so that the loops vectorize
+#define SUMMATION_LANES 16
+
+// Reproducible mode: terms are pre-rounded a block at a time, against bins 2^(k*REPRO_BIN_BITS) chosen from the block's
+// largest term. A block of REPRO_BLOCK terms needs 12 bits of headroom above that term (REPRO_BLOCK*4 = 2^12), which
+// bounds the bin width at 53 - 12 bits.
+#define REPRO_BLOCK 1024
+#define REPRO_HEADROOM 12
+#define REPRO_BIN_BITS 40
+// every term is split over this many bins, for about 80 bits below the largest term of its block
+#define REPRO_FOLDS 3
+// top bins cover 2^-1000 .. 2^1040, and the folds go REPRO_FOLDS-1 bins lower
+#define REPRO_MIN_BIN -25
+#define REPRO_MAX_BIN 26
+#define REPRO_BINS (REPRO_MAX_BIN - REPRO_MIN_BIN + REPRO_FOLDS)
+
+namespace{
+
+std::atomic<int> configured{-1};
+
+Summation defaultMode(){
+    static const Summation mode = []{
+        if (const char *env = std::getenv("LINALG_SUMMATION")){
+            if (std::strcmp(env, "compensated") == 0)
+                return Summation::Compensated;
+            if (std::strcmp(env, "reproducible") == 0)
+                return Summation::Reproducible;
+        }
+        return Summation::Fast;
+    }();
+    return mode;
+}
+
+// error-free transformations: a + b = s + e and a * b = p + e exactly
+inline void twoSum(double a, double b, double &s, double &e){
+    s = a + b;
+    double z = s - a;
+    e = (a - (s - z)) + (b - z);
+}
+
+inline void twoProduct(double a, double b, double &p, double &e){
+    p = a * b;
+#ifdef FP_FAST_FMA
+    e = std::fma(a, b, -p);
+#else
+    // Dekker's product, splitting the factors into 26-bit halves
+    const double split = 134217729.0;
+    double t = split * a, ah = t - (t - a), al = a - ah;
+    t = split * b;
+    double bh = t - (t - b), bl = b - bh;
+    e = al * bl - (((p - ah * bh) - al * bh) - ah * bl);
+#endif
+}
+
+// the terms of a reduction: value(i) is the rounded term, exact(i) splits it into rounded value plus error
+template <bool Contiguous>
+struct DotTerms{
+    const double *x, *y;
+    long incx, incy;
+    double value(long i) const{ return Contiguous ? x[i] * y[i] : x[i * incx] * y[i * incy]; }
+    void exact(long i, double &p, double &e) const{ twoProduct(Contiguous ? x[i] : x[i * incx], Contiguous ? y[i] : y[i * incy], p, e); }
+};
+
+template <bool Contiguous>
+struct SumTerms{
+    const double *x;
+    long incx;
+    double value(long i) const{ return Contiguous ? x[i] : x[i * incx]; }
+    void exact(long i, double &p, double &e) const{ p = value(i); e = 0; }
+};
+
+// ------------------------------- Fast ------------------------------- //
+
+template <class Terms>
+double fastRange(const Terms &t, long lo, long hi){
+    double sum[SUMMATION_LANES] = {};
+    long i = lo;
+    for (; i + SUMMATION_LANES <= hi; i += SUMMATION_LANES)
+        for (int l = 0; l < SUMMATION_LANES; l++)
+            sum[l] += t.value(i + l);
+    for (; i < hi; i++)
+        sum[0] += t.value(i);
+    double s = 0;
+    for (int l = 0; l < SUMMATION_LANES; l++)
+        s += sum[l];
+    return s;
+}
+
+// ---------------------------- Compensated ---------------------------- //
+
+// sum s with the accumulated rounding errors c
+struct Compensated{
+    double s = 0, c = 0;
+    void add(double p, double e){
+        double q;
+        twoSum(s, p, s, q);
+        c += q + e;
+    }
+    void merge(const Compensated &o){ add(o.s, o.c); }
+    double value() const{ return s + c; }
+};
+
+template <class Terms>
+Compensated compensatedRange(const Terms &t, long lo, long hi){
+    double sum[SUMMATION_LANES] = {}, err[SUMMATION_LANES] = {};
+    long i = lo;
+    for (; i + SUMMATION_LANES <= hi; i += SUMMATION_LANES)
+        for (int l = 0; l < SUMMATION_LANES; l++){
+            double p, e, q;
+            t.exact(i + l, p, e);
+            twoSum(sum[l], p, sum[l], q);
+            err[l] += q + e;
+        }
+    Compensated acc;
+    for (int l = 0; l < SUMMATION_LANES; l++)
+        acc.merge(Compensated{sum[l], err[l]});
+    for (; i < hi; i++){
+        double p, e;
+        t.exact(i, p, e);
+        acc.add(p, e);
+    }
+    return acc;
+}
+
+// ---------------------------- Reproducible ---------------------------- //
+
+// A 128-bit two's complement integer in two halves, rather than the __int128 of some compilers, so that every compiler
+// runs the same integer arithmetic. toDouble rounds once, to nearest, as the conversion of a native 128-bit integer does.
+struct Wide{
+    uint64_t lo = 0, hi = 0;
+
+    void add(uint64_t l, uint64_t h){
+        lo += l;
+        hi += h + (lo < l);
+    }
+    void add(int64_t x){ add((uint64_t)x, x < 0 ? ~0ULL : 0); }
+    void add(const Wide &o){ add(o.lo, o.hi); }
+    bool isZero() const{ return lo == 0 && hi == 0; }
+
+    double toDouble() const{
+        bool negative = hi >> 63;
+        uint64_t l = lo, h = hi;
+        if (negative){
+            l = ~l + 1;
+            h = ~h + (l == 0);
+        }
+        double r;
+        if (h == 0)
+            r = (double)l;
+        else{
+            // the top 64 bits, with any nonzero bit shifted out kept as a sticky lowest bit, so that the rounding to
+            // 53 bits sees it (the bins stay far below 2^127, so s < 64)
+            int s = 0;
+            while (s < 64 && (h >> s) != 0)
+                s++;
+            uint64_t m = (h << (64 - s)) | (l >> s) | ((l << (64 - s)) != 0);
+            r = std::ldexp((double)m, s);
+        }
+        return negative ? -r : r;
+    }
+};
+
+// Exact sums of the pre-rounded slices: bin b counts units of 2^((b + REPRO_MIN_BIN - REPRO_FOLDS + 1)*REPRO_BIN_BITS - 52).
+// Integer addition is associative, so the bins of the blocks can be merged in any order. (A block adds at most 2^50 units
+// to a bin, so 128 bits hold the sum of any vector.)
+struct Bins{
+    Wide v[REPRO_BINS];
+    bool nan = false, positiveInfinity = false, negativeInfinity = false;
+
+    void merge(const Bins &o){
+        for (int b = 0; b < REPRO_BINS; b++)
+            v[b].add(o.v[b]);
+        nan = nan || o.nan;
+        positiveInfinity = positiveInfinity || o.positiveInfinity;
+        negativeInfinity = negativeInfinity || o.negativeInfinity;
+    }
+
+    double value() const{
+        if (nan || (positiveInfinity && negativeInfinity))
+            return std::numeric_limits<double>::quiet_NaN();
+        if (positiveInfinity || negativeInfinity)
+            return positiveInfinity ? HUGE_VAL : -HUGE_VAL;
+        double r = 0;
+        for (int b = 0; b < REPRO_BINS; b++)
+            if (!v[b].isZero())
+                r += std::ldexp(v[b].toDouble(), (b + REPRO_MIN_BIN - REPRO_FOLDS + 1) * REPRO_BIN_BITS - 52);
+        return r;
+    }
+};
+
+void binNonFinite(const double *t, int len, Bins &bins){
+    for (int i = 0; i < len; i++){
+        if (std::isnan(t[i]))
+            bins.nan = true;
+        else if (t[i] == HUGE_VAL)
+            bins.positiveInfinity = true;
+        else if (t[i] == -HUGE_VAL)
+            bins.negativeInfinity = true;
+    }
+}
+
+// adds the terms t[0 .. len-1] of one block to bins; t is padded with zeros to a whole number of lanes
+void binBlock(double *t, int len, Bins &bins){
+    double lane[SUMMATION_LANES] = {};
+    for (int i = 0; i < len; i += SUMMATION_LANES)
+        for (int l = 0; l < SUMMATION_LANES; l++){
+            // (written as a select rather than std::max so that it vectorizes)
+            double a = std::abs(t[i + l]);
+            lane[l] = a > lane[l] ? a : lane[l];
+        }
+    double m = *std::max_element(lane, lane + SUMMATION_LANES);
+    // (NaNs are invisible to the maximum: an all-NaN block looks like zeros)
+    if (m == 0 || !(m <= std::numeric_limits<double>::max())){
+        binNonFinite(t, len, bins);
+        return;
+    }
+    // top bin: 2^(k*W) >= 2^REPRO_HEADROOM * m
+    int e = std::ilogb(m) + 1 + REPRO_HEADROOM;
+    int k = std::max(REPRO_MIN_BIN, (int)std::ceil((double)e / REPRO_BIN_BITS));
+    // 1.5*2^(k*W) would overflow in the top bin: work on the block scaled down by one bin
+    int kc = k;
+    if (k > REPRO_MAX_BIN - 1){
+        kc = k - 1;
+        for (int i = 0; i < len; i++)
+            t[i] = std::ldexp(t[i], -REPRO_BIN_BITS);
+    }
+    // fold f rounds what the previous folds left of t to a multiple of ulp(s[f]), exactly; the rounding depends on t alone,
+    // and the sums of the folds are exact, so neither depends on the order of the terms
+    double s0 = std::ldexp(1.5, kc * REPRO_BIN_BITS), s1 = std::ldexp(1.5, (kc - 1) * REPRO_BIN_BITS), s2 = std::ldexp(1.5, (kc - 2) * REPRO_BIN_BITS);
+    double a0[SUMMATION_LANES] = {}, a1[SUMMATION_LANES] = {}, a2[SUMMATION_LANES] = {};
+    for (int i = 0; i < len; i += SUMMATION_LANES)
+        for (int l = 0; l < SUMMATION_LANES; l++){
+            double r = t[i + l], q0 = (s0 + r) - s0;
+            r -= q0;
+            double q1 = (s1 + r) - s1;
+            r -= q1;
+            a0[l] += q0;
+            a1[l] += q1;
+            a2[l] += (s2 + r) - s2;
+        }
+    double fold[REPRO_FOLDS] = {};
+    for (int l = 0; l < SUMMATION_LANES; l++){
+        fold[0] += a0[l];
+        fold[1] += a1[l];
+        fold[2] += a2[l];
+    }
+    if (!std::isfinite(fold[0])){
+        // a NaN among the terms
+        binNonFinite(t, len, bins);
+        return;
+    }
+    for (int f = 0; f < REPRO_FOLDS; f++)
+        bins.v[k - REPRO_MIN_BIN + REPRO_FOLDS - 1 - f].add((int64_t)std::ldexp(fold[f], 52 - (kc - f) * REPRO_BIN_BITS));
+}
+
+// blocks are aligned to multiples of REPRO_BLOCK from the start of the vector, whoever processes them
+template <class Terms>
+void reproducibleRange(const Terms &t, long lo, long hi, Bins &bins){
+    double block[REPRO_BLOCK];
+    for (long b0 = lo; b0 < hi; b0 += REPRO_BLOCK){
+        int len = (int)std::min<long>(REPRO_BLOCK, hi - b0);
+        for (int i = 0; i < len; i++)
+            block[i] = t.value(b0 + i);
+        std::fill(block + len, block + (len + SUMMATION_LANES - 1) / SUMMATION_LANES * SUMMATION_LANES, 0.0);
+        binBlock(block, len, bins);
+    }
+}
+
+// ------------------------------- driver ------------------------------- //
+
+template <class Terms>
+double reduce(long n, const Terms &t, Summation mode){
+    if (n <= 0)
+        return 0;
+    // short reductions, the common case, accumulate on the stack: no chunk array and no parallelFor
+    if (n < SUMMATION_PARALLEL_MIN){
+        switch (mode){
+        case Summation::Compensated:
+            return compensatedRange(t, 0, n).value();
+        case Summation::Reproducible:{
+            Bins bins;
+            reproducibleRange(t, 0, n, bins);
+            return bins.value();
+        }
+        default:
+            return fastRange(t, 0, n);
+        }
+    }
+    int threads = 0;
+    switch (mode){
+    case Summation::Compensated:{
+        std::vector<Compensated> part(parallelChunks(0, n, SUMMATION_GRAIN, threads));
+        parallelFor(0, n, [&](int c, long long lo, long long hi){ part[c] = compensatedRange(t, lo, hi); }, SUMMATION_GRAIN, threads);
+        for (size_t c = 1; c < part.size(); c++)
+            part[0].merge(part[c]);
+        return part[0].value();
+    }
+    case Summation::Reproducible:{
+        // the chunks are made of whole blocks
+        long blocks = (n + REPRO_BLOCK - 1) / REPRO_BLOCK;
+        std::vector<Bins> part(parallelChunks(0, blocks, SUMMATION_GRAIN / REPRO_BLOCK, threads));
+        parallelFor(0, blocks, [&](int c, long long lo, long long hi){
+            reproducibleRange(t, lo * REPRO_BLOCK, std::min<long>(n, hi * REPRO_BLOCK), part[c]);
+        }, SUMMATION_GRAIN / REPRO_BLOCK, threads);
+        for (size_t c = 1; c < part.size(); c++)
+            part[0].merge(part[c]);
+        return part[0].value();
+    }
+    default:{
+        std::vector<double> part(parallelChunks(0, n, SUMMATION_GRAIN, threads));
+        parallelFor(0, n, [&](int c, long long lo, long long hi){ part[c] = fastRange(t, lo, hi); }, SUMMATION_GRAIN, threads);
+        double s = 0;
+        for (double p: part)
+            s += p;
+        return s;
+    }
+    }
+}
+
+}
+
+Summation summationMode(){
+    int m = configured.load(std::memory_order_relaxed);
+    return m >= 0 ? (Summation)m : defaultMode();
+}
+
+void setSummationMode(Summation mode){
+    configured.store((int)mode, std::memory_order_relaxed);
+}
+
+double reduceDot(long n, const double *x, long incx, const double *y, long incy, Summation mode){
+    if (incx == 1 && incy == 1)
+        return reduce(n, DotTerms<true>{x, y, 1, 1}, mode);
+    return reduce(n, DotTerms<false>{x, y, incx, incy}, mode);
+}
+
+double reduceSum(long n, const double *x, long incx, Summation mode){
+    if (incx == 1)
+        return reduce(n, SumTerms<true>{x, 1}, mode);
+    return reduce(n, SumTerms<false>{x, incx}, mode);
+}
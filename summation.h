@@ -0,0 +1,54 @@
+#ifndef SUMMATION_H
+#define SUMMATION_H
+
+#pragma once
+
+// Summation modes of the reductions behind Vector::dot, Vector::norm and their view counterparts.
+//
+// Fast keeps several partial sums (so the loop vectorizes) and splits long vectors over threads: its result depends on
+// the thread count, like any parallel sum. Compensated is the Dot2/Sum2 algorithm of Ogita, Rump and Oishi: the result is
+// as accurate as if computed in twice the working precision, then rounded. Reproducible pre-rounds every term onto a fixed
+// grid of exponent bins (binned summation, after Demmel and Nguyen): the terms of each block of the vector are split
+// exactly into two slices aligned to the bins, the slices are summed exactly as 128-bit integers, and only the final
+// conversion rounds. The result is bitwise identical whatever the thread count, the order of the blocks or the vector
+// width, with an error about n*2^-80*max|term| on top of the rounding of the products. Across machines and compilers it
+// is identical as long as both use IEEE doubles rounded to nearest and keep every product and sum rounded separately:
+// summation.cpp turns floating point contraction off with -ffp-contract=off under GCC and Clang (see CMakeLists.txt) and
+// with the FP_CONTRACT pragmas elsewhere, and the bins need no compiler extension such as __int128.
+//
+// Cost relative to Fast, measured for Vector::dot on one core of an x86-64 machine (Xeon, AVX-512), in a default build
+// and, in brackets, one with -march=native:
+//   Compensated   6-8x (1.3-2x) while the vectors fit in cache, 2x (1.3x) for 8M elements streamed from memory
+//   Reproducible  5-6x (3.5-4.5x) in cache, 2.3x (1.7x) from memory
+// The exact products of Compensated take one fused multiply-add with FMA, instead of Dekker's split. Reproducible misses
+// the aim of about 2x in cache; it only comes near it for vectors streamed from memory.
+// Reductions of fewer than 2^20 terms run on the calling thread and do not allocate.
+
+/**
+ * @brief How a reduction accumulates its terms.
+ *
+ */
+enum class Summation{Fast, Compensated, Reproducible};
+
+/**
+ * @brief Returns the mode used when none is given: the one set by setSummationMode if any, otherwise the LINALG_SUMMATION
+ * environment variable (fast, compensated or reproducible), otherwise Fast.
+ */
+Summation summationMode();
+
+/**
+ * @brief Sets the mode used by the reductions called without one.
+ */
+void setSummationMode(Summation mode);
+
+/**
+ * @brief Sum of x[i*incx] * y[i*incy] for i = 0 .. n-1.
+ */
+double reduceDot(long n, const double *x, long incx, const double *y, long incy, Summation mode = summationMode());
+
+/**
+ * @brief Sum of x[i*incx] for i = 0 .. n-1.
+ */
+double reduceSum(long n, const double *x, long incx, Summation mode = summationMode());
+
+#endif
@@ -0,0 +1,158 @@
+#include <deque>
+#include <thread>
+#include "task.h"
+#include "parallel.h"
+#include "numa.h"
+
+namespace{
+
+// the task whose job runs on this thread, for taskCheckpoint
+thread_local TaskState *current = nullptr;
+
+}
+
+bool TaskState::ready(){
+    std::lock_guard<std::mutex> guard(lock);
+    return done;
+}
+
+void TaskState::wait(){
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [this]{ return done; });
+}
+
+void TaskState::report(double f){
+    f = std::min(1.0, std::max(f, 0.0));
+    if (f <= fraction)
+        return;
+    fraction = f;
+    std::function<void(double)> callback;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        callback = progressCallback;
+    }
+    if (callback)
+        callback(f);
+}
+
+void TaskState::onProgress(std::function<void(double)> callback){
+    std::lock_guard<std::mutex> guard(lock);
+    progressCallback = std::move(callback);
+}
+
+void TaskState::finish(std::exception_ptr e){
+    std::vector<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        error = e;
+        done = true;
+        pending.swap(continuations);
+    }
+    finished.notify_all();
+    for (auto &f: pending)
+        f();
+}
+
+void TaskState::whenDone(std::function<void()> f){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!done){
+            continuations.push_back(std::move(f));
+            return;
+        }
+    }
+    f();
+}
+
+void TaskContext::checkpoint(double fraction){
+    state->report(fraction);
+    if (state->cancelled())
+        throw TaskCancelled();
+}
+
+void taskCheckpoint(double fraction){
+    if (current)
+        TaskContext(current).checkpoint(fraction);
+}
+
+struct Executor::Impl{
+    std::mutex lock;
+    std::condition_variable available;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    void work(){
+        for (;;){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                available.wait(guard, [this]{ return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+Executor::Executor(int threads): impl{new Impl}{
+    threads = std::max(1, threads);
+    // pinned workers are spread over the nodes like the chunks of parallelFor
+    bool pin = threadPinning();
+    for (int i = 0; i < threads; i++)
+        impl->workers.emplace_back([this, pin, i, threads]{
+            NumaPin pinned(pin ? numaChunkNode(i, threads) : -1);
+            impl->work();
+        });
+}
+
+Executor::~Executor(){
+    {
+        std::lock_guard<std::mutex> guard(impl->lock);
+        impl->stopping = true;
+    }
+    impl->available.notify_all();
+    for (auto &w: impl->workers)
+        w.join();
+}
+
+Executor &Executor::global(){
+    static Executor executor(std::max(2, threadCount()));
+    return executor;
+}
+
+void Executor::submit(std::function<void()> job){
+    {
+        std::lock_guard<std::mutex> guard(impl->lock);
+        impl->jobs.push_back(std::move(job));
+    }
+    impl->available.notify_one();
+}
+
+int Executor::size() const{
+    return impl->workers.size();
+}
+
+void Executor::run(TaskState *state, const std::function<void(TaskContext &)> &job){
+    if (state->cancelled()){
+        state->finish(std::make_exception_ptr(TaskCancelled()));
+        return;
+    }
+    TaskState *outer = current;
+    current = state;
+    std::exception_ptr error;
+    try{
+        TaskContext context(state);
+        job(context);
+    }
+    catch (...){
+        error = std::current_exception();
+    }
+    current = outer;
+    if (!error)
+        state->report(1);
+    state->finish(error);
+}
@@ -0,0 +1,290 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define LINALG_COROUTINES
+#endif
+
+#pragma once
+
+// Asynchronous execution of long-running routines on the library's executor, a fixed pool of worker threads.
+// runAsync returns a Task, a future that can be waited on, polled, cancelled, observed for progress, chained with then
+// and joined with whenAll, and co_awaited under C++20.
+//
+// Cancellation is cooperative: the long-running kernels (LU, Gram-Schmidt, row reduction, gemm) call taskCheckpoint
+// at regular points, which reports their progress and throws TaskCancelled once the task they run in is cancelled.
+
+/**
+ * @brief Thrown by Task::get for a cancelled task, and inside the task at its next checkpoint.
+ *
+ */
+class TaskCancelled: public std::runtime_error{
+public:
+    TaskCancelled(): std::runtime_error("task cancelled"){}
+};
+
+/**
+ * @brief The state a Task shares with the job computing it: completion, error, cancellation, progress and continuations.
+ *
+ */
+class TaskState{
+    std::mutex lock;
+    std::condition_variable finished;
+    bool done = false;
+    std::exception_ptr error;
+    std::atomic<bool> cancelRequested{false};
+    std::atomic<double> fraction{0};
+    std::function<void(double)> progressCallback;
+    std::vector<std::function<void()>> continuations;
+public:
+    virtual ~TaskState(){}
+
+    bool ready();
+    void wait();
+    void cancel(){ cancelRequested = true; }
+    bool cancelled() const{ return cancelRequested; }
+    double progress() const{ return fraction; }
+    std::exception_ptr exception(){ wait(); return error; }
+
+    /**
+     * @brief Records the fraction of the work done (kept monotone) and calls the progress callback.
+     */
+    void report(double f);
+    void onProgress(std::function<void(double)> callback);
+
+    /**
+     * @brief Marks the task as done (with an error if e is not null), wakes the waiters and runs the continuations.
+     */
+    void finish(std::exception_ptr e = nullptr);
+
+    /**
+     * @brief Runs f when the task is done: at once if it already is, otherwise on the thread finishing it.
+     */
+    void whenDone(std::function<void()> f);
+};
+
+template <class T>
+class TaskResult: public TaskState{
+public:
+    std::optional<T> value;
+};
+
+/**
+ * @brief Handle given to the function run by runAsync, to report progress and check for cancellation.
+ *
+ */
+class TaskContext{
+    TaskState *state;
+public:
+    TaskContext(TaskState *state): state{state}{}
+    bool cancelled() const{ return state->cancelled(); }
+    void progress(double fraction){ state->report(fraction); }
+    /**
+     * @brief Reports progress and throws TaskCancelled if the task was cancelled.
+     */
+    void checkpoint(double fraction);
+};
+
+/**
+ * @brief Reports the progress of the calling kernel (a fraction in [0,1] of its work) to the task it runs in, and throws
+ * TaskCancelled if that task was cancelled. Outside a task, it does nothing.
+ */
+void taskCheckpoint(double fraction);
+
+/**
+ * @brief The pool of worker threads running the tasks.
+ *
+ */
+class Executor{
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+public:
+    /**
+     * @brief Starts the given number of worker threads.
+     */
+    explicit Executor(int threads);
+    /**
+     * @brief Runs the queued jobs and joins the workers.
+     */
+    ~Executor();
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    /**
+     * @brief The library's executor, with max(2, threadCount()) workers, started on first use.
+     */
+    static Executor &global();
+
+    void submit(std::function<void()> job);
+    int size() const;
+
+    /**
+     * @brief Runs job(context) for the task of the given state: skipped (TaskCancelled) if cancelled before starting,
+     * with taskCheckpoint reporting to the task while it runs.
+     */
+    static void run(TaskState *state, const std::function<void(TaskContext &)> &job);
+};
+
+template <class T>
+class Task;
+
+template <class F>
+auto runAsync(F f, Executor &executor = Executor::global());
+
+/**
+ * @brief The result of an asynchronous computation, shared by all copies of the handle. T must not be void.
+ *
+ */
+template <class T>
+class Task{
+    std::shared_ptr<TaskResult<T>> state;
+    template <class U> friend class Task;
+    template <class F> friend auto runAsync(F f, Executor &executor);
+    template <class... U> friend Task<std::tuple<U...>> whenAll(const Task<U> &...tasks);
+public:
+    typedef T value_type;
+    Task(){}
+    explicit Task(std::shared_ptr<TaskResult<T>> state): state{std::move(state)}{}
+
+    /**
+     * @brief Returns an already completed task holding value.
+     */
+    static Task completed(T value){
+        auto s = std::make_shared<TaskResult<T>>();
+        s->value = std::move(value);
+        s->report(1);
+        s->finish();
+        return Task(s);
+    }
+
+    bool valid() const{ return (bool)state; }
+
+    /**
+     * @brief Checks if the task is done, without blocking.
+     */
+    bool isReady() const{ return state->ready(); }
+
+    /**
+     * @brief Blocks until the task is done.
+     */
+    void wait() const{ state->wait(); }
+
+    /**
+     * @brief Blocks until the task is done and returns its result, or rethrows its exception (TaskCancelled if it was cancelled).
+     */
+    const T &get() const{
+        if (std::exception_ptr e = state->exception())
+            std::rethrow_exception(e);
+        return *state->value;
+    }
+
+    /**
+     * @brief Requests cancellation: the task stops at its next checkpoint, or does not start. Tasks depending on it fail with TaskCancelled.
+     */
+    void cancel() const{ state->cancel(); }
+    bool cancelled() const{ return state->cancelled(); }
+
+    /**
+     * @brief Returns the fraction of the work done, as last reported.
+     */
+    double progress() const{ return state->progress(); }
+
+    /**
+     * @brief Calls callback(fraction) on every progress report, from the thread running the task.
+     */
+    void onProgress(std::function<void(double)> callback) const{ state->onProgress(std::move(callback)); }
+
+    /**
+     * @brief Returns the task computing f(result) once this one is done. If this task fails, the new one fails with the same exception without calling f.
+     * f may also take a TaskContext& as second argument.
+     */
+    template <class F>
+    auto then(F f, Executor &executor = Executor::global()) const{
+        auto s = state;
+        typedef std::conditional_t<std::is_invocable_v<F, const T &, TaskContext &>,
+            std::invoke_result<F, const T &, TaskContext &>, std::invoke_result<F, const T &>> R;
+        typedef std::decay_t<typename R::type> U;
+        auto next = std::make_shared<TaskResult<U>>();
+        state->whenDone([s, next, f, &executor]() mutable{
+            if (std::exception_ptr e = s->exception()){
+                next->finish(e);
+                return;
+            }
+            executor.submit([s, next, f]() mutable{
+                Executor::run(next.get(), [&](TaskContext &context){
+                    if constexpr (std::is_invocable_v<F, const T &, TaskContext &>)
+                        next->value.emplace(f(*s->value, context));
+                    else
+                        next->value.emplace(f(*s->value));
+                });
+            });
+        });
+        return Task<U>(next);
+    }
+
+#ifdef LINALG_COROUTINES
+    // co_await resumes the coroutine on the executor and yields get(), a reference into the task: copy the value of an
+    // awaited temporary task before the end of the statement
+    bool await_ready() const{ return isReady(); }
+    void await_suspend(std::coroutine_handle<> handle) const{
+        state->whenDone([handle]{ Executor::global().submit([handle]{ handle.resume(); }); });
+    }
+    const T &await_resume() const{ return get(); }
+#endif
+};
+
+/**
+ * @brief Runs f on the executor and returns the task of its result. f takes no argument or a TaskContext&.
+ */
+template <class F>
+auto runAsync(F f, Executor &executor){
+    typedef std::conditional_t<std::is_invocable_v<F, TaskContext &>, std::invoke_result<F, TaskContext &>, std::invoke_result<F>> R;
+    typedef std::decay_t<typename R::type> T;
+    auto s = std::make_shared<TaskResult<T>>();
+    executor.submit([s, f]() mutable{
+        Executor::run(s.get(), [&](TaskContext &context){
+            if constexpr (std::is_invocable_v<F, TaskContext &>)
+                s->value.emplace(f(context));
+            else
+                s->value.emplace(f());
+        });
+    });
+    return Task<T>(s);
+}
+
+/**
+ * @brief Returns the task of the tuple of the results, done once all the given tasks are. Fails with the first exception among them.
+ */
+template <class... U>
+Task<std::tuple<U...>> whenAll(const Task<U> &...tasks){
+    static_assert(sizeof...(U) > 0, "whenAll needs at least one task");
+    auto res = std::make_shared<TaskResult<std::tuple<U...>>>();
+    auto remaining = std::make_shared<std::atomic<int>>((int)sizeof...(U));
+    auto states = std::make_tuple(tasks.state...);
+    auto arrive = [res, remaining, states]{
+        if (--*remaining)
+            return;
+        std::exception_ptr e;
+        std::apply([&](const auto &...s){ ((e = e ? e : s->exception()), ...); }, states);
+        if (!e)
+            res->value.emplace(std::apply([](const auto &...s){ return std::make_tuple(*s->value...); }, states));
+        res->report(1);
+        res->finish(e);
+    };
+    (tasks.state->whenDone(arrive), ...);
+    return Task<std::tuple<U...>>(res);
+}
+
+#endif
@@ -0,0 +1,71 @@
+// Minimal checking macros shared by the tests. Each test is its own executable: CHECK records a failure and carries
+// on, and main returns report(), which is non-zero if any check failed, for ctest.
+
+#ifndef LINALG_TESTS_CHECK_H
+#define LINALG_TESTS_CHECK_H
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "linalg"
+
+namespace check{
+
+inline int failures = 0;
+
+inline void fail(const char *file, int line, const char *what){
+    std::cerr << file << ":" << line << ": check failed: " << what << std::endl;
+    failures++;
+}
+
+inline int report(){
+    if (failures)
+        std::cerr << failures << " check(s) failed" << std::endl;
+    return failures ? 1 : 0;
+}
+
+// largest elementwise difference of two matrices of the same shape, infinity if the shapes differ
+inline double maxDiff(const Matrix &A, const Matrix &B){
+    if (A.order() != B.order())
+        return INFINITY;
+    double d = 0;
+    for (int j = 0; j < A.order().second; j++)
+        for (int i = 0; i < A.order().first; i++)
+            d = std::max(d, std::abs(A.at(j).data()[i] - B.at(j).data()[i]));
+    return d;
+}
+
+inline double maxDiff(const Vector &a, const Vector &b){
+    if (a.size() != b.size())
+        return INFINITY;
+    double d = 0;
+    for (int i = 0; i < a.size(); i++)
+        d = std::max(d, std::abs(a[i] - b[i]));
+    return d;
+}
+
+inline double maxDiff(double a, double b){
+    return std::abs(a - b);
+}
+
+// an m*n matrix of standard normal samples
+inline Matrix random(int m, int n, unsigned seed = 1){
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> dist;
+    Matrix A(m, n);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < m; i++)
+            A.at(j).data()[i] = dist(gen);
+    return A;
+}
+
+}
+
+#define CHECK(cond) do{ if (!(cond)) check::fail(__FILE__, __LINE__, #cond); }while(0)
+// a and b (matrices, vectors or scalars) agree elementwise to within tol
+#define CHECK_NEAR(a, b, tol) CHECK(check::maxDiff((a), (b)) <= (tol))
+// the expression throws an exception of the given type
+#define CHECK_THROWS(expr, type) do{ bool thrown = false; try{ (void)(expr); }catch (const type &){ thrown = true; } \
+    if (!thrown) check::fail(__FILE__, __LINE__, #expr " throws " #type); }while(0)
+
+#endif
@@ -0,0 +1,81 @@
+// Zero-copy adoption of external buffers, moves in and out of Vector and Matrix, and the bulk constructors.
+
+#include <atomic>
+#include <type_traits>
+#include "check.h"
+
+int main(){
+    // moving a std::vector in and out keeps its storage
+    std::vector<double> raw = {1, 2, 3};
+    const double *storage = raw.data();
+    Vector v(std::move(raw));
+    CHECK(v.data() == storage);
+    CHECK(v.size() == 3 && v[2] == 3);
+    std::vector<double> back = v.release();
+    CHECK(back.data() == storage);
+    CHECK(v.size() == 0);
+
+    std::vector<Vector> columns = {Vector({1, 2}), Vector({3, 4})};
+    const double *first = columns[0].data();
+    Matrix M(std::move(columns));
+    CHECK(M.at(0).data() == first);
+    CHECK(M.at(1, 1) == 4);
+
+    // the row-wise initializer list
+    CHECK_NEAR(Matrix({{1, 2, 3}, {4, 5, 6}}), Matrix({{1, 4}, {2, 5}, {3, 6}}, true), 0);
+
+    // generators, small and large enough to be split over threads
+    Vector g(100000, [](int i){ return 0.5 * i; });
+    CHECK(g[0] == 0 && g[99999] == 0.5 * 99999);
+    for (int m: {3, 700}){
+        Matrix G(m, 50, [](int i, int j){ return i + 1000.0 * j; });
+        bool ok = true;
+        for (int j = 0; j < 50; j++)
+            for (int i = 0; i < m; i++)
+                ok = ok && G.at(i, j) == i + 1000.0 * j;
+        CHECK(ok);
+    }
+    CHECK(Matrix(0, 0, [](int, int){ return 1.0; }).order() == std::make_pair(0, 0));
+
+    // a row-major buffer, viewed without copying
+    double rowMajor[6] = {1, 2, 3, 4, 5, 6};
+    ConstMatrixView R(rowMajor, 2, 3, 3, 1);
+    CHECK_NEAR(Matrix(R), Matrix({{1, 2, 3}, {4, 5, 6}}), 0);
+    MatrixView W(rowMajor, 2, 3, 3, 1);
+    W.at(1, 0) = 40;
+    CHECK(rowMajor[3] == 40);
+    Matrix P = Matrix(R) * Matrix({{1}, {1}, {1}});
+    CHECK(P.at(0, 0) == 6 && P.at(1, 0) == 51);
+    CHECK_THROWS(ConstMatrixView(rowMajor, 2, 3, -1, 1), std::invalid_argument);
+
+    ConstVectorView odd(rowMajor, 3, 2);
+    CHECK(odd[0] == 1 && odd[1] == 3 && odd[2] == 5);
+
+    // MatrixBuffer runs its deleter once, after the last copy is gone
+    std::atomic<int> deleted{0};
+    {
+        MatrixBuffer B(new double[4]{1, 2, 3, 4}, 2, 2, 2, [&](double *p){ delete[] p; deleted++; });
+        {
+            MatrixBuffer copy(B);
+            copy.at(0, 0) = 10;
+        }
+        CHECK(deleted == 0);
+        CHECK(B.at(0, 0) == 10);
+        Matrix product = Matrix(B) * Matrix(B);
+        CHECK(product.at(0, 0) == 10 * 10 + 3 * 2);
+        // the buffer is aliased, not copied, by views of it
+        CHECK(B.overlaps(B.block(1, 1, 1, 1)));
+    }
+    CHECK(deleted == 1);
+
+    MatrixBuffer own(3, 2);
+    own = 0.0;
+    own.at(2, 1) = 7;
+    CHECK(Matrix(own).at(2, 1) == 7);
+    // a buffer or view is copied into a Matrix only where the call says so
+    static_assert(!std::is_convertible_v<MatrixBuffer, Matrix> && !std::is_convertible_v<ConstMatrixView, SquareMatrix>);
+    static_assert(std::is_constructible_v<Matrix, MatrixBuffer> && std::is_constructible_v<SquareMatrix, ConstMatrixView>);
+    CHECK(SquareMatrix(own.block(1, 0, 2, 2)).rank() == 1);
+    CHECK_THROWS(gemm(1, own.block(0, 0, 2, 2), own.block(0, 0, 2, 2), 0, own.block(1, 0, 2, 2)), std::invalid_argument);
+    return check::report();
+}
@@ -0,0 +1,85 @@
+// The opt-in per-matrix cache: memoized results, invalidation on modification, and results independent of the cache state.
+
+#include <utility>
+#include "check.h"
+
+int main(){
+    // a permutation: the determinant carries the sign of the row exchange whatever was queried before
+    SquareMatrix P({{0, 1}, {1, 0}});
+    CHECK(P.det() == -1);
+    P.enableCache();
+    CHECK(P.det() == -1);
+    P.lu();
+    CHECK(P.det() == -1);
+    SquareMatrix Q({{0, 1}, {1, 0}});
+    Q.enableCache();
+    Q.lu();
+    CHECK(Q.det() == -1);
+    CHECK(SquareMatrix({{0, 0, 1}, {0, 1, 0}, {1, 0, 0}}).det() == -1);
+    CHECK(SquareMatrix({{1, 2}, {2, 4}}).det() == 0);
+    CHECK(std::abs(SquareMatrix({{2, 1, 0}, {1, 3, 1}, {0, 1, 4}}).det() - 18) <= 1e-12);
+
+    SquareMatrix A(check::random(30, 30));
+    double d = A.det(), r = A.rcond();
+    int rank = A.rank();
+    SquareMatrix inv = A.inverse();
+    A.enableCache();
+    CHECK(A.cacheEnabled());
+    // the same answers, then the same objects from the cache
+    CHECK(std::abs(A.det() - d) <= 1e-9 * std::abs(d));
+    CHECK(A.rank() == rank);
+    CHECK(A.rcond() == r);
+    CHECK_NEAR(A.inverse(), inv, 1e-9);
+    CHECK(A.lu() == A.lu());
+    CHECK(A.det() == A.lu()->det());
+
+    // a modification through a mutating accessor bumps the version and drops the memoized results
+    unsigned long long version = A.version();
+    auto factors = A.lu();
+    A.at(0, 0) += 1;
+    CHECK(A.version() > version);
+    CHECK(A.lu() != factors);
+    SquareMatrix B(A);
+    CHECK(std::abs(A.det() - SquareMatrix(B).det()) <= 1e-9 * std::abs(A.det()));
+
+    // reads through cat or a const reference keep them
+    auto kept = A.lu();
+    version = A.version();
+    double read = A.cat(1, 1) + A.cat(2).norm() + std::as_const(A).at(3, 3);
+    CHECK(A.version() == version && A.lu() == kept && std::isfinite(read));
+    A.at(1, 1);
+    CHECK(A.version() > version && A.lu() != kept);
+
+    // QR is memoized per method
+    Matrix T = check::random(200, 5, 3);
+    auto gs = T.QR(), tsqr = T.QR(QRMethod::TSQR);
+    CHECK(check::maxDiff(gs.first, tsqr.first) > 0);
+    T.enableCache();
+    for (int k = 0; k < 2; k++){
+        CHECK_NEAR(T.QR().first, gs.first, 0);
+        CHECK_NEAR(T.QR(QRMethod::TSQR).first, tsqr.first, 0);
+    }
+
+    // a write through a view obtained earlier is only noticed after touch()
+    MatrixView corner = A.block(0, 0, 1, 1);
+    double before = A.det();
+    auto lu = A.lu();
+    corner = 0.0;
+    CHECK(A.lu() == lu);
+    A.touch();
+    CHECK(A.lu() != lu);
+    CHECK(A.det() != before);
+
+    // copies start with an empty cache, and assignment invalidates the target's
+    SquareMatrix C(A);
+    CHECK(C.cacheEnabled());
+    version = C.version();
+    C = SquareMatrix(check::random(30, 30, 2));
+    CHECK(C.version() > version);
+    CHECK(std::abs(C.det() - SquareMatrix(check::random(30, 30, 2)).det()) <= 1e-9 * std::abs(C.det()));
+
+    A.enableCache(false);
+    CHECK(!A.cacheEnabled());
+    CHECK(A.lu() != A.lu());
+    return check::report();
+}
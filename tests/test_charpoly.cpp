@@ -0,0 +1,51 @@
+// SquareMatrix::charpoly and Paterson-Stockmeyer evaluation of polynomials at a matrix.
+
+#include "check.h"
+
+namespace{
+
+// p(A) by Horner's rule
+Matrix horner(const Polynomial &p, const SquareMatrix &A){
+    int n = A.order();
+    Matrix acc(n, n);
+    for (int k = (int)p.coefficients().size() - 1; k >= 0; k--){
+        acc = acc * A;
+        for (int i = 0; i < n; i++)
+            acc.at(i, i) += p[k];
+    }
+    return acc;
+}
+
+}
+
+int main(){
+    SquareMatrix T({{2, 1, 0}, {1, 3, 1}, {0, 1, 4}});
+    // det(xI - T) = x^3 - 9x^2 + 24x - 18
+    Polynomial t = T.charpoly();
+    CHECK(t.coefficients().size() == 4);
+    CHECK_NEAR(t[0], -18, 1e-12);
+    CHECK_NEAR(t[1], 24, 1e-12);
+    CHECK_NEAR(t[2], -9, 1e-12);
+    CHECK(t[3] == 1);
+
+    // Cayley-Hamilton on a random matrix
+    SquareMatrix A(check::random(12, 12));
+    Polynomial c = A.charpoly();
+    CHECK(c.coefficients().size() == 13 && c[12] == 1);
+    CHECK(A.evaluate(c).normInf() <= 1e-8 * std::pow(A.normInf(), 12));
+
+    // every degree, including those where the top block is a single coefficient (degree a multiple of the block size)
+    SquareMatrix B(check::random(7, 7, 2));
+    for (int j = 0; j < 7; j++)
+        B.at(j) /= 3;
+    for (int d = 0; d <= 17; d++){
+        std::vector<double> coefficients(d + 1);
+        for (int k = 0; k <= d; k++)
+            coefficients[k] = 1.0 / (k + 1) - 0.3 * (k % 3);
+        Polynomial p(coefficients);
+        CHECK_NEAR(B.evaluate(p), horner(p, B), 1e-12);
+    }
+    CHECK_NEAR(B.evaluate(Polynomial()), Matrix(7, 7), 0);
+    CHECK_NEAR(B.evaluate(Polynomial({0, 0, 1})), B * B, 1e-14);
+    return check::report();
+}
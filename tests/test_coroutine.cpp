@@ -0,0 +1,82 @@
+// co_await on a Task (C++20): a coroutine suspended on a pending task resumes on the executor with its value, an
+// awaited failure is rethrown inside the coroutine, and a finished task does not suspend at all.
+
+#include <future>
+#include <thread>
+#include "check.h"
+
+#ifndef LINALG_COROUTINES
+#error "test_coroutine needs a C++20 compiler with coroutine support"
+#endif
+
+namespace{
+
+// a coroutine type that starts at once and is never awaited itself: results go through a std::promise
+struct Detached{
+    struct promise_type{
+        Detached get_return_object(){ return {}; }
+        std::suspend_never initial_suspend() noexcept{ return {}; }
+        std::suspend_never final_suspend() noexcept{ return {}; }
+        void return_void(){}
+        void unhandled_exception(){ std::terminate(); }
+    };
+};
+
+struct Result{
+    SquareMatrix inverse;
+    bool resumedElsewhere = false;
+};
+
+Detached invert(const SquareMatrix &A, Task<int> gate, std::promise<Result> &out){
+    std::thread::id caller = std::this_thread::get_id();
+    co_await gate;
+    SquareMatrix inverse = co_await A.inverseAsync();
+    out.set_value({inverse, std::this_thread::get_id() != caller});
+}
+
+Detached failing(std::promise<bool> &out){
+    try{
+        co_await runAsync([]() -> int{ throw std::domain_error("failed"); });
+        out.set_value(false);
+    }
+    catch (const std::domain_error &){
+        out.set_value(true);
+    }
+}
+
+Detached ready(std::promise<std::pair<int, bool>> &out){
+    std::thread::id caller = std::this_thread::get_id();
+    int v = co_await Task<int>::completed(7);
+    out.set_value({v, std::this_thread::get_id() == caller});
+}
+
+}
+
+int main(){
+    SquareMatrix A = check::random(50, 50);
+    std::atomic<bool> release{false};
+    Task<int> gate = runAsync([&]{ while (!release); return 1; });
+    std::promise<Result> result;
+    std::future<Result> pending = result.get_future();
+    invert(A, gate, result);
+    // the coroutine is suspended on the gate
+    CHECK(pending.wait_for(std::chrono::milliseconds(10)) == std::future_status::timeout);
+    release = true;
+    Result r = pending.get();
+    CHECK_NEAR(r.inverse, A.inverse(), 1e-10);
+    CHECK(r.resumedElsewhere);
+
+    std::promise<bool> caught;
+    std::future<bool> failure = caught.get_future();
+    failing(caught);
+    CHECK(failure.get());
+
+    std::promise<std::pair<int, bool>> immediate;
+    std::future<std::pair<int, bool>> value = immediate.get_future();
+    ready(immediate);
+    CHECK(value.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    auto [v, sameThread] = value.get();
+    CHECK(v == 7 && sameThread);
+
+    return check::report();
+}
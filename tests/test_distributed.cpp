@@ -0,0 +1,52 @@
+// Collectives of both transports, and the distributed product and solve against their serial counterparts.
+
+#include <stdexcept>
+#include "check.h"
+
+namespace{
+
+// the collectives and a distributed product and solve on one rank, throwing on a wrong result (the socket ranks are
+// separate processes, so only the exit status reaches the test)
+void exercise(Transport &comm, const Matrix &A, const Matrix &B, const Vector &b){
+    std::vector<int> all(comm.size());
+    for (int r = 0; r < comm.size(); r++)
+        all[r] = r;
+
+    std::vector<double> data{comm.rank() == 0 ? 42.0 : 0.0};
+    comm.broadcast(data, 0, all, 1);
+    std::vector<double> total{double(comm.rank() + 1), 1};
+    comm.allSum(total, all, 2);
+    if (data[0] != 42 || total[0] != comm.size() * (comm.size() + 1) / 2 || total[1] != comm.size())
+        throw std::runtime_error("wrong collective");
+
+    DistributedMatrix dA(comm, A, 4), dB(comm, B, 4);
+    if (check::maxDiff((dA * dB).gather(), A * B) > 1e-10)
+        throw std::runtime_error("wrong product");
+    Vector x = dA.solve(b);
+    if (check::maxDiff(A * x, b) > 1e-9)
+        throw std::runtime_error("wrong solution");
+    comm.barrier();
+}
+
+}
+
+int main(){
+    Matrix A = check::random(19, 19), B = check::random(19, 11, 2);
+    Vector b = Matrix(check::random(19, 1, 3)).at(0);
+
+    // forks before the threads of the other cases are started, as SocketTransport::run requires
+    CHECK(SocketTransport::run(4, [&](Transport &comm){ exercise(comm, A, B, b); }) == 0);
+    CHECK(SocketTransport::run(2, [](Transport &comm){ if (comm.rank() == 1) throw std::runtime_error("failed"); }) > 0);
+
+    std::vector<int> failed(4);
+    ThreadTransport::run(4, [&](Transport &comm){
+        try{
+            exercise(comm, A, B, b);
+        }catch (const std::exception &){
+            failed[comm.rank()] = 1;
+        }
+    });
+    CHECK(failed == std::vector<int>(4));
+
+    return check::report();
+}
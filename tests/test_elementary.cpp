@@ -0,0 +1,58 @@
+// ElementaryProgram: replaying a recorded sequence matches performing it operation by operation, and the algebra of
+// programs (matrix, inverse, composition) agrees with the elementary matrices.
+
+#include "check.h"
+
+int main(){
+    const int n = 5;
+    Matrix A = check::random(n, 4);
+
+    ElementaryProgram p(n);
+    p.scale(1, 3).swap(0, 4).add(2, 4, -0.5).swap(1, 3).append(ElementaryOp::Add, 0, 1, 2);
+    CHECK(p.size() == 5 && p.order() == n);
+
+    // the same operations, one at a time
+    Matrix expected = A;
+    expected.elementaryRowOperation(ElementaryOp::Scale, 1, 0, 3);
+    expected.elementaryRowOperation(ElementaryOp::Swap, 0, 4);
+    expected.elementaryRowOperation(ElementaryOp::Add, 2, 4, -0.5);
+    expected.elementaryRowOperation("P", 1, 3);
+    expected.elementaryRowOperation("E", 0, 1, 2);
+    Matrix rows = A;
+    p.applyToRows(rows);
+    CHECK_NEAR(rows, expected, 1e-14);
+
+    SquareMatrix E = p.toMatrix();
+    CHECK_NEAR(E * A, expected, 1e-14);
+    Vector v = A.at(2);
+    p.apply(v);
+    CHECK_NEAR(v, expected.at(2), 1e-14);
+
+    // on columns the program computes A E^T
+    Matrix C = check::random(3, n, 2), columns = C;
+    p.applyToColumns(columns);
+    CHECK_NEAR(columns, C * Matrix(E.view().transposed()), 1e-14);
+
+    SquareMatrix identity(n, true);
+    Matrix undone = rows;
+    p.inverse().applyToRows(undone);
+    CHECK_NEAR(undone, A, 1e-14);
+    CHECK_NEAR(p.then(p.inverse()).toMatrix(), identity, 1e-14);
+
+    ElementaryProgram q(n);
+    q.add(3, 0, 1.5).swap(2, 3);
+    CHECK_NEAR(p.then(q).toMatrix(), q.toMatrix() * p.toMatrix(), 1e-14);
+
+    CHECK_THROWS(ElementaryProgram(3).scale(0, 0), std::invalid_argument);
+    CHECK_THROWS(ElementaryProgram(3).swap(0, 3), std::out_of_range);
+
+    // rref records the reduction, which then reproduces it on the same matrix
+    Matrix S = check::random(4, 6, 3);
+    ElementaryProgram ops;
+    Matrix R = S.rref(ops);
+    Matrix replayed = S;
+    ops.applyToRows(replayed);
+    CHECK_NEAR(replayed, R, 1e-12);
+
+    return check::report();
+}
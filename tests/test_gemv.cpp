@@ -0,0 +1,77 @@
+// gemv, gemvT and ger on Vectors and views, including operands that alias the output.
+
+#include "check.h"
+
+namespace{
+
+Vector naiveProduct(const Matrix &A, const Vector &x){
+    Vector y(A.order().first);
+    for (int i = 0; i < A.order().first; i++)
+        for (int j = 0; j < A.order().second; j++)
+            y[i] += A.at(i, j) * x[j];
+    return y;
+}
+
+}
+
+int main(){
+    Matrix A = check::random(37, 23);
+    Vector x = Matrix(check::random(23, 1)).at(0), z = Matrix(check::random(37, 1, 2)).at(0);
+
+    Vector y(37);
+    Matrix::gemv(2, A, x, 0, y);
+    CHECK_NEAR(y, naiveProduct(A, x) * 2, 1e-12);
+    CHECK_NEAR(A * x, naiveProduct(A, x), 1e-12);
+
+    Vector w(23);
+    Matrix::gemvT(1, A, z, 0, w);
+    CHECK_NEAR(w, naiveProduct(A.transpose(), z), 1e-12);
+
+    Matrix B = A;
+    Matrix::ger(0.5, z, x, B);
+    for (int i = 0; i < 37; i++)
+        for (int j = 0; j < 23; j++)
+            CHECK(std::abs(B.at(i, j) - (A.at(i, j) + 0.5 * z[i] * x[j])) <= 1e-12);
+
+    // a transposed view goes through the dot-product kernel
+    Vector t(23);
+    gemv(1, A.view().transposed(), z, 0, t);
+    CHECK_NEAR(t, w, 1e-12);
+
+    CHECK_THROWS(Matrix::gemv(1, A, z, 0, y), std::invalid_argument);
+
+    // x is a column of the matrix updated by ger
+    Matrix C({{1, 2}, {3, 4}});
+    Matrix::ger(1, C.at(0), {1, 1}, C);
+    CHECK_NEAR(C, Matrix({{2, 3}, {6, 7}}), 0);
+
+    // y is a column of the matrix multiplied by gemv, and x a column of the same matrix as y
+    Matrix D({{1, 2}, {3, 4}});
+    Matrix::gemv(1, D, {1, 1}, 0, D.at(1));
+    CHECK_NEAR(D.at(1), Vector({3, 7}), 0);
+    Matrix E({{1, 2}, {3, 4}});
+    Matrix::gemvT(1, E, E.at(0), 0, E.at(1));
+    CHECK_NEAR(E.at(1), Vector({10, 14}), 0);
+
+    // the same aliasing, large enough for the parallel kernels
+    Matrix F = check::random(300, 300, 3), G = F;
+    Vector expected = naiveProduct(F, F.at(7));
+    Matrix::gemv(1, F, F.at(7), 0, F.at(7));
+    CHECK_NEAR(F.at(7), expected, 1e-10);
+    Vector x0 = G.at(5), y0 = G.at(9);
+    Matrix::ger(1, G.at(5), G.at(9), G);
+    Matrix H = check::random(300, 300, 3);
+    for (int j = 0; j < 300; j++)
+        for (int i = 0; i < 300; i++)
+            H.at(i, j) += x0[i] * y0[j];
+    CHECK_NEAR(G, H, 1e-12);
+
+    // views of one external buffer are seen to alias even when they address it differently
+    double buffer[6] = {1, 2, 3, 4, 5, 6};
+    ConstMatrixView colMajor(buffer, 2, 3, 2), rowMajor(buffer, 3, 2, 2, 1);
+    CHECK(colMajor.overlaps(rowMajor));
+    CHECK(!colMajor.block(0, 0, 2, 1).overlaps(colMajor.block(0, 1, 2, 2)));
+    // interleaved rows of the buffer share no element
+    CHECK(!ConstMatrixView(buffer, 1, 3, 2).overlaps(ConstMatrixView(buffer + 1, 1, 3, 2)));
+    return check::report();
+}
@@ -0,0 +1,66 @@
+// Profiler bookkeeping: scopes, allocation attribution through countAllocation, and the JSON and trace writers.
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+void *operator new(std::size_t size){
+    Profiler::countAllocation(size);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+// GCC takes the free of a replacement delete for a mismatch with the built-in new
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept{ std::free(p); }
+void operator delete(void *p, std::size_t) noexcept{ std::free(p); }
+
+int main(){
+    unsigned long long allocs = Profiler::threadAllocations(), bytes = Profiler::threadAllocatedBytes();
+    {
+        std::vector<double> v(100);
+        CHECK(v.size() == 100);
+    }
+    CHECK(Profiler::threadAllocations() == allocs + 1);
+    CHECK(Profiler::threadAllocatedBytes() == bytes + 800);
+
+    Profiler::reset();
+    for (int k = 0; k < 3; k++){
+        ProfileScope scope("test::scope", 10, 20);
+        std::vector<double> v(4);
+        CHECK(v.size() == 4);
+    }
+    ProfileStats s = Profiler::stats("test::scope");
+    CHECK(s.calls == 3);
+    CHECK(s.flops == 30);
+    CHECK(s.bytes == 60);
+    CHECK(s.allocations == 3);
+    CHECK(s.allocated_bytes == 96);
+    CHECK(s.seconds >= 0);
+    CHECK(Profiler::stats("never called").calls == 0);
+
+    std::ostringstream json, trace;
+    Profiler::writeJson(json);
+    Profiler::writeChromeTrace(trace);
+    CHECK(json.str().find("\"test::scope\": {\"calls\": 3") != std::string::npos);
+    CHECK(trace.str().find("\"name\": \"test::scope\"") != std::string::npos);
+
+    // the instrumented routines record only in an instrumented build
+    Profiler::reset();
+    Matrix A = check::random(8, 8);
+    Matrix B = A * A;
+    CHECK((Profiler::stats("Matrix::operator*").calls > 0) == Profiler::enabled());
+    CHECK(B.order().first == 8);
+    // the parallel QR methods return from their own kernels, inside the scope of the routine
+    Matrix tall = check::random(2000, 6);
+    tall.GramSchmidt(false, QRMethod::TSQR);
+    tall.QR(QRMethod::BlockCGS2);
+    CHECK((Profiler::stats("Matrix::GramSchmidt").calls == 1) == Profiler::enabled());
+    CHECK((Profiler::stats("Matrix::QR").calls == 1) == Profiler::enabled());
+    CHECK((Profiler::stats("tsqr").calls == 1) == Profiler::enabled());
+    return check::report();
+}
@@ -0,0 +1,64 @@
+// Lazy Kronecker sums against the explicit matrices they stand for: elements, products, transposes and solves.
+
+#include "check.h"
+
+namespace{
+
+// the explicit A (x) B
+Matrix kron(const Matrix &A, const Matrix &B){
+    int m = A.order().first, n = A.order().second, p = B.order().first, q = B.order().second;
+    return Matrix(m * p, n * q, [&](int i, int j){ return A.at(i / p, j / q) * B.at(i % p, j % q); });
+}
+
+Vector randomVector(int n, unsigned seed){
+    return Matrix(check::random(n, 1, seed)).at(0);
+}
+
+}
+
+int main(){
+    Matrix A = check::random(3, 4), B = check::random(2, 5, 2);
+    Kronecker K(A, B);
+    Matrix dense = kron(A, B);
+    CHECK(K.order() == std::make_pair(6L, 20L) && K.terms() == 1);
+    CHECK_NEAR(K.dense(), dense, 0);
+    CHECK(K.at(5, 19) == dense.at(5, 19));
+    CHECK_THROWS(K.at(6, 0), std::out_of_range);
+
+    Vector x = randomVector(20, 3), z = randomVector(6, 4);
+    CHECK_NEAR(K * x, dense * x, 1e-13);
+    Vector y = randomVector(6, 5), expected = dense * x * 2 + y * 0.5;
+    Kronecker::gemv(2, K, x, 0.5, y);
+    CHECK_NEAR(y, expected, 1e-13);
+    Vector w(20);
+    Kronecker::gemvT(1, K, z, 0, w);
+    CHECK_NEAR(w, Matrix(dense.view().transposed()) * z, 1e-13);
+    CHECK_NEAR(K.transposed().dense(), Matrix(dense.view().transposed()), 0);
+
+    // a sum of terms: 2 A (x) B - A2 (x) B2
+    Matrix A2 = check::random(3, 4, 6), B2 = check::random(2, 5, 7);
+    Kronecker S = 2 * K - Kronecker(A2, B2);
+    CHECK(S.terms() == 2);
+    Matrix denseS(6, 20), second = kron(A2, B2);
+    for (int j = 0; j < 20; j++)
+        for (int i = 0; i < 6; i++)
+            denseS.at(i, j) = 2 * dense.at(i, j) - second.at(i, j);
+    CHECK_NEAR(S.dense(), denseS, 1e-14);
+    CHECK_NEAR(S * x, denseS * x, 1e-13);
+    CHECK_THROWS(K + Kronecker(B, A), std::invalid_argument);
+
+    // solves: one square term through the factors, a sum through the dense matrix; x may alias y
+    SquareMatrix C = check::random(4, 4, 8), D = check::random(5, 5, 9);
+    Kronecker single(C, D);
+    Vector b = randomVector(20, 10);
+    CHECK_NEAR(single.dense() * single.solve(b), b, 1e-10);
+    Kronecker sum = single + Kronecker(SquareMatrix(4, true), D);
+    CHECK_NEAR(sum.dense() * sum.solve(b), b, 1e-10);
+    CHECK_NEAR(LS_Solver::solve(single, b).first, single.solve(b), 1e-12);
+    Vector inPlace = b;
+    Kronecker::gemv(1, single, inPlace, 0, inPlace);
+    CHECK_NEAR(inPlace, single.dense() * b, 1e-12);
+    CHECK_THROWS(Kronecker(SquareMatrix(2), D).solve(randomVector(10, 11)), std::domain_error);
+
+    return check::report();
+}
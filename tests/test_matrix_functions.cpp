@@ -0,0 +1,49 @@
+// expm, sqrtm, logm and SquareMatrix::pow.
+
+#include <climits>
+#include "check.h"
+
+int main(){
+    // exp of a rotation generator is the rotation
+    double t = 0.7;
+    SquareMatrix J({{0, -t}, {t, 0}});
+    CHECK_NEAR(expm(J), Matrix({{std::cos(t), -std::sin(t)}, {std::sin(t), std::cos(t)}}), 1e-14);
+    CHECK_NEAR(expm(SquareMatrix(3)), SquareMatrix(3, true), 0);
+    // large norm: many squarings
+    SquareMatrix D({{10, 0}, {0, -3}});
+    CHECK_NEAR(expm(D), Matrix({{std::exp(10.0), 0}, {0, std::exp(-3.0)}}), 1e-9);
+
+    // a symmetric positive definite matrix: sqrtm squares back, logm inverts expm
+    Matrix R = check::random(6, 6);
+    SquareMatrix S(R.view().transposed() * R);
+    for (int i = 0; i < 6; i++)
+        S.at(i, i) += 1;
+    SquareMatrix X = sqrtm(S);
+    CHECK_NEAR(X * X, S, 1e-10 * S.normInf());
+    SquareMatrix L = logm(S);
+    CHECK_NEAR(expm(L), S, 1e-10 * S.normInf());
+    SquareMatrix small(check::random(5, 5, 2));
+    for (int j = 0; j < 5; j++)
+        small.at(j) /= 4;
+    CHECK_NEAR(logm(expm(small)), small, 1e-12);
+    CHECK_THROWS(sqrtm(SquareMatrix({{-1, 0}, {0, 1}})), std::domain_error);
+    CHECK_THROWS(logm(SquareMatrix({{-2, 0}, {0, 1}})), std::domain_error);
+
+    // powers against repeated products
+    SquareMatrix A(check::random(5, 5, 3));
+    for (int j = 0; j < 5; j++)
+        A.at(j) /= 3;
+    Matrix product = SquareMatrix(5, true);
+    for (int k = 0; k <= 13; k++){
+        CHECK_NEAR(A.pow(k), product, 1e-12);
+        product = product * A;
+    }
+    CHECK_NEAR(A.pow(-3) * A.pow(3), SquareMatrix(5, true), 1e-9);
+
+    // extreme exponents of a permutation of order 2
+    SquareMatrix P({{0, 1}, {1, 0}});
+    CHECK_NEAR(P.pow(LLONG_MIN), SquareMatrix(2, true), 0);
+    CHECK_NEAR(P.pow(LLONG_MAX), P, 0);
+    CHECK_NEAR(P.pow(LLONG_MIN + 1), P, 0);
+    return check::report();
+}
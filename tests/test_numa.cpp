@@ -0,0 +1,92 @@
+// NUMA policies and thread pinning: the settings and the chunk to node map, and results that do not depend on either.
+// On a single node machine placement is a no-op, so only the bookkeeping and the results are checked.
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "check.h"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace{
+
+Matrix product(){
+    Matrix A(600, 700, [](int i, int j){ return std::sin(i + 0.5 * j); }), B(700, 300, [](int i, int j){ return std::cos(i - j); });
+    return A * B;
+}
+
+}
+
+int main(){
+    // read once, before anything is allocated
+    setenv("LINALG_NUMA", "bind:0", 1);
+    setenv("LINALG_PIN_THREADS", "1", 1);
+    CHECK(numaPolicy() == NumaPolicy::Bind && numaBindNode() == 0);
+    CHECK(threadPinning());
+
+    int nodes = numaNodeCount();
+    CHECK(nodes >= 1);
+    // chunks are dealt to the nodes in contiguous groups, every node serving some
+    for (int chunks: {1, 3, 16}){
+        int previous = 0;
+        std::vector<bool> used(nodes);
+        for (int c = 0; c < chunks; c++){
+            int node = numaChunkNode(c, chunks);
+            CHECK(node >= previous && node < nodes);
+            previous = node;
+            used[node] = true;
+        }
+        if (chunks >= nodes)
+            CHECK(std::find(used.begin(), used.end(), false) == used.end());
+    }
+
+    Matrix reference = product();
+    for (NumaPolicy policy: {NumaPolicy::Default, NumaPolicy::FirstTouch, NumaPolicy::Interleave, NumaPolicy::Bind})
+        for (bool pin: {false, true}){
+            setNumaPolicy(policy, 0);
+            setThreadPinning(pin);
+            CHECK(numaPolicy() == policy && threadPinning() == pin);
+            CHECK_NEAR(product(), reference, 0);
+        }
+    setNumaPolicy(NumaPolicy::Interleave);
+    CHECK(numaRangeNode(5, 100) == -1);
+    setNumaPolicy(NumaPolicy::FirstTouch);
+    CHECK(numaRangeNode(0, 100) == 0 && numaRangeNode(99, 100) < nodes);
+
+#ifdef __linux__
+    // a pin restores the affinity of the thread when it ends
+    cpu_set_t before, during, after;
+    sched_getaffinity(0, sizeof before, &before);
+    {
+        NumaPin pin(0);
+        sched_getaffinity(0, sizeof during, &during);
+        CHECK(CPU_COUNT(&during) >= 1 && CPU_COUNT(&during) <= CPU_COUNT(&before));
+    }
+    sched_getaffinity(0, sizeof after, &after);
+    CHECK(CPU_EQUAL(&before, &after));
+
+    // pinned loops run on the same workers call after call, each confined to one node, and leave the caller as it was
+    setThreadPinning(true);
+    std::mutex lock;
+    std::set<std::thread::id> workers;
+    std::thread::id caller = std::this_thread::get_id();
+    bool confined = true;
+    for (int call = 0; call < 20; call++)
+        parallelFor(0, 4, [&](int, long long, long long){
+            cpu_set_t cpus;
+            sched_getaffinity(0, sizeof cpus, &cpus);
+            std::lock_guard<std::mutex> guard(lock);
+            confined = confined && CPU_COUNT(&cpus) <= CPU_COUNT(&before);
+            if (std::this_thread::get_id() != caller)
+                workers.insert(std::this_thread::get_id());
+        }, 1, 4);
+    CHECK(confined && workers.size() <= 3);
+    sched_getaffinity(0, sizeof after, &after);
+    CHECK(CPU_EQUAL(&before, &after));
+#endif
+
+    return check::report();
+}
@@ -0,0 +1,87 @@
+// parallelFor: the chunks cover the range once each, run on workers kept across calls, nest inline, pass exceptions
+// to the caller, and keep working from several callers at once and in a forked child.
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "check.h"
+
+namespace{
+
+// whether parallelFor over [0, n) in the given number of chunks touches every index exactly once
+bool coversOnce(long long n, int threads){
+    std::vector<std::atomic<int>> seen(n);
+    int chunks = parallelFor(0, n, [&](int, long long lo, long long hi){
+        for (long long i = lo; i < hi; i++)
+            seen[i]++;
+    }, 1, threads);
+    bool once = chunks == std::min<long long>(threads, n);
+    for (auto &s: seen)
+        once = once && s == 1;
+    return once;
+}
+
+}
+
+int main(){
+    CHECK(coversOnce(1000, 4));
+    CHECK(coversOnce(3, 8));
+    CHECK(parallelFor(5, 5, [](int, long long, long long){}, 1, 4) == 0);
+
+    // the chunks other than the caller's run on the same few workers, call after call
+    std::mutex lock;
+    std::set<std::thread::id> workers;
+    std::thread::id caller = std::this_thread::get_id();
+    for (int call = 0; call < 50; call++)
+        parallelFor(0, 4, [&](int, long long, long long){
+            std::lock_guard<std::mutex> guard(lock);
+            if (std::this_thread::get_id() != caller)
+                workers.insert(std::this_thread::get_id());
+        }, 1, 4);
+    CHECK(workers.size() <= 3);
+
+    // a loop inside a chunk runs inline, as a single chunk
+    std::atomic<int> inner{0};
+    parallelFor(0, 4, [&](int, long long, long long){
+        if (parallelFor(0, 100, [](int, long long, long long){}, 1, 4) == 1)
+            inner++;
+    }, 1, 4);
+    CHECK(inner == 4);
+
+    // an exception in a chunk reaches the caller once the other chunks are done, and the workers carry on
+    std::atomic<int> done{0};
+    CHECK_THROWS(parallelFor(0, 4, [&](int c, long long, long long){
+        if (c == 2)
+            throw std::runtime_error("chunk 2");
+        done++;
+    }, 1, 4), std::runtime_error);
+    CHECK(done == 3);
+    CHECK(coversOnce(1000, 4));
+
+    // several callers share the workers
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 3; t++)
+        callers.emplace_back([&]{
+            for (int i = 0; i < 20; i++)
+                if (!coversOnce(500, 4))
+                    ok = false;
+        });
+    for (auto &t: callers)
+        t.join();
+    CHECK(ok);
+
+    // a forked child has none of the workers of its parent, and starts its own
+    pid_t child = fork();
+    if (child == 0)
+        _exit(coversOnce(1000, 4) ? 0 : 1);
+    int status = -1;
+    waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    return check::report();
+}
@@ -0,0 +1,84 @@
+// Polynomial products on every path (schoolbook, Karatsuba, FFT), division, evaluation and roots.
+
+#include <algorithm>
+#include "check.h"
+
+namespace{
+
+Polynomial randomPolynomial(int degree, unsigned seed){
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(-9, 9);
+    std::vector<double> c(degree + 1);
+    for (double &x: c)
+        x = dist(gen);
+    c[degree] = 5;
+    return Polynomial(c);
+}
+
+Polynomial schoolbook(const Polynomial &p, const Polynomial &q){
+    std::vector<double> c(p.degree() + q.degree() + 1);
+    for (int i = 0; i <= p.degree(); i++)
+        for (int j = 0; j <= q.degree(); j++)
+            c[i + j] += p[i] * q[j];
+    return Polynomial(c);
+}
+
+double maxDiff(const Polynomial &p, const Polynomial &q){
+    if (p.degree() != q.degree())
+        return INFINITY;
+    double d = 0;
+    for (int i = 0; i <= p.degree(); i++)
+        d = std::max(d, std::abs(p[i] - q[i]));
+    return d;
+}
+
+}
+
+int main(){
+    for (int degree: {5, 100, 1500}){
+        Polynomial p = randomPolynomial(degree, degree), q = randomPolynomial(degree + 3, degree + 1);
+        // integer coefficients: exact below the FFT cutoff, within rounding above it
+        Polynomial pq = p * q;
+        CHECK(maxDiff(pq, schoolbook(p, q)) <= (degree < 1000 ? 0 : 1e-6));
+    }
+
+    // long division amplifies rounding on long polynomials, so it is checked on short ones
+    Polynomial a = randomPolynomial(12, 1), b = randomPolynomial(7, 2);
+    auto [quotient, remainder] = (a * b + Polynomial{1, 2}).divmod(b);
+    CHECK(maxDiff(quotient, a) < 1e-9);
+    CHECK(maxDiff(remainder, Polynomial{1, 2}) < 1e-9);
+
+    Polynomial p{1, -3, 0, 2};
+    CHECK(maxDiff(p.derivative(), Polynomial{-3, 0, 6}) == 0);
+    CHECK(p(2.0) == 11);
+    CHECK(std::abs(p(std::complex<double>(0, 1)) - std::complex<double>(1, -5)) < 1e-15);
+    std::vector<double> xs(300);
+    for (size_t i = 0; i < xs.size(); i++)
+        xs[i] = 0.01 * i - 1.5;
+    std::vector<double> ys = p(xs);
+    for (size_t i = 0; i < xs.size(); i++)
+        CHECK_NEAR(ys[i], p(xs[i]), 1e-14);
+
+    // (x - 1)(x - 2)(x + 3)
+    Polynomial cubic = Polynomial{-1, 1} * Polynomial{-2, 1} * Polynomial{3, 1};
+    std::vector<std::complex<double>> r = cubic.roots();
+    std::vector<double> real;
+    for (auto z: r){
+        CHECK(std::abs(z.imag()) < 1e-10);
+        real.push_back(z.real());
+    }
+    std::sort(real.begin(), real.end());
+    CHECK(real.size() == 3);
+    CHECK_NEAR(real[0], -3, 1e-10);
+    CHECK_NEAR(real[1], 1, 1e-10);
+    CHECK_NEAR(real[2], 2, 1e-10);
+
+    // x^2 + 1 has no real roots
+    for (auto z: Polynomial{1, 0, 1}.roots())
+        CHECK_NEAR(std::abs(z.imag()), 1, 1e-12);
+
+    CHECK(maxDiff(gcd(cubic, Polynomial{-1, 1} * Polynomial{4, 1}), Polynomial{-1, 1}) < 1e-10);
+    CHECK_THROWS(cubic / Polynomial(), std::invalid_argument);
+
+    return check::report();
+}
@@ -0,0 +1,36 @@
+// Column-pivoted QR and the rank estimates built on it, on matrices of known rank.
+
+#include "check.h"
+
+int main(){
+    // rank 4 by construction
+    Matrix U = check::random(50, 4), V = check::random(4, 30, 2), A = U * V;
+
+    RRQR f = A.pivotedQR();
+    CHECK(f.rank == 4);
+    Matrix AP(50, 30);
+    for (int j = 0; j < 30; j++)
+        AP.at(j) = A.at(f.perm[j]);
+    CHECK_NEAR(f.Q() * f.R(), AP, 1e-10);
+    // the early exit performs only the steps asked for
+    CHECK(A.pivotedQR(-1, 2).tau.size() == 2);
+
+    CHECK(A.numericalRank() == 4);
+    CHECK(A.rank() == 4);
+    CHECK(A.hasRankAtLeast(4));
+    CHECK(!A.hasRankAtLeast(5));
+    CHECK(!A.isFullRank());
+    CHECK(A.randomizedRank(10) == 4);
+    CHECK(A.randomizedRank(2) == 2);
+
+    // a perturbation above the tolerance counts, one below does not
+    Matrix B = A;
+    B.at(0, 0) += 1e-6;
+    CHECK(B.numericalRank() == 5);
+    CHECK(B.numericalRank(1e-4) == 4);
+
+    CHECK(Matrix(6, 4).numericalRank() == 0);
+    CHECK(check::random(7, 7, 3).isFullRank());
+
+    return check::report();
+}
@@ -0,0 +1,57 @@
+// Condition number estimates against the exact 1 / (||A||_1 ||A^{-1}||_1), well and badly conditioned.
+
+#include <cstring>
+#include "check.h"
+
+namespace{
+
+double exactRcond(const SquareMatrix &A){
+    return 1 / (A.norm1() * A.inverse().norm1());
+}
+
+}
+
+int main(){
+    SquareMatrix graded = check::random(40, 40, 2);
+    for (int j = 0; j < 40; j++)
+        for (int i = 0; i < 40; i++)
+            graded.at(i, j) *= std::pow(10.0, -0.25 * j);
+    for (const SquareMatrix &A: {SquareMatrix(check::random(40, 40)), graded}){
+        double exact = exactRcond(A), estimate = LU(A).rcond();
+        // the norm estimate is a lower bound, so rcond is overestimated, rarely by more than 3
+        CHECK(estimate >= exact * (1 - 1e-10) && estimate <= 10 * exact);
+        CHECK_NEAR(A.rcond(), estimate, 1e-15);
+        double mixed = MixedPrecisionLU(A).rcond();
+        CHECK(mixed >= exact * 0.5 && mixed <= 20 * exact);
+
+        double fromSolve = -1;
+        Vector x = Matrix(check::random(40, 1, 3)).at(0);
+        Vector b = A * x;
+        auto res = LS_Solver::solve(A, b, &fromSolve);
+        CHECK_NEAR(fromSolve, estimate, 1e-15);
+        CHECK_NEAR(A * res.first, b, 1e-12);
+    }
+    CHECK(exactRcond(graded) < 1e-8);
+
+    // estimateNorm1 on an explicit matrix
+    Matrix B = check::random(30, 30, 4);
+    double norm = estimateNorm1(30, [&](double *x){
+        Vector v(std::vector<double>(x, x + 30));
+        Vector y = B * v;
+        std::memcpy(x, y.data(), 30 * sizeof(double));
+    }, [&](double *x){
+        Vector v(std::vector<double>(x, x + 30));
+        Vector y = v * B;
+        std::memcpy(x, y.data(), 30 * sizeof(double));
+    });
+    CHECK(norm <= B.norm1() * (1 + 1e-12) && norm >= B.norm1() / 3);
+
+    SquareMatrix singular{{1, 2}, {2, 4}};
+    CHECK(singular.rcond() == 0);
+    double r = -1;
+    LS_Solver::solve(singular, Vector({3, 6}), &r);
+    CHECK(r == 0);
+    CHECK(SquareMatrix(5, true).rcond() == 1);
+
+    return check::report();
+}
@@ -0,0 +1,67 @@
+// Mixed-precision LU with iterative refinement, and LS_Solver::solveRefined's fallback to solve.
+
+#include <cfloat>
+#include "check.h"
+
+int main(){
+    // well conditioned: float factors refined to double accuracy
+    SquareMatrix A(check::random(60, 60));
+    for (int i = 0; i < 60; i++)
+        A.at(i, i) += 20;
+    Vector x = Matrix(check::random(60, 1, 2)).at(0);
+    Vector b = A * x;
+    RefinementInfo info;
+    double rcond = 0;
+    auto res = LS_Solver::solveRefined(A, b, &info, &rcond);
+    CHECK(!info.fellBack);
+    CHECK(info.iterations >= 1 && info.iterations <= 5);
+    CHECK(info.backwardError <= 1e-15);
+    CHECK_NEAR(res.first, x, 1e-12);
+    CHECK(res.second.empty());
+    CHECK(rcond > 1e-3 && rcond <= 1);
+
+    MixedPrecisionLU lu(A);
+    CHECK(!lu.isSingular());
+    Matrix X = lu.solve(Matrix(std::vector<Vector>{b, b * 2}), &info);
+    CHECK_NEAR(X.at(1), x * 2, 1e-12);
+    CHECK_THROWS(lu.solve(Vector(3)), std::invalid_argument);
+
+    // cond ~ 1e10: beyond float, MixedPrecisionLU falls back to its double LU
+    SquareMatrix H(8);
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 8; j++)
+            H.at(i, j) = 1.0 / (i + j + 1);
+    Vector y(8, [](int i){ return 1.0 + i; });
+    Vector hy = H * y;
+    MixedPrecisionLU hilbert(H);
+    Vector z = hilbert.solve(hy, &info);
+    CHECK(info.fellBack);
+    CHECK(info.backwardError <= 1e-14);
+    CHECK(hilbert.rcond() < 1e-6);
+
+    // exactly singular and consistent: the basis of solutions, as solve gives it
+    Matrix S({{1, 2}, {2, 4}});
+    auto singular = LS_Solver::solveRefined(S, {3, 6}, &info, &rcond);
+    CHECK(rcond == 0);
+    CHECK(singular.second.size() == 1);
+    CHECK_NEAR(S * singular.first, Vector({3, 6}), 1e-12);
+
+    // numerically singular (rank 20 of 30 up to rounding): not a refined vector with an empty basis
+    Matrix N = check::random(30, 20, 3) * check::random(20, 30, 4);
+    Vector nb = N * Vector(Matrix(check::random(30, 1, 5)).at(0));
+    auto expected = LS_Solver::solve(N, nb);
+    auto got = LS_Solver::solveRefined(N, nb, &info, &rcond);
+    CHECK(info.fellBack);
+    CHECK(rcond < FLT_EPSILON);
+    CHECK(got.second.size() == expected.second.size());
+    CHECK_NEAR(got.first, expected.first, 0);
+
+    // entries beyond the float range
+    SquareMatrix big({{1e300, 1}, {1, 1e300}});
+    auto large = LS_Solver::solveRefined(big, {1e300, 1e300}, &info);
+    CHECK(large.second.empty());
+    CHECK_NEAR(large.first, Vector({1, 1}), 1e-12);
+
+    CHECK_THROWS(LS_Solver::solveRefined(A, Vector(3)), std::invalid_argument);
+    return check::report();
+}
@@ -0,0 +1,99 @@
+// Sparse matrices and the supernodal solvers, on the 5-point Laplacian of a grid and a nonsymmetric variant of it.
+
+#include <algorithm>
+#include "check.h"
+
+namespace{
+
+// the k^2 * k^2 5-point Laplacian, plus convection * (difference to the left neighbour) to make it nonsymmetric
+SparseMatrix laplacian(int k, double convection = 0){
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+    auto add = [&](int i, int j, double v){ rows.push_back(i); cols.push_back(j); values.push_back(v); };
+    for (int x = 0; x < k; x++)
+        for (int y = 0; y < k; y++){
+            int i = x * k + y;
+            add(i, i, 4 + convection);
+            if (x > 0) add(i, i - k, -1 - convection);
+            if (x < k - 1) add(i, i + k, -1);
+            if (y > 0) add(i, i - 1, -1);
+            if (y < k - 1) add(i, i + 1, -1);
+        }
+    return SparseMatrix::fromTriplets(k * k, k * k, rows, cols, values);
+}
+
+}
+
+int main(){
+    SparseMatrix A = laplacian(20);
+    Matrix dense = A.dense();
+    CHECK(A.order() == std::make_pair(400, 400) && A.nonZeros() == 400 * 5 - 4 * 20);
+    CHECK(A.at(21, 21) == 4 && A.at(21, 1) == -1 && A.at(21, 0) == 0);
+    CHECK_NEAR(SparseMatrix(dense).dense(), dense, 0);
+    CHECK(SparseMatrix(dense).samePattern(A));
+    CHECK_NEAR(A.transposed().dense(), dense, 0);
+
+    Vector x = Matrix(check::random(400, 1)).at(0), y = Matrix(check::random(400, 1, 2)).at(0);
+    CHECK_NEAR(A * x, dense * x, 1e-13);
+    Vector z = y;
+    SparseMatrix::gemvT(2, A, x, -1, z);
+    CHECK_NEAR(z, x * dense * 2 - y, 1e-12);
+
+    // duplicates are summed, bad input rejected
+    SparseMatrix T = SparseMatrix::fromTriplets(2, 2, {0, 1, 0}, {0, 1, 0}, {1, 2, 3});
+    CHECK(T.nonZeros() == 2 && T.at(0, 0) == 4);
+    CHECK_THROWS(SparseMatrix::fromTriplets(2, 2, {2}, {0}, {1}), std::invalid_argument);
+    CHECK_THROWS(SparseMatrix(2, 2, {0, 1}, {0}, {1}), std::invalid_argument);
+
+    Vector b = A * x;
+    SparseSymbolic natural(A, SparseOrdering::Natural);
+    for (SparseOrdering ordering: {SparseOrdering::Natural, SparseOrdering::MinimumDegree, SparseOrdering::NestedDissection}){
+        std::vector<int> perm = fillReducingOrder(A, ordering);
+        std::vector<int> sorted = perm;
+        std::sort(sorted.begin(), sorted.end());
+        bool permutation = true;
+        for (int i = 0; i < 400; i++)
+            permutation = permutation && sorted[i] == i;
+        CHECK(permutation);
+        if (ordering != SparseOrdering::Natural)
+            CHECK(SparseSymbolic(A, ordering).factorNonZeros() < natural.factorNonZeros());
+
+        SparseCholesky cholesky(A, ordering);
+        CHECK(cholesky.isPositiveDefinite());
+        CHECK_NEAR(cholesky.solve(b), x, 1e-10);
+        SparseLU lu(A, ordering);
+        CHECK_NEAR(lu.solve(b), x, 1e-10);
+    }
+
+    // refactoring with the same pattern reuses the analysis
+    SparseCholesky cholesky(A);
+    SparseMatrix scaled = A;
+    for (long k = 0; k < scaled.nonZeros(); k++)
+        scaled.values()[k] *= 3;
+    cholesky.refactor(scaled);
+    CHECK_NEAR(cholesky.solve(b), x * (1.0 / 3), 1e-10);
+    Matrix cut = dense;
+    cut.at(0, 1) = cut.at(1, 0) = 0;
+    CHECK_THROWS(cholesky.refactor(SparseMatrix(cut)), std::invalid_argument);
+
+    // nonsymmetric: LU only
+    SparseMatrix N = laplacian(20, 1.5);
+    SparseLU lu(N);
+    RefinementInfo info;
+    Vector c = N * x;
+    CHECK_NEAR(lu.solve(c, &info), x, 1e-10);
+    CHECK(info.backwardError < 1e-14);
+    CHECK_NEAR(LS_Solver::solve(N, c).first, x, 1e-10);
+    Matrix X = check::random(400, 3, 3);
+    Matrix C(400, 3);
+    for (int j = 0; j < 3; j++)
+        C.at(j) = N * X.at(j);
+    CHECK_NEAR(lu.solve(C), X, 1e-10);
+
+    // an indefinite matrix has no Cholesky factor
+    SparseMatrix indefinite = A;
+    indefinite.values()[0] = -10;
+    CHECK(!SparseCholesky(indefinite).isPositiveDefinite());
+
+    return check::report();
+}
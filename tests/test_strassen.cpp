@@ -0,0 +1,35 @@
+// Strassen-Winograd products and the algorithm operator* uses.
+
+#include "check.h"
+
+int main(){
+    // operator* is the blocked product unless Strassen is opted in to
+    CHECK(multiplyAlgorithm() == MultiplyAlgorithm::Blocked);
+    setStrassenCutoff(16);
+    Matrix A = check::random(70, 53), B = check::random(53, 67, 2);
+    Matrix blocked = A.multiply(B, MultiplyAlgorithm::Blocked), fast = A.multiply(B, MultiplyAlgorithm::Strassen);
+    CHECK_NEAR(A * B, blocked, 0);
+    // odd dimensions at every level are peeled off; the normwise bound leaves some room over the blocked product
+    CHECK_NEAR(fast, blocked, 1e-11);
+
+    setMultiplyAlgorithm(MultiplyAlgorithm::Auto);
+    CHECK_NEAR(A * B, fast, 0);
+    Matrix small = check::random(20, 20, 3);
+    CHECK_NEAR(small * small, small.multiply(small, MultiplyAlgorithm::Blocked), 0);
+    setMultiplyAlgorithm(MultiplyAlgorithm::Blocked);
+
+    // through views, with a workspace reused across calls
+    std::vector<double> workspace;
+    Matrix C(70, 67);
+    strassen(A, B, C, 16, &workspace);
+    CHECK_NEAR(C, fast, 0);
+    CHECK(workspace.size() >= strassenWorkspaceSize(70, 53, 67, 16));
+    Matrix D(35, 30);
+    strassen(A.block(0, 0, 35, 53), B.block(0, 10, 53, 30), D, 16, &workspace);
+    CHECK_NEAR(D, Matrix(A.block(0, 0, 35, 53)).multiply(Matrix(B.block(0, 10, 53, 30)), MultiplyAlgorithm::Blocked), 1e-11);
+
+    Matrix S = check::random(64, 64, 4);
+    CHECK_THROWS(strassen(S, S, S, 16), std::invalid_argument);
+    setStrassenCutoff(0);
+    return check::report();
+}
@@ -0,0 +1,85 @@
+// Diagonal, triangular, banded and symmetric matrices against their dense equivalents: products, solves, determinants
+// and inverses.
+
+#include "check.h"
+
+int main(){
+    const int n = 9;
+    Vector x = Matrix(check::random(n, 1)).at(0);
+    Matrix B = check::random(n, 3, 2);
+    Matrix G = check::random(n, n, 3);
+
+    DiagonalMatrix D(Vector({1, -2, 3, 0.5, 4, -1, 2, 6, 0.25}));
+    SquareMatrix Dd = D;
+    CHECK(D.at(1, 1) == -2 && D.at(1, 2) == 0);
+    CHECK_NEAR(D * x, Dd * x, 0);
+    CHECK_NEAR(D * B, Dd * B, 0);
+    CHECK_NEAR(G * D, G * Dd, 1e-14);
+    CHECK_NEAR(Dd * D.solve(x), x, 1e-14);
+    CHECK_NEAR(D.det(), Dd.det(), 1e-12);
+    CHECK_NEAR(SquareMatrix(D.inverse()), Dd.inverse(), 1e-14);
+    CHECK_THROWS(DiagonalMatrix(3).solve(Vector(3)), std::domain_error);
+
+    for (bool upper: {true, false}){
+        // a well conditioned triangle: the diagonal dominates
+        SquareMatrix A = G;
+        for (int i = 0; i < n; i++)
+            A.at(i, i) += upper ? 5 : -5;
+        const TriangularMatrix T(A, upper);
+        SquareMatrix Td = T;
+        CHECK(T.at(upper ? 0 : n - 1, upper ? n - 1 : 0) == A.at(upper ? 0 : n - 1, upper ? n - 1 : 0));
+        CHECK(T.at(upper ? n - 1 : 0, upper ? 0 : n - 1) == 0);
+        CHECK_NEAR(T * x, Td * x, 1e-13);
+        CHECK_NEAR(T * B, Td * B, 1e-13);
+        CHECK_NEAR(Td * T.solve(x), x, 1e-12);
+        CHECK_NEAR(Td * T.solve(B), B, 1e-12);
+        CHECK_NEAR(T.det(), Td.det(), 1e-9 * std::abs(T.det()));
+        CHECK_NEAR(SquareMatrix(T.inverse()), Td.inverse(), 1e-12);
+        CHECK_NEAR(SquareMatrix(T.transpose()), SquareMatrix(Td.view().transposed()), 0);
+    }
+
+    // bandwidths 2 below and 1 above; pivoting must be able to fill in up to kl + ku above the diagonal
+    SquareMatrix A = G;
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            if (i - j > 2 || j - i > 1)
+                A.at(i, j) = 0;
+    BandedMatrix W(A, 2, 1);
+    SquareMatrix Wd = W;
+    CHECK_NEAR(Wd, A, 0);
+    CHECK(W.lowerBandwidth() == 2 && W.upperBandwidth() == 1);
+    CHECK_NEAR(W * x, A * x, 1e-13);
+    CHECK_NEAR(W * B, A * B, 1e-13);
+    CHECK_NEAR(A * W.solve(x), x, 1e-10);
+    CHECK_NEAR(A * W.solve(B), B, 1e-10);
+    CHECK_NEAR(W.det(), A.det(), 1e-10 * std::abs(A.det()));
+    CHECK_NEAR(W.inverse(), A.inverse(), 1e-9);
+    CHECK_THROWS(W.at(5, 0) = 1, std::out_of_range);
+
+    // G G^T + I is positive definite; G + G^T is not
+    SquareMatrix P = G * Matrix(G.view().transposed());
+    for (int i = 0; i < n; i++)
+        P.at(i, i) += 1;
+    SymmetricMatrix Sp(P);
+    CHECK(Sp.isPositiveDefinite());
+    TriangularMatrix L = Sp.cholesky();
+    CHECK(!L.isUpper());
+    CHECK_NEAR(SquareMatrix(L) * Matrix(SquareMatrix(L).view().transposed()), P, 1e-11);
+    CHECK_NEAR(Sp * x, P * x, 1e-12);
+    CHECK_NEAR(P * Sp.solve(x), x, 1e-10);
+    CHECK_NEAR(Sp.det(), P.det(), 1e-9 * std::abs(P.det()));
+    CHECK_NEAR(SquareMatrix(Sp.inverse()), P.inverse(), 1e-10);
+
+    SquareMatrix I = G;
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            I.at(i, j) = G.at(i, j) + G.at(j, i);
+    SymmetricMatrix Si(I);
+    CHECK(!Si.isPositiveDefinite());
+    CHECK_THROWS(Si.cholesky(), std::domain_error);
+    CHECK_NEAR(I * Si.solve(x), x, 1e-9);
+    Si.at(0, 3) = 7;
+    CHECK(Si.at(3, 0) == 7);
+
+    return check::report();
+}
@@ -0,0 +1,66 @@
+// Null space, column space and row space bases, by pivoted QR and by the reduced row echelon form.
+
+#include "check.h"
+
+namespace{
+
+// largest |(Q^T Q - I)_ij|
+double orthogonality(const Matrix &Q){
+    Matrix G = Q.view().transposed() * Q;
+    for (int i = 0; i < G.order().first; i++)
+        G.at(i, i) -= 1;
+    return G.normInf();
+}
+
+// residual of projecting the columns of X onto the span of the orthonormal columns of Q
+double outsideSpan(const Matrix &Q, const Matrix &X){
+    Matrix residual = X;
+    Matrix::gemm(-1, Q, Q.view().transposed() * X, 1, residual);
+    return residual.normInf();
+}
+
+}
+
+int main(){
+    // 40*60 of rank 25
+    Matrix A = check::random(40, 25) * check::random(25, 60, 2);
+    CHECK(A.numericalRank() == 25);
+    for (SubspaceMethod method: {SubspaceMethod::QR, SubspaceMethod::RREF}){
+        Matrix N = A.nullspace(method), C = A.colspace(method), R = A.rowspace(method);
+        CHECK(N.order() == std::make_pair(60, 35));
+        CHECK(C.order() == std::make_pair(40, 25));
+        CHECK(R.order() == std::make_pair(60, 25));
+        CHECK((A * N).normInf() <= 1e-9 * A.normInf() * N.normInf());
+        // the column space and row space hold every column and row of A
+        Matrix Qc = C.QR().first, Qr = R.QR().first;
+        CHECK(outsideSpan(Qc, A) <= 1e-9 * A.normInf());
+        CHECK(outsideSpan(Qr, Matrix(A.view().transposed())) <= 1e-9 * A.normInf());
+        if (method == SubspaceMethod::QR){
+            CHECK(orthogonality(N) <= 1e-12);
+            CHECK(orthogonality(C) <= 1e-12);
+            CHECK(orthogonality(R) <= 1e-12);
+        }
+    }
+
+    // small integers: the RREF bases are exact, with the free variables set to 0 and 1
+    Matrix B({{1, 2, 3, 4}, {2, 4, 6, 8}, {1, 0, 1, 0}});
+    Matrix N = B.nullspace(SubspaceMethod::RREF);
+    CHECK_NEAR(N, Matrix({{-1, -1, 1, 0}, {0, -2, 0, 1}}, true), 0);
+    CHECK_NEAR(B.colspace(SubspaceMethod::RREF), Matrix({{1, 2, 1}, {2, 4, 0}}, true), 0);
+    CHECK_NEAR(B.rowspace(SubspaceMethod::RREF), Matrix({{1, 0, 1, 0}, {0, 1, 1, 2}}, true), 0);
+
+    // full rank and zero matrices: an empty basis has no columns, and so reports order() (0, 0)
+    Matrix F({{1, 0}, {0, 1}, {1, 1}});
+    for (SubspaceMethod method: {SubspaceMethod::QR, SubspaceMethod::RREF}){
+        CHECK(F.nullspace(method).order() == std::make_pair(0, 0));
+        CHECK(F.colspace(method).order() == std::make_pair(3, 2));
+        CHECK(F.rowspace(method).order() == std::make_pair(2, 2));
+        CHECK(check::random(5, 5).nullspace(method).order() == std::make_pair(0, 0));
+        Matrix Z(4, 3);
+        CHECK(Z.nullspace(method).order() == std::make_pair(3, 3));
+        CHECK(Z.colspace(method).order() == std::make_pair(0, 0));
+        CHECK(Z.rowspace(method).order() == std::make_pair(0, 0));
+    }
+    CHECK_THROWS(F * F.nullspace(), std::invalid_argument);
+    return check::report();
+}
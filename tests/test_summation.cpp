@@ -0,0 +1,71 @@
+// Summation modes of Vector::dot and Vector::norm: accuracy, reproducibility and no allocation on short vectors.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "check.h"
+
+namespace{
+std::atomic<long> allocations{0};
+}
+
+void *operator new(std::size_t size){
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept{ std::free(p); }
+void operator delete(void *p, std::size_t) noexcept{ std::free(p); }
+
+int main(){
+    // x.y = 1 exactly, but the terms cancel down from 1e16: Fast loses it, the others do not
+    Vector x({1e16, 1, -1e16, 1e-3}), y({1, 1, 1, 0});
+    CHECK(x.dot(y, Summation::Compensated) == 1);
+    CHECK(x.dot(y, Summation::Reproducible) == 1);
+
+    // a long sum whose exact value is known: (1 + 2^-40) repeated, then cancelled
+    int n = 3 << 20;
+    std::vector<double> v(n);
+    for (int i = 0; i < n; i++)
+        v[i] = (i % 2 ? -1.0 : 1.0) * (1 + i * 0x1p-40);
+    double exact = -(n / 2) * 0x1p-40;
+    CHECK(reduceSum(n, v.data(), 1, Summation::Compensated) == exact);
+    CHECK(std::abs(reduceSum(n, v.data(), 1, Summation::Reproducible) - exact) <= 1e-12 * std::abs(exact));
+
+    // Reproducible does not depend on the order of the terms nor on the thread count
+    double ordered = reduceSum(n, v.data(), 1, Summation::Reproducible);
+    std::vector<double> shuffled = v;
+    std::reverse(shuffled.begin(), shuffled.end());
+    std::rotate(shuffled.begin(), shuffled.begin() + 12345, shuffled.end());
+    CHECK(reduceSum(n, shuffled.data(), 1, Summation::Reproducible) == ordered);
+    int threads = threadCount();
+    setThreadCount(3);
+    CHECK(reduceSum(n, v.data(), 1, Summation::Reproducible) == ordered);
+    setThreadCount(threads);
+
+    // strided terms, as in a row of a matrix
+    CHECK(reduceDot(2, x.data(), 2, y.data(), 2, Summation::Compensated) == 0);
+
+    // the modes agree with the plain definition on well-conditioned data
+    Vector a = Matrix(check::random(1000, 1)).at(0), b = Matrix(check::random(1000, 1, 2)).at(0);
+    double plain = 0;
+    for (int i = 0; i < 1000; i++)
+        plain += a[i] * b[i];
+    for (Summation mode: {Summation::Fast, Summation::Compensated, Summation::Reproducible}){
+        CHECK(std::abs(a.dot(b, mode) - plain) <= 1e-12);
+        CHECK(std::abs(a.norm(2, mode) - std::sqrt(a.dot(a, Summation::Compensated))) <= 1e-12);
+    }
+
+    // short reductions do not touch the heap
+    long before = allocations;
+    double s = 0;
+    for (Summation mode: {Summation::Fast, Summation::Compensated, Summation::Reproducible})
+        s += a.dot(b, mode) + a.norm(2, mode);
+    CHECK(allocations == before);
+    CHECK(std::isfinite(s));
+
+    CHECK(std::isnan(Vector({1, NAN}).dot(Vector({1, 1}), Summation::Reproducible)));
+    return check::report();
+}
@@ -0,0 +1,61 @@
+// Tasks on the executor: results, exceptions, continuations, whenAll, cooperative cancellation and progress, and the
+// asynchronous variants of the decompositions against their synchronous results.
+
+#include <atomic>
+#include "check.h"
+
+int main(){
+    Task<int> answer = runAsync([]{ return 6 * 7; });
+    CHECK(answer.get() == 42);
+    CHECK(answer.isReady() && answer.progress() == 1);
+
+    Task<int> failing = runAsync([]() -> int{ throw std::domain_error("no"); });
+    CHECK_THROWS(failing.get(), std::domain_error);
+    // a continuation of a failed task fails the same way without running
+    std::atomic<bool> ran{false};
+    CHECK_THROWS(failing.then([&](int x){ ran = true; return x; }).get(), std::domain_error);
+    CHECK(!ran);
+
+    Task<double> half = answer.then([](int x){ return x / 2.0; });
+    auto [a, b] = whenAll(answer, half).get();
+    CHECK(a == 42 && b == 21);
+    CHECK(Task<int>::completed(5).get() == 5);
+
+    // cancellation is seen at the next checkpoint, and progress is reported until then
+    std::atomic<bool> started{false};
+    std::atomic<double> seen{0};
+    Task<int> endless = runAsync([&](TaskContext &context){
+        started = true;
+        for (long i = 0;; i++)
+            context.checkpoint(1 - 1.0 / (i + 2));
+        return 0;
+    });
+    endless.onProgress([&](double f){ seen = f; });
+    while (!started || seen == 0)
+        ;
+    endless.cancel();
+    CHECK_THROWS(endless.get(), TaskCancelled);
+    CHECK(endless.cancelled() && endless.progress() > 0 && endless.progress() < 1);
+
+    // a task cancelled before its worker is free never starts
+    Executor one(1);
+    std::atomic<bool> release{false}, queuedRan{false};
+    Task<int> blocker = runAsync([&]{ while (!release); return 1; }, one);
+    Task<int> queued = runAsync([&]{ queuedRan = true; return 2; }, one);
+    queued.cancel();
+    release = true;
+    CHECK(blocker.get() == 1);
+    CHECK_THROWS(queued.get(), TaskCancelled);
+    CHECK(!queuedRan);
+
+    SquareMatrix A = check::random(60, 60);
+    CHECK_NEAR(A.inverseAsync().get(), A.inverse(), 1e-10);
+    Vector x = Matrix(check::random(60, 1, 2)).at(0);
+    Vector y = LS_Solver::solveAsync(A.luAsync(), Task<Vector>::completed(A * x)).get();
+    CHECK_NEAR(y, x, 1e-9);
+    Matrix T = check::random(80, 6, 3);
+    auto [Q, R] = T.QRAsync().get();
+    CHECK_NEAR(Q, T.QR().first, 1e-12);
+
+    return check::report();
+}
@@ -0,0 +1,48 @@
+// TSQR and block Gram-Schmidt: orthonormal Q, QR = A with a positive diagonal, and rank deficiency reported.
+
+#include "check.h"
+#include "tsqr.h"
+
+namespace{
+
+void checkFactors(const Matrix &A, const Matrix &Q, const TriangularMatrix &R){
+    int n = A.order().second;
+    Matrix QtQ(n, n), QR(A.order().first, n), identity(n, n);
+    for (int i = 0; i < n; i++)
+        identity.at(i).data()[i] = 1;
+    gemm(1, Q.view().transposed(), Q, 0, QtQ);
+    Matrix::gemm(1, Q, R, 0, QR);
+    CHECK_NEAR(QtQ, identity, 1e-12);
+    CHECK_NEAR(QR, A, 1e-11);
+    for (int i = 0; i < n; i++)
+        CHECK(R.at(i, i) > 0);
+}
+
+}
+
+int main(){
+    // one leaf, several leaves of an odd count (an unpaired node moves up the tree), one row block per thread
+    for (auto [m, n, threads]: {std::tuple{40, 7, 1}, {20000, 5, 3}, {9000, 12, 0}}){
+        Matrix A = check::random(m, n, m), Q;
+        TriangularMatrix R;
+        CHECK(tsqr(A, Q, R, threads));
+        checkFactors(A, Q, R);
+        CHECK(blockGramSchmidt(A, Q, R, 4, threads));
+        checkFactors(A, Q, R);
+    }
+
+    Matrix A = check::random(5000, 6, 7);
+    auto [Q, R] = A.QR(QRMethod::TSQR);
+    checkFactors(A, Q, R);
+
+    // a column equal to another: both report it, and GramSchmidt(TSQR) falls back to the plain basis
+    Matrix D = check::random(8000, 4, 8), Q2;
+    for (int i = 0; i < 8000; i++)
+        D.at(3).data()[i] = D.at(1).data()[i];
+    TriangularMatrix R2;
+    CHECK(!tsqr(D, Q2, R2));
+    CHECK(!blockGramSchmidt(D, Q2, R2, 2));
+    CHECK(D.GramSchmidt(false, QRMethod::TSQR).order() == D.GramSchmidt().order());
+
+    return check::report();
+}
@@ -0,0 +1,64 @@
+// The tuning cache: loaded on first use from LINALG_TUNING_FILE, saved without losing the sections of other CPUs, and
+// results that do not depend on the parameters beyond rounding.
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "check.h"
+
+int main(){
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("linalg-tuning-" + std::to_string(std::random_device()()));
+    fs::path file = dir / "tuning";
+    fs::create_directories(dir);
+    {
+        std::ofstream out(file);
+        out << "[some other cpu]\nthreads 64\n\n[" << cpuModel() << "]\nthreads 3\ngemm_row_block 48\nlu_block 8\n";
+    }
+    // read on the first use of a parameter
+    setenv("LINALG_TUNING_FILE", file.c_str(), 1);
+    CHECK(tuningCachePath() == file.string());
+    TuningParameters loaded = tuning();
+    CHECK(loaded.threads == 3 && loaded.gemmRowBlock == 48 && loaded.luBlock == 8 && loaded.strassenCutoff == 0);
+    CHECK(threadCount() == 3);
+
+    SquareMatrix A = check::random(150, 150);
+    Matrix product = A * A;
+    SquareMatrix inverse = A.inverse();
+
+    TuningParameters saved;
+    saved.qrBlock = 16;
+    saved.inverseLUMin = 2;
+    saveTuning(saved, file.string());
+    std::ifstream in(file);
+    std::stringstream text;
+    text << in.rdbuf();
+    CHECK(text.str().find("[some other cpu]") != std::string::npos);
+    CHECK(text.str().find("threads 64") != std::string::npos);
+    CHECK(loadTuning(file.string()));
+    CHECK(tuning().qrBlock == 16 && tuning().inverseLUMin == 2 && tuning().threads == 0);
+
+    // other parameters change the blocking, not the results
+    CHECK_NEAR(A * A, product, 1e-12);
+    CHECK_NEAR(A.inverse(), inverse, 1e-10);
+    setTuning(TuningParameters{});
+    CHECK(tuning().gemmRowBlock == 0);
+    CHECK_NEAR(A * A, product, 1e-12);
+
+    // concurrent writers each write their own temporary file, and leave none behind
+    std::vector<std::thread> writers;
+    for (int k = 0; k < 4; k++)
+        writers.emplace_back([&]{ saveTuning(saved, file.string()); });
+    for (auto &w: writers)
+        w.join();
+    CHECK(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 1);
+    CHECK(loadTuning(file.string()) && tuning().qrBlock == 16);
+
+    CHECK(!loadTuning((dir / "missing").string()));
+    fs::remove_all(dir);
+
+    return check::report();
+}
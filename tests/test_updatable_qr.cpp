@@ -0,0 +1,73 @@
+// UpdatableQR: after every update QR equals the updated matrix and Q stays orthonormal.
+
+#include <vector>
+#include "check.h"
+#include "updatableQR.h"
+
+namespace{
+
+Matrix fromColumns(const std::vector<Vector> &columns){
+    Matrix A(columns[0].size(), columns.size());
+    for (size_t j = 0; j < columns.size(); j++)
+        A.at(j) = columns[j];
+    return A;
+}
+
+void checkFactorization(const UpdatableQR &qr, const std::vector<Vector> &columns){
+    Matrix Q = qr.Q(), R = qr.R(), QR = Q * R, QtQ = Q.transpose() * Q;
+    Matrix identity(R.order().first, R.order().first);
+    for (int i = 0; i < R.order().first; i++)
+        identity.at(i).data()[i] = 1;
+    CHECK_NEAR(QR, fromColumns(columns), 1e-11);
+    CHECK_NEAR(QtQ, identity, 1e-12);
+}
+
+}
+
+int main(){
+    Matrix A = check::random(40, 6);
+    std::vector<Vector> columns;
+    for (int j = 0; j < 6; j++)
+        columns.push_back(A.at(j));
+    UpdatableQR qr(A);
+    CHECK(qr.order() == std::make_pair(40, 6));
+    checkFactorization(qr, columns);
+
+    Vector extra = Matrix(check::random(40, 1, 2)).at(0);
+    CHECK(qr.appendColumn(extra));
+    columns.push_back(extra);
+    checkFactorization(qr, columns);
+    // a combination of the columns is not appended
+    CHECK(!qr.appendColumn(columns[0] + columns[3]));
+    CHECK(qr.order().second == 7);
+
+    qr.removeColumn(2);
+    columns.erase(columns.begin() + 2);
+    checkFactorization(qr, columns);
+
+    Vector u = Matrix(check::random(40, 1, 3)).at(0), v = Matrix(check::random(6, 1, 4)).at(0);
+    std::vector<Vector> updated = columns;
+    for (int j = 0; j < 6; j++)
+        updated[j] = columns[j] + u * v[j];
+    qr.rank1Update(u, v);
+    checkFactorization(qr, updated);
+    qr.rank1Downdate(u, v);
+    checkFactorization(qr, columns);
+
+    // least squares: the residual is orthogonal to the columns
+    Vector b = Matrix(check::random(40, 1, 5)).at(0);
+    Vector x = qr.solve(b);
+    Vector residual = fromColumns(columns) * x - b;
+    for (const Vector &c: columns)
+        CHECK(std::abs(c.dot(residual)) < 1e-10);
+
+    // dependent columns are rejected, or skipped and reported
+    Matrix D = fromColumns({columns[0], columns[1], columns[0] + columns[1], columns[2]});
+    CHECK_THROWS(UpdatableQR(D), std::domain_error);
+    std::vector<int> dropped;
+    UpdatableQR partial(D, &dropped);
+    CHECK(dropped == std::vector<int>{2});
+    checkFactorization(partial, {columns[0], columns[1], columns[2]});
+
+    return check::report();
+}
@@ -0,0 +1,60 @@
+// Blocks, strided slices, transposes, rows, columns and diagonals of a Matrix: indexing, writes through to the parent,
+// arithmetic on views and products of views against copies.
+
+#include "check.h"
+
+int main(){
+    // A(i, j) = 10*i + j
+    Matrix A(6, 5, [](int i, int j){ return 10.0 * i + j; });
+
+    ConstMatrixView B = static_cast<const Matrix &>(A).block(1, 2, 3, 2);
+    CHECK(B.order() == std::make_pair(3, 2));
+    CHECK(B.at(0, 0) == 12 && B.at(2, 1) == 33);
+    CHECK_THROWS(B.at(3, 0), std::out_of_range);
+    CHECK_THROWS(A.view().block(4, 0, 3, 1), std::out_of_range);
+
+    ConstMatrixView S = A.view().strided(0, 1, 3, 2, 2, 3);
+    CHECK(S.at(0, 0) == 1 && S.at(2, 1) == 44);
+    ConstMatrixView T = B.transposed();
+    CHECK(T.order() == std::make_pair(2, 3) && T.at(1, 2) == 33);
+    CHECK(T.transposed().at(2, 1) == 33);
+
+    ConstVectorView r = A.view().row(4), c = A.view().col(3), d = A.view().diagonal(1), e = A.view().diagonal(-2);
+    CHECK(r.size() == 5 && r[2] == 42 && !r.contiguous());
+    CHECK(c.size() == 6 && c[5] == 53 && c.contiguous() && c.data() == A.at(3).data());
+    CHECK(d.size() == 4 && d[0] == 1 && d[3] == 34);
+    CHECK(e.size() == 4 && e[0] == 20 && e[3] == 53);
+    CHECK(r.slice(1, 2, 2)[1] == 43);
+    CHECK(r.dot(c.slice(0, 5)) == 40 * 3 + 41 * 13 + 42 * 23 + 43 * 33 + 44 * 43);
+
+    // writes go to the parent
+    Matrix M = A;
+    M.block(0, 0, 2, 2) = 0.0;
+    CHECK(M.at(0, 0) == 0 && M.at(1, 1) == 0 && M.at(2, 2) == 22);
+    M.row(5) += A.view().row(0);
+    CHECK(M.at(5, 4) == 54 + 4);
+    M.diagonal() *= 2;
+    CHECK(M.at(3, 3) == 66);
+    M.col(4).axpy(-1, A.view().col(4));
+    CHECK(M.at(2, 4) == 0);
+    // a transposed block assigned onto another block
+    M.block(0, 0, 2, 3) = A.view().block(0, 0, 3, 2).transposed();
+    CHECK(M.at(1, 2) == 21);
+
+    // products of views match products of their copies
+    Matrix X = check::random(7, 9), Y = check::random(9, 5, 2);
+    ConstMatrixView Xt = X.view().transposed(), Yb = Y.view().block(2, 1, 7, 4);
+    CHECK_NEAR(Xt.block(0, 0, 9, 7) * Yb, Matrix(Xt) * Matrix(Yb), 1e-12);
+    Matrix C(4, 4);
+    gemm(1, X.view().strided(0, 0, 4, 9, 2, 1), Y.view().block(0, 0, 9, 4), 0, C.view());
+    CHECK_NEAR(C, Matrix(X.view().strided(0, 0, 4, 9, 2, 1)) * Matrix(Y.view().block(0, 0, 9, 4)), 1e-12);
+
+    // a view of a Vector
+    Vector v({1, 2, 3, 4});
+    VectorView w(v);
+    w.slice(0, 2, 2) = 0.0;
+    CHECK(v[0] == 0 && v[1] == 2 && v[2] == 0);
+    CHECK_THROWS(w[4], std::out_of_range);
+
+    return check::report();
+}
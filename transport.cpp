@@ -0,0 +1,370 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "transport.h"
+
+// tag of the barrier; the other collectives take theirs from the caller
+#define TAG_BARRIER -1
+
+namespace{
+
+// incoming messages of one rank, queued by (sender, tag)
+class Mailbox{
+    std::mutex lock;
+    std::condition_variable arrived;
+    std::map<std::pair<int,int>, std::deque<std::vector<double>>> queues;
+    std::vector<bool> closed;
+public:
+    Mailbox(int size): closed(size){}
+
+    void put(int from, int tag, std::vector<double> data){
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queues[{from, tag}].push_back(std::move(data));
+        }
+        arrived.notify_all();
+    }
+
+    void close(int from){
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed[from] = true;
+        }
+        arrived.notify_all();
+    }
+
+    std::vector<double> take(int from, int tag){
+        std::unique_lock<std::mutex> guard(lock);
+        auto &q = queues[{from, tag}];
+        arrived.wait(guard, [&]{ return !q.empty() || closed[from]; });
+        if (q.empty()){
+            std::cerr << "Transport::receive: connection to rank " << from << " lost" << std::endl;
+            throw std::runtime_error("Transport::receive: connection lost");
+        }
+        std::vector<double> data = std::move(q.front());
+        q.pop_front();
+        return data;
+    }
+};
+
+void checkRank(int r, int size, const char *where){
+    if (r < 0 || r >= size){
+        std::cerr << where << ": rank out of range" << std::endl;
+        throw std::out_of_range(std::string(where) + ": rank out of range");
+    }
+}
+
+}
+
+// ===================== collectives ============================= //
+
+void Transport::broadcast(std::vector<double> &data, int root, const std::vector<int> &group, int tag){
+    if (rank() == root){
+        for (int r: group)
+            if (r != root)
+                send(r, tag, data);
+    }
+    else
+        data = receive(root, tag);
+}
+
+void Transport::sum(std::vector<double> &data, int root, const std::vector<int> &group, int tag){
+    if (rank() == root){
+        for (int r: group)
+            if (r != root){
+                std::vector<double> part = receive(r, tag);
+                for (size_t i = 0; i < data.size() && i < part.size(); i++)
+                    data[i] += part[i];
+            }
+    }
+    else
+        send(root, tag, data);
+}
+
+void Transport::allSum(std::vector<double> &data, const std::vector<int> &group, int tag){
+    sum(data, group.front(), group, tag);
+    broadcast(data, group.front(), group, tag);
+}
+
+void Transport::barrier(){
+    std::vector<int> all(size());
+    for (int r = 0; r < size(); r++)
+        all[r] = r;
+    std::vector<double> token(1);
+    allSum(token, all, TAG_BARRIER);
+}
+
+// ===================== threads ============================= //
+
+struct ThreadTransport::Hub{
+    std::vector<std::unique_ptr<Mailbox>> boxes;
+};
+
+ThreadTransport::ThreadTransport(std::shared_ptr<Hub> hub, int rank): hub{std::move(hub)}, me{rank}{}
+
+int ThreadTransport::size() const{
+    return hub->boxes.size();
+}
+
+void ThreadTransport::send(int to, int tag, const double *data, size_t count){
+    checkRank(to, size(), "ThreadTransport::send");
+    hub->boxes[to]->put(me, tag, std::vector<double>(data, data + count));
+}
+
+std::vector<double> ThreadTransport::receive(int from, int tag){
+    checkRank(from, size(), "ThreadTransport::receive");
+    return hub->boxes[me]->take(from, tag);
+}
+
+void ThreadTransport::run(int size, const std::function<void(Transport &)> &body){
+    auto hub = std::make_shared<Hub>();
+    for (int r = 0; r < size; r++)
+        hub->boxes.push_back(std::make_unique<Mailbox>(size));
+    std::exception_ptr error;
+    std::mutex lock;
+    std::vector<std::thread> ranks;
+    for (int r = 0; r < size; r++)
+        ranks.emplace_back([&, r]{
+            ThreadTransport t(hub, r);
+            try{
+                body(t);
+            }
+            catch (...){
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error)
+                    error = std::current_exception();
+                // unblock the ranks waiting for this one
+                for (auto &box: hub->boxes)
+                    box->close(r);
+            }
+        });
+    for (auto &t: ranks)
+        t.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// ===================== Unix sockets ============================= //
+
+namespace{
+
+// message header on the wire: the tag and the number of doubles that follow. The padding is an explicit field, so that
+// every byte sent is initialized.
+struct Header{
+    int32_t tag;
+    int32_t reserved;
+    uint64_t count;
+};
+
+bool writeAll(int fd, const void *buf, size_t len){
+    const char *p = (const char *)buf;
+    while (len > 0){
+        ssize_t w = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        p += w;
+        len -= w;
+    }
+    return true;
+}
+
+bool readAll(int fd, void *buf, size_t len){
+    char *p = (char *)buf;
+    while (len > 0){
+        ssize_t r = ::recv(fd, p, len, 0);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+sockaddr_un socketAddress(const std::string &directory, int rank){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::string path = directory + "/rank" + std::to_string(rank) + ".sock";
+    if (path.size() >= sizeof(addr.sun_path)){
+        std::cerr << "SocketTransport: socket path too long" << std::endl;
+        throw std::invalid_argument("SocketTransport: socket path too long");
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    return addr;
+}
+
+[[noreturn]] void socketError(const std::string &what){
+    std::cerr << "SocketTransport: " << what << ": " << std::strerror(errno) << std::endl;
+    throw std::runtime_error("SocketTransport: " + what);
+}
+
+}
+
+struct SocketTransport::Impl{
+    int me, n;
+    std::string path;
+    int listener = -1;
+    std::vector<int> peers;
+    std::vector<std::unique_ptr<std::mutex>> writeLocks;
+    std::vector<std::thread> readers;
+    Mailbox box;
+
+    Impl(int me, int n): me{me}, n{n}, peers(n, -1), box(n){
+        for (int r = 0; r < n; r++)
+            writeLocks.push_back(std::make_unique<std::mutex>());
+    }
+
+    // one reader per peer drains its connection into the mailbox, so a send never waits for the peer to call receive
+    void read(int from){
+        int fd = peers[from];
+        Header h;
+        while (readAll(fd, &h, sizeof h)){
+            std::vector<double> data(h.count);
+            if (!readAll(fd, data.data(), h.count * sizeof(double)))
+                break;
+            box.put(from, h.tag, std::move(data));
+        }
+        box.close(from);
+    }
+};
+
+SocketTransport::SocketTransport(const std::string &directory, int rank, int size, double timeout): impl{new Impl(rank, size)}{
+    checkRank(rank, size, "SocketTransport");
+    sockaddr_un self = socketAddress(directory, rank);
+    impl->path = self.sun_path;
+    impl->listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (impl->listener < 0)
+        socketError("socket");
+    ::unlink(self.sun_path);
+    if (::bind(impl->listener, (sockaddr *)&self, sizeof self) < 0)
+        socketError("bind");
+    if (::listen(impl->listener, size) < 0)
+        socketError("listen");
+    // connect to the lower ranks, announcing our rank; then accept the higher ranks
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    for (int r = 0; r < rank; r++){
+        sockaddr_un addr = socketAddress(directory, r);
+        for (;;){
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
+                socketError("socket");
+            if (::connect(fd, (sockaddr *)&addr, sizeof addr) == 0){
+                int32_t id = rank;
+                if (!writeAll(fd, &id, sizeof id))
+                    socketError("handshake");
+                impl->peers[r] = fd;
+                break;
+            }
+            ::close(fd);
+            if (std::chrono::steady_clock::now() > deadline)
+                socketError("cannot connect to rank " + std::to_string(r));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    for (int k = rank + 1; k < size; k++){
+        int fd = ::accept(impl->listener, nullptr, nullptr);
+        int32_t id;
+        if (fd < 0 || !readAll(fd, &id, sizeof id) || id <= rank || id >= size)
+            socketError("accept");
+        impl->peers[id] = fd;
+    }
+    for (int r = 0; r < size; r++)
+        if (r != rank)
+            impl->readers.emplace_back([this, r]{ impl->read(r); });
+}
+
+SocketTransport::~SocketTransport(){
+    for (int fd: impl->peers)
+        if (fd >= 0)
+            ::shutdown(fd, SHUT_RDWR);
+    for (auto &t: impl->readers)
+        t.join();
+    for (int fd: impl->peers)
+        if (fd >= 0)
+            ::close(fd);
+    ::close(impl->listener);
+    ::unlink(impl->path.c_str());
+}
+
+int SocketTransport::rank() const{
+    return impl->me;
+}
+
+int SocketTransport::size() const{
+    return impl->n;
+}
+
+void SocketTransport::send(int to, int tag, const double *data, size_t count){
+    checkRank(to, impl->n, "SocketTransport::send");
+    if (to == impl->me){
+        impl->box.put(to, tag, std::vector<double>(data, data + count));
+        return;
+    }
+    Header h{tag, 0, count};
+    std::lock_guard<std::mutex> guard(*impl->writeLocks[to]);
+    if (!writeAll(impl->peers[to], &h, sizeof h) || !writeAll(impl->peers[to], data, count * sizeof(double)))
+        socketError("send to rank " + std::to_string(to));
+}
+
+std::vector<double> SocketTransport::receive(int from, int tag){
+    checkRank(from, impl->n, "SocketTransport::receive");
+    return impl->box.take(from, tag);
+}
+
+int SocketTransport::run(int size, const std::function<void(Transport &)> &body){
+    char dir[] = "/tmp/linalg-XXXXXX";
+    if (!::mkdtemp(dir))
+        socketError("mkdtemp");
+    // buffered output would otherwise be written again by every child
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::vector<pid_t> children;
+    for (int r = 0; r < size; r++){
+        pid_t pid = ::fork();
+        if (pid < 0)
+            socketError("fork");
+        if (pid == 0){
+            int status = 0;
+            try{
+                SocketTransport t(dir, r, size);
+                body(t);
+                // the others may still be reading from us: leave together
+                t.barrier();
+            }
+            catch (const std::exception &e){
+                std::cerr << "rank " << r << ": " << e.what() << std::endl;
+                status = 1;
+            }
+            std::cout.flush();
+            std::fflush(nullptr);
+            ::_exit(status);
+        }
+        children.push_back(pid);
+    }
+    int failed = 0;
+    for (pid_t pid: children){
+        int status;
+        if (::waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failed++;
+    }
+    ::rmdir(dir);
+    return failed;
+}
@@ -0,0 +1,120 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#pragma once
+
+// Message passing between the ranks 0 .. size-1 of a distributed computation (see distributed.h).
+// Messages are vectors of doubles, matched by sender and tag; messages with the same sender and tag arrive in the order sent.
+// Sends never wait for the matching receive, so two ranks can exchange data by both sending first.
+// Negative tags are reserved for the library.
+
+/**
+ * @brief The pluggable transport: point-to-point messages plus the few collectives the distributed kernels need,
+ * built on top of them. A backend implements rank, size, send and receive.
+ *
+ */
+class Transport{
+public:
+    virtual ~Transport(){}
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    /**
+     * @brief Sends count doubles to the given rank. Returns once the data is copied out; never waits for the receiver.
+     */
+    virtual void send(int to, int tag, const double *data, size_t count) = 0;
+
+    /**
+     * @brief Blocks until a message with the given tag arrives from the given rank, and returns it.
+     * Throws a runtime_error if the connection to that rank is lost.
+     */
+    virtual std::vector<double> receive(int from, int tag) = 0;
+
+    void send(int to, int tag, const std::vector<double> &data){ send(to, tag, data.data(), data.size()); }
+
+    /**
+     * @brief Sends data from root to every other member of group. Every member calls it, with the same group and root.
+     */
+    void broadcast(std::vector<double> &data, int root, const std::vector<int> &group, int tag);
+
+    /**
+     * @brief Elementwise sum of data over the members of group, left in data on root only.
+     */
+    void sum(std::vector<double> &data, int root, const std::vector<int> &group, int tag);
+
+    /**
+     * @brief Elementwise sum of data over the members of group, left in data on every member.
+     */
+    void allSum(std::vector<double> &data, const std::vector<int> &group, int tag);
+
+    /**
+     * @brief Blocks until every rank has called it.
+     */
+    void barrier();
+};
+
+/**
+ * @brief In-process backend: the ranks are threads of one process, exchanging messages through shared mailboxes.
+ *
+ */
+class ThreadTransport: public Transport{
+public:
+    struct Hub;
+    ThreadTransport(std::shared_ptr<Hub> hub, int rank);
+    int rank() const override{ return me; }
+    int size() const override;
+    void send(int to, int tag, const double *data, size_t count) override;
+    std::vector<double> receive(int from, int tag) override;
+
+    /**
+     * @brief Runs body on size threads, each with its ThreadTransport, and waits for all of them.
+     * The first exception thrown by a rank is rethrown.
+     */
+    static void run(int size, const std::function<void(Transport &)> &body);
+private:
+    std::shared_ptr<Hub> hub;
+    int me;
+};
+
+/**
+ * @brief Multi-process backend over Unix domain sockets: rank r listens on directory/rank<r>.sock and every pair of ranks
+ * shares one connection. The ranks may be started in any order; each waits for the sockets of the others to appear.
+ *
+ */
+class SocketTransport: public Transport{
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+public:
+    /**
+     * @brief Connects rank to the other size-1 ranks through sockets in directory, which must exist and be shared by all ranks.
+     * Throws a runtime_error if the connections cannot be set up within timeout seconds.
+     */
+    SocketTransport(const std::string &directory, int rank, int size, double timeout = 30);
+    ~SocketTransport();
+    int rank() const override;
+    int size() const override;
+    void send(int to, int tag, const double *data, size_t count) override;
+    std::vector<double> receive(int from, int tag) override;
+
+    /**
+     * @brief Forks size processes, each running body with its SocketTransport over a fresh temporary directory, and waits for them.
+     * Meant for running a distributed computation on one machine.
+     *
+     * @note The children are forked, not executed anew, and inherit only the calling thread: a lock held by another thread
+     * at the fork stays locked in them forever. Call run before anything that leaves threads running, i.e. the task
+     * executor (runAsync and the *Async methods, see task.h), whose workers live until exit, and library calls on other
+     * threads of the program. The workers of the parallel kernels (see parallel.h) are idle between calls and a child
+     * starts its own, so the kernels may run before.
+     *
+     * @return int the number of ranks that failed (threw or crashed)
+     */
+    static int run(int size, const std::function<void(Transport &)> &body);
+};
+
+#endif
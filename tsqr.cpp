@@ -0,0 +1,350 @@
+#include <cmath>
+#include <memory>
+#include "tsqr.h"
+#include "parallel.h"
+#include "tuning.h"
+
+// rows below which a block of rows is not worth its own thread
+#define TSQR_MIN_ROWS 4096
+// doubles in a leaf of the TSQR tree (256 KB): a leaf is factorized while it sits in cache, so A is streamed from memory once
+#define TSQR_LEAF_DOUBLES 32768
+// rows of a leaf multiplied by its factor S at a time when Q is formed
+#define TSQR_Q_TILE 64
+// default panel width of blockGramSchmidt, unless tuned (see tuning.h)
+#define BCGS_BLOCK 32
+
+namespace{
+
+// Householder QR (LAPACK's geqr2) of the m*n matrix whose column j starts at col[j], m >= n.
+// R overwrites the upper triangle; reflector k is (1, col[k][k+1 .. m-1]) with coefficient tau[k].
+void householder(double *const *col, int m, int n, double *tau){
+    for (int k = 0; k < n; k++){
+        double *v = col[k];
+        double s = 0;
+        for (int i = k + 1; i < m; i++)
+            s += v[i] * v[i];
+        if (s == 0){
+            tau[k] = 0;
+            continue;
+        }
+        double alpha = v[k];
+        double beta = -std::copysign(std::sqrt(alpha * alpha + s), alpha);
+        tau[k] = (beta - alpha) / beta;
+        double scale = 1 / (alpha - beta);
+        for (int i = k + 1; i < m; i++)
+            v[i] *= scale;
+        v[k] = beta;
+        for (int j = k + 1; j < n; j++){
+            double *c = col[j];
+            double w = c[k];
+            for (int i = k + 1; i < m; i++)
+                w += v[i] * c[i];
+            w *= tau[k];
+            c[k] -= w;
+            for (int i = k + 1; i < m; i++)
+                c[i] -= w * v[i];
+        }
+    }
+}
+
+// C := H_0 ... H_{n-1} C for the reflectors left by householder, C being m*nc with column j starting at c[j]
+void applyQ(const double *const *col, int m, int n, const double *tau, double *const *c, int nc){
+    for (int k = n - 1; k >= 0; k--){
+        if (tau[k] == 0)
+            continue;
+        const double *v = col[k];
+        for (int j = 0; j < nc; j++){
+            double *x = c[j];
+            double w = x[k];
+            for (int i = k + 1; i < m; i++)
+                w += v[i] * x[i];
+            w *= tau[k];
+            x[k] -= w;
+            for (int i = k + 1; i < m; i++)
+                x[i] -= w * v[i];
+        }
+    }
+}
+
+// Q = H_0 ... H_{n-1} [I; 0] in place of the reflectors left by householder (LAPACK's org2r)
+void formQ(double *const *col, int m, int n, const double *tau){
+    for (int k = n - 1; k >= 0; k--){
+        double *v = col[k];
+        if (tau[k] != 0)
+            for (int j = k + 1; j < n; j++){
+                double *c = col[j];
+                double w = c[k];
+                for (int i = k + 1; i < m; i++)
+                    w += v[i] * c[i];
+                w *= tau[k];
+                c[k] -= w;
+                for (int i = k + 1; i < m; i++)
+                    c[i] -= w * v[i];
+            }
+        for (int i = k + 1; i < m; i++)
+            v[i] *= -tau[k];
+        v[k] = 1 - tau[k];
+        std::fill(v, v + k, 0.0);
+    }
+}
+
+// an m*n block with its reflectors: a node of the reduction tree, stored contiguously, or a leaf, factorized in place
+// in the rows of Q it will become
+struct Block{
+    int m, n;
+    std::vector<double> a, tau;
+    std::vector<double *> cols;
+    Block(int m, int n): m{m}, n{n}, a((size_t)m * n), tau(n), cols(n){
+        for (int j = 0; j < n; j++)
+            cols[j] = a.data() + (size_t)j * m;
+    }
+    Block(int m, int n, double *const *columns): m{m}, n{n}, tau(n), cols(columns, columns + n){}
+    void factorize(){ householder(cols.data(), m, n, tau.data()); }
+};
+
+// TSQR of the m*n matrix with columns a[j] (m >= n). Q goes to the columns q[j], which may be those of a, and R to the
+// n*n column-major r. Returns false if some |R_ii| <= EPSILON * max(reference, max |R_jj|).
+// The leaves are factorized in the rows of q, so apart from q the memory used is the tree of n*n factors.
+bool tsqrRaw(const double *const *a, double *const *q, int m, int n, double *r, double reference, int threads){
+    // leaves of at least n rows and about TSQR_LEAF_DOUBLES elements, dealt out to the threads in contiguous runs
+    long long leafRows = std::max(n, TSQR_LEAF_DOUBLES / std::max(n, 1));
+    int chunks = std::max(1LL, m / leafRows);
+    std::vector<std::unique_ptr<Block>> leaves(chunks);
+    std::vector<long long> first(chunks), last(chunks);
+    // leaves: the only pass over A
+    parallelFor(0, chunks, [&](int, long long c0, long long c1){
+        for (long long c = c0; c < c1; c++){
+            long long lo = (long long)m * c / chunks, hi = (long long)m * (c + 1) / chunks;
+            first[c] = lo;
+            last[c] = hi;
+            std::vector<double *> rows(n);
+            for (int j = 0; j < n; j++){
+                rows[j] = q[j] + lo;
+                if (q[j] != a[j])
+                    std::copy(a[j] + lo, a[j] + hi, rows[j]);
+            }
+            auto leaf = std::make_unique<Block>((int)(hi - lo), n, rows.data());
+            leaf->factorize();
+            leaves[c] = std::move(leaf);
+        }
+    }, 1, threads);
+
+    // reduction tree: level L+1 stacks the R factors of level L pairwise; an odd one out moves up unchanged
+    std::vector<std::vector<Block *>> level(1);
+    for (auto &leaf: leaves)
+        level[0].push_back(leaf.get());
+    std::vector<std::vector<std::unique_ptr<Block>>> nodes;
+    while (level.back().size() > 1){
+        const std::vector<Block *> &below = level.back();
+        int pairs = below.size() / 2;
+        std::vector<std::unique_ptr<Block>> pairNodes(pairs);
+        parallelFor(0, pairs, [&](int, long long p0, long long p1){
+            for (long long p = p0; p < p1; p++){
+                auto node = std::make_unique<Block>(2 * n, n);
+                for (int j = 0; j < n; j++)
+                    for (int i = 0; i <= j; i++){
+                        node->cols[j][i] = below[2 * p]->cols[j][i];
+                        node->cols[j][n + i] = below[2 * p + 1]->cols[j][i];
+                    }
+                node->factorize();
+                pairNodes[p] = std::move(node);
+            }
+        }, 1, threads);
+        std::vector<Block *> above;
+        for (auto &node: pairNodes)
+            above.push_back(node.get());
+        if (below.size() % 2)
+            above.push_back(below.back());
+        nodes.push_back(std::move(pairNodes));
+        level.push_back(std::move(above));
+    }
+
+    const Block *root = level.back()[0];
+    double rmax = reference;
+    for (int i = 0; i < n; i++)
+        rmax = std::max(rmax, std::abs(root->cols[i][i]));
+    // signs making the diagonal of R positive, as Gram-Schmidt gives it
+    std::vector<double> d(n);
+    for (int i = 0; i < n; i++){
+        double rii = root->cols[i][i];
+        if (std::abs(rii) <= EPSILON * rmax)
+            return false;
+        d[i] = rii < 0 ? -1 : 1;
+    }
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++)
+            r[(size_t)j * n + i] = i <= j ? d[i] * root->cols[j][i] : 0;
+
+    // Q, top down: the n*n factor S of a node, pushed through the node's reflectors, gives the factors of its two children
+    std::vector<std::vector<double>> S(1, std::vector<double>((size_t)n * n));
+    for (int i = 0; i < n; i++)
+        S[0][(size_t)i * n + i] = d[i];
+    for (int L = (int)level.size() - 1; L > 0; L--){
+        int count = level[L - 1].size(), pairs = count / 2;
+        std::vector<std::vector<double>> next(count);
+        for (int p = 0; p < pairs; p++){
+            const Block *node = nodes[L - 1][p].get();
+            Block C(2 * n, n);
+            for (int j = 0; j < n; j++)
+                std::copy(S[p].begin() + (size_t)j * n, S[p].begin() + (size_t)(j + 1) * n, C.cols[j]);
+            applyQ(node->cols.data(), 2 * n, n, node->tau.data(), C.cols.data(), n);
+            next[2 * p].resize((size_t)n * n);
+            next[2 * p + 1].resize((size_t)n * n);
+            for (int j = 0; j < n; j++){
+                std::copy(C.cols[j], C.cols[j] + n, next[2 * p].begin() + (size_t)j * n);
+                std::copy(C.cols[j] + n, C.cols[j] + 2 * n, next[2 * p + 1].begin() + (size_t)j * n);
+            }
+        }
+        if (count % 2)
+            next[count - 1] = std::move(S[pairs]);
+        S = std::move(next);
+    }
+    // leaves: Q_c = H_c [S_c; 0] = (H_c [I; 0]) S_c, formed over the reflectors and multiplied by S_c a tile of rows at a time
+    parallelFor(0, chunks, [&](int, long long c0, long long c1){
+        std::vector<double> tile((size_t)TSQR_Q_TILE * n);
+        for (long long c = c0; c < c1; c++){
+            Block &leaf = *leaves[c];
+            formQ(leaf.cols.data(), leaf.m, n, leaf.tau.data());
+            const double *s = S[c].data();
+            for (int i0 = 0; i0 < leaf.m; i0 += TSQR_Q_TILE){
+                int h = std::min(TSQR_Q_TILE, leaf.m - i0);
+                std::fill(tile.begin(), tile.begin() + (size_t)h * n, 0.0);
+                for (int j = 0; j < n; j++)
+                    for (int l = 0; l < n; l++){
+                        double f = s[(size_t)j * n + l];
+                        if (f == 0)
+                            continue;
+                        const double *x = leaf.cols[l] + i0;
+                        double *t = tile.data() + (size_t)j * h;
+                        for (int i = 0; i < h; i++)
+                            t[i] += f * x[i];
+                    }
+                for (int j = 0; j < n; j++)
+                    std::copy(tile.begin() + (size_t)j * h, tile.begin() + (size_t)(j + 1) * h, leaf.cols[j] + i0);
+            }
+        }
+    }, 1, threads);
+    return true;
+}
+
+// S = Q^T W and then W -= Q S, for the k columns q and the w columns W of length m: two passes over the data, parallel over rows.
+void project(const double *const *q, int k, double *const *W, int w, int m, std::vector<double> &S, int threads){
+    long long grain = TSQR_MIN_ROWS;
+    int chunks = parallelChunks(0, m, grain, threads);
+    std::vector<double> partial((size_t)chunks * k * w);
+    parallelFor(0, m, [&](int c, long long lo, long long hi){
+        double *s = partial.data() + (size_t)c * k * w;
+        for (int l = 0; l < w; l++)
+            for (int i = 0; i < k; i++){
+                double dot = 0;
+                for (long long r = lo; r < hi; r++)
+                    dot += q[i][r] * W[l][r];
+                s[(size_t)l * k + i] = dot;
+            }
+    }, grain, threads);
+    S.assign((size_t)k * w, 0);
+    for (int c = 0; c < chunks; c++)
+        for (size_t t = 0; t < S.size(); t++)
+            S[t] += partial[(size_t)c * k * w + t];
+    parallelFor(0, m, [&](int, long long lo, long long hi){
+        for (int l = 0; l < w; l++){
+            double *x = W[l];
+            for (int i = 0; i < k; i++){
+                double f = S[(size_t)l * k + i];
+                const double *y = q[i];
+                for (long long r = lo; r < hi; r++)
+                    x[r] -= f * y[r];
+            }
+        }
+    }, grain, threads);
+}
+
+// the column pointers of Q and A, and a check shared by both factorizations
+bool prepare(const Matrix &A, Matrix &Q, std::vector<const double *> &a, std::vector<double *> &q){
+    int m = A.order().first, n = A.order().second;
+    if (n == 0 || m < n)
+        return false;
+    Q = Matrix(m, n);
+    for (int j = 0; j < n; j++){
+        a.push_back(A.at(j).data());
+        q.push_back(Q.at(j).data());
+    }
+    return true;
+}
+
+void toTriangular(const std::vector<double> &r, int n, TriangularMatrix &R){
+    R = TriangularMatrix(n, true);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i <= j; i++)
+            R.at(i, j) = r[(size_t)j * n + i];
+}
+
+}
+
+bool tsqr(const Matrix &A, Matrix &Q, TriangularMatrix &R, int threads){
+    int m = A.order().first, n = A.order().second;
+    LINALG_PROFILE("tsqr", 4.0 * m * n * n, 16.0 * m * n);
+    std::vector<const double *> a;
+    std::vector<double *> q;
+    if (!prepare(A, Q, a, q))
+        return false;
+    std::vector<double> r((size_t)n * n);
+    if (!tsqrRaw(a.data(), q.data(), m, n, r.data(), 0, threads))
+        return false;
+    toTriangular(r, n, R);
+    return true;
+}
+
+bool blockGramSchmidt(const Matrix &A, Matrix &Q, TriangularMatrix &R, int block, int threads){
+    int m = A.order().first, n = A.order().second;
+    if (block <= 0)
+        block = tuning().qrBlock > 0 ? tuning().qrBlock : BCGS_BLOCK;
+    LINALG_PROFILE("blockGramSchmidt", 8.0 * m * n * n, 32.0 * m * n * n / block);
+    std::vector<const double *> a;
+    std::vector<double *> q;
+    if (!prepare(A, Q, a, q))
+        return false;
+    // the largest column norm: a panel column is dependent when projecting it leaves nothing on this scale
+    double reference = 0;
+    for (int j = 0; j < n; j++)
+        reference = std::max(reference, A.at(j).norm());
+    std::vector<double> r((size_t)n * n), S1, S2;
+    for (int j0 = 0; j0 < n; j0 += block){
+        int w = std::min(block, n - j0);
+        double *const *W = q.data() + j0;
+        for (int l = 0; l < w; l++)
+            std::copy(a[j0 + l], a[j0 + l] + m, W[l]);
+        std::vector<double> R1((size_t)w * w), R2((size_t)w * w);
+        if (j0 > 0)
+            project(q.data(), j0, W, w, m, S1, threads);
+        if (!tsqrRaw(W, W, m, w, R1.data(), reference, threads))
+            return false;
+        if (j0 == 0){
+            for (int l = 0; l < w; l++)
+                std::copy(R1.begin() + (size_t)l * w, R1.begin() + (size_t)(l + 1) * w, r.begin() + (size_t)l * n);
+            continue;
+        }
+        // second pass: one projection restores orthogonality to working precision (the "twice is enough" of CGS2)
+        project(q.data(), j0, W, w, m, S2, threads);
+        if (!tsqrRaw(W, W, m, w, R2.data(), 0, threads))
+            return false;
+        // A_panel = Q_prev (S1 + S2 R1) + Q_panel (R2 R1)
+        for (int l = 0; l < w; l++){
+            double *rl = r.data() + (size_t)(j0 + l) * n;
+            for (int i = 0; i < j0; i++){
+                double s = S1[(size_t)l * j0 + i];
+                for (int t = 0; t <= l; t++)
+                    s += S2[(size_t)t * j0 + i] * R1[(size_t)l * w + t];
+                rl[i] = s;
+            }
+            for (int i = 0; i <= l; i++){
+                double s = 0;
+                for (int t = i; t <= l; t++)
+                    s += R2[(size_t)t * w + i] * R1[(size_t)l * w + t];
+                rl[j0 + i] = s;
+            }
+        }
+    }
+    toTriangular(r, n, R);
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef TSQR_H
+#define TSQR_H
+
+#include "Matrix.h"
+#include "structuredMatrix.h"
+
+#pragma once
+
+// Parallel QR factorizations of tall-skinny matrices (m >> n), the kernels behind QRMethod::TSQR and QRMethod::BlockCGS2.
+// Both return Q with orthonormal columns and R with a positive diagonal, like Matrix::QR. They need linearly independent
+// columns: on a (numerically) rank deficient matrix they return false, and Matrix::QR then falls back to Gram-Schmidt.
+
+/**
+ * @brief Communication-avoiding QR: every thread computes a Householder QR of its block of rows, and the n*n R factors
+ * are then reduced pairwise in a binary tree. A is read once, against n times for Gram-Schmidt. The blocks are factorized
+ * in place in Q, so besides Q and R the memory used is the tree of n*n factors.
+ *
+ * @param A m*n matrix
+ * @param Q receives the m*n factor with orthonormal columns
+ * @param R receives the n*n upper triangular factor
+ * @param threads the number of row blocks, 0 for threadCount(). Every block keeps at least n rows.
+ * @return bool false if A is rank deficient (Q and R are then unspecified)
+ */
+bool tsqr(const Matrix &A, Matrix &Q, TriangularMatrix &R, int threads = 0);
+
+/**
+ * @brief Block classical Gram-Schmidt with reorthogonalization (BCGS2): panels of columns are projected against the
+ * previous ones with two block inner products and two block updates, each parallel over rows, and orthonormalized
+ * within the panel by TSQR. Suited to adding columns to an existing basis block by block.
+ *
+ * @param A m*n matrix
+ * @param Q receives the m*n factor with orthonormal columns
+ * @param R receives the n*n upper triangular factor
+ * @param block the panel width, 0 for the tuned width (see tuning.h), by default 32 columns
+ * @param threads the number of threads, 0 for threadCount()
+ * @return bool false if A is rank deficient (Q and R are then unspecified)
+ */
+bool blockGramSchmidt(const Matrix &A, Matrix &Q, TriangularMatrix &R, int block = 0, int threads = 0);
+
+#endif
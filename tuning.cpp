@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tuning.h"
+
+namespace{
+
+struct Key{
+    const char *name;
+    int TuningParameters::*field;
+};
+
+// the keys of the cache file, in the order they are written
+const Key keys[] = {
+    {"threads", &TuningParameters::threads},
+    {"gemm_row_block", &TuningParameters::gemmRowBlock},
+    {"gemm_depth_block", &TuningParameters::gemmDepthBlock},
+    {"strassen_cutoff", &TuningParameters::strassenCutoff},
+    {"transpose_tile", &TuningParameters::transposeTile},
+    {"lu_block", &TuningParameters::luBlock},
+    {"qr_block", &TuningParameters::qrBlock},
+    {"inverse_lu_min", &TuningParameters::inverseLUMin},
+};
+const int keyCount = sizeof keys / sizeof keys[0];
+
+// the parameters in use, one atomic per key: the kernels read them concurrently while setTuning may write them
+std::atomic<int> values[keyCount];
+std::once_flag loaded;
+
+void store(const TuningParameters &p){
+    for (int k = 0; k < keyCount; k++)
+        values[k].store(std::max(0, p.*keys[k].field), std::memory_order_relaxed);
+}
+
+std::string trim(const std::string &s){
+    size_t b = s.find_first_not_of(" \t\r"), e = s.find_last_not_of(" \t\r");
+    return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+// the cache as (cpu model, lines of its section) pairs, in file order
+std::vector<std::pair<std::string, std::vector<std::string>>> readSections(const std::string &path){
+    std::vector<std::pair<std::string, std::vector<std::string>>> sections;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)){
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (line.front() == '[' && line.back() == ']')
+            sections.push_back({trim(line.substr(1, line.size() - 2)), {}});
+        else if (!sections.empty())
+            sections.back().second.push_back(line);
+    }
+    return sections;
+}
+
+// reads the section of this CPU from the cache file into p; false if there is none
+bool readSection(const std::string &file, TuningParameters &p){
+    if (file.empty())
+        return false;
+    std::string model = cpuModel();
+    for (auto &section: readSections(file)){
+        if (section.first != model)
+            continue;
+        for (auto &line: section.second){
+            std::istringstream fields(line);
+            std::string name;
+            int value;
+            if (!(fields >> name >> value))
+                continue;
+            // unknown keys are skipped, so caches written by newer versions still load
+            for (auto &k: keys)
+                if (name == k.name)
+                    p.*k.field = value;
+        }
+        return true;
+    }
+    return false;
+}
+
+}
+
+TuningParameters tuning(){
+    std::call_once(loaded, []{
+        TuningParameters p;
+        if (readSection(tuningCachePath(), p))
+            store(p);
+    });
+    TuningParameters p;
+    for (int k = 0; k < keyCount; k++)
+        p.*keys[k].field = values[k].load(std::memory_order_relaxed);
+    return p;
+}
+
+void setTuning(const TuningParameters &parameters){
+    // a later first call of tuning() must not overwrite these with the cache
+    std::call_once(loaded, []{});
+    store(parameters);
+}
+
+std::string cpuModel(){
+    static const std::string model = []{
+        std::ifstream in("/proc/cpuinfo");
+        std::string line;
+        // x86 names the model "model name"; other architectures use "Processor", "cpu model" or "Hardware"
+        for (const char *field: {"model name", "Processor", "cpu model", "Hardware"}){
+            in.clear();
+            in.seekg(0);
+            while (std::getline(in, line)){
+                size_t colon = line.find(':');
+                if (colon != std::string::npos && trim(line.substr(0, colon)) == field){
+                    std::string value = trim(line.substr(colon + 1));
+                    // brackets would end the section header
+                    for (char &c: value)
+                        if (c == '[' || c == ']') c = '(';
+                    if (!value.empty())
+                        return value;
+                }
+            }
+        }
+        return std::string("unknown");
+    }();
+    return model;
+}
+
+std::string tuningCachePath(){
+    if (const char *env = std::getenv("LINALG_TUNING_FILE"))
+        return env;
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"))
+        if (*xdg)
+            return std::string(xdg) + "/linalg/tuning";
+    if (const char *home = std::getenv("HOME"))
+        if (*home)
+            return std::string(home) + "/.cache/linalg/tuning";
+    return "";
+}
+
+bool loadTuning(const std::string &path){
+    TuningParameters p;
+    if (!readSection(path.empty() ? tuningCachePath() : path, p))
+        return false;
+    std::call_once(loaded, []{});
+    store(p);
+    return true;
+}
+
+void saveTuning(const TuningParameters &parameters, const std::string &path){
+    std::string file = path.empty() ? tuningCachePath() : path;
+    if (file.empty()){
+        std::cerr << "saveTuning: no path for the tuning cache" << std::endl;
+        throw std::runtime_error("saveTuning: no path for the tuning cache");
+    }
+    std::string model = cpuModel();
+    auto sections = readSections(file);
+    std::vector<std::string> lines;
+    for (auto &k: keys)
+        if (parameters.*k.field > 0)
+            lines.push_back(std::string(k.name) + " " + std::to_string(parameters.*k.field));
+    bool replaced = false;
+    for (auto &section: sections)
+        if (section.first == model){
+            section.second = lines;
+            replaced = true;
+        }
+    if (!replaced)
+        sections.push_back({model, lines});
+
+    std::error_code ec;
+    std::filesystem::path target(file);
+    if (target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), ec);
+    // written next to the target under a unique name and renamed over it, so a concurrent reader sees the old or the
+    // new file, and concurrent writers do not write into each other's file (the last rename wins)
+    std::string temporary = file + ".XXXXXX";
+    int fd = mkstemp(&temporary[0]);
+    if (fd < 0){
+        std::cerr << "saveTuning: cannot create a temporary file next to " << file << std::endl;
+        throw std::runtime_error("saveTuning: cannot create a temporary file next to " + file);
+    }
+    // mkstemp creates the file readable by its owner only, but the cache may be shared
+    fchmod(fd, 0644);
+    close(fd);
+    {
+        std::ofstream out(temporary);
+        out << "# linalg tuning cache, written by linalg-tune: one section per CPU model\n";
+        for (auto &section: sections){
+            out << "[" << section.first << "]\n";
+            for (auto &line: section.second)
+                out << line << "\n";
+        }
+        if (!out){
+            std::remove(temporary.c_str());
+            std::cerr << "saveTuning: cannot write " << temporary << std::endl;
+            throw std::runtime_error("saveTuning: cannot write " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), file.c_str()) != 0){
+        std::remove(temporary.c_str());
+        std::cerr << "saveTuning: cannot replace " << file << std::endl;
+        throw std::runtime_error("saveTuning: cannot replace " + file);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <string>
+
+#pragma once
+
+// Machine-dependent kernel parameters: block sizes, the Strassen cutoff, the thread count and the order from which
+// inverses go through LU instead of rref. The built-in defaults suit a typical desktop CPU; the linalg-tune tool
+// (bench/tune.cpp) benchmarks candidates on the host and stores the winners in a tuning cache, which the library
+// loads the first time a parameter is needed. The cache is a text file holding one section per CPU model, so one
+// file can be shared by the machines of a fleet:
+//
+//     [Intel(R) Xeon(R) Gold 6230 CPU @ 2.10GHz]
+//     threads 20
+//     gemm_row_block 256
+//     ...
+//
+// Every parameter is an int, and 0 (or a missing key) means "not tuned": the kernel then uses its built-in default.
+// Explicit settings (setThreadCount, setStrassenCutoff) and the LINALG_NUM_THREADS and LINALG_STRASSEN_CUTOFF
+// environment variables still take precedence over the cache.
+
+/**
+ * @brief The tunable parameters. 0 leaves a parameter at its built-in default.
+ *
+ */
+struct TuningParameters{
+    /// threads of the parallel kernels, see threadCount
+    int threads = 0;
+    /// rows and depth of the panel of A that gemm keeps in cache (at most GEMM_KC_MAX deep, see view.cpp)
+    int gemmRowBlock = 0, gemmDepthBlock = 0;
+    /// recursion cutoff of Strassen-Winograd, see strassenCutoff
+    int strassenCutoff = 0;
+    /// tile of Matrix::transpose
+    int transposeTile = 0;
+    /// panel width of the blocked LU factorization (1 factorizes unblocked)
+    int luBlock = 0;
+    /// panel width of the BlockCGS2 QR, see blockGramSchmidt
+    int qrBlock = 0;
+    /// order from which SquareMatrix::inverse factorizes by LU instead of reducing (A|I) to its rref
+    int inverseLUMin = 0;
+};
+
+/**
+ * @brief Returns the parameters in use. The first call loads the section of this CPU from the tuning cache (see tuningCachePath).
+ */
+TuningParameters tuning();
+
+/**
+ * @brief Replaces the parameters in use, e.g. to try candidates or to apply a cache read elsewhere. TuningParameters{} restores the defaults.
+ */
+void setTuning(const TuningParameters &parameters);
+
+/**
+ * @brief Returns the model name of the CPU, the key of the sections of the tuning cache ("unknown" if it cannot be found).
+ */
+std::string cpuModel();
+
+/**
+ * @brief Returns the path of the tuning cache: the LINALG_TUNING_FILE environment variable if set (an empty value
+ * disables the cache), otherwise $XDG_CACHE_HOME/linalg/tuning, otherwise $HOME/.cache/linalg/tuning.
+ */
+std::string tuningCachePath();
+
+/**
+ * @brief Reads the section of this CPU from a tuning cache and makes it the parameters in use.
+ *
+ * @param path the cache, tuningCachePath() if empty
+ * @return bool false (and the parameters are left alone) if the file or the section does not exist
+ */
+bool loadTuning(const std::string &path = "");
+
+/**
+ * @brief Writes parameters as the section of this CPU of a tuning cache, keeping the sections of other CPUs.
+ * The file is replaced atomically and its directory created if needed. Throws a runtime_error if it cannot be written.
+ *
+ * @param path the cache, tuningCachePath() if empty
+ */
+void saveTuning(const TuningParameters &parameters, const std::string &path = "");
+
+#endif
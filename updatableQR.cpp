@@ -0,0 +1,213 @@
+#include <algorithm>
+#include "updatableQR.h"
+
+UpdatableQR::UpdatableQR(int m): m{m}
+{
+    if (m < 0){
+        std::cerr << "error in UpdatableQR: negative dimension.\n";
+        throw std::invalid_argument("error in UpdatableQR: negative dimension.");
+    }
+}
+
+UpdatableQR::UpdatableQR(const Matrix &A, std::vector<int> *dropped): m{A.order().first}
+{
+    for (int j = 0; j < A.order().second; j++){
+        if (appendColumn(A.at(j)))
+            continue;
+        if (!dropped){
+            std::cerr << "error in UpdatableQR: column " << j << " is linearly dependent on the previous ones.\n";
+            throw std::domain_error("error in UpdatableQR: linearly dependent columns.");
+        }
+        dropped->push_back(j);
+    }
+}
+
+bool UpdatableQR::appendColumn(const Vector &a){
+    if (a.size() != m){
+        std::cerr << "error in appendColumn: dimension mismatch.\n";
+        throw std::invalid_argument("error in appendColumn: dimension mismatch.");
+    }
+    int k = q.size();
+    if (k == m)
+        return false; // Q already spans R^m
+    std::vector<double> w(a.begin(), a.end()), coeff(k + 1, 0.0);
+    double anorm = a.norm();
+
+    // two passes of modified Gram-Schmidt; the second one removes what cancellation left behind in the first.
+    for (int pass = 0; pass < 2; pass++)
+        for (int j = 0; j < k; j++){
+            const double *qj = q[j].data();
+            double d = 0;
+            for (int i = 0; i < m; i++)
+                d += qj[i] * w[i];
+            for (int i = 0; i < m; i++)
+                w[i] -= d * qj[i];
+            coeff[j] += d;
+        }
+
+    double wnorm = 0;
+    for (double x: w)
+        wnorm += x * x;
+    wnorm = std::sqrt(wnorm);
+    if (wnorm <= EPSILON * anorm || wnorm < EPSILON)
+        return false;
+
+    for (auto &x: w)
+        x /= wnorm;
+    coeff[k] = wnorm;
+    for (auto &col: r)
+        col.push_back(0);
+    q.push_back(std::move(w));
+    r.push_back(std::move(coeff));
+    return true;
+}
+
+void UpdatableQR::rotate(int i, double c, double s, int first_col){
+    for (int j = first_col; j < (int)r.size(); j++){
+        double x = r[j][i], y = r[j][i + 1];
+        r[j][i] = c * x + s * y;
+        r[j][i + 1] = -s * x + c * y;
+    }
+    double *qi = q[i].data(), *qn = q[i + 1].data();
+    for (int l = 0; l < m; l++){
+        double x = qi[l], y = qn[l];
+        qi[l] = c * x + s * y;
+        qn[l] = -s * x + c * y;
+    }
+}
+
+void UpdatableQR::shrink(){
+    q.pop_back();
+    for (auto &col: r)
+        col.pop_back();
+}
+
+void UpdatableQR::removeColumn(int j){
+    int k = r.size();
+    if (j < 0 || j >= k){
+        std::cerr << "error in removeColumn: invalid column index.\n";
+        throw std::out_of_range("error in removeColumn: invalid column index.");
+    }
+    r.erase(r.begin() + j);
+    // R is now upper Hessenberg from column j onwards: chase the subdiagonal away.
+    for (int i = j; i < k - 1; i++){
+        double a = r[i][i], b = r[i][i + 1];
+        double h = std::hypot(a, b);
+        if (h == 0)
+            continue;
+        rotate(i, a / h, b / h, i);
+        r[i][i + 1] = 0;
+    }
+    shrink();
+}
+
+void UpdatableQR::rank1Update(const Vector &u, const Vector &v){
+    int k = r.size();
+    if (u.size() != m || v.size() != k){
+        std::cerr << "error in rank1Update: dimension mismatch.\n";
+        throw std::invalid_argument("error in rank1Update: dimension mismatch.");
+    }
+    if (k == 0)
+        return;
+
+    // w = Q^T u, p = u - Qw (reorthogonalized as in appendColumn)
+    std::vector<double> w(k, 0.0), p(u.begin(), u.end());
+    for (int pass = 0; pass < 2; pass++)
+        for (int j = 0; j < k; j++){
+            const double *qj = q[j].data();
+            double d = 0;
+            for (int i = 0; i < m; i++)
+                d += qj[i] * p[i];
+            for (int i = 0; i < m; i++)
+                p[i] -= d * qj[i];
+            w[j] += d;
+        }
+    double rho = 0;
+    for (double x: p)
+        rho += x * x;
+    rho = std::sqrt(rho);
+
+    // if u leaves the span of Q, temporarily extend Q by p/rho and R by a zero row.
+    bool extended = false;
+    if (k < m && rho > EPSILON * u.norm() && rho >= EPSILON){
+        for (auto &x: p)
+            x /= rho;
+        q.push_back(std::move(p));
+        for (auto &col: r)
+            col.push_back(0);
+        w.push_back(rho);
+        extended = true;
+    }
+    int len = w.size();
+
+    // rotate w into a multiple of e_1, bottom up. R becomes upper Hessenberg.
+    for (int i = len - 1; i > 0; i--){
+        double a = w[i - 1], b = w[i];
+        double h = std::hypot(a, b);
+        if (h == 0)
+            continue;
+        rotate(i - 1, a / h, b / h, i - 1);
+        w[i - 1] = h;
+        w[i] = 0;
+    }
+    for (int j = 0; j < k; j++)
+        r[j][0] += w[0] * v[j];
+
+    // restore the triangular shape.
+    for (int i = 0; i < std::min(len - 1, k); i++){
+        double a = r[i][i], b = r[i][i + 1];
+        double h = std::hypot(a, b);
+        if (h == 0)
+            continue;
+        rotate(i, a / h, b / h, i);
+        r[i][i + 1] = 0;
+    }
+    if (extended)
+        shrink();
+}
+
+void UpdatableQR::rank1Downdate(const Vector &u, const Vector &v){
+    rank1Update(-1 * u, v);
+}
+
+Vector UpdatableQR::solve(const Vector &b) const{
+    if (b.size() != m){
+        std::cerr << "error in UpdatableQR::solve: dimension mismatch.\n";
+        throw std::invalid_argument("error in UpdatableQR::solve: dimension mismatch.");
+    }
+    int k = r.size();
+    Vector x(k);
+    for (int j = 0; j < k; j++){
+        const double *qj = q[j].data();
+        double d = 0;
+        for (int i = 0; i < m; i++)
+            d += qj[i] * b.data()[i];
+        x[j] = d;
+    }
+    // back substitution, column oriented
+    for (int j = k - 1; j >= 0; j--){
+        if (std::abs(r[j][j]) < EPSILON){
+            std::cerr << "error in UpdatableQR::solve: R is singular.\n";
+            throw std::domain_error("error in UpdatableQR::solve: R is singular.");
+        }
+        x[j] /= r[j][j];
+        for (int i = 0; i < j; i++)
+            x[i] -= r[j][i] * x[j];
+    }
+    return x;
+}
+
+Matrix UpdatableQR::Q() const{
+    Matrix res(m, q.size());
+    for (int j = 0; j < (int)q.size(); j++)
+        std::copy(q[j].begin(), q[j].end(), res.at(j).data());
+    return res;
+}
+
+Matrix UpdatableQR::R() const{
+    int k = r.size();
+    Matrix res(k, k);
+    for (int j = 0; j < k; j++)
+        std::copy(r[j].begin(), r[j].end(), res.at(j).data());
+    return res;
+}
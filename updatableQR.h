@@ -0,0 +1,103 @@
+#ifndef UPDATABLEQR_H
+#define UPDATABLEQR_H
+
+#include <vector>
+#include "Matrix.h"
+
+#pragma once
+
+/**
+ * @brief Thin QR factorization A = QR (Q is m*k with orthonormal columns, R is k*k upper triangular) that can be updated in place.
+ * Appending or deleting a column and rank-1 updates each cost O(mk) instead of re-orthogonalizing the whole matrix.
+ *
+ * @note Columns are orthogonalized by modified Gram-Schmidt with one reorthogonalization pass ("twice is enough").
+ * Deletions and rank-1 updates restore the triangular shape of R with Givens rotations.
+ */
+class UpdatableQR{
+    int m;
+    // columns of Q, each of length m
+    std::vector<std::vector<double>> q;
+    // columns of R, each of length k (the number of columns of Q)
+    std::vector<std::vector<double>> r;
+public:
+    /**
+     * @brief Construct an empty factorization for columns of dimension m.
+     *
+     * @param m the number of rows of the factorized matrix
+     */
+    UpdatableQR(int m);
+
+    /**
+     * @brief Construct the factorization of A by appending its columns one at a time.
+     * A column in the span of the previous ones throws a domain_error, unless dropped is given: the column is then skipped
+     * and its index added to *dropped, and the factorization is that of A without these columns.
+     *
+     * @param A the matrix to factorize
+     * @param dropped receives the indices of the skipped columns, in increasing order
+     */
+    UpdatableQR(const Matrix &A, std::vector<int> *dropped = nullptr);
+
+    /**
+     * @brief Gives the dimensions {m, k} of the factorized matrix.
+     *
+     * @return std::pair<int,int>
+     */
+    std::pair<int,int> order() const{ return {m, (int)q.size()}; }
+
+    /**
+     * @brief Appends a column a to the factorized matrix in O(mk).
+     *
+     * @param a the new column. Must have dimension m.
+     * @return true if the column was appended, false if it lies (numerically) in the span of the current columns, in which case nothing changes.
+     */
+    bool appendColumn(const Vector &a);
+
+    /**
+     * @brief Deletes the jth column of the factorized matrix in O(mk).
+     *
+     * @param j index of the column to delete
+     */
+    void removeColumn(int j);
+
+    /**
+     * @brief Replaces the factorization of A by the factorization of A + u*v^T in O(mk).
+     *
+     * @param u Vector of dimension m
+     * @param v Vector of dimension k
+     */
+    void rank1Update(const Vector &u, const Vector &v);
+
+    /**
+     * @brief Replaces the factorization of A by the factorization of A - u*v^T in O(mk).
+     *
+     * @param u Vector of dimension m
+     * @param v Vector of dimension k
+     */
+    void rank1Downdate(const Vector &u, const Vector &v);
+
+    /**
+     * @brief Returns the least squares solution x minimizing |Ax - b|, computed as R^{-1}(Q^T b) in O(mk + k^2).
+     *
+     * @param b the right hand side, of dimension m
+     * @return Vector x of dimension k
+     */
+    Vector solve(const Vector &b) const;
+
+    /**
+     * @brief Returns the m*k factor Q.
+     */
+    Matrix Q() const;
+
+    /**
+     * @brief Returns the k*k upper triangular factor R.
+     */
+    Matrix R() const;
+
+private:
+    // applies the rotation [c s; -s c] to rows i and i+1 of R (columns from first_col onwards) and the transpose to columns i, i+1 of Q.
+    void rotate(int i, double c, double s, int first_col);
+    // drops the last column of Q and the last row of R
+    void shrink();
+};
+
+#endif
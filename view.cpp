@@ -0,0 +1,783 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include "view.h"
+#include "Matrix.h"
+#include "parallel.h"
+#include "tuning.h"
+
+namespace{
+
+// calls f(k, len, stride) for each run of elements k, k+1, ..., k+len-1 that are stride apart in memory.
+// A view inside one parent column is a single run; otherwise (rows, transposed columns) every element is its own run.
+template <class F>
+void forEachRun(int n, long rs, long cs, F f){
+    if (cs == 0){
+        if (n > 0)
+            f(0, n, rs);
+        return;
+    }
+    for (int k = 0; k < n; k++)
+        f(k, 1, 1);
+}
+
+void dimensionCheck(int a, int b, const char *what){
+    if (a != b){
+        std::cerr << what << ": dimension mismatch" << std::endl;
+        throw std::invalid_argument(std::string(what) + ": dimension mismatch");
+    }
+}
+
+}
+
+// ===================== vector views ============================= //
+
+ConstVectorView::ConstVectorView(const double *data, int n, long stride): r0{0}, c0{0}, rs{stride}, cs{0}, n{n}{
+    if (n < 0 || stride < 0){
+        std::cerr << "invalid buffer dimensions for a view" << std::endl;
+        throw std::invalid_argument("invalid buffer dimensions for a view");
+    }
+    // addressed like a strided matrix view (see below)
+    st.base = data;
+    st.ld = 1;
+}
+
+ConstVectorView ConstVectorView::slice(int start, int len, int step) const{
+    if (start < 0 || len < 0 || step < 1 || (len > 0 && start + (long)(len - 1) * step >= n)){
+        std::cerr << "slice out of range" << std::endl;
+        throw std::out_of_range("slice out of range");
+    }
+    ConstVectorView res(*this);
+    res.r0 = r0 + start * rs;
+    res.c0 = c0 + start * cs;
+    res.rs = rs * step;
+    res.cs = cs * step;
+    res.n = len;
+    return res;
+}
+
+void ConstVectorView::copyTo(double *out) const{
+    if (n == 0)
+        return;
+    if (cs == 0){
+        const double *p = st.column(c0) + r0;
+        if (rs == 1)
+            std::copy(p, p + n, out);
+        else
+            for (int k = 0; k < n; k++)
+                out[k] = p[k * rs];
+        return;
+    }
+    for (int k = 0; k < n; k++)
+        out[k] = *ptr(k);
+}
+
+double ConstVectorView::dot(const ConstVectorView &v, Summation mode) const{
+    if (n != v.n){
+        std::cerr << "Invalid dot product" << std::endl;
+        throw std::invalid_argument("Vectors do not have the same dimension. Cannot take dot product.");
+    }
+    if (n == 0)
+        return 0;
+    if (cs == 0 && v.cs == 0)
+        return reduceDot(n, st.column(c0) + r0, rs, v.st.column(v.c0) + v.r0, v.rs, mode);
+    // elements spread over several columns (rows of a matrix) are gathered first
+    std::vector<double> a(n), b(n);
+    copyTo(a.data());
+    v.copyTo(b.data());
+    return reduceDot(n, a.data(), 1, b.data(), 1, mode);
+}
+
+double ConstVectorView::norm(int k, Summation mode) const{
+    if (k == 2)
+        return std::sqrt(dot(*this, mode));
+    std::vector<double> powers(n);
+    for (int i = 0; i < n; i++)
+        powers[i] = std::pow(std::abs(*ptr(i)), k);
+    return std::pow(reduceSum(n, powers.data(), 1, mode), 1.0 / k);
+}
+
+void VectorView::copyFrom(const double *in) const{
+    if (n == 0)
+        return;
+    if (cs == 0){
+        double *p = wptr(0);
+        if (rs == 1)
+            std::copy(in, in + n, p);
+        else
+            for (int k = 0; k < n; k++)
+                p[k * rs] = in[k];
+        return;
+    }
+    for (int k = 0; k < n; k++)
+        *wptr(k) = in[k];
+}
+
+const VectorView &VectorView::operator=(const ConstVectorView &v) const{
+    dimensionCheck(n, v.n, "VectorView assignment");
+    if (n == 0)
+        return *this;
+    if (cs == 0 && v.cs == 0){
+        double *a = wptr(0);
+        const double *b = v.ptr(0);
+        // element by element in the direction that is safe when the two views overlap in the same column
+        if (a <= b)
+            for (int k = 0; k < n; k++)
+                a[k * rs] = b[k * v.rs];
+        else
+            for (int k = n - 1; k >= 0; k--)
+                a[k * rs] = b[k * v.rs];
+        return *this;
+    }
+    std::vector<double> tmp(n);
+    v.copyTo(tmp.data());
+    copyFrom(tmp.data());
+    return *this;
+}
+
+const VectorView &VectorView::operator=(double d) const{
+    forEachRun(n, rs, cs, [&](int k, int len, long stride){
+        double *p = wptr(k);
+        for (int i = 0; i < len; i++)
+            p[i * stride] = d;
+    });
+    return *this;
+}
+
+const VectorView &VectorView::axpy(double alpha, const ConstVectorView &x) const{
+    dimensionCheck(n, x.n, "VectorView::axpy");
+    if (n == 0)
+        return *this;
+    if (cs == 0 && x.cs == 0){
+        double *a = wptr(0);
+        const double *b = x.ptr(0);
+        if (rs == 1 && x.rs == 1)
+            for (int k = 0; k < n; k++)
+                a[k] += alpha * b[k];
+        else
+            for (int k = 0; k < n; k++)
+                a[k * rs] += alpha * b[k * x.rs];
+        return *this;
+    }
+    for (int k = 0; k < n; k++)
+        *wptr(k) += alpha * *x.ptr(k);
+    return *this;
+}
+
+const VectorView &VectorView::operator+=(const ConstVectorView &v) const{
+    return axpy(1, v);
+}
+
+const VectorView &VectorView::operator-=(const ConstVectorView &v) const{
+    return axpy(-1, v);
+}
+
+const VectorView &VectorView::operator*=(double factor) const{
+    forEachRun(n, rs, cs, [&](int k, int len, long stride){
+        double *p = wptr(k);
+        for (int i = 0; i < len; i++)
+            p[i * stride] *= factor;
+    });
+    return *this;
+}
+
+const VectorView &VectorView::operator/=(double factor) const{
+    if (std::abs(factor) < EPSILON){
+        std::cerr << "Division by 0" << std::endl;
+        throw std::invalid_argument("Cannot divide by 0");
+    }
+    return *this *= 1 / factor;
+}
+
+// ===================== matrix views ============================= //
+
+ConstMatrixView::ConstMatrixView(const Matrix &A): m{A.order().first}, n{A.order().second}{
+    st.cols = A.mat.data();
+}
+
+ConstMatrixView::ConstMatrixView(const double *data, int m, int n, long ld): m{m}, n{n}{
+    if (m < 0 || n < 0 || ld < m){
+        std::cerr << "invalid buffer dimensions for a view" << std::endl;
+        throw std::invalid_argument("invalid buffer dimensions for a view");
+    }
+    st.base = data;
+    st.ld = ld;
+}
+
+ConstMatrixView::ConstMatrixView(const double *data, int m, int n, long rowStride, long colStride): m{m}, n{n}{
+    if (m < 0 || n < 0 || rowStride < 0 || colStride < 0){
+        std::cerr << "invalid buffer dimensions for a view" << std::endl;
+        throw std::invalid_argument("invalid buffer dimensions for a view");
+    }
+    // one parent "column" of leading dimension 1: element (i,j) is at base + i*ri + j*rj
+    st.base = data;
+    st.ld = 1;
+    ri = rowStride; rj = colStride;
+    ci = 0; cj = 0;
+}
+
+MatrixView::MatrixView(Matrix &A): ConstMatrixView(A){
+    // writes through the view are not tracked one by one: handing it out counts as the modification
+    A.touch();
+}
+
+MatrixBuffer::MatrixBuffer(double *data, int m, int n, long ld, std::function<void(double *)> deleter): MatrixView(data, m, n, ld){
+    if (deleter)
+        owner = std::shared_ptr<double>(data, std::move(deleter));
+}
+
+MatrixBuffer::MatrixBuffer(double *data, int m, int n, long rowStride, long colStride, std::function<void(double *)> deleter):
+    MatrixView(data, m, n, rowStride, colStride){
+    if (deleter)
+        owner = std::shared_ptr<double>(data, std::move(deleter));
+}
+
+MatrixBuffer::MatrixBuffer(int m, int n): MatrixBuffer(m < 0 || n < 0 ? nullptr : new double[(size_t)m * n], m, n, m, [](double *p){ delete[] p; }){}
+
+void ConstMatrixView::checkBlock(int i, int j, int rows, int cols) const{
+    if (i < 0 || j < 0 || rows < 0 || cols < 0 || i + rows > m || j + cols > n){
+        std::cerr << "block out of range" << std::endl;
+        throw std::out_of_range("block out of range");
+    }
+}
+
+const double &ConstMatrixView::at(int i, int j) const{
+    if (i < 0 || i >= m || j < 0 || j >= n){
+        std::cerr << "index out of bounds" << std::endl;
+        throw std::out_of_range("index out of bounds");
+    }
+    return st.column(c0 + i * ci + j * cj)[r0 + i * ri + j * rj];
+}
+
+ConstMatrixView ConstMatrixView::block(int i, int j, int rows, int cols) const{
+    checkBlock(i, j, rows, cols);
+    ConstMatrixView res(*this);
+    res.r0 = r0 + i * ri + j * rj;
+    res.c0 = c0 + i * ci + j * cj;
+    res.m = rows;
+    res.n = cols;
+    return res;
+}
+
+ConstMatrixView ConstMatrixView::strided(int i, int j, int rows, int cols, int row_step, int col_step) const{
+    if (row_step < 1 || col_step < 1){
+        std::cerr << "strided: steps must be positive" << std::endl;
+        throw std::invalid_argument("strided: steps must be positive");
+    }
+    checkBlock(i, j, rows ? (rows - 1) * row_step + 1 : 0, cols ? (cols - 1) * col_step + 1 : 0);
+    ConstMatrixView res = block(i, j, 0, 0);
+    res.ri = ri * row_step; res.ci = ci * row_step;
+    res.rj = rj * col_step; res.cj = cj * col_step;
+    res.m = rows;
+    res.n = cols;
+    return res;
+}
+
+ConstMatrixView ConstMatrixView::transposed() const{
+    ConstMatrixView res(*this);
+    std::swap(res.ri, res.rj);
+    std::swap(res.ci, res.cj);
+    std::swap(res.m, res.n);
+    return res;
+}
+
+ConstMatrixView ConstMatrixView::column(const ConstVectorView &v){
+    ConstMatrixView res;
+    res.st = v.st;
+    res.r0 = v.r0; res.c0 = v.c0;
+    res.ri = v.rs; res.ci = v.cs;
+    res.rj = 0; res.cj = 0;
+    res.m = v.n; res.n = 1;
+    return res;
+}
+
+ConstVectorView ConstMatrixView::row(int i) const{
+    checkBlock(i, 0, 1, n);
+    ConstVectorView res;
+    res.st = st;
+    res.r0 = r0 + i * ri; res.c0 = c0 + i * ci;
+    res.rs = rj; res.cs = cj;
+    res.n = n;
+    return res;
+}
+
+ConstVectorView ConstMatrixView::col(int j) const{
+    checkBlock(0, j, m, 1);
+    ConstVectorView res;
+    res.st = st;
+    res.r0 = r0 + j * rj; res.c0 = c0 + j * cj;
+    res.rs = ri; res.cs = ci;
+    res.n = m;
+    return res;
+}
+
+ConstVectorView ConstMatrixView::diagonal(int k) const{
+    int i = k < 0 ? -k : 0, j = k > 0 ? k : 0;
+    ConstVectorView res;
+    res.st = st;
+    res.r0 = r0 + i * ri + j * rj; res.c0 = c0 + i * ci + j * cj;
+    res.rs = ri + rj; res.cs = ci + cj;
+    res.n = std::max(0, std::min(m - i, n - j));
+    return res;
+}
+
+// pairs of lines below which overlaps() compares every pair as it generates them, without sorting (or allocating)
+#define OVERLAP_DIRECT_PAIRS 4096
+
+bool ConstMatrixView::overlaps(const ConstMatrixView &v) const{
+    if (m == 0 || n == 0 || v.m == 0 || v.n == 0)
+        return false;
+    // Views are compared by the memory they touch, not by their parent, so that a Vector which is a column of a Matrix,
+    // or two views adopting the same buffer, are seen to alias. Each view is cut into lines that stay inside one
+    // buffer, every line an arithmetic progression of addresses.
+    struct Line{ std::uintptr_t first, last, stride; };
+    // a column of the view stays in one buffer unless it crosses the columns of a Matrix parent; likewise a row
+    auto byColumns = [](const ConstMatrixView &a){
+        bool can_down = !a.st.cols || a.ci == 0, can_across = !a.st.cols || a.cj == 0;
+        return can_down && (!can_across || a.n == 1 || (a.m > 1 && a.ci * a.st.ld + a.ri <= a.cj * a.st.ld + a.rj));
+    };
+    auto byRows = [&](const ConstMatrixView &a){ return !byColumns(a) && (!a.st.cols || a.cj == 0); };
+    auto lineCount = [&](const ConstMatrixView &a){
+        return byColumns(a) ? (long)a.n : byRows(a) ? (long)a.m : (long)a.m * a.n;
+    };
+    // calls f on each line of a until it returns true
+    auto forEachLine = [&](const ConstMatrixView &a, auto f){
+        auto address = [&](long i, long j){
+            return (std::uintptr_t)(a.st.column(a.c0 + i * a.ci + j * a.cj) + a.r0 + i * a.ri + j * a.rj);
+        };
+        auto line = [&](long i0, long j0, long i1, long j1, long step){
+            return Line{address(i0, j0), address(i1, j1), (std::uintptr_t)std::max(1L, step) * sizeof(double)};
+        };
+        if (byColumns(a)){
+            for (int j = 0; j < a.n; j++)
+                if (f(line(0, j, a.m - 1, j, a.ci * a.st.ld + a.ri)))
+                    return true;
+        }
+        else if (byRows(a)){
+            for (int i = 0; i < a.m; i++)
+                if (f(line(i, 0, i, a.n - 1, a.cj * a.st.ld + a.rj)))
+                    return true;
+        }
+        else
+            for (int j = 0; j < a.n; j++)
+                for (int i = 0; i < a.m; i++)
+                    if (f(line(i, j, i, j, 1)))
+                        return true;
+        return false;
+    };
+    // whether two lines share an address
+    auto meets = [](const Line &x, const Line &y){
+        if (x.last < y.first || y.last < x.first)
+            return false;
+        std::uintptr_t offset = x.first > y.first ? x.first - y.first : y.first - x.first;
+        if (offset % std::gcd(x.stride, y.stride) != 0)
+            return false;
+        if (x.stride == y.stride)
+            return true;
+        // walk the sparser line through the common range, checking each of its addresses against the other line
+        const Line &p = x.stride > y.stride ? x : y, &q = x.stride > y.stride ? y : x;
+        std::uintptr_t lo = std::max(x.first, y.first), hi = std::min(x.last, y.last);
+        for (std::uintptr_t at = p.first + (lo - p.first + p.stride - 1) / p.stride * p.stride; at <= hi; at += p.stride)
+            if ((at - q.first) % q.stride == 0)
+                return true;
+        return false;
+    };
+
+    // few pairs, e.g. a matrix against a vector in gemv: compare them all
+    if ((double)lineCount(*this) * lineCount(v) <= OVERLAP_DIRECT_PAIRS)
+        return forEachLine(*this, [&](const Line &x){
+            return forEachLine(v, [&](const Line &y){ return meets(x, y); });
+        });
+
+    // otherwise sort the lines of v by their first address and only compare each line of this view with those in its range
+    std::vector<Line> b;
+    b.reserve(lineCount(v));
+    forEachLine(v, [&](const Line &y){ b.push_back(y); return false; });
+    std::sort(b.begin(), b.end(), [](const Line &x, const Line &y){ return x.first < y.first; });
+    // reach[k]: the furthest address touched by b[0..k], so the search below stops at the first line that cannot reach
+    std::vector<std::uintptr_t> reach(b.size());
+    for (size_t k = 0; k < b.size(); k++)
+        reach[k] = std::max(b[k].last, k ? reach[k - 1] : 0);
+    return forEachLine(*this, [&](const Line &x){
+        size_t k = std::upper_bound(b.begin(), b.end(), x.last, [](std::uintptr_t p, const Line &y){ return p < y.first; }) - b.begin();
+        while (k-- > 0 && reach[k] >= x.first)
+            if (meets(x, b[k]))
+                return true;
+        return false;
+    });
+}
+
+const MatrixView &MatrixView::operator=(const ConstMatrixView &v) const{
+    dimensionCheck(m, v.order().first, "MatrixView assignment");
+    dimensionCheck(n, v.order().second, "MatrixView assignment");
+    if (overlaps(v)){
+        // e.g. shifting a block inside its own matrix: go through a copy
+        Matrix tmp(v);
+        return *this = ConstMatrixView(tmp);
+    }
+    for (int j = 0; j < n; j++)
+        col(j) = v.col(j);
+    return *this;
+}
+
+const MatrixView &MatrixView::operator=(const Matrix &v) const{
+    return *this = ConstMatrixView(v);
+}
+
+const MatrixView &MatrixView::operator=(double d) const{
+    for (int j = 0; j < n; j++)
+        col(j) = d;
+    return *this;
+}
+
+const MatrixView &MatrixView::operator+=(const ConstMatrixView &v) const{
+    dimensionCheck(m, v.order().first, "MatrixView addition");
+    dimensionCheck(n, v.order().second, "MatrixView addition");
+    for (int j = 0; j < n; j++)
+        col(j) += v.col(j);
+    return *this;
+}
+
+const MatrixView &MatrixView::operator-=(const ConstMatrixView &v) const{
+    dimensionCheck(m, v.order().first, "MatrixView subtraction");
+    dimensionCheck(n, v.order().second, "MatrixView subtraction");
+    for (int j = 0; j < n; j++)
+        col(j) -= v.col(j);
+    return *this;
+}
+
+const MatrixView &MatrixView::operator*=(double factor) const{
+    for (int j = 0; j < n; j++)
+        col(j) *= factor;
+    return *this;
+}
+
+// ===================== products ============================= //
+
+// row and depth blocking of gemm: a GEMM_MC x GEMM_KC panel of A stays in cache while every column of C is updated.
+// These are the defaults; the tuned blocks (see tuning.h) replace them, the depth capped at GEMM_KC_MAX.
+#define GEMM_MC 256
+#define GEMM_KC 128
+#define GEMM_KC_MAX 1024
+// multiply-adds below which gemm runs on one thread
+#define GEMM_PARALLEL_MIN (1 << 21)
+
+void gemm(double alpha, const ConstMatrixView &A, const ConstMatrixView &B, double beta, const MatrixView &C){
+    int m = A.order().first, K = A.order().second, n = B.order().second;
+    LINALG_PROFILE("gemm", 2.0 * m * K * n, 8.0 * (m * K + K * n + 2.0 * m * n));
+    if (K != B.order().first || C.order().first != m || C.order().second != n){
+        std::cerr<<"Matrices incompatible for multiplication"<<std::endl;
+        throw std::invalid_argument("Matrices incompatible for multiplication");
+    }
+    if (C.overlaps(A) || C.overlaps(B)){
+        std::cerr<<"gemm: output aliases an input"<<std::endl;
+        throw std::invalid_argument("gemm: output aliases an input");
+    }
+    if (beta == 0)
+        C = 0.0;
+    else if (beta != 1)
+        C *= beta;
+    if (alpha == 0 || m == 0 || K == 0)
+        return;
+    TuningParameters tuned = tuning();
+    int mc = tuned.gemmRowBlock > 0 ? tuned.gemmRowBlock : GEMM_MC;
+    int kc = tuned.gemmDepthBlock > 0 ? std::min(tuned.gemmDepthBlock, GEMM_KC_MAX) : GEMM_KC;
+
+    // the columns of C (and B) are split over the threads, as FirstTouch placement split them over the nodes (see numa.h)
+    parallelFor(0, n, [&](int, long long lo, long long hi){
+        // columns of A that are not contiguous (strided or transposed views) are packed once per panel;
+        // likewise a non-contiguous column of B or C is gathered into bbuf or cbuf (and C scattered back)
+        bool acontig = A.ci == 0 && A.ri == 1, bcontig = B.ci == 0 && B.ri == 1, ccontig = C.ci == 0 && C.ri == 1;
+        const double *acols[GEMM_KC_MAX];
+        double bbuf[GEMM_KC_MAX];
+        std::vector<double> apack(acontig ? 0 : (size_t)mc * kc), cbuf(ccontig ? 0 : mc);
+        for (int kk = 0; kk < K; kk += kc){
+            taskCheckpoint((double)kk / K);
+            int kend = std::min(kk + kc, K), klen = kend - kk;
+            for (int ii = 0; ii < m; ii += mc){
+                int ilen = std::min(mc, m - ii);
+                for (int k = 0; k < klen; k++){
+                    if (acontig)
+                        acols[k] = A.columnStart(kk + k) + ii;
+                    else{
+                        A.col(kk + k).slice(ii, ilen).copyTo(apack.data() + (size_t)k * mc);
+                        acols[k] = apack.data() + (size_t)k * mc;
+                    }
+                }
+                for (long long j = lo; j < hi; j++){
+                    const double *b = bbuf;
+                    if (bcontig)
+                        b = B.columnStart(j) + kk;
+                    else
+                        B.col(j).slice(kk, klen).copyTo(bbuf);
+                    double *c = cbuf.data();
+                    if (ccontig)
+                        c = const_cast<double *>(C.columnStart(j)) + ii;
+                    else
+                        C.col(j).slice(ii, ilen).copyTo(c);
+                    int k = 0;
+                    // four columns of A per pass, so each element of C is loaded and stored once per four updates
+                    for (; k + 4 <= klen; k += 4){
+                        double b0 = alpha * b[k], b1 = alpha * b[k+1], b2 = alpha * b[k+2], b3 = alpha * b[k+3];
+                        const double *a0 = acols[k], *a1 = acols[k+1], *a2 = acols[k+2], *a3 = acols[k+3];
+                        for (int i = 0; i < ilen; i++)
+                            c[i] += a0[i] * b0 + a1[i] * b1 + a2[i] * b2 + a3[i] * b3;
+                    }
+                    for (; k < klen; k++){
+                        double bk = alpha * b[k];
+                        const double *a = acols[k];
+                        for (int i = 0; i < ilen; i++)
+                            c[i] += a[i] * bk;
+                    }
+                    if (!ccontig)
+                        C.col(j).slice(ii, ilen).copyFrom(c);
+                }
+            }
+        }
+    }, 1, (double)m * K * n >= GEMM_PARALLEL_MIN ? 0 : 1);
+}
+
+// rows of y (gemv) or of x (gemvT) per block: the block of the vector stays in L1 while every column passes over it
+#define GEMV_MB 2048
+// partial sums per column in the gemvT dot products, so that the loops vectorize
+#define GEMV_LANES 2
+// multiply-adds below which gemv, gemvT and ger run on one thread
+#define GEMV_PARALLEL_MIN (1 << 18)
+
+namespace{
+
+void gemvCheck(bool ok, const char *what){
+    if (!ok){
+        std::cerr << what << ": matrix and vector incompatible for multiplication" << std::endl;
+        throw std::invalid_argument(std::string(what) + ": matrix and vector incompatible for multiplication");
+    }
+}
+
+// s[c] += a[c][0 .. len-1] . x[0 .. len-1] for the four columns a[0..3], which share each load of x
+void dot4(const double *const *a, const double *x, int len, double *s){
+    const double *a0 = a[0], *a1 = a[1], *a2 = a[2], *a3 = a[3];
+    double p0[GEMV_LANES] = {}, p1[GEMV_LANES] = {}, p2[GEMV_LANES] = {}, p3[GEMV_LANES] = {};
+    int i = 0;
+    for (; i + GEMV_LANES <= len; i += GEMV_LANES)
+        for (int l = 0; l < GEMV_LANES; l++){
+            double xi = x[i + l];
+            p0[l] += a0[i + l] * xi;
+            p1[l] += a1[i + l] * xi;
+            p2[l] += a2[i + l] * xi;
+            p3[l] += a3[i + l] * xi;
+        }
+    for (int l = 0; l < GEMV_LANES; l++){
+        s[0] += p0[l];
+        s[1] += p1[l];
+        s[2] += p2[l];
+        s[3] += p3[l];
+    }
+    for (; i < len; i++){
+        s[0] += a0[i] * x[i];
+        s[1] += a1[i] * x[i];
+        s[2] += a2[i] * x[i];
+        s[3] += a3[i] * x[i];
+    }
+}
+
+double dot1(const double *a, const double *x, int len){
+    double p[GEMV_LANES] = {};
+    int i = 0;
+    for (; i + GEMV_LANES <= len; i += GEMV_LANES)
+        for (int l = 0; l < GEMV_LANES; l++)
+            p[l] += a[i + l] * x[i + l];
+    double t = 0;
+    for (int l = 0; l < GEMV_LANES; l++)
+        t += p[l];
+    for (; i < len; i++)
+        t += a[i] * x[i];
+    return t;
+}
+
+// y[0 .. len-1] = beta * y, where beta = 0 overwrites whatever y held
+void scale(double *y, long len, double beta){
+    if (beta == 0)
+        std::fill(y, y + len, 0.0);
+    else if (beta != 1)
+        for (long i = 0; i < len; i++)
+            y[i] *= beta;
+}
+
+}
+
+void gemv(double alpha, const ConstMatrixView &A, const ConstVectorView &x, double beta, const VectorView &y){
+    int m = A.m, n = A.n;
+    LINALG_PROFILE("gemv", 2.0 * m * n, 8.0 * (m * n + n + 2.0 * m));
+    gemvCheck(x.size() == n && y.size() == m, "gemv");
+    if (m == 0)
+        return;
+    // rows of a transposed matrix are its contiguous direction: dot products run along them
+    if (!(A.ci == 0 && A.ri == 1) && A.cj == 0 && A.rj == 1)
+        return gemvT(alpha, A.transposed(), x, beta, y);
+    if (!(A.ci == 0 && A.ri == 1)){
+        Matrix packed(A);
+        return gemv(alpha, packed, x, beta, y);
+    }
+    ConstMatrixView ycol = ConstMatrixView::column(y);
+    // x is read while y is written: gather it first if it is strided or shares elements with y
+    std::vector<double> xbuf;
+    const double *px = x.data();
+    if (n > 0 && (!px || ConstMatrixView::column(x).overlaps(ycol))){
+        xbuf.resize(n);
+        x.copyTo(xbuf.data());
+        px = xbuf.data();
+    }
+    std::vector<double> ybuf;
+    double *py = y.data();
+    bool direct = py && !A.overlaps(ycol);
+    if (!direct){
+        ybuf.resize(m);
+        if (beta != 0)
+            y.copyTo(ybuf.data());
+        py = ybuf.data();
+    }
+
+    // each thread owns a range of rows of y and passes every column of A over it
+    parallelFor(0, m, [&](int, long long lo, long long hi){
+        for (long long ii = lo; ii < hi; ii += GEMV_MB){
+            int len = (int)std::min<long long>(GEMV_MB, hi - ii);
+            double *yb = py + ii;
+            scale(yb, len, beta);
+            if (alpha == 0)
+                continue;
+            int j = 0;
+            // four columns per pass, so each element of y is loaded and stored once per four updates
+            for (; j + 4 <= n; j += 4){
+                double x0 = alpha * px[j], x1 = alpha * px[j+1], x2 = alpha * px[j+2], x3 = alpha * px[j+3];
+                const double *a0 = A.columnStart(j) + ii, *a1 = A.columnStart(j+1) + ii, *a2 = A.columnStart(j+2) + ii, *a3 = A.columnStart(j+3) + ii;
+                for (int i = 0; i < len; i++)
+                    yb[i] += a0[i] * x0 + a1[i] * x1 + a2[i] * x2 + a3[i] * x3;
+            }
+            for (; j < n; j++){
+                double xj = alpha * px[j];
+                const double *a = A.columnStart(j) + ii;
+                for (int i = 0; i < len; i++)
+                    yb[i] += a[i] * xj;
+            }
+        }
+    }, 1, (double)m * n >= GEMV_PARALLEL_MIN ? 0 : 1);
+    if (!direct)
+        y.copyFrom(ybuf.data());
+}
+
+void gemvT(double alpha, const ConstMatrixView &A, const ConstVectorView &x, double beta, const VectorView &y){
+    int m = A.m, n = A.n;
+    LINALG_PROFILE("gemvT", 2.0 * m * n, 8.0 * (m * n + m + 2.0 * n));
+    gemvCheck(x.size() == m && y.size() == n, "gemvT");
+    if (n == 0)
+        return;
+    if (!(A.ci == 0 && A.ri == 1) && A.cj == 0 && A.rj == 1)
+        return gemv(alpha, A.transposed(), x, beta, y);
+    if (!(A.ci == 0 && A.ri == 1)){
+        Matrix packed(A);
+        return gemvT(alpha, packed, x, beta, y);
+    }
+    ConstMatrixView ycol = ConstMatrixView::column(y);
+    std::vector<double> xbuf;
+    const double *px = x.data();
+    if (m > 0 && (!px || ConstMatrixView::column(x).overlaps(ycol))){
+        xbuf.resize(m);
+        x.copyTo(xbuf.data());
+        px = xbuf.data();
+    }
+    std::vector<double> ybuf;
+    double *py = y.data();
+    bool direct = py && !A.overlaps(ycol);
+    if (!direct){
+        ybuf.resize(n);
+        if (beta != 0)
+            y.copyTo(ybuf.data());
+        py = ybuf.data();
+    }
+
+    // each thread owns a range of columns of A (entries of y), as FirstTouch placement split them over the nodes (see numa.h)
+    parallelFor(0, n, [&](int, long long lo, long long hi){
+        long long cols = hi - lo;
+        double *yb = py + lo;
+        scale(yb, cols, beta);
+        if (alpha == 0)
+            return;
+        for (int ii = 0; ii < m; ii += GEMV_MB){
+            int len = std::min(GEMV_MB, m - ii);
+            const double *xb = px + ii;
+            long long j = 0;
+            for (; j + 4 <= cols; j += 4){
+                const double *a[4] = {A.columnStart(lo + j) + ii, A.columnStart(lo + j + 1) + ii,
+                                      A.columnStart(lo + j + 2) + ii, A.columnStart(lo + j + 3) + ii};
+                double s[4] = {};
+                dot4(a, xb, len, s);
+                for (int c = 0; c < 4; c++)
+                    yb[j + c] += alpha * s[c];
+            }
+            for (; j < cols; j++)
+                yb[j] += alpha * dot1(A.columnStart(lo + j) + ii, xb, len);
+        }
+    }, 1, (double)m * n >= GEMV_PARALLEL_MIN ? 0 : 1);
+    if (!direct)
+        y.copyFrom(ybuf.data());
+}
+
+void ger(double alpha, const ConstVectorView &x, const ConstVectorView &y, const MatrixView &A){
+    int m = A.m, n = A.n;
+    LINALG_PROFILE("ger", 2.0 * m * n, 8.0 * (2.0 * m * n + m + n));
+    gemvCheck(x.size() == m && y.size() == n, "ger");
+    if (alpha == 0 || m == 0 || n == 0)
+        return;
+    // A^T += alpha*y*x^T updates the rows of a transposed matrix along their contiguous direction
+    if (!(A.ci == 0 && A.ri == 1) && A.cj == 0 && A.rj == 1)
+        return ger(alpha, y, x, A.transposed());
+    // x and y are read while A is written: gather them first if they are strided or share elements with A
+    std::vector<double> xbuf, ybuf;
+    const double *px = x.data(), *py = y.data();
+    if (!px || A.overlaps(ConstMatrixView::column(x))){
+        xbuf.resize(m);
+        x.copyTo(xbuf.data());
+        px = xbuf.data();
+    }
+    if (!py || A.overlaps(ConstMatrixView::column(y))){
+        ybuf.resize(n);
+        y.copyTo(ybuf.data());
+        py = ybuf.data();
+    }
+    parallelFor(0, n, [&](int, long long lo, long long hi){
+        for (long long j = lo; j < hi; j++){
+            double s = alpha * py[j];
+            if (A.ci == 0){
+                double *a = const_cast<double *>(A.columnStart(j));
+                long ri = A.ri;
+                if (ri == 1)
+                    for (int i = 0; i < m; i++)
+                        a[i] += px[i] * s;
+                else
+                    for (int i = 0; i < m; i++)
+                        a[i * ri] += px[i] * s;
+            }
+            else
+                for (int i = 0; i < m; i++)
+                    A.at(i, j) += px[i] * s;
+        }
+    }, 1, (double)m * n >= GEMV_PARALLEL_MIN ? 0 : 1);
+}
+
+Matrix operator*(const ConstMatrixView &A, const ConstMatrixView &B){
+    if (A.order().second != B.order().first){
+        std::cerr<<"Matrices incompatible for multiplication"<<std::endl;
+        throw std::invalid_argument("Matrices incompatible for multiplication");
+    }
+    Matrix product(A.order().first, B.order().second);
+    gemm(1, A, B, 0, product);
+    return product;
+}
+
+Matrix operator*(const Matrix &A, const ConstMatrixView &B){
+    return ConstMatrixView(A) * B;
+}
+
+Matrix operator*(const ConstMatrixView &A, const Matrix &B){
+    return A * ConstMatrixView(B);
+}
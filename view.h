@@ -0,0 +1,460 @@
+#ifndef VIEW_H
+#define VIEW_H
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include "Vector.h"
+
+#pragma once
+
+// Views alias part of a Matrix (or a Vector, or an external column-major or strided buffer) without copying it: blocks,
+// rows, columns, diagonals, strided slices and transposes. A view is a small handle (no allocation), so making one costs O(1).
+// A MatrixBuffer is a view that also owns its buffer, to adopt memory handed over by other components.
+//
+// ConstMatrixView/ConstVectorView are read-only; MatrixView/VectorView derive from them and write through to the parent.
+// Like std::span, constness belongs to the type and not to the handle: a const MatrixView& can still be written through.
+// A view is invalidated when its parent is destroyed or changes its order.
+//
+// Routines that take a const Matrix& accept a view (or a MatrixBuffer) only through the explicit Matrix(view) or
+// SquareMatrix(view), so the copy of the viewed elements shows at the call site; a const Vector& still takes a vector view
+// through an implicit copy. The arithmetic below (assignment, +=, -=, scaling, dot, gemm, products) works on views directly.
+
+class Matrix;
+class MatrixView;
+
+/**
+ * @brief Where the elements of a view live: either the column table of a Matrix, or a column-major buffer with leading dimension ld.
+ *
+ */
+struct ViewStorage{
+    const Vector *cols = nullptr;
+    const double *base = nullptr;
+    long ld = 0;
+
+    /**
+     * @brief Returns a pointer to the start of column c of the parent.
+     */
+    const double *column(long c) const{ return cols ? cols[c].data() : base + c * ld; }
+    /**
+     * @brief Checks if two storages belong to the same parent.
+     */
+    bool sameAs(const ViewStorage &o) const{ return cols == o.cols && base == o.base; }
+};
+
+/**
+ * @brief Read-only strided view of a vector. Element k is at row r0 + k*rs, column c0 + k*cs of the parent.
+ *
+ */
+class ConstVectorView{
+protected:
+    ViewStorage st;
+    long r0 = 0, c0 = 0, rs = 1, cs = 0;
+    int n = 0;
+
+    const double *ptr(int k) const{ return st.column(c0 + k * cs) + r0 + k * rs; }
+    void check(int k) const{
+        if (k < 0 || k >= n){
+            std::cerr << "Index out of range";
+            throw std::out_of_range("Index out of range");
+        }
+    }
+    friend class VectorView;
+    friend class ConstMatrixView;
+public:
+    /**
+     * @brief Construct an empty view.
+     */
+    ConstVectorView(){}
+
+    /**
+     * @brief Construct a view of the whole Vector v.
+     */
+    ConstVectorView(const Vector &v): r0{0}, c0{0}, rs{1}, cs{0}, n{v.size()}{
+        st.base = v.data();
+    }
+
+    /**
+     * @brief Construct a view of n doubles stride apart in an external buffer, without copying them. The buffer is not owned.
+     * Raises invalid_argument error if n or stride is negative.
+     */
+    ConstVectorView(const double *data, int n, long stride = 1);
+
+    /**
+     * @brief returns the number of elements in the view.
+     */
+    int size() const{ return n; }
+
+    /**
+     * @brief Checks if the elements are consecutive in memory, i.e. data() can be used.
+     */
+    bool contiguous() const{ return cs == 0 && (rs == 1 || n <= 1); }
+
+    /**
+     * @brief direct access to the elements when the view is contiguous, for use by the numerical kernels.
+     *
+     * @return const double*. Pointer to the first element, or nullptr if the view is not contiguous.
+     */
+    const double *data() const{ return contiguous() && n > 0 ? ptr(0) : nullptr; }
+
+    /**
+     * @brief access (read-only) the element at the given index. Throws out_of_range error if the index is invalid.
+     */
+    const double &operator[](int index) const{
+        check(index);
+        return *ptr(index);
+    }
+
+    /**
+     * @brief access (read-only) the element at the given index. Throws out_of_range error if the index is invalid.
+     */
+    const double &at(int index) const{ return (*this)[index]; }
+
+    /**
+     * @brief Returns the view of the len elements start, start+step, start+2*step, ...
+     *
+     * @param start index of the first element
+     * @param len number of elements
+     * @param step distance between consecutive elements (>= 1)
+     */
+    ConstVectorView slice(int start, int len, int step = 1) const;
+
+    /**
+     * @brief Copies the elements into the contiguous buffer out of size() doubles.
+     */
+    void copyTo(double *out) const;
+
+    /**
+     * @brief Computes the dot product with v, summed as mode says (see summation.h).
+     * Raises invalid_argument error if the dimensions do not match.
+     */
+    double dot(const ConstVectorView &v, Summation mode = summationMode()) const;
+
+    /**
+     * @brief Computes the k-norm of the viewed elements.
+     *
+     * @param k The norm required. Defaults to 2.
+     * @param mode how the powers of the elements are summed (see summation.h)
+     */
+    double norm(int k = 2, Summation mode = summationMode()) const;
+};
+
+/**
+ * @brief Writable strided view of a vector. Writes go to the parent.
+ *
+ */
+class VectorView: public ConstVectorView{
+    friend class MatrixView;
+    VectorView(const ConstVectorView &v): ConstVectorView(v){}
+    double *wptr(int k) const{ return const_cast<double *>(ptr(k)); }
+public:
+    VectorView(){}
+
+    /**
+     * @brief Construct a writable view of the whole Vector v.
+     */
+    VectorView(Vector &v): ConstVectorView(v){}
+
+    /**
+     * @brief Construct a writable view of n doubles stride apart in an external buffer. The buffer is not owned.
+     */
+    VectorView(double *data, int n, long stride = 1): ConstVectorView(data, n, stride){}
+
+    VectorView(const VectorView &) = default;
+
+    /**
+     * @brief direct access to the elements when the view is contiguous.
+     *
+     * @return double*. Pointer to the first element, or nullptr if the view is not contiguous.
+     */
+    double *data() const{ return const_cast<double *>(ConstVectorView::data()); }
+
+    /**
+     * @brief access the element at the given index. Throws out_of_range error if the index is invalid.
+     */
+    double &operator[](int index) const{
+        check(index);
+        return *wptr(index);
+    }
+
+    /**
+     * @brief access the element at the given index. Throws out_of_range error if the index is invalid.
+     */
+    double &at(int index) const{ return (*this)[index]; }
+
+    /**
+     * @brief Returns the writable view of the len elements start, start+step, start+2*step, ...
+     */
+    VectorView slice(int start, int len, int step = 1) const{ return VectorView(ConstVectorView::slice(start, len, step)); }
+
+    /**
+     * @brief Overwrites the elements from the contiguous buffer in of size() doubles.
+     */
+    void copyFrom(const double *in) const;
+
+    /**
+     * @brief Copies the elements of v into the viewed elements (not a rebinding). Raises invalid_argument error if the dimensions do not match.
+     */
+    const VectorView &operator=(const ConstVectorView &v) const;
+    const VectorView &operator=(const VectorView &v) const{ return *this = static_cast<const ConstVectorView &>(v); }
+    const VectorView &operator=(const Vector &v) const{ return *this = ConstVectorView(v); }
+
+    /**
+     * @brief Sets every viewed element to d.
+     */
+    const VectorView &operator=(double d) const;
+
+    const VectorView &operator+=(const ConstVectorView &v) const;
+    const VectorView &operator-=(const ConstVectorView &v) const;
+    const VectorView &operator*=(double factor) const;
+    /**
+     * @brief divides the viewed elements by factor. Throws an exception if factor is zero.
+     */
+    const VectorView &operator/=(double factor) const;
+
+    /**
+     * @brief self += alpha * x
+     */
+    const VectorView &axpy(double alpha, const ConstVectorView &x) const;
+};
+
+/**
+ * @brief Read-only view of a matrix. Element (i,j) is at row r0 + i*ri + j*rj, column c0 + i*ci + j*cj of the parent,
+ * which covers blocks, strided slices and transposes with one representation.
+ *
+ */
+class ConstMatrixView{
+protected:
+    ViewStorage st;
+    long r0 = 0, c0 = 0, ri = 1, rj = 0, ci = 0, cj = 1;
+    int m = 0, n = 0;
+
+    void checkBlock(int i, int j, int rows, int cols) const;
+    // address of element (0,j), for the kernels; the column is contiguous when ci == 0 and ri == 1
+    const double *columnStart(int j) const{ return st.column(c0 + j * cj) + r0 + j * rj; }
+    // the m*1 view of the elements of v, to check a vector against a matrix with overlaps()
+    static ConstMatrixView column(const ConstVectorView &v);
+    friend void gemm(double alpha, const ConstMatrixView &A, const ConstMatrixView &B, double beta, const MatrixView &C);
+    friend void gemv(double alpha, const ConstMatrixView &A, const ConstVectorView &x, double beta, const VectorView &y);
+    friend void gemvT(double alpha, const ConstMatrixView &A, const ConstVectorView &x, double beta, const VectorView &y);
+    friend void ger(double alpha, const ConstVectorView &x, const ConstVectorView &y, const MatrixView &A);
+public:
+    /**
+     * @brief Construct an empty view.
+     */
+    ConstMatrixView(){}
+
+    /**
+     * @brief Construct a view of the whole Matrix A.
+     */
+    ConstMatrixView(const Matrix &A);
+
+    /**
+     * @brief Construct a view of an m*n column-major buffer with leading dimension ld (>= m). The buffer is not owned.
+     */
+    ConstMatrixView(const double *data, int m, int n, long ld);
+
+    /**
+     * @brief Construct a view of an m*n matrix whose element (i,j) is data[i*rowStride + j*colStride], such as a row-major
+     * (colStride = 1) or NumPy/Arrow strided buffer (strides in elements, not bytes), without copying it. The buffer is not owned.
+     * Raises invalid_argument error if a dimension or a stride is negative.
+     */
+    ConstMatrixView(const double *data, int m, int n, long rowStride, long colStride);
+
+    /**
+     * @brief Gives the dimensions of the view as the std::pair {num_rows, num_columns}.
+     */
+    std::pair<int,int> order() const{ return {m, n}; }
+
+    /**
+     * @brief Returns a const reference to the (i,j)th element. Throws out_of_range error if the indices are invalid.
+     */
+    const double &at(int i, int j) const;
+
+    /**
+     * @brief Returns the rows*cols block whose top left element is (i,j).
+     */
+    ConstMatrixView block(int i, int j, int rows, int cols) const;
+
+    /**
+     * @brief Returns every row_step-th row and every col_step-th column of the rows*cols block starting at (i,j),
+     * i.e. the elements (i + a*row_step, j + b*col_step) for 0 <= a < rows, 0 <= b < cols.
+     */
+    ConstMatrixView strided(int i, int j, int rows, int cols, int row_step, int col_step) const;
+
+    /**
+     * @brief Returns the transpose, without moving any element.
+     */
+    ConstMatrixView transposed() const;
+
+    /**
+     * @brief Returns the ith row.
+     */
+    ConstVectorView row(int i) const;
+
+    /**
+     * @brief Returns the jth column.
+     */
+    ConstVectorView col(int j) const;
+
+    /**
+     * @brief Returns the kth diagonal: the main one for k = 0, above it for k > 0 and below it for k < 0.
+     */
+    ConstVectorView diagonal(int k = 0) const;
+
+    /**
+     * @brief Checks if the view may share elements with v, by the addresses both touch: a column of a Matrix passed as a
+     * Vector, or two views of the same external buffer, overlap with the views of that matrix or buffer.
+     */
+    bool overlaps(const ConstMatrixView &v) const;
+};
+
+/**
+ * @brief Writable view of a matrix. Writes go to the parent.
+ *
+ */
+class MatrixView: public ConstMatrixView{
+    MatrixView(const ConstMatrixView &v): ConstMatrixView(v){}
+public:
+    MatrixView(){}
+
+    /**
+     * @brief Construct a writable view of the whole Matrix A.
+     */
+    MatrixView(Matrix &A);
+
+    /**
+     * @brief Construct a writable view of an m*n column-major buffer with leading dimension ld (>= m). The buffer is not owned.
+     */
+    MatrixView(double *data, int m, int n, long ld): ConstMatrixView(data, m, n, ld){}
+
+    /**
+     * @brief Construct a writable view of an m*n strided buffer, element (i,j) at data[i*rowStride + j*colStride]. The buffer is not owned.
+     */
+    MatrixView(double *data, int m, int n, long rowStride, long colStride): ConstMatrixView(data, m, n, rowStride, colStride){}
+
+    MatrixView(const MatrixView &) = default;
+
+    /**
+     * @brief Returns a reference to the (i,j)th element. Throws out_of_range error if the indices are invalid.
+     */
+    double &at(int i, int j) const{ return const_cast<double &>(ConstMatrixView::at(i, j)); }
+
+    MatrixView block(int i, int j, int rows, int cols) const{ return MatrixView(ConstMatrixView::block(i, j, rows, cols)); }
+    MatrixView strided(int i, int j, int rows, int cols, int row_step, int col_step) const{
+        return MatrixView(ConstMatrixView::strided(i, j, rows, cols, row_step, col_step));
+    }
+    MatrixView transposed() const{ return MatrixView(ConstMatrixView::transposed()); }
+    VectorView row(int i) const{ return VectorView(ConstMatrixView::row(i)); }
+    VectorView col(int j) const{ return VectorView(ConstMatrixView::col(j)); }
+    VectorView diagonal(int k = 0) const{ return VectorView(ConstMatrixView::diagonal(k)); }
+
+    /**
+     * @brief Copies the elements of v into the viewed elements (not a rebinding). Raises invalid_argument error if the orders do not match.
+     */
+    const MatrixView &operator=(const ConstMatrixView &v) const;
+    const MatrixView &operator=(const MatrixView &v) const{ return *this = static_cast<const ConstMatrixView &>(v); }
+    const MatrixView &operator=(const Matrix &v) const;
+
+    /**
+     * @brief Sets every viewed element to d.
+     */
+    const MatrixView &operator=(double d) const;
+
+    const MatrixView &operator+=(const ConstMatrixView &v) const;
+    const MatrixView &operator-=(const ConstMatrixView &v) const;
+    const MatrixView &operator*=(double factor) const;
+};
+
+/**
+ * @brief Writable view that owns the buffer it views: it adopts memory allocated elsewhere (an Arrow or NumPy buffer,
+ * a memory mapped file) without copying it, and calls the deleter on the buffer when the last copy of the MatrixBuffer
+ * is destroyed. Copies share the buffer. Plain views taken from it (block, col, ...) do not keep the buffer alive.
+ *
+ */
+class MatrixBuffer: public MatrixView{
+    std::shared_ptr<double> owner;
+public:
+    MatrixBuffer(){}
+
+    /**
+     * @brief Adopt an m*n column-major buffer with leading dimension ld (>= m).
+     *
+     * @param deleter called on data once the buffer is no longer used; null to only alias the buffer, as MatrixView does
+     */
+    MatrixBuffer(double *data, int m, int n, long ld, std::function<void(double *)> deleter);
+
+    /**
+     * @brief Adopt an m*n strided buffer, element (i,j) at data[i*rowStride + j*colStride] (see the strided ConstMatrixView).
+     *
+     * @param deleter called on data once the buffer is no longer used; null to only alias the buffer
+     */
+    MatrixBuffer(double *data, int m, int n, long rowStride, long colStride, std::function<void(double *)> deleter);
+
+    /**
+     * @brief Allocate an m*n column-major buffer, uninitialized, to be filled in place (e.g. by a reader) and then used as a view.
+     */
+    MatrixBuffer(int m, int n);
+
+    MatrixBuffer(const MatrixBuffer &) = default;
+
+    // assignment copies elements, as for MatrixView; between two buffers that would be mistaken for sharing, so it is spelled B = ConstMatrixView(other)
+    using MatrixView::operator=;
+    MatrixBuffer &operator=(const MatrixBuffer &) = delete;
+};
+
+/**
+ * @brief General matrix multiply C = alpha*A*B + beta*C on views, blocked for the cache (Matrix::gemm forwards here).
+ * Any of A, B, C may be blocks, strided slices or transposes. C must not overlap A or B.
+ *
+ * @param alpha scalar multiplying A*B
+ * @param A left factor
+ * @param B right factor
+ * @param beta scalar multiplying the previous contents of C. With beta = 0 the contents of C are ignored.
+ * @param C the output, of order (rows of A, columns of B)
+ */
+void gemm(double alpha, const ConstMatrixView &A, const ConstMatrixView &B, double beta, const MatrixView &C);
+
+/**
+ * @brief Matrix-vector multiply y = alpha*A*x + beta*y on views, without converting x or y to matrices (Matrix::gemv forwards here).
+ * x may alias A or y; a y overlapping A is computed in a buffer and copied back.
+ *
+ * @param alpha scalar multiplying A*x
+ * @param A the matrix, m*n
+ * @param x the vector of size n
+ * @param beta scalar multiplying the previous contents of y. With beta = 0 the contents of y are ignored.
+ * @param y the output, of size m
+ */
+void gemv(double alpha, const ConstMatrixView &A, const ConstVectorView &x, double beta, const VectorView &y);
+
+/**
+ * @brief Transposed matrix-vector multiply y = alpha*A^T*x + beta*y, i.e. the row vector alpha*x^T*A + beta*y^T, on views
+ * (Matrix::gemvT forwards here). Aliasing is handled as in gemv.
+ *
+ * @param alpha scalar multiplying A^T*x
+ * @param A the matrix, m*n
+ * @param x the vector of size m
+ * @param beta scalar multiplying the previous contents of y. With beta = 0 the contents of y are ignored.
+ * @param y the output, of size n
+ */
+void gemvT(double alpha, const ConstMatrixView &A, const ConstVectorView &x, double beta, const VectorView &y);
+
+/**
+ * @brief Rank-1 update A += alpha*x*y^T on views (Matrix::ger forwards here). x and y may alias A.
+ *
+ * @param alpha scalar multiplying x*y^T
+ * @param x the vector of size m
+ * @param y the vector of size n
+ * @param A the m*n matrix updated in place
+ */
+void ger(double alpha, const ConstVectorView &x, const ConstVectorView &y, const MatrixView &A);
+
+/**
+ * @brief Returns the product of two views as a new Matrix.
+ */
+Matrix operator*(const ConstMatrixView &A, const ConstMatrixView &B);
+Matrix operator*(const Matrix &A, const ConstMatrixView &B);
+Matrix operator*(const ConstMatrixView &A, const Matrix &B);
+
+#endif